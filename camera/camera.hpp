@@ -1,23 +1,228 @@
 #ifndef PHOTOGRAMMETRY_CAMERA_HPP
 #define PHOTOGRAMMETRY_CAMERA_HPP
 
+#include "camera/camera_model.hpp"
+#include "camera/camera_parametres.hpp"
 #include "core/eigen_types.hpp"
+#include <algorithm>
+#include <cassert>
 
 // camera class, Mutiple frames can be associated with a single camera
 // they generally have the same intrinsic parameters(focal length, principal point, et al.),
-// but different extrinsic parameters the extrinsic parameters are 
+// but different extrinsic parameters the extrinsic parameters are
 // the relative pose between the camera and the world
 // the intrinsic parameters are the same for all the frames
 
 namespace photogrammetry {
 namespace camera {
+
+/*
+ * @brief 物理相机: 一份内参(相机模型) + 所有帧的位姿
+ * 位姿按 SoA 连续存放: 旋转矩阵的 9 个元素与相机中心的 3 个分量各占一行, 每行按帧连续,
+ * 由 Eigen 对齐分配。对同一点在所有帧上的变换逐行整体运算, 可被向量化; 新增帧只在容量不足时
+ * 成倍扩容, 不会为每一帧单独分配内存。
+ * @tparam CameraModelT 相机模型, 如 PinholeCameraBrown
+ */
+template <typename CameraModelT>
 class Camera {
 public:
+  typedef CameraModelT CameraModel;
+  typedef typename CameraModelT::Scalar Scalar;
+  typedef Vec2T<Scalar> Vec2;
+  typedef Vec3T<Scalar> Vec3;
+  typedef Mat33T<Scalar> Mat33;
+  typedef Mat2XT<Scalar> Mat2X;
+  typedef Mat3XT<Scalar> Mat3X;
+
+  explicit Camera(const CameraModelT &model) : model_(model) {}
+
+  // 相机模型(内参), 所有帧共享
+  const CameraModelT &Model() const { return model_; }
+  CameraModelT &Model() { return model_; }
+
+  size_t NumFrames() const { return num_frames_; }
+
+  // 预留帧的存储空间
+  void Reserve(const size_t num_frames) {
+    if (num_frames > Capacity()) {
+      rotations_.conservativeResize(Eigen::NoChange, num_frames);
+      centers_.conservativeResize(Eigen::NoChange, num_frames);
+    }
+  }
+
+  /*
+   * @brief 新增一帧
+   * @param pose 帧位姿
+   * @return 帧序号
+   */
+  size_t AddFrame(const CameraExtrinsicParams &pose) {
+    if (num_frames_ == Capacity()) {
+      Reserve(std::max<size_t>(16, 2 * Capacity()));
+    }
+    SetPose(num_frames_, pose);
+    return num_frames_++;
+  }
+
+  // 删除所有帧, 保留已分配的存储
+  void ClearFrames() { num_frames_ = 0; }
+
+  void SetPose(const size_t frame, const CameraExtrinsicParams &pose) {
+    assert(frame < Capacity());
+    for (int c = 0; c < 3; ++c) {
+      for (int r = 0; r < 3; ++r) {
+        rotations_(3 * c + r, frame) = Scalar(pose.Rotation()(r, c));
+      }
+      centers_(c, frame) = Scalar(pose.Center()(c));
+    }
+  }
+
+  CameraExtrinsicParams Pose(const size_t frame) const {
+    return CameraExtrinsicParams(Rotation(frame).template cast<double>(),
+                                 Center(frame).template cast<double>());
+  }
+
+  Mat33 Rotation(const size_t frame) const {
+    assert(frame < num_frames_);
+    Mat33 R;
+    for (int c = 0; c < 3; ++c) {
+      for (int r = 0; r < 3; ++r) {
+        R(r, c) = rotations_(3 * c + r, frame);
+      }
+    }
+    return R;
+  }
+
+  Vec3 Center(const size_t frame) const {
+    assert(frame < num_frames_);
+    return centers_.col(frame);
+  }
 
+  /*
+   * @brief 将世界坐标系下的点变换到某一帧的相机坐标系
+   * @param frame 帧序号
+   * @param X 世界坐标系下的点 (3xN)
+   * @param X_cam 输出的相机坐标 (3xN), 需预先分配好大小
+   */
+  void WorldToCamera(const size_t frame, const Eigen::Ref<const Mat3X> &X,
+                     Eigen::Ref<Mat3X> X_cam) const {
+    X_cam.noalias() = Rotation(frame) * (X.colwise() - Center(frame));
+  }
+
+  /*
+   * @brief 将同一个世界点变换到所有帧的相机坐标系
+   * @param X 世界坐标系下的点
+   * @param X_cam 输出的相机坐标 (3 x NumFrames), 需预先分配好大小
+   */
+  void WorldToCameraAllFrames(const Vec3 &X, Eigen::Ref<Mat3X> X_cam) const {
+    WorldToCameraFrames(X, 0, X_cam);
+  }
+  Mat3X WorldToCameraAllFrames(const Vec3 &X) const {
+    Mat3X X_cam(3, num_frames_);
+    WorldToCameraAllFrames(X, X_cam);
+    return X_cam;
+  }
+
+  /*
+   * @brief 将一个世界点投影到某一帧
+   * @param frame 帧序号
+   * @param X 世界坐标系下的点
+   * @param ignore_distortion 是否忽略畸变
+   */
+  Vec2 Project(const size_t frame, const Vec3 &X, const bool ignore_distortion = false) const {
+    return model_.project(Rotation(frame) * (X - Center(frame)), ignore_distortion);
+  }
+
+  /*
+   * @brief 将一组世界点投影到某一帧
+   * @param frame 帧序号
+   * @param X 世界坐标系下的点 (3xN)
+   * @param x 输出的像素坐标 (2xN), 需预先分配好大小
+   * @param ignore_distortion 是否忽略畸变
+   * @note 每 kBatchBlockSize 个点为一块, 相机坐标暂存在栈上, 不分配堆内存
+   */
+  void Project(const size_t frame, const Eigen::Ref<const Mat3X> &X, Eigen::Ref<Mat2X> x,
+               const bool ignore_distortion = false) const {
+    const Mat33 R = Rotation(frame);
+    const Vec3 C = Center(frame);
+    BlockPoints offsets, X_cam;
+    for (Eigen::Index start = 0; start < X.cols(); start += internal::kBatchBlockSize) {
+      const Eigen::Index n = std::min(internal::kBatchBlockSize, X.cols() - start);
+      // 矩阵乘积的操作数为表达式时 Eigen 会求值到堆上的临时变量, 先写入栈上的块
+      offsets = X.middleCols(start, n).colwise() - C;
+      X_cam.noalias() = R.lazyProduct(offsets);
+      auto x_block = x.middleCols(start, n);
+      model_.projectBatch(X_cam, x_block, ignore_distortion);
+    }
+  }
+
+  /*
+   * @brief 将同一个世界点投影到所有帧
+   * @param X 世界坐标系下的点
+   * @param x 输出的像素坐标 (2 x NumFrames), 需预先分配好大小
+   * @param ignore_distortion 是否忽略畸变
+   */
+  void ProjectAllFrames(const Vec3 &X, Eigen::Ref<Mat2X> x,
+                        const bool ignore_distortion = false) const {
+    const Eigen::Index num_frames = static_cast<Eigen::Index>(num_frames_);
+    BlockPoints X_cam;
+    for (Eigen::Index start = 0; start < num_frames; start += internal::kBatchBlockSize) {
+      X_cam.resize(3, std::min(internal::kBatchBlockSize, num_frames - start));
+      WorldToCameraFrames(X, start, X_cam);
+      auto x_block = x.middleCols(start, X_cam.cols());
+      model_.projectBatch(X_cam, x_block, ignore_distortion);
+    }
+  }
+  Mat2X ProjectAllFrames(const Vec3 &X, const bool ignore_distortion = false) const {
+    Mat2X x(2, num_frames_);
+    ProjectAllFrames(X, x, ignore_distortion);
+    return x;
+  }
+
+  /*
+   * @brief 所有帧上的重投影残差 x - project(X)
+   * @param X 世界坐标系下的点
+   * @param x 各帧中的观测 (2 x NumFrames)
+   * @param r 输出的残差 (2 x NumFrames), 需预先分配好大小
+   */
+  void ResidualAllFrames(const Vec3 &X, const Eigen::Ref<const Mat2X> &x, Eigen::Ref<Mat2X> r,
+                         const bool ignore_distortion = false) const {
+    ProjectAllFrames(X, r, ignore_distortion);
+    r = x - r;
+  }
 
 private:
+  typedef Eigen::Matrix<Scalar, 9, Eigen::Dynamic, Eigen::RowMajor> RotationStore;
+  typedef Eigen::Matrix<Scalar, 3, Eigen::Dynamic, Eigen::RowMajor> CenterStore;
+
+  // 最多 kBatchBlockSize 个点的相机坐标, 存放在栈上
+  typedef Eigen::Matrix<Scalar, 3, Eigen::Dynamic, Eigen::ColMajor, 3, internal::kBatchBlockSize>
+      BlockPoints;
+
+  size_t Capacity() const { return static_cast<size_t>(rotations_.cols()); }
+
+  // 将 X 变换到第 begin 帧起的 X_cam.cols() 帧, 逐行整体运算, 不产生临时数组
+  void WorldToCameraFrames(const Vec3 &X, const Eigen::Index begin, Eigen::Ref<Mat3X> X_cam) const {
+    const Eigen::Index n = X_cam.cols();
+    for (int r = 0; r < 3; ++r) {
+      X_cam.row(r).array() =
+          rotations_.row(r).segment(begin, n).array() *
+              (X.x() - centers_.row(0).segment(begin, n).array()) +
+          rotations_.row(3 + r).segment(begin, n).array() *
+              (X.y() - centers_.row(1).segment(begin, n).array()) +
+          rotations_.row(6 + r).segment(begin, n).array() *
+              (X.z() - centers_.row(2).segment(begin, n).array());
+    }
+  }
+
+  CameraModelT model_;
+  // 第 3 * c + r 行为所有帧的 R(r, c)
+  RotationStore rotations_;
+  // 第 i 行为所有帧相机中心的第 i 个分量
+  CenterStore centers_;
+  size_t num_frames_ = 0;
 };
-}
+
+} // namespace camera
 } // namespace photogrammetry
 
 #endif // PHOTOGRAMMETRY_CAMERA_HPP
@@ -3,17 +3,87 @@
 
 #include "camera/camera_parametres.hpp"
 #include "camera/std_types.hpp"
+#include "utils/profiler.hpp"
 #include <iostream>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace photogrammetry {
 namespace camera {
-template <typename Derived>
+
+namespace internal {
+// 批处理时每个块的列数, 块内数据以 SoA 形式暂存在栈上, 便于编译器向量化
+constexpr Eigen::Index kBatchBlockSize = 256;
+// 块内的一行数据(例如所有点的 x 分量), 最大尺寸固定, 不会分配堆内存
+template <typename T>
+using BatchRow = Eigen::Array<T, 1, Eigen::Dynamic, Eigen::RowMajor, 1, kBatchBlockSize>;
+
+// 取标量的数值部分, 用于统计信息等只需要数值的地方; ceres::Jet 取其实部
+template <typename T>
+inline double ScalarValue(const T &x) {
+  if constexpr (std::is_arithmetic<T>::value) {
+    return static_cast<double>(x);
+  } else {
+    return ScalarValue(x.a);
+  }
+}
+
+/*
+ * @brief 世界坐标系下的点经位姿变换后投影到归一化摄像机平面, 并求雅可比
+ * @param R, C 位姿 X_cam = R * (X - C)
+ * @param X 世界坐标系下的点
+ * @param J_point 可选, dp/dX (2x3)
+ * @param J_pose 可选, dp/d(w, C) (2x6), w 为左乘在 R 上的旋转向量扰动: R <- exp([w]x) * R
+ * @return 归一化摄像机平面上的点 p
+ */
+template <typename T>
+inline Vec2T<T> NormalizedPointJacobians(const Mat33T<T> &R, const Vec3T<T> &C, const Vec3T<T> &X,
+                                         Eigen::Matrix<T, 2, 3> *J_point,
+                                         Eigen::Matrix<T, 2, 6> *J_pose) {
+  const Vec3T<T> X_cam = R * (X - C);
+  const T inv_z = T(1) / X_cam.z();
+  const Vec2T<T> p(X_cam.x() * inv_z, X_cam.y() * inv_z);
+  if (J_point != nullptr || J_pose != nullptr) {
+    // dp/dX_cam
+    Eigen::Matrix<T, 2, 3> H;
+    H << inv_z, T(0), -p.x() * inv_z, T(0), inv_z, -p.y() * inv_z;
+    const Eigen::Matrix<T, 2, 3> H_R = H * R;
+    if (J_point != nullptr) {
+      *J_point = H_R;
+    }
+    if (J_pose != nullptr) {
+      // d(X_cam)/dw = -[X_cam]x, d(X_cam)/dC = -R
+      Mat33T<T> skew;
+      skew << T(0), -X_cam.z(), X_cam.y(), X_cam.z(), T(0), -X_cam.x(), -X_cam.y(), X_cam.x(),
+          T(0);
+      J_pose->template leftCols<3>() = -H * skew;
+      J_pose->template rightCols<3>() = -H_R;
+    }
+  }
+  return p;
+}
+} // namespace internal
+
+/*
+ * @brief 相机模型基类(CRTP)
+ * @tparam Derived 派生的相机模型
+ * @tparam T 标量类型: float 用于稠密图像处理(SIMD 通道数翻倍), double 为默认精度,
+ *           ceres::Jet 用于自动求导的光束法平差
+ */
+template <typename Derived, typename T = double>
 class CameraModel {
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  typedef T Scalar;
+  typedef Vec2T<T> Vec2;
+  typedef Vec3T<T> Vec3;
+  typedef Mat34T<T> Mat34;
+  typedef Mat2XT<T> Mat2X;
+  typedef Mat3XT<T> Mat3X;
+  // 批量雅可比按行优先存储, 每个点的两行连续
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> JacobianMatrix;
 
   CameraModel(const camera_t camera_id = UINvaliedCameraId, const size_t width = 0,
               const size_t height = 0)
@@ -22,7 +92,7 @@ public:
   ~CameraModel() = default;
 
   inline bool InitCamera(const CameraParams *params) {
-    return static_cast<Derived *>(this)->InitCamera(params);
+    return derived().InitCamera(params);
   }
   inline camera_t CameraId() const { return camera_id_; }
   inline void SetCameraId(const camera_t camera_id) { camera_id_ = camera_id; }
@@ -33,65 +103,258 @@ public:
   inline void SetWidth(const size_t width) { width_ = width; }
   inline void SetHeight(const size_t height) { height_ = height; }
 
+  // 内参版本号, 每次 InitCamera/updateFromVariableParams 后递增; 只在同一对象内有意义,
+  // 不同相机或拷贝之间不可比较, 跨相机的缓存应使用 IntrinsicsKey
+  inline uint32_t ParamsVersion() const { return params_version_; }
+
   Vec2 project(const Vec3 &X, const bool ignore_distortion = false) const {
-    if (static_cast<Derived *>(this)->haveDistortion() &&
-        !ignore_distortion) // apply disto & intrinsics
+    if (derived().haveDistortion() && !ignore_distortion) // apply disto & intrinsics
     {
-      return static_cast<Derived *>(this)->cam2ima(
-          static_cast<Derived *>(this)->distort(X.hnormalized()));
+      return derived().cam2ima(derived().distort(X.hnormalized()));
     } else // apply intrinsics
     {
-      return static_cast<Derived *>(this)->cam2ima(X.hnormalized());
+      return derived().cam2ima(X.hnormalized());
     }
   }
 
   Vec2 residual(const Vec3 &X, const Vec2 &x, const bool ignore_distortion = false) const {
-    const Vec2 proj = static_cast<Derived *>(this)->project(X, ignore_distortion);
+    const Vec2 proj = derived().project(X, ignore_distortion);
     return x - proj;
   }
 
   // 纯虚函数：投影和反投影
-  Vec2 ima2cam(const Vec2 &point2d) const { return static_cast<Derived *>(this)->ima2cam(point2d); }
-  Vec2 cam2ima(const Vec2 &point2d) const { return static_cast<Derived *>(this)->cam2ima(point2d); }
-  bool haveDistortion() const { return static_cast<Derived *>(this)->haveDistortion(); }
+  Vec2 ima2cam(const Vec2 &point2d) const { return derived().ima2cam(point2d); }
+  Vec2 cam2ima(const Vec2 &point2d) const { return derived().cam2ima(point2d); }
+  bool haveDistortion() const { return derived().haveDistortion(); }
 
   // 获取变量参数
-  std::vector<double> getVariableParams() const {
-    return static_cast<Derived *>(this)->getVariableParams();
+  std::vector<T> getVariableParams() const {
+    return derived().getVariableParams();
   }
   // 纯虚函数：畸变校正
   Vec2 distort(const Vec2 &point_undistorted) const {
-    return static_cast<Derived *>(this)->distort(point_undistorted);
+    return derived().distort(point_undistorted);
   }
   Vec2 undistort(const Vec2 &point_distorted) const {
-    return static_cast<Derived *>(this)->undistort(point_distorted);
+    return derived().undistort(point_distorted);
   }
 
   // 相机类型
-  CameraModelType getType() const { return static_cast<Derived *>(this)->getType(); }
+  CameraModelType getType() const { return derived().getType(); }
   // Get bearing vectors from image coordinates
-  Mat3X operator()(const Mat2X &p) const { return static_cast<Derived *>(this)->operator()(p); }
+  Mat3X operator()(const Mat2X &p) const { return derived().operator()(p); }
   // get projection matrix
-  Mat34 ProjectionMatrix(const ExtrinsicParams &extrinsic_params) const {
-    return static_cast<Derived *>(this)->ProjectionMatrix(extrinsic_params);
+  Mat34 ProjectionMatrix(const CameraExtrinsicParams &extrinsic_params) const {
+    return derived().ProjectionMatrix(extrinsic_params);
   }
   // 验证相机参数是否符合模型要求
   bool VerifyModelSpecificParams() const {
-    return static_cast<Derived *>(this)->VerifyModelSpecificParams();
+    return derived().VerifyModelSpecificParams();
   }
 
-  bool updateFromVariableParams(const std::vector<double> &variable_params) {
-    return static_cast<Derived *>(this)->updateFromVariableParams(variable_params);
+  bool updateFromVariableParams(const std::vector<T> &variable_params) {
+    return derived().updateFromVariableParams(variable_params);
+  }
+  const std::string ParamsInfo() const { return derived().ParamsInfo(); }
+
+  /*
+   * @brief 批量投影
+   * @param X 相机坐标系下的三维点 (3xN)
+   * @param x 输出的像素坐标 (2xN), 需预先分配好大小
+   * @param ignore_distortion 是否忽略畸变
+   * @note 原始内存可以通过 Eigen::Map<const Mat3X>/Eigen::Map<Mat2X> 直接传入, 无需拷贝
+   */
+  void projectBatch(const Eigen::Ref<const Mat3X> &X, Eigen::Ref<Mat2X> x,
+                    const bool ignore_distortion = false) const {
+    PHOTOGRAMMETRY_PROFILE_SCOPE("camera/project_batch");
+    PHOTOGRAMMETRY_PROFILE_COUNT("camera/projected_points", X.cols());
+    derived().projectBatchKernel(X, x, ignore_distortion);
+  }
+  Mat2X projectBatch(const Mat3X &X, const bool ignore_distortion = false) const {
+    Mat2X x(2, X.cols());
+    projectBatch(X, x, ignore_distortion);
+    return x;
+  }
+
+  /*
+   * @brief 批量计算重投影残差 r = x - project(X)
+   * @param X 相机坐标系下的三维点 (3xN)
+   * @param x 观测到的像素坐标 (2xN)
+   * @param r 输出的残差 (2xN), 需预先分配好大小
+   * @param ignore_distortion 是否忽略畸变
+   */
+  void residualBatch(const Eigen::Ref<const Mat3X> &X, const Eigen::Ref<const Mat2X> &x,
+                     Eigen::Ref<Mat2X> r, const bool ignore_distortion = false) const {
+    projectBatch(X, r, ignore_distortion);
+    r = x - r;
+  }
+  Mat2X residualBatch(const Mat3X &X, const Mat2X &x, const bool ignore_distortion = false) const {
+    Mat2X r(2, X.cols());
+    residualBatch(X, x, r, ignore_distortion);
+    return r;
+  }
+
+  /*
+   * @brief 批量畸变/去畸变（在归一化摄像机平面上）
+   * @param points 输入点 (2xN)
+   * @param out 输出点 (2xN), 需预先分配好大小
+   */
+  void distortBatch(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    derived().distortBatchKernel(points, out);
+  }
+  Mat2X distortBatch(const Mat2X &points) const {
+    Mat2X out(2, points.cols());
+    distortBatch(points, out);
+    return out;
+  }
+  void undistortBatch(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    derived().undistortBatchKernel(points, out);
+  }
+  Mat2X undistortBatch(const Mat2X &points) const {
+    Mat2X out(2, points.cols());
+    undistortBatch(points, out);
+    return out;
+  }
+
+  /*
+   * @brief 批量计算投影及解析雅可比, 位姿相关的量每批只计算一次
+   * @param extrinsic_params 相机位姿
+   * @param X 世界坐标系下的三维点 (3xN)
+   * @param x 输出的像素坐标 (2xN), 需预先分配好大小
+   * @param J_point 可选, 输出 2N x 3, 第 2i 与 2i+1 行对应第 i 个点
+   * @param J_pose 可选, 输出 2N x 6, 参数化方式见 projectJacobian
+   * @param J_intrinsics 可选, 输出 2N x K, K 为 getVariableParams() 的长度
+   * @param adjust 需要优化的内参, 其余内参对应的列为 0
+   */
+  void projectJacobianBatch(const CameraExtrinsicParams &extrinsic_params,
+                            const Eigen::Ref<const Mat3X> &X, Eigen::Ref<Mat2X> x,
+                            JacobianMatrix *J_point, JacobianMatrix *J_pose,
+                            JacobianMatrix *J_intrinsics,
+                            const IntrinsicParameterType adjust =
+                                IntrinsicParameterType::ADJUST_ALL) const {
+    typedef typename Derived::IntrinsicJacobian IntrinsicJacobian;
+    const Mat33T<T> R = extrinsic_params.Rotation().template cast<T>();
+    const Vec3 C = extrinsic_params.Center().template cast<T>();
+    Eigen::Matrix<T, 2, 3> J_point_i;
+    Eigen::Matrix<T, 2, 6> J_pose_i;
+    IntrinsicJacobian J_intrinsics_i;
+    if (J_point != nullptr) {
+      J_point->resize(2 * X.cols(), 3);
+    }
+    if (J_pose != nullptr) {
+      J_pose->resize(2 * X.cols(), 6);
+    }
+    if (J_intrinsics != nullptr) {
+      J_intrinsics->resize(2 * X.cols(), IntrinsicJacobian::ColsAtCompileTime);
+    }
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      x.col(i) = derived().projectJacobian(
+          R, C, X.col(i), J_point != nullptr ? &J_point_i : nullptr,
+          J_pose != nullptr ? &J_pose_i : nullptr,
+          J_intrinsics != nullptr ? &J_intrinsics_i : nullptr, adjust);
+      if (J_point != nullptr) {
+        J_point->template middleRows<2>(2 * i) = J_point_i;
+      }
+      if (J_pose != nullptr) {
+        J_pose->template middleRows<2>(2 * i) = J_pose_i;
+      }
+      if (J_intrinsics != nullptr) {
+        J_intrinsics->template middleRows<2>(2 * i) = J_intrinsics_i;
+      }
+    }
+  }
+
+  // 默认的批处理内核：逐点调用, 派生类可以提供同名的向量化实现来覆盖
+  void projectBatchKernel(const Eigen::Ref<const Mat3X> &X, Eigen::Ref<Mat2X> x,
+                          const bool ignore_distortion) const {
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      x.col(i) = derived().project(X.col(i), ignore_distortion);
+    }
+  }
+  void distortBatchKernel(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    for (Eigen::Index i = 0; i < points.cols(); ++i) {
+      out.col(i) = derived().distort(points.col(i));
+    }
+  }
+  void undistortBatchKernel(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    for (Eigen::Index i = 0; i < points.cols(); ++i) {
+      out.col(i) = derived().undistort(points.col(i));
+    }
   }
-  const std::string ParamsInfo() const { return static_cast<Derived *>(this)->ParamsInfo(); }
 
 protected:
+  inline Derived &derived() { return *static_cast<Derived *>(this); }
+  inline const Derived &derived() const { return *static_cast<const Derived *>(this); }
+
   // 相机 ID
   camera_t camera_id_;
 
   // 图像宽度和高度
   size_t width_;
   size_t height_;
+
+  // 内参版本号
+  uint32_t params_version_ = 0;
+};
+
+/*
+ * @brief 依赖内参与图像尺寸的缓存的键
+ * 按模型类型、图像尺寸与内参的值比较, 不依赖相机 ID 或 ParamsVersion:
+ * 相同 ID 的不同相机, 以及拷贝后各自修改内参的相机都不会误用彼此的缓存。
+ * 比较只读取内参, 不分配内存。
+ */
+class IntrinsicsKey {
+public:
+  IntrinsicsKey() = default;
+
+  template <typename CameraType>
+  explicit IntrinsicsKey(const CameraType &camera)
+      : type_(camera.getType()), width_(camera.width()), height_(camera.height()) {
+    const auto &intrinsics = camera.Intrinsics();
+    params_.resize(4 + intrinsics.DistortionParams().size());
+    for (size_t i = 0; i < params_.size(); ++i) {
+      params_[i] = Param(intrinsics, i);
+    }
+  }
+
+  // camera 的模型类型、图像尺寸与内参是否与生成本键的相机完全相同
+  template <typename CameraType>
+  bool Matches(const CameraType &camera) const {
+    const auto &intrinsics = camera.Intrinsics();
+    if (type_ != camera.getType() || width_ != camera.width() || height_ != camera.height() ||
+        params_.size() != 4 + intrinsics.DistortionParams().size()) {
+      return false;
+    }
+    for (size_t i = 0; i < params_.size(); ++i) {
+      if (params_[i] != Param(intrinsics, i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  // 按 fx, fy, cx, cy, 畸变参数 的顺序取第 i 个内参
+  template <typename IntrinsicParams>
+  static double Param(const IntrinsicParams &intrinsics, const size_t i) {
+    switch (i) {
+    case 0:
+      return internal::ScalarValue(intrinsics.FocalLengthX());
+    case 1:
+      return internal::ScalarValue(intrinsics.FocalLengthY());
+    case 2:
+      return internal::ScalarValue(intrinsics.PrincipalPointX());
+    case 3:
+      return internal::ScalarValue(intrinsics.PrincipalPointY());
+    default:
+      return internal::ScalarValue(intrinsics.DistortionParams()[i - 4]);
+    }
+  }
+
+  CameraModelType type_ = CameraModelType::NONE;
+  size_t width_ = 0;
+  size_t height_ = 0;
+  std::vector<double> params_;
 };
 
 /*
@@ -100,8 +363,8 @@ protected:
  * @param model 相机模型
  * @return 输出流
  */
-template <typename Derived>
-std::ostream &operator<<(std::ostream &os, const CameraModel<Derived> &model) {
+template <typename Derived, typename T>
+std::ostream &operator<<(std::ostream &os, const CameraModel<Derived, T> &model) {
   os << model.ParamsInfo();
   return os;
 }
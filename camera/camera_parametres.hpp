@@ -2,6 +2,9 @@
 #define PHOTOGRAMMETRY_CAMERA_PARAMETRES_HPP
 
 #include "core/eigen_types.hpp"
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -36,9 +39,21 @@ enum class IntrinsicParameterType : int {
   ADJUST_ALL = ADJUST_FOCAL_LENGTH | ADJUST_PRINCIPAL_POINT | ADJUST_DISTORTION
 };
 
+inline IntrinsicParameterType operator|(IntrinsicParameterType lhs, IntrinsicParameterType rhs) {
+  return static_cast<IntrinsicParameterType>(static_cast<int>(lhs) | static_cast<int>(rhs));
+}
+
+// Whether the parameter group 'flag' is adjusted under the refinement option 'adjust'
+static inline bool isIntrinsicAdjusted(IntrinsicParameterType adjust,
+                                       IntrinsicParameterType flag) {
+  return (static_cast<int>(adjust) & static_cast<int>(flag)) != 0;
+}
+
 struct CameraParams {
   CameraModelType type_;
   CameraParams(const CameraModelType &type) : type_(type) {}
+  // 通过基类指针释放派生的初始化参数
+  virtual ~CameraParams() = default;
 };
 
 struct PinholeCameraInitParams : public CameraParams {
@@ -50,51 +65,130 @@ struct PinholeCameraInitParams : public CameraParams {
   PinholeCameraInitParams(const CameraModelType &type) : CameraParams(type) {}
 };
 
+/*
+ * @brief 针孔相机内参
+ * @tparam T 标量类型
+ * @tparam NumDistortionParams 畸变参数个数, 由相机模型在编译期确定
+ * @note 所有数据内联存储, 无堆内存分配, T 为算术类型时可平凡拷贝。
+ *       K 与 K^-1 在每次修改内参时重新计算并缓存, 读取时不再构造或求逆。
+ */
+template <typename T, size_t NumDistortionParams>
 class PinholeIntrinsicParams {
+public:
+  static constexpr size_t kNumDistortionParams = NumDistortionParams;
+  typedef std::array<T, NumDistortionParams> Distortion;
+  typedef Mat33T<T> Mat33;
+
 protected:
-  double fx_, fy_, cx_, cy_;
-  std::vector<double> distortion_;
+  T fx_ = T(1), fy_ = T(1), cx_ = T(0), cy_ = T(0);
+  Distortion distortion_{};
+  // 缓存的 K 与 K^-1, 列优先存储
+  std::array<T, 9> intrinsic_matrix_{};
+  std::array<T, 9> inverse_intrinsic_matrix_{};
+
+  // 根据 fx, fy, cx, cy 重新计算 K 与 K^-1
+  inline void UpdateIntrinsicMatrix() {
+    const T zero(0), one(1);
+    intrinsic_matrix_ = {fx_, zero, zero, zero, fy_, zero, cx_, cy_, one};
+    inverse_intrinsic_matrix_ = {one / fx_, zero, zero, zero, one / fy_, zero, -cx_ / fx_,
+                                 -cy_ / fy_, one};
+  }
 
 public:
-  PinholeIntrinsicParams() noexcept = default;
+  PinholeIntrinsicParams() noexcept { UpdateIntrinsicMatrix(); }
+  // params 能否初始化本内参: 针孔模型且畸变参数个数一致, 不取得所有权
+  static bool IsValidInitParams(const CameraParams *params) {
+    return params != nullptr && isPinhole(params->type_) &&
+           static_cast<const PinholeCameraInitParams *>(params)->distortion.size() ==
+               NumDistortionParams;
+  }
+  /*
+   * @brief 用初始化参数设置内参
+   * @param params 所有权转移给本函数, 无论成功与否都会被释放
+   * @return 参数无效时返回 false, 内参保持不变
+   */
   bool InitCamera(const CameraParams *params) {
-    if (isPinhole(params->type_)) {
-      const auto &pinhole_params = static_cast<const PinholeCameraInitParams *>(params);
-      this->SetFocalLengthX(pinhole_params->fx);
-      this->SetFocalLengthY(pinhole_params->fy);
-      this->SetPrincipalPointX(pinhole_params->cx);
-      this->SetPrincipalPointY(pinhole_params->cy);
-      this->SetDistortion(pinhole_params->distortion);
-      delete params;
-      return true;
+    const std::unique_ptr<const CameraParams> owned(params);
+    if (!IsValidInitParams(params)) {
+      return false;
     }
-    return false;
+    const auto *pinhole_params = static_cast<const PinholeCameraInitParams *>(params);
+    this->SetFocalLengthX(T(pinhole_params->fx));
+    this->SetFocalLengthY(T(pinhole_params->fy));
+    this->SetPrincipalPointX(T(pinhole_params->cx));
+    this->SetPrincipalPointY(T(pinhole_params->cy));
+    this->SetDistortion(pinhole_params->distortion.data());
+    return true;
+  }
+  inline T MeanFocalLength() const { return (fx_ + fy_) / T(2); }
+  inline T FocalLengthX() const { return fx_; }
+  inline T FocalLengthY() const { return fy_; }
+  inline void SetFocalLength(const T focal_length) {
+    fx_ = fy_ = focal_length;
+    UpdateIntrinsicMatrix();
+  }
+  inline void SetFocalLengthX(const T focal_length_x) {
+    fx_ = focal_length_x;
+    UpdateIntrinsicMatrix();
+  }
+  inline void SetFocalLengthY(const T focal_length_y) {
+    fy_ = focal_length_y;
+    UpdateIntrinsicMatrix();
   }
-  inline double MeanFocalLength() const { return (fx_ + fy_) / 2.0; }
-  inline double FocalLengthX() const { return fx_; }
-  inline double FocalLengthY() const { return fy_; }
-  inline void SetFocalLength(const double focal_length) { fx_ = fy_ = focal_length; }
-  inline void SetFocalLengthX(const double focal_length_x) { fx_ = focal_length_x; }
-  inline void SetFocalLengthY(const double focal_length_y) { fy_ = focal_length_y; }
 
-  inline double PrincipalPointX() const { return cx_; }
-  inline double PrincipalPointY() const { return cy_; }
-  inline void SetPrincipalPoint(const double cx, const double cy) { cx_ = cx; }
-  inline void SetPrincipalPointX(const double cx) { cx_ = cx; }
-  inline void SetPrincipalPointY(const double cy) { cy_ = cy; }
+  inline T PrincipalPointX() const { return cx_; }
+  inline T PrincipalPointY() const { return cy_; }
+  inline void SetPrincipalPoint(const T cx, const T cy) {
+    cx_ = cx;
+    cy_ = cy;
+    UpdateIntrinsicMatrix();
+  }
+  inline void SetPrincipalPointX(const T cx) {
+    cx_ = cx;
+    UpdateIntrinsicMatrix();
+  }
+  inline void SetPrincipalPointY(const T cy) {
+    cy_ = cy;
+    UpdateIntrinsicMatrix();
+  }
 
-  inline void SetDistortion(const std::vector<double> &distortion) { distortion_ = distortion; }
-  inline std::vector<double> DistortionParams() const { return distortion_; }
-  inline std::vector<double> &DistortionParams() { return distortion_; }
+  // 从连续内存中拷贝 NumDistortionParams 个畸变参数, 必要时转换标量类型
+  template <typename U>
+  inline void SetDistortion(const U *distortion) {
+    for (size_t i = 0; i < NumDistortionParams; ++i) {
+      distortion_[i] = T(distortion[i]);
+    }
+  }
+  inline void SetDistortion(const Distortion &distortion) { distortion_ = distortion; }
+  inline const Distortion &DistortionParams() const { return distortion_; }
 
-  inline const Mat33 IntrinsicMatrix() const {
-    return (Mat33() << fx_, 0, cx_, 0, fy_, cy_, 0, 0, 1).finished();
+  inline Eigen::Map<const Mat33> IntrinsicMatrix() const {
+    return Eigen::Map<const Mat33>(intrinsic_matrix_.data());
   }
-  inline Mat33 &IntrinsicMatrix() {
-    return (Mat33() << fx_, 0, cx_, 0, fy_, cy_, 0, 0, 1).finished();
+  inline Eigen::Map<const Mat33> InverseIntrinsicMatrix() const {
+    return Eigen::Map<const Mat33>(inverse_intrinsic_matrix_.data());
   }
 
-  inline const Mat33 InverseIntrinsicMatrix() const { return IntrinsicMatrix().inverse(); }
+  /*
+   * @brief 在优化选项 adjust 下保持不变的内参下标
+   * @param adjust 需要优化的内参
+   * @return 下标按 fx, fy, cx, cy, 畸变参数 的顺序 (与相机模型的 getVariableParams 一致)
+   */
+  static std::vector<int> ConstantParamIndices(const IntrinsicParameterType adjust) {
+    std::vector<int> indices;
+    if (!isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_FOCAL_LENGTH)) {
+      indices.insert(indices.end(), {0, 1});
+    }
+    if (!isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_PRINCIPAL_POINT)) {
+      indices.insert(indices.end(), {2, 3});
+    }
+    if (!isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_DISTORTION)) {
+      for (size_t i = 0; i < NumDistortionParams; ++i) {
+        indices.push_back(static_cast<int>(4 + i));
+      }
+    }
+    return indices;
+  }
 
   const std::string ParamsInfo() const {
     std::stringstream ss;
@@ -103,7 +197,6 @@ public:
        << ")\n";
     return ss.str();
   }
-  ~PinholeIntrinsicParams() noexcept = default;
 };
 
 /*
@@ -172,7 +265,7 @@ public:
 
   // 对 Vec3 进行偏特化
   inline Vec3 operator()(const Vec3 &other) const {
-    return rotation_.transpose() * (other + center_);
+    return rotation_ * (other - center_);
   }
 };
 
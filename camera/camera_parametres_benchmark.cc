@@ -0,0 +1,62 @@
+#include "camera/camera_parametres.hpp"
+#include <benchmark/benchmark.h>
+
+using namespace photogrammetry::camera;
+
+namespace {
+CameraExtrinsicParams MakePose(const double angle) {
+  return CameraExtrinsicParams(
+      Eigen::AngleAxisd(angle, Vec3(0.2, -1.0, 0.5).normalized()).toRotationMatrix(),
+      Vec3(0.4, -0.3, -0.5));
+}
+} // namespace
+
+// 逐点变换到相机坐标系, 走 Vec3 特化
+static void BM_ExtrinsicTransformPerPoint(benchmark::State &state) {
+  const CameraExtrinsicParams pose = MakePose(0.3);
+  const Mat3X X = Mat3X::Random(3, state.range(0));
+  Mat3X X_cam(3, X.cols());
+  for (auto _ : state) {
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      X_cam.col(i) = pose(Vec3(X.col(i)));
+    }
+    benchmark::DoNotOptimize(X_cam.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+static void BM_ExtrinsicTransformBatch(benchmark::State &state) {
+  const CameraExtrinsicParams pose = MakePose(0.3);
+  const Mat3X X = Mat3X::Random(3, state.range(0));
+  for (auto _ : state) {
+    Mat3X X_cam = pose(X);
+    benchmark::DoNotOptimize(X_cam.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+static void BM_ExtrinsicCompose(benchmark::State &state) {
+  const CameraExtrinsicParams a = MakePose(0.3);
+  const CameraExtrinsicParams b = MakePose(-0.7);
+  for (auto _ : state) {
+    CameraExtrinsicParams c = a * b;
+    benchmark::DoNotOptimize(c.Rotation().data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ExtrinsicMatrix(benchmark::State &state) {
+  const CameraExtrinsicParams pose = MakePose(0.3);
+  for (auto _ : state) {
+    Mat34 Rt = pose.getExtrinsicMatrix();
+    benchmark::DoNotOptimize(Rt.data());
+    Mat34 inverse = pose.getInverseMatrix();
+    benchmark::DoNotOptimize(inverse.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ExtrinsicTransformPerPoint)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_ExtrinsicTransformBatch)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_ExtrinsicCompose);
+BENCHMARK(BM_ExtrinsicMatrix);
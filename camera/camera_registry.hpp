@@ -0,0 +1,217 @@
+#ifndef PHOTOGRAMMETRY_CAMERA_REGISTRY_HPP
+#define PHOTOGRAMMETRY_CAMERA_REGISTRY_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "camera/camera_type.hpp"
+#include "camera/pinhole_model.hpp"
+#include "camera/std_types.hpp"
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace photogrammetry {
+namespace camera {
+
+// 运行时可持有的全部相机模型, 新增模型时在此追加即可 (模型需提供静态成员 kModelType)
+typedef std::variant<PinholeCameraModel, PinholeCameraBrown> AnyCameraModel;
+
+namespace internal {
+template <typename Variant>
+struct ModelVectors;
+template <typename... Models>
+struct ModelVectors<std::variant<Models...>> {
+  typedef std::tuple<std::vector<Models>...> type;
+};
+
+// 模型 Model 在 Variant 中的下标
+template <typename Model, typename Variant, size_t I = 0>
+constexpr size_t ModelIndex() {
+  static_assert(I < std::variant_size<Variant>::value, "Model is not part of AnyCameraModel");
+  if constexpr (std::is_same<Model, std::variant_alternative_t<I, Variant>>::value) {
+    return I;
+  } else {
+    return ModelIndex<Model, Variant, I + 1>();
+  }
+}
+
+template <typename Variant, size_t I = 0>
+std::optional<Variant> CreateModel(const camera_t camera_id, const size_t width,
+                                   const size_t height, const CameraParams *params) {
+  if constexpr (I == std::variant_size<Variant>::value) {
+    delete params;
+    return std::nullopt;
+  } else {
+    typedef std::variant_alternative_t<I, Variant> Model;
+    if (params != nullptr && params->type_ == Model::kModelType) {
+      // 先检查参数, 构造函数不会因参数无效而抛出异常
+      if (!Model::IntrinsicParams::IsValidInitParams(params)) {
+        delete params;
+        return std::nullopt;
+      }
+      return Variant(std::in_place_index<I>, camera_id, width, height, params);
+    }
+    return CreateModel<Variant, I + 1>(camera_id, width, height, params);
+  }
+}
+} // namespace internal
+
+/*
+ * @brief 按 CameraModelType 创建相机模型
+ * @param params 初始化参数, 与模型构造函数一致, 所有权转移给本函数, 任何情况下都会被释放
+ * @return 类型未注册或参数与模型不匹配(如畸变参数个数不一致)时返回空
+ */
+inline std::optional<AnyCameraModel> CreateCameraModel(const camera_t camera_id, const size_t width,
+                                                       const size_t height,
+                                                       const CameraParams *params) {
+  return internal::CreateModel<AnyCameraModel>(camera_id, width, height, params);
+}
+
+// 相机类型名(kCameraType)对应的模型类型, 尚未实现的模型返回 NONE
+inline CameraModelType CameraModelTypeFromCameraType(const kCameraType type) {
+  switch (type) {
+  case kCameraType::CameraSimplePinholeModel:
+    return CameraModelType::PINHOLE_CAMERA;
+  case kCameraType::CameraBrownConradyDistortionPinholeModel:
+    return CameraModelType::PINHOLE_CAMERA_BROWN;
+  default:
+    return CameraModelType::NONE;
+  }
+}
+
+inline CameraModelType GetModelType(const AnyCameraModel &model) {
+  return std::visit([](const auto &camera) { return camera.getType(); }, model);
+}
+
+/*
+ * @brief 异构相机集合
+ * 每种模型各自存放在一个连续的 std::vector 中, 按相机 ID 查找时只做一次类型分派,
+ * 回调拿到的是具体模型类型, 批处理内核可以完全内联, 逐点不再有虚函数调用。
+ */
+class CameraRegistry {
+public:
+  typedef internal::ModelVectors<AnyCameraModel>::type ModelVectors;
+  static constexpr size_t kNumModelTypes = std::variant_size<AnyCameraModel>::value;
+
+private:
+  struct Handle {
+    size_t type_index;
+    size_t index;
+  };
+
+  template <size_t I, typename Func, typename Vectors>
+  static decltype(auto) VisitImpl(const Handle &handle, Func &&func, Vectors &models) {
+    if constexpr (I + 1 == kNumModelTypes) {
+      return func(std::get<I>(models)[handle.index]);
+    } else {
+      if (handle.type_index == I) {
+        return func(std::get<I>(models)[handle.index]);
+      }
+      return VisitImpl<I + 1>(handle, std::forward<Func>(func), models);
+    }
+  }
+
+public:
+  /*
+   * @brief 对某个相机调用 func(具体模型), 只做一次类型分派
+   * @note 相机不存在时抛出 std::out_of_range
+   */
+  template <typename Func>
+  decltype(auto) Visit(const camera_t camera_id, Func &&func) const {
+    const Handle &handle = handles_.at(camera_id);
+    return VisitImpl<0>(handle, std::forward<Func>(func), models_);
+  }
+  template <typename Func>
+  decltype(auto) Visit(const camera_t camera_id, Func &&func) {
+    const Handle &handle = handles_.at(camera_id);
+    return VisitImpl<0>(handle, std::forward<Func>(func), models_);
+  }
+
+  /*
+   * @brief 添加相机, 相机 ID 取自模型
+   * @return 相机 ID 已存在时返回 false
+   */
+  template <typename Model>
+  bool Add(const Model &model) {
+    constexpr size_t type_index = internal::ModelIndex<Model, AnyCameraModel>();
+    std::vector<Model> &models = std::get<type_index>(models_);
+    if (!handles_.emplace(model.CameraId(), Handle{type_index, models.size()}).second) {
+      return false;
+    }
+    models.push_back(model);
+    return true;
+  }
+  bool Add(const AnyCameraModel &model) {
+    return std::visit([this](const auto &camera) { return Add(camera); }, model);
+  }
+
+  /*
+   * @brief 按 CameraModelType 创建并添加相机
+   * @param params 初始化参数, 所有权转移给本函数
+   * @return 类型未注册、参数无效或相机 ID 已存在时返回 false
+   */
+  bool Create(const camera_t camera_id, const size_t width, const size_t height,
+              const CameraParams *params) {
+    const std::optional<AnyCameraModel> model =
+        CreateCameraModel(camera_id, width, height, params);
+    return model.has_value() && Add(*model);
+  }
+
+  bool Contains(const camera_t camera_id) const { return handles_.count(camera_id) > 0; }
+  size_t Size() const { return handles_.size(); }
+
+  CameraModelType Type(const camera_t camera_id) const {
+    return Visit(camera_id, [](const auto &camera) { return camera.getType(); });
+  }
+
+  // 对所有相机调用 func(具体模型), 同类型的相机连续访问
+  template <typename Func>
+  void ForEach(Func &&func) const {
+    std::apply(
+        [&func](const auto &...models) {
+          (..., [&func](const auto &vector) {
+            for (const auto &model : vector) {
+              func(model);
+            }
+          }(models));
+        },
+        models_);
+  }
+
+  // 某种模型的全部相机, 连续存放
+  template <typename Model>
+  const std::vector<Model> &ModelsOfType() const {
+    return std::get<internal::ModelIndex<Model, AnyCameraModel>()>(models_);
+  }
+
+  // 批量投影, 见 CameraModel::projectBatch
+  void projectBatch(const camera_t camera_id, const Eigen::Ref<const Mat3X> &X,
+                    Eigen::Ref<Mat2X> x, const bool ignore_distortion = false) const {
+    Visit(camera_id, [&](const auto &camera) { camera.projectBatch(X, x, ignore_distortion); });
+  }
+
+  // 批量残差, 见 CameraModel::residualBatch
+  void residualBatch(const camera_t camera_id, const Eigen::Ref<const Mat3X> &X,
+                     const Eigen::Ref<const Mat2X> &x, Eigen::Ref<Mat2X> r,
+                     const bool ignore_distortion = false) const {
+    Visit(camera_id, [&](const auto &camera) { camera.residualBatch(X, x, r, ignore_distortion); });
+  }
+
+  // 批量去畸变, 见 CameraModel::undistortBatch
+  void undistortBatch(const camera_t camera_id, const Eigen::Ref<const Mat2X> &points,
+                      Eigen::Ref<Mat2X> out) const {
+    Visit(camera_id, [&](const auto &camera) { camera.undistortBatch(points, out); });
+  }
+
+private:
+  ModelVectors models_;
+  Hash_Map<camera_t, Handle> handles_;
+};
+
+} // namespace camera
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_CAMERA_REGISTRY_HPP
@@ -0,0 +1,80 @@
+#include "camera/camera_registry.hpp"
+#include <gtest/gtest.h>
+
+using namespace photogrammetry;
+using namespace photogrammetry::camera;
+
+namespace {
+PinholeCameraInitParams *MakeParams(const CameraModelType type) {
+  auto *params = new PinholeCameraInitParams(type);
+  params->fx = 1000.0;
+  params->fy = 1010.0;
+  params->cx = 640.0;
+  params->cy = 480.0;
+  if (type == CameraModelType::PINHOLE_CAMERA_BROWN) {
+    params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+  }
+  return params;
+}
+} // namespace
+
+TEST(CameraRegistryTest, FactoryCreatesModelByType) {
+  const auto pinhole =
+      CreateCameraModel(0, 1280, 960, MakeParams(CameraModelType::PINHOLE_CAMERA));
+  ASSERT_TRUE(pinhole.has_value());
+  EXPECT_TRUE(std::holds_alternative<PinholeCameraModel>(*pinhole));
+  EXPECT_EQ(GetModelType(*pinhole), CameraModelType::PINHOLE_CAMERA);
+
+  const auto brown =
+      CreateCameraModel(1, 1280, 960, MakeParams(CameraModelType::PINHOLE_CAMERA_BROWN));
+  ASSERT_TRUE(brown.has_value());
+  EXPECT_TRUE(std::holds_alternative<PinholeCameraBrown>(*brown));
+  EXPECT_EQ(GetModelType(*brown), CameraModelType::PINHOLE_CAMERA_BROWN);
+
+  EXPECT_FALSE(
+      CreateCameraModel(2, 1280, 960, MakeParams(CameraModelType::PINHOLE_CAMERA_RADIAL1)));
+  // 类型匹配但畸变参数个数不一致
+  PinholeCameraInitParams *mismatched = MakeParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  mismatched->distortion.pop_back();
+  EXPECT_FALSE(CreateCameraModel(3, 1280, 960, mismatched));
+  EXPECT_FALSE(CreateCameraModel(4, 1280, 960, nullptr));
+  EXPECT_EQ(CameraModelTypeFromCameraType(kCameraType::CameraBrownConradyDistortionPinholeModel),
+            CameraModelType::PINHOLE_CAMERA_BROWN);
+}
+
+TEST(CameraRegistryTest, DispatchesOncePerBatch) {
+  CameraRegistry registry;
+  for (camera_t camera_id = 0; camera_id < 10; ++camera_id) {
+    const CameraModelType type = camera_id % 2 == 0 ? CameraModelType::PINHOLE_CAMERA
+                                                    : CameraModelType::PINHOLE_CAMERA_BROWN;
+    ASSERT_TRUE(registry.Create(camera_id, 1280, 960, MakeParams(type)));
+  }
+  EXPECT_FALSE(registry.Create(3, 1280, 960, MakeParams(CameraModelType::PINHOLE_CAMERA)));
+  PinholeCameraInitParams *mismatched = MakeParams(CameraModelType::PINHOLE_CAMERA);
+  mismatched->distortion = {0.1};
+  EXPECT_FALSE(registry.Create(10, 1280, 960, mismatched));
+  EXPECT_EQ(registry.Size(), 10u);
+  EXPECT_EQ(registry.ModelsOfType<PinholeCameraModel>().size(), 5u);
+  EXPECT_EQ(registry.ModelsOfType<PinholeCameraBrown>().size(), 5u);
+  EXPECT_EQ(registry.Type(4), CameraModelType::PINHOLE_CAMERA);
+  EXPECT_EQ(registry.Type(7), CameraModelType::PINHOLE_CAMERA_BROWN);
+
+  Mat3X X = Mat3X::Random(3, 100);
+  X.row(2).array() += 3.0;
+  Mat2X x(2, X.cols());
+  registry.projectBatch(7, X, x);
+  const PinholeCameraBrown brown(7, 1280, 960, MakeParams(CameraModelType::PINHOLE_CAMERA_BROWN));
+  EXPECT_TRUE(x.isApprox(brown.projectBatch(X), 1e-12));
+
+  Mat2X r(2, X.cols());
+  registry.residualBatch(7, X, x, r);
+  EXPECT_LT(r.cwiseAbs().maxCoeff(), 1e-9);
+
+  size_t num_visited = 0;
+  registry.ForEach([&num_visited](const auto &camera) {
+    EXPECT_EQ(camera.width(), 1280u);
+    ++num_visited;
+  });
+  EXPECT_EQ(num_visited, registry.Size());
+  EXPECT_THROW(registry.Type(42), std::out_of_range);
+}
@@ -0,0 +1,77 @@
+#include "camera/camera.hpp"
+#include "camera/pinhole_model.hpp"
+#include <gtest/gtest.h>
+
+using namespace photogrammetry::camera;
+
+class CameraTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+    params->fx = 1000.0;
+    params->fy = 1010.0;
+    params->cx = 640.0;
+    params->cy = 480.0;
+    params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+    camera_ =
+        std::make_unique<Camera<PinholeCameraBrown>>(PinholeCameraBrown(0, 1280, 960, params));
+    for (int i = 0; i < 100; ++i) {
+      poses_.emplace_back(
+          Eigen::AngleAxisd(0.01 * i, Vec3(0.2, 1.0, -0.3).normalized()).toRotationMatrix(),
+          Vec3(0.05 * i, -0.02 * i, -5.0));
+      camera_->AddFrame(poses_.back());
+    }
+  }
+
+  std::unique_ptr<Camera<PinholeCameraBrown>> camera_;
+  std::vector<CameraExtrinsicParams> poses_;
+};
+
+TEST_F(CameraTest, StoresPosesPerFrame) {
+  ASSERT_EQ(camera_->NumFrames(), poses_.size());
+  for (size_t i = 0; i < poses_.size(); ++i) {
+    EXPECT_EQ(camera_->Rotation(i), poses_[i].Rotation());
+    EXPECT_EQ(camera_->Center(i), poses_[i].Center());
+  }
+  camera_->SetPose(3, poses_[7]);
+  EXPECT_EQ(camera_->Pose(3).Rotation(), poses_[7].Rotation());
+  EXPECT_EQ(camera_->Pose(3).Center(), poses_[7].Center());
+}
+
+TEST_F(CameraTest, AllFramesMatchPerFrameProjection) {
+  const Vec3 X(0.3, -0.4, 1.0);
+  const Mat3X X_cam = camera_->WorldToCameraAllFrames(X);
+  const Mat2X x = camera_->ProjectAllFrames(X);
+  for (size_t i = 0; i < poses_.size(); ++i) {
+    EXPECT_TRUE(X_cam.col(i).isApprox(poses_[i](X), 1e-12));
+    EXPECT_TRUE(x.col(i).isApprox(camera_->Model().project(poses_[i](X)), 1e-12));
+  }
+  Mat2X r(2, poses_.size());
+  camera_->ResidualAllFrames(X, x, r);
+  EXPECT_LT(r.cwiseAbs().maxCoeff(), 1e-9);
+}
+
+TEST_F(CameraTest, ProjectPointSetIntoFrame) {
+  Mat3X X = Mat3X::Random(3, 500);
+  X.row(2).array() += 1.0;
+  Mat2X x(2, X.cols());
+  camera_->Project(42, X, x);
+  for (Eigen::Index j = 0; j < X.cols(); ++j) {
+    EXPECT_TRUE(x.col(j).isApprox(camera_->Model().project(poses_[42](Vec3(X.col(j)))), 1e-12));
+  }
+}
+
+TEST_F(CameraTest, ProjectAcrossBlocks) {
+  // 帧数超过一个批处理块
+  for (int i = 100; i < 600; ++i) {
+    camera_->AddFrame(poses_[i % 100]);
+  }
+  const Vec3 X(-0.2, 0.1, 0.5);
+  const Mat2X x = camera_->ProjectAllFrames(X);
+  ASSERT_EQ(x.cols(), 600);
+  for (size_t i = 0; i < camera_->NumFrames(); ++i) {
+    const Vec2 expected = camera_->Model().project(poses_[i % 100](X));
+    EXPECT_TRUE(x.col(i).isApprox(expected, 1e-12)) << i;
+    EXPECT_TRUE(camera_->Project(i, X).isApprox(expected, 1e-12)) << i;
+  }
+}
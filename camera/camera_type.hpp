@@ -2,6 +2,7 @@
 #define PHOTOGRAMMETRY_CAMERA_TYPE_HPP
 
 #include "utils/know_enum.hpp"
+#include <string_view>
 
 namespace photogrammetry {
 namespace camera {
@@ -19,16 +20,16 @@ enum class kCameraType {
  * @param kCameraType type
  * @return true or false
  */
-bool is_camera_type_valid(kCameraType const &type) {
+inline bool is_camera_type_valid(kCameraType const &type) {
   return type >= kCameraType::CameraSimplePinholeModel && type <= kCameraType::CameraFisheyeModel;
 }
 
 /**
  * @brief Get the camera type name from the enum value
  * @param kCameraType type
- * @return std::string
+ * @return std::string_view
  */
-std::string get_camera_type_name(kCameraType const &type) {
+inline std::string_view get_camera_type_name(kCameraType const &type) {
   return photogrammetry::utils::get_enum_name(type);
 }
 
@@ -37,9 +38,10 @@ std::string get_camera_type_name(kCameraType const &type) {
  * @param kCameraType type
  * @return true or false
  */
-bool is_camera_model_name_valid(std::string const &camera_model_name) {
-  auto const camera_type = photogrammetry::utils::enum_from_name<kCameraType>(camera_model_name);
-  return is_camera_type_valid(camera_type);
+inline bool is_camera_model_name_valid(std::string_view const camera_model_name) {
+  kCameraType camera_type;
+  return photogrammetry::utils::try_enum_from_name(camera_model_name, &camera_type) &&
+         is_camera_type_valid(camera_type);
 }
 
 /**
@@ -47,7 +49,8 @@ bool is_camera_model_name_valid(std::string const &camera_model_name) {
  * @param kCameraType type
  * @return kCameraType
  */
-kCameraType get_camera_type_from_camera_model_name(std::string const &camera_model_name) {
+inline kCameraType get_camera_type_from_camera_model_name(
+    std::string_view const camera_model_name) {
   return photogrammetry::utils::enum_from_name<kCameraType>(camera_model_name);
 }
 } // namespace camera
@@ -14,6 +14,32 @@ enum class DistortionParamsIdx {
   IDX_DISTORTION_T2 = 8,
 };
 
+// 迭代去畸变的结果状态
+enum class UndistortStatus {
+  CONVERGED = 0,     // 残差小于容差
+  NO_CONVERGENCE,    // 达到最大迭代次数仍未收敛
+  SINGULAR_JACOBIAN, // 畸变函数的雅可比矩阵奇异(畸变模型在该点折叠)
+};
+
+// 迭代去畸变的终止条件
+struct UndistortOptions {
+  // 最大迭代次数
+  int max_iterations = 20;
+  // 收敛容差, 为 |distort(p_u) - p_d| 的曼哈顿距离(归一化摄像机平面)
+  double tolerance = 1e-10;
+};
+
+// 迭代去畸变的统计信息
+struct UndistortSummary {
+  UndistortStatus status = UndistortStatus::CONVERGED;
+  // 实际迭代次数(批处理时为最大值)
+  int iterations = 0;
+  // 最终残差(批处理时为最大值)
+  double residual = 0.0;
+  // 批处理时收敛的点数
+  size_t num_converged = 0;
+};
+
 } // namespace camera
 } // namespace photogrammetry
 #endif // PHOTOGRAMMETRY_DISTORTION_MODEL_HPP
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "camera/std_types.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+using namespace photogrammetry;
+
+namespace {
+// Image pairs of a sequential capture: every image is matched to its next neighbours, so the
+// ids are small and (a,b) and (b,a) patterns are frequent
+std::vector<Pair> MakePairs(const size_t num_pairs) {
+  std::vector<Pair> pairs;
+  pairs.reserve(num_pairs);
+  for (camera_t a = 0; pairs.size() < num_pairs; ++a) {
+    for (camera_t d = 1; d <= 20 && pairs.size() < num_pairs; ++d) {
+      pairs.emplace_back(a, a + d);
+    }
+  }
+  return pairs;
+}
+
+std::vector<point3D_t> MakePointIds(const size_t num_points) {
+  std::vector<point3D_t> ids(num_points);
+  std::mt19937_64 rng(7);
+  for (point3D_t &id : ids) {
+    id = rng() % (8 * num_points);
+  }
+  return ids;
+}
+
+// Inputs are cached so that their creation is not timed
+template <typename Key>
+const std::vector<Key> &Keys(const size_t n);
+
+template <>
+const std::vector<Pair> &Keys<Pair>(const size_t n) {
+  static std::vector<Pair> pairs;
+  if (pairs.size() != n) {
+    pairs = MakePairs(n);
+  }
+  return pairs;
+}
+
+template <>
+const std::vector<point3D_t> &Keys<point3D_t>(const size_t n) {
+  static std::vector<point3D_t> ids;
+  if (ids.size() != n) {
+    ids = MakePointIds(n);
+  }
+  return ids;
+}
+
+template <typename Map>
+Map MakeMap(const std::vector<typename Map::key_type> &keys) {
+  Map map;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    map[keys[i]] = i;
+  }
+  return map;
+}
+
+typedef Hash_Map<Pair, size_t> PairHashMap;
+typedef Flat_Hash_Map<Pair, size_t> PairFlatHashMap;
+typedef Hash_Map<point3D_t, size_t> PointHashMap;
+typedef Flat_Hash_Map<point3D_t, size_t> PointFlatHashMap;
+} // namespace
+
+template <typename Map>
+static void BM_Insert(benchmark::State &state) {
+  const auto &keys = Keys<typename Map::key_type>(state.range(0));
+  for (auto _ : state) {
+    Map map = MakeMap<Map>(keys);
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Only the first half of the keys is in the map, half of the lookups miss
+template <typename Map>
+static void BM_Lookup(benchmark::State &state) {
+  typedef typename Map::key_type Key;
+  const std::vector<Key> &keys = Keys<Key>(state.range(0));
+  const Map map = MakeMap<Map>(std::vector<Key>(keys.begin(), keys.begin() + keys.size() / 2));
+  for (auto _ : state) {
+    size_t num_found = 0;
+    for (const Key &key : keys) {
+      num_found += map.find(key) != map.end() ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(num_found);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Map>
+static void BM_Iterate(benchmark::State &state) {
+  const Map map = MakeMap<Map>(Keys<typename Map::key_type>(state.range(0)));
+  for (auto _ : state) {
+    size_t sum = 0;
+    for (const auto &item : map) {
+      sum += item.second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * map.size());
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, PairHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, PairFlatHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, PointHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, PointFlatHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Lookup, PairHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Lookup, PairFlatHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Lookup, PointHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Lookup, PointFlatHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Iterate, PairHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Iterate, PairFlatHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Iterate, PointHashMap)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Iterate, PointFlatHashMap)->Range(1 << 10, 1 << 20);
+
@@ -3,64 +3,96 @@
 
 #include "camera/camera_model.hpp"
 #include "camera/camera_parametres.hpp"
+#include "camera/distortion_model.hpp"
+#include "utils/logger.hpp"
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
+#include <type_traits>
 
 namespace photogrammetry {
 namespace camera {
 
 // 基础针孔相机模型 - 无畸变
-class PinholeCameraModel : public CameraModel<PinholeCameraModel> {
+template <typename T>
+class PinholeCameraModelT : public CameraModel<PinholeCameraModelT<T>, T> {
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-  using CameraType = PinholeCameraModel;
-  PinholeCameraModel(const camera_t camera_id, const size_t width, const size_t height,
-                     const CameraParams *params)
-      : CameraModel<PinholeCameraModel>(camera_id, width, height),
-        intrinsic_params_(std::make_unique<PinholeIntrinsicParams>()) {
-    InitCamera(params);
+  using CameraType = PinholeCameraModelT<T>;
+  typedef CameraModel<PinholeCameraModelT<T>, T> Base;
+  typedef T Scalar;
+  typedef Vec2T<T> Vec2;
+  typedef Vec3T<T> Vec3;
+  typedef Mat33T<T> Mat33;
+  typedef Mat34T<T> Mat34;
+  typedef Mat2XT<T> Mat2X;
+  typedef Mat3XT<T> Mat3X;
+  typedef PinholeIntrinsicParams<T, 0> IntrinsicParams;
+  typedef typename IntrinsicParams::Distortion Distortion;
+  // 可优化内参个数: fx, fy, cx, cy
+  static constexpr int kNumIntrinsicParams = 4;
+  typedef Eigen::Matrix<T, 2, 3> PointJacobian;
+  typedef Eigen::Matrix<T, 2, 6> PoseJacobian;
+  typedef Eigen::Matrix<T, 2, kNumIntrinsicParams> IntrinsicJacobian;
+
+  /*
+   * @param params 初始化参数, 所有权转移给本函数
+   * @throw std::invalid_argument 参数与模型不匹配(如畸变参数个数不一致)
+   */
+  PinholeCameraModelT(const camera_t camera_id, const size_t width, const size_t height,
+                      const CameraParams *params)
+      : Base(camera_id, width, height) {
+    if (!InitCamera(params)) {
+      throw std::invalid_argument("Camera parameters do not match the camera model");
+    }
   }
   inline bool InitCamera(const CameraParams *params) {
-    return intrinsic_params_->InitCamera(params);
+    if (!intrinsic_params_.InitCamera(params)) {
+      return false;
+    }
+    ++this->params_version_;
+    return true;
   }
+  // 获取内参
+  const IntrinsicParams &Intrinsics() const { return intrinsic_params_; }
   // 获取内参矩阵
-  const Mat33 &IntrinsicsMatrix() const { return intrinsic_params_->IntrinsicMatrix(); }
-  const Mat33 &InverseIntrinsicsMatrix() const {
-    return intrinsic_params_->InverseIntrinsicMatrix();
+  Eigen::Map<const Mat33> IntrinsicsMatrix() const { return intrinsic_params_.IntrinsicMatrix(); }
+  Eigen::Map<const Mat33> InverseIntrinsicsMatrix() const {
+    return intrinsic_params_.InverseIntrinsicMatrix();
   }
   // 获取畸变参数
-  const std::vector<double> &DistortionParams() const {
-    return intrinsic_params_->DistortionParams();
-  }
+  const Distortion &DistortionParams() const { return intrinsic_params_.DistortionParams(); }
 
   // 图像坐标到相机坐标的转换
   Vec2 ima2cam(const Vec2 &point2d) const {
     return {
-        (point2d.x() - intrinsic_params_->PrincipalPointX()) / intrinsic_params_->FocalLengthX(),
-        (point2d.y() - intrinsic_params_->PrincipalPointY()) / intrinsic_params_->FocalLengthY()};
+        (point2d.x() - intrinsic_params_.PrincipalPointX()) / intrinsic_params_.FocalLengthX(),
+        (point2d.y() - intrinsic_params_.PrincipalPointY()) / intrinsic_params_.FocalLengthY()};
   }
 
   // 相机坐标到图像坐标的转换
   Vec2 cam2ima(const Vec2 &point2d) const {
     return Vec2(
-        intrinsic_params_->FocalLengthX() * point2d.x() + intrinsic_params_->PrincipalPointX(),
-        intrinsic_params_->FocalLengthY() * point2d.y() + intrinsic_params_->PrincipalPointY());
+        intrinsic_params_.FocalLengthX() * point2d.x() + intrinsic_params_.PrincipalPointX(),
+        intrinsic_params_.FocalLengthY() * point2d.y() + intrinsic_params_.PrincipalPointY());
   }
 
   bool haveDistortion() const { return false; }
 
-  CameraModelType getType() const { return CameraModelType::PINHOLE_CAMERA_START; }
+  static constexpr CameraModelType kModelType = CameraModelType::PINHOLE_CAMERA;
+  CameraModelType getType() const { return kModelType; }
   // 无畸变模型，直接返回输入点
   Vec2 distort(const Vec2 &point_undistorted) const { return point_undistorted; }
 
   Vec2 undistort(const Vec2 &point_distorted) const { return point_distorted; }
 
   Mat34 ProjectionMatrix(const CameraExtrinsicParams &extrinsic_params) const {
-    return IntrinsicsMatrix() * extrinsic_params.getExtrinsicMatrix();
+    return IntrinsicsMatrix() * extrinsic_params.getExtrinsicMatrix().template cast<T>();
   }
 
-  std::vector<double> getVariableParams() const {
-    return {intrinsic_params_->FocalLengthX(), intrinsic_params_->FocalLengthY(),
-            intrinsic_params_->PrincipalPointX(), intrinsic_params_->PrincipalPointY()};
+  std::vector<T> getVariableParams() const {
+    return {intrinsic_params_.FocalLengthX(), intrinsic_params_.FocalLengthY(),
+            intrinsic_params_.PrincipalPointX(), intrinsic_params_.PrincipalPointY()};
   }
 
   bool VerifyModelSpecificParams() const { return getVariableParams().size() == 4; }
@@ -70,24 +102,96 @@ public:
     return (InverseIntrinsicsMatrix() * p.colwise().homogeneous()).colwise().normalized();
   }
 
-  bool updateFromVariableParams(const std::vector<double> &variable_params) {
-    if (VerifyModelSpecificParams()) {
-      intrinsic_params_->SetFocalLengthX(variable_params[0]);
-      intrinsic_params_->SetFocalLengthY(variable_params[1]);
-      intrinsic_params_->SetPrincipalPointX(variable_params[2]);
-      intrinsic_params_->SetPrincipalPointY(variable_params[3]);
-      return true;
+  bool updateFromVariableParams(const std::vector<T> &variable_params) {
+    if (variable_params.size() == 4) {
+      return updateFromVariableParams(variable_params.data());
     } else {
-      std::cerr << "PinholeCameraModel updateFromVariableParams failed: "
-                << "Variable params size is not equal to 4" << std::endl;
+      PHOTOGRAMMETRY_LOG(WARNING,
+                         "PinholeCameraModel updateFromVariableParams failed: expected {} variable "
+                         "params, got {}",
+                         4, variable_params.size());
       return false;
     }
   }
+  // 从连续内存更新内参, 顺序与 getVariableParams 一致, 长度由调用者保证 (如 ceres 参数块)
+  bool updateFromVariableParams(const T *variable_params) {
+    intrinsic_params_.SetFocalLengthX(variable_params[0]);
+    intrinsic_params_.SetFocalLengthY(variable_params[1]);
+    intrinsic_params_.SetPrincipalPoint(variable_params[2], variable_params[3]);
+    ++this->params_version_;
+    return true;
+  }
 
-  const std::string ParamsInfo() const { return intrinsic_params_->ParamsInfo(); }
+  const std::string ParamsInfo() const { return intrinsic_params_.ParamsInfo(); }
+
+  /*
+   * @brief 投影并计算解析雅可比
+   * @param extrinsic_params 相机位姿
+   * @param X 世界坐标系下的三维点
+   * @param J_point 可选, d(x)/dX (2x3)
+   * @param J_pose 可选, d(x)/d(w, C) (2x6), w 为左乘在 R 上的旋转向量扰动: R <- exp([w]x) * R
+   * @param J_intrinsics 可选, d(x)/d(fx, fy, cx, cy), 列顺序与 getVariableParams 一致
+   * @param adjust 需要优化的内参, 其余内参对应的列为 0
+   * @return 像素坐标
+   */
+  Vec2 projectJacobian(const CameraExtrinsicParams &extrinsic_params, const Vec3 &X,
+                       PointJacobian *J_point, PoseJacobian *J_pose,
+                       IntrinsicJacobian *J_intrinsics = nullptr,
+                       const IntrinsicParameterType adjust =
+                           IntrinsicParameterType::ADJUST_ALL) const {
+    return projectJacobian(extrinsic_params.Rotation().template cast<T>(),
+                           extrinsic_params.Center().template cast<T>(), X, J_point, J_pose,
+                           J_intrinsics, adjust);
+  }
+  Vec2 projectJacobian(const Mat33 &R, const Vec3 &C, const Vec3 &X, PointJacobian *J_point,
+                       PoseJacobian *J_pose, IntrinsicJacobian *J_intrinsics = nullptr,
+                       const IntrinsicParameterType adjust =
+                           IntrinsicParameterType::ADJUST_ALL) const {
+    const T fx = intrinsic_params_.FocalLengthX();
+    const T fy = intrinsic_params_.FocalLengthY();
+    const Vec2 p = internal::NormalizedPointJacobians<T>(R, C, X, J_point, J_pose);
+    // d(x)/dp = diag(fx, fy)
+    if (J_point != nullptr) {
+      J_point->row(0) *= fx;
+      J_point->row(1) *= fy;
+    }
+    if (J_pose != nullptr) {
+      J_pose->row(0) *= fx;
+      J_pose->row(1) *= fy;
+    }
+    if (J_intrinsics != nullptr) {
+      J_intrinsics->setZero();
+      if (isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_FOCAL_LENGTH)) {
+        (*J_intrinsics)(0, 0) = p.x();
+        (*J_intrinsics)(1, 1) = p.y();
+      }
+      if (isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_PRINCIPAL_POINT)) {
+        (*J_intrinsics)(0, 2) = T(1);
+        (*J_intrinsics)(1, 3) = T(1);
+      }
+    }
+    return cam2ima(p);
+  }
+
+  // 批处理内核：按行整体运算, 由 Eigen 向量化
+  void projectBatchKernel(const Eigen::Ref<const Mat3X> &X, Eigen::Ref<Mat2X> x,
+                          const bool /*ignore_distortion*/) const {
+    const T fx = intrinsic_params_.FocalLengthX();
+    const T fy = intrinsic_params_.FocalLengthY();
+    const T cx = intrinsic_params_.PrincipalPointX();
+    const T cy = intrinsic_params_.PrincipalPointY();
+    x.row(0).array() = fx * (X.row(0).array() / X.row(2).array()) + cx;
+    x.row(1).array() = fy * (X.row(1).array() / X.row(2).array()) + cy;
+  }
+  void distortBatchKernel(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    out = points;
+  }
+  void undistortBatchKernel(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    out = points;
+  }
 
 protected:
-  std::unique_ptr<PinholeIntrinsicParams> intrinsic_params_;
+  IntrinsicParams intrinsic_params_;
 };
 
 // 一阶径向畸变模型
@@ -95,80 +199,181 @@ protected:
 // 三阶径向畸变模型
 
 // Brown-Conrady畸变模型（径向+切向畸变）
-class PinholeCameraBrown : public CameraModel<PinholeCameraBrown> {
+template <typename T>
+class PinholeCameraBrownT : public CameraModel<PinholeCameraBrownT<T>, T> {
 public:
-  using CameraType = PinholeCameraBrown;
-  PinholeCameraBrown(const camera_t camera_id, const size_t width, const size_t height,
-                     const CameraParams *params)
-      : CameraModel<PinholeCameraBrown>(camera_id, width, height),
-        intrinsic_params_(std::make_unique<PinholeIntrinsicParams>()) {
-    InitCamera(params);
+  using CameraType = PinholeCameraBrownT<T>;
+  typedef CameraModel<PinholeCameraBrownT<T>, T> Base;
+  typedef T Scalar;
+  typedef Vec2T<T> Vec2;
+  typedef Vec3T<T> Vec3;
+  typedef Mat22T<T> Mat22;
+  typedef Mat33T<T> Mat33;
+  typedef Mat34T<T> Mat34;
+  typedef Mat2XT<T> Mat2X;
+  typedef Mat3XT<T> Mat3X;
+  typedef internal::BatchRow<T> BatchRow;
+  // k1,k2,k3,t1,t2
+  typedef PinholeIntrinsicParams<T, 5> IntrinsicParams;
+  typedef typename IntrinsicParams::Distortion Distortion;
+  // 可优化内参个数: fx, fy, cx, cy, k1, k2, k3, t1, t2
+  static constexpr int kNumIntrinsicParams = 9;
+  typedef Eigen::Matrix<T, 2, 3> PointJacobian;
+  typedef Eigen::Matrix<T, 2, 6> PoseJacobian;
+  typedef Eigen::Matrix<T, 2, kNumIntrinsicParams> IntrinsicJacobian;
+
+  /*
+   * @param params 初始化参数, 所有权转移给本函数
+   * @throw std::invalid_argument 参数与模型不匹配(如畸变参数个数不一致)
+   */
+  PinholeCameraBrownT(const camera_t camera_id, const size_t width, const size_t height,
+                      const CameraParams *params)
+      : Base(camera_id, width, height) {
+    if (!InitCamera(params)) {
+      throw std::invalid_argument("Camera parameters do not match the camera model");
+    }
   }
   // 初始化相机
   inline bool InitCamera(const CameraParams *params) {
-    return intrinsic_params_->InitCamera(params);
+    if (!intrinsic_params_.InitCamera(params)) {
+      return false;
+    }
+    ++this->params_version_;
+    return true;
   }
+  // 获取内参
+  const IntrinsicParams &Intrinsics() const { return intrinsic_params_; }
   // 获取内参矩阵
-  const Mat33 &IntrinsicsMatrix() const { return intrinsic_params_->IntrinsicMatrix(); }
-  const Mat33 &InverseIntrinsicsMatrix() const {
-    return intrinsic_params_->InverseIntrinsicMatrix();
+  Eigen::Map<const Mat33> IntrinsicsMatrix() const { return intrinsic_params_.IntrinsicMatrix(); }
+  Eigen::Map<const Mat33> InverseIntrinsicsMatrix() const {
+    return intrinsic_params_.InverseIntrinsicMatrix();
   }
   // 获取畸变参数
-  const std::vector<double> &DistortionParams() const {
-    return intrinsic_params_->DistortionParams();
-  }
+  const Distortion &DistortionParams() const { return intrinsic_params_.DistortionParams(); }
 
-  CameraModelType getType() const { return CameraModelType::PINHOLE_CAMERA_BROWN; }
+  static constexpr CameraModelType kModelType = CameraModelType::PINHOLE_CAMERA_BROWN;
+  CameraModelType getType() const { return kModelType; }
 
   // 图像坐标到相机坐标的转换
   Vec2 ima2cam(const Vec2 &point2d) const {
     return {
-        (point2d.x() - intrinsic_params_->PrincipalPointX()) / intrinsic_params_->FocalLengthX(),
-        (point2d.y() - intrinsic_params_->PrincipalPointY()) / intrinsic_params_->FocalLengthY()};
+        (point2d.x() - intrinsic_params_.PrincipalPointX()) / intrinsic_params_.FocalLengthX(),
+        (point2d.y() - intrinsic_params_.PrincipalPointY()) / intrinsic_params_.FocalLengthY()};
   }
 
   // 相机坐标到图像坐标的转换
   Vec2 cam2ima(const Vec2 &point2d) const {
     return Vec2(
-        intrinsic_params_->FocalLengthX() * point2d.x() + intrinsic_params_->PrincipalPointX(),
-        intrinsic_params_->FocalLengthY() * point2d.y() + intrinsic_params_->PrincipalPointY());
+        intrinsic_params_.FocalLengthX() * point2d.x() + intrinsic_params_.PrincipalPointX(),
+        intrinsic_params_.FocalLengthY() * point2d.y() + intrinsic_params_.PrincipalPointY());
   }
 
   bool haveDistortion() const { return true; }
 
   Vec2 distort(const Vec2 &p) const { return (p + DistortFunc(DistortionParams(), p)); }
 
+  /*
+   * @brief 畸变函数关于归一化坐标的雅可比矩阵 d(distort(p))/dp
+   * @param p 归一化摄像机平面上的点
+   * @return 2x2 雅可比矩阵
+   */
+  Mat22 distortJacobian(const Vec2 &p) const { return DistortJacobianFunc(DistortionParams(), p); }
+
   /*
    * @brief 去畸变（在归一化摄像机平面上）
    * @param point_distorted 畸变点
    * @return 去畸变后的点
-   * @note Heikkila J (2000) Geometric Camera Calibration Using Circular Control Points.
+   * @note 使用默认终止条件的牛顿迭代, 见 undistortNewton
    */
   Vec2 undistort(const Vec2 &point_distorted) const {
-    const double epsilon = 1e-10;
+    return undistortNewton(point_distorted, UndistortOptions());
+  }
+
+  /*
+   * @brief 牛顿法去畸变, 求解 distort(p_u) = p_d
+   * @param point_distorted 畸变点
+   * @param options 最大迭代次数与收敛容差
+   * @param summary 可选, 输出收敛状态、迭代次数与残差
+   * @return 去畸变后的点(未收敛时为最后一次迭代的结果)
+   */
+  Vec2 undistortNewton(const Vec2 &point_distorted, const UndistortOptions &options,
+                       UndistortSummary *summary = nullptr) const {
+    using std::abs;
+    const Distortion &distortions = DistortionParams();
+    UndistortStatus status = UndistortStatus::NO_CONVERGENCE;
     Vec2 p_u = point_distorted;
+    Vec2 f = p_u + DistortFunc(distortions, p_u) - point_distorted;
+    int it = 0;
+    for (;; ++it) {
+      if (f.template lpNorm<1>() <= options.tolerance) {
+        status = UndistortStatus::CONVERGED;
+        break;
+      }
+      if (it == options.max_iterations) {
+        break;
+      }
+      const Mat22 J = DistortJacobianFunc(distortions, p_u);
+      const T det = J(0, 0) * J(1, 1) - J(0, 1) * J(1, 0);
+      if (abs(det) < kSingularDeterminant) {
+        status = UndistortStatus::SINGULAR_JACOBIAN;
+        break;
+      }
+      // p_u -= J^-1 * f, 2x2 逆矩阵直接展开
+      p_u.x() -= (J(1, 1) * f.x() - J(0, 1) * f.y()) / det;
+      p_u.y() -= (J(0, 0) * f.y() - J(1, 0) * f.x()) / det;
+      f = p_u + DistortFunc(distortions, p_u) - point_distorted;
+    }
+    if (summary != nullptr) {
+      summary->status = status;
+      summary->iterations = it;
+      summary->residual = internal::ScalarValue(f.template lpNorm<1>());
+      summary->num_converged = status == UndistortStatus::CONVERGED ? 1 : 0;
+    }
+    return p_u;
+  }
 
-    Vec2 d = DistortFunc(DistortionParams(), p_u);
-    while ((p_u + d - point_distorted).lpNorm<1>() >
-           epsilon) // manhattan distance between the two points
-    {
+  /*
+   * @brief 不动点迭代去畸变(原实现, 增加了迭代次数上限)
+   * @param point_distorted 畸变点
+   * @param options 最大迭代次数与收敛容差
+   * @param summary 可选, 输出收敛状态、迭代次数与残差
+   * @return 去畸变后的点
+   * @note Heikkila J (2000) Geometric Camera Calibration Using Circular Control Points.
+   */
+  Vec2 undistortHeikkila(const Vec2 &point_distorted, const UndistortOptions &options,
+                         UndistortSummary *summary = nullptr) const {
+    const Distortion &distortions = DistortionParams();
+    Vec2 p_u = point_distorted;
+
+    Vec2 d = DistortFunc(distortions, p_u);
+    int it = 0;
+    T residual = (p_u + d - point_distorted).template lpNorm<1>();
+    // manhattan distance between the two points
+    while (residual > options.tolerance && it < options.max_iterations) {
       p_u = point_distorted - d;
-      d = DistortFunc(DistortionParams(), p_u);
+      d = DistortFunc(distortions, p_u);
+      residual = (p_u + d - point_distorted).template lpNorm<1>();
+      ++it;
+    }
+    if (summary != nullptr) {
+      const bool converged = residual <= options.tolerance;
+      summary->status = converged ? UndistortStatus::CONVERGED : UndistortStatus::NO_CONVERGENCE;
+      summary->iterations = it;
+      summary->residual = internal::ScalarValue(residual);
+      summary->num_converged = converged ? 1 : 0;
     }
-
     return p_u;
   }
 
   Mat34 ProjectionMatrix(const CameraExtrinsicParams &extrinsic_params) const {
-    return IntrinsicsMatrix() * extrinsic_params.getExtrinsicMatrix();
+    return IntrinsicsMatrix() * extrinsic_params.getExtrinsicMatrix().template cast<T>();
   }
 
-  std::vector<double> getVariableParams() const {
-    std::vector<double> params{intrinsic_params_->FocalLengthX(), intrinsic_params_->FocalLengthY(),
-                               intrinsic_params_->PrincipalPointX(),
-                               intrinsic_params_->PrincipalPointY()};
-    params.insert(params.end(), intrinsic_params_->DistortionParams().begin(),
-                  intrinsic_params_->DistortionParams().end());
+  std::vector<T> getVariableParams() const {
+    std::vector<T> params{intrinsic_params_.FocalLengthX(), intrinsic_params_.FocalLengthY(),
+                          intrinsic_params_.PrincipalPointX(), intrinsic_params_.PrincipalPointY()};
+    params.insert(params.end(), intrinsic_params_.DistortionParams().begin(),
+                  intrinsic_params_.DistortionParams().end());
     return params;
   }
 
@@ -181,57 +386,341 @@ public:
 
   const std::string ParamsInfo() const {
     std::stringstream ss;
-    ss << intrinsic_params_->ParamsInfo();
+    ss << intrinsic_params_.ParamsInfo();
     ss << "Distortion: ";
-    const auto &distortion_params = intrinsic_params_->DistortionParams();
+    const auto &distortion_params = intrinsic_params_.DistortionParams();
     ss << "k1: " << distortion_params[0] << ", k2: " << distortion_params[1]
        << ", k3: " << distortion_params[2] << "\nt1: " << distortion_params[3]
        << ", t2: " << distortion_params[4] << std::endl;
     return ss.str();
   }
 
-  bool updateFromVariableParams(const std::vector<double> &variable_params) {
-    if (VerifyModelSpecificParams()) {
-      intrinsic_params_->SetFocalLengthX(variable_params[0]);
-      intrinsic_params_->SetFocalLengthY(variable_params[1]);
-      intrinsic_params_->SetPrincipalPointX(variable_params[2]);
-      intrinsic_params_->SetPrincipalPointY(variable_params[3]);
-      // k1,k2,k3,t1,t2
-      intrinsic_params_->SetDistortion(variable_params);
-      return true;
+  bool updateFromVariableParams(const std::vector<T> &variable_params) {
+    if (variable_params.size() == 9) {
+      return updateFromVariableParams(variable_params.data());
     } else {
-      std::cerr << "PinholeCameraBrown updateFromVariableParams failed: "
-                << "Variable params size is not equal to 9" << std::endl;
+      PHOTOGRAMMETRY_LOG(WARNING,
+                         "PinholeCameraBrown updateFromVariableParams failed: expected {} variable "
+                         "params, got {}",
+                         9, variable_params.size());
       return false;
     }
   }
+  // 从连续内存更新内参, 顺序与 getVariableParams 一致, 长度由调用者保证 (如 ceres 参数块)
+  bool updateFromVariableParams(const T *variable_params) {
+    intrinsic_params_.SetFocalLengthX(variable_params[0]);
+    intrinsic_params_.SetFocalLengthY(variable_params[1]);
+    intrinsic_params_.SetPrincipalPoint(variable_params[2], variable_params[3]);
+    // k1,k2,k3,t1,t2
+    intrinsic_params_.SetDistortion(variable_params + 4);
+    ++this->params_version_;
+    return true;
+  }
+
+  /*
+   * @brief 投影并计算解析雅可比
+   * @param extrinsic_params 相机位姿
+   * @param X 世界坐标系下的三维点
+   * @param J_point 可选, d(x)/dX (2x3)
+   * @param J_pose 可选, d(x)/d(w, C) (2x6), w 为左乘在 R 上的旋转向量扰动: R <- exp([w]x) * R
+   * @param J_intrinsics 可选, d(x)/d(fx, fy, cx, cy, k1, k2, k3, t1, t2),
+   *        列顺序与 getVariableParams 一致
+   * @param adjust 需要优化的内参, 其余内参对应的列为 0
+   * @return 像素坐标(含畸变)
+   */
+  Vec2 projectJacobian(const CameraExtrinsicParams &extrinsic_params, const Vec3 &X,
+                       PointJacobian *J_point, PoseJacobian *J_pose,
+                       IntrinsicJacobian *J_intrinsics = nullptr,
+                       const IntrinsicParameterType adjust =
+                           IntrinsicParameterType::ADJUST_ALL) const {
+    return projectJacobian(extrinsic_params.Rotation().template cast<T>(),
+                           extrinsic_params.Center().template cast<T>(), X, J_point, J_pose,
+                           J_intrinsics, adjust);
+  }
+  Vec2 projectJacobian(const Mat33 &R, const Vec3 &C, const Vec3 &X, PointJacobian *J_point,
+                       PoseJacobian *J_pose, IntrinsicJacobian *J_intrinsics = nullptr,
+                       const IntrinsicParameterType adjust =
+                           IntrinsicParameterType::ADJUST_ALL) const {
+    const T fx = intrinsic_params_.FocalLengthX();
+    const T fy = intrinsic_params_.FocalLengthY();
+    const Vec2 p = internal::NormalizedPointJacobians<T>(R, C, X, J_point, J_pose);
+    const Vec2 p_d = distort(p);
+    if (J_point != nullptr || J_pose != nullptr) {
+      // d(x)/dp = diag(fx, fy) * d(distort)/dp
+      Mat22 J_pixel = DistortJacobianFunc(DistortionParams(), p);
+      J_pixel.row(0) *= fx;
+      J_pixel.row(1) *= fy;
+      if (J_point != nullptr) {
+        *J_point = J_pixel * (*J_point);
+      }
+      if (J_pose != nullptr) {
+        *J_pose = J_pixel * (*J_pose);
+      }
+    }
+    if (J_intrinsics != nullptr) {
+      J_intrinsics->setZero();
+      if (isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_FOCAL_LENGTH)) {
+        (*J_intrinsics)(0, 0) = p_d.x();
+        (*J_intrinsics)(1, 1) = p_d.y();
+      }
+      if (isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_PRINCIPAL_POINT)) {
+        (*J_intrinsics)(0, 2) = T(1);
+        (*J_intrinsics)(1, 3) = T(1);
+      }
+      if (isIntrinsicAdjusted(adjust, IntrinsicParameterType::ADJUST_DISTORTION)) {
+        const T x = p.x(), y = p.y();
+        const T r2 = x * x + y * y;
+        const T r4 = r2 * r2;
+        const T xy2 = T(2) * x * y;
+        // k1, k2, k3
+        (*J_intrinsics)(0, 4) = fx * x * r2;
+        (*J_intrinsics)(1, 4) = fy * y * r2;
+        (*J_intrinsics)(0, 5) = fx * x * r4;
+        (*J_intrinsics)(1, 5) = fy * y * r4;
+        (*J_intrinsics)(0, 6) = fx * x * r4 * r2;
+        (*J_intrinsics)(1, 6) = fy * y * r4 * r2;
+        // t1, t2
+        (*J_intrinsics)(0, 7) = fx * xy2;
+        (*J_intrinsics)(1, 7) = fy * (r2 + T(2) * y * y);
+        (*J_intrinsics)(0, 8) = fx * (r2 + T(2) * x * x);
+        (*J_intrinsics)(1, 8) = fy * xy2;
+      }
+    }
+    return cam2ima(p_d);
+  }
+
+  /*
+   * @brief 批量投影内核
+   * @note 每 kBatchBlockSize 个点为一块, 先转置为 SoA 行再整体计算畸变, 避免逐点调用
+   */
+  void projectBatchKernel(const Eigen::Ref<const Mat3X> &X, Eigen::Ref<Mat2X> x,
+                          const bool ignore_distortion) const {
+    const T fx = intrinsic_params_.FocalLengthX();
+    const T fy = intrinsic_params_.FocalLengthY();
+    const T cx = intrinsic_params_.PrincipalPointX();
+    const T cy = intrinsic_params_.PrincipalPointY();
+    const Distortion &distortions = DistortionParams();
+    for (Eigen::Index start = 0; start < X.cols(); start += internal::kBatchBlockSize) {
+      const Eigen::Index n = std::min(internal::kBatchBlockSize, X.cols() - start);
+      const BatchRow inv_z = X.row(2).segment(start, n).array().inverse();
+      BatchRow u = X.row(0).segment(start, n).array() * inv_z;
+      BatchRow v = X.row(1).segment(start, n).array() * inv_z;
+      if (!ignore_distortion) {
+        BatchRow du(n), dv(n);
+        DistortBlock(distortions, u, v, du, dv);
+        u += du;
+        v += dv;
+      }
+      x.row(0).segment(start, n).array() = fx * u + cx;
+      x.row(1).segment(start, n).array() = fy * v + cy;
+    }
+  }
+
+  void distortBatchKernel(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    const Distortion &distortions = DistortionParams();
+    for (Eigen::Index start = 0; start < points.cols(); start += internal::kBatchBlockSize) {
+      const Eigen::Index n = std::min(internal::kBatchBlockSize, points.cols() - start);
+      const BatchRow u = points.row(0).segment(start, n).array();
+      const BatchRow v = points.row(1).segment(start, n).array();
+      BatchRow du(n), dv(n);
+      DistortBlock(distortions, u, v, du, dv);
+      out.row(0).segment(start, n).array() = u + du;
+      out.row(1).segment(start, n).array() = v + dv;
+    }
+  }
+
+  using Base::undistortBatch;
+
+  /*
+   * @brief 批量牛顿法去畸变
+   * @param points 畸变点 (2xN)
+   * @param out 输出的去畸变点 (2xN), 需预先分配好大小
+   * @param options 最大迭代次数与收敛容差
+   * @param summaries 可选, 输出每个点的收敛状态, 大小会被调整为 N
+   * @return 汇总信息: 最差的状态、最大迭代次数、最大残差和收敛点数
+   * @note 每 kBatchBlockSize 个点为一块整体迭代, 雅可比与 2x2 求逆都按行向量化,
+   *       块内所有点收敛或达到最大迭代次数后结束
+   */
+  UndistortSummary undistortBatch(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out,
+                                  const UndistortOptions &options,
+                                  std::vector<UndistortSummary> *summaries = nullptr) const {
+    typedef internal::BatchRow<int> BatchRowi;
+    const Distortion &distortions = DistortionParams();
+    if (summaries != nullptr) {
+      summaries->resize(points.cols());
+    }
+    UndistortSummary total;
+    for (Eigen::Index start = 0; start < points.cols(); start += internal::kBatchBlockSize) {
+      const Eigen::Index n = std::min(internal::kBatchBlockSize, points.cols() - start);
+      const BatchRow xd = points.row(0).segment(start, n).array();
+      const BatchRow yd = points.row(1).segment(start, n).array();
+      BatchRow pu = xd, pv = yd, du(n), dv(n), fu(n), fv(n), residual(n);
+      BatchRow j00(n), j01(n), j10(n), j11(n), det(n);
+      BatchRowi iterations = BatchRowi::Zero(n);
+      BatchRowi singular = BatchRowi::Zero(n);
+      for (int it = 0;; ++it) {
+        DistortBlock(distortions, pu, pv, du, dv);
+        fu = pu + du - xd;
+        fv = pv + dv - yd;
+        residual = fu.abs() + fv.abs();
+        if (residual.maxCoeff() <= options.tolerance || it == options.max_iterations) {
+          break;
+        }
+        const BatchRowi active =
+            ((residual > T(options.tolerance)) && (singular == 0)).template cast<int>();
+        iterations += active;
+        DistortJacobianBlock(distortions, pu, pv, j00, j01, j10, j11);
+        det = j00 * j11 - j01 * j10;
+        singular = (active == 1 && det.abs() < T(kSingularDeterminant)).select(1, singular);
+        // 已收敛或奇异的点步长为 0
+        det = (active == 1 && singular == 0).select(det.inverse(), T(0));
+        pu -= det * (j11 * fu - j01 * fv);
+        pv -= det * (j00 * fv - j10 * fu);
+      }
+      out.row(0).segment(start, n).array() = pu;
+      out.row(1).segment(start, n).array() = pv;
+
+      for (Eigen::Index i = 0; i < n; ++i) {
+        UndistortSummary summary;
+        summary.iterations = iterations(i);
+        summary.residual = internal::ScalarValue(residual(i));
+        if (residual(i) <= options.tolerance) {
+          summary.status = UndistortStatus::CONVERGED;
+          summary.num_converged = 1;
+        } else {
+          summary.status = singular(i) ? UndistortStatus::SINGULAR_JACOBIAN
+                                       : UndistortStatus::NO_CONVERGENCE;
+        }
+        total.status = std::max(total.status, summary.status);
+        total.iterations = std::max(total.iterations, summary.iterations);
+        total.residual = std::max(total.residual, summary.residual);
+        total.num_converged += summary.num_converged;
+        if (summaries != nullptr) {
+          (*summaries)[start + i] = summary;
+        }
+      }
+    }
+    return total;
+  }
+
+  // 批量去畸变内核, 使用默认终止条件的向量化牛顿迭代
+  void undistortBatchKernel(const Eigen::Ref<const Mat2X> &points, Eigen::Ref<Mat2X> out) const {
+    undistortBatch(points, out, UndistortOptions());
+  }
 
 protected:
-  std::unique_ptr<PinholeIntrinsicParams> intrinsic_params_;
+  IntrinsicParams intrinsic_params_;
+
+  // 雅可比行列式小于该值时认为奇异
+  static constexpr double kSingularDeterminant = 1e-12;
 
   /*
    * @brief 畸变函数
    * @param distortions 畸变参数
    * @param point2d 归一化摄像机平面上的点
    * @return 畸变后的点
+   * @note 常数统一写成 T(2) 等形式, 以便 float 不被提升为 double, ceres::Jet 也能直接使用
    */
-  static Vec2 DistortFunc(const std::vector<double> &distortions, const Vec2 &point2d) {
-    const double k1 = distortions[0];
-    const double k2 = distortions[1];
-    const double k3 = distortions[2];
-    const double t1 = distortions[3];
-    const double t2 = distortions[4];
-
-    const double r2 = point2d(0) * point2d(0) + point2d(1) * point2d(1);
-    const double r4 = r2 * r2;
-    const double r6 = r4 * r2;
-    const double k_diff = (k1 * r2 + k2 * r4 + k3 * r6);
-    const double t_x = t2 * (r2 + 2 * point2d(0) * point2d(0)) + 2 * t1 * point2d(0) * point2d(1);
-    const double t_y = t1 * (r2 + 2 * point2d(1) * point2d(1)) + 2 * t2 * point2d(0) * point2d(1);
+  static Vec2 DistortFunc(const Distortion &distortions, const Vec2 &point2d) {
+    const T k1 = distortions[0];
+    const T k2 = distortions[1];
+    const T k3 = distortions[2];
+    const T t1 = distortions[3];
+    const T t2 = distortions[4];
+
+    const T r2 = point2d(0) * point2d(0) + point2d(1) * point2d(1);
+    const T r4 = r2 * r2;
+    const T r6 = r4 * r2;
+    const T k_diff = (k1 * r2 + k2 * r4 + k3 * r6);
+    const T t_x =
+        t2 * (r2 + T(2) * point2d(0) * point2d(0)) + T(2) * t1 * point2d(0) * point2d(1);
+    const T t_y =
+        t1 * (r2 + T(2) * point2d(1) * point2d(1)) + T(2) * t2 * point2d(0) * point2d(1);
     return {point2d(0) * k_diff + t_x, point2d(1) * k_diff + t_y};
   }
+
+  /*
+   * @brief 畸变后坐标 p + DistortFunc(p) 关于 p 的雅可比矩阵
+   * @param distortions 畸变参数
+   * @param point2d 归一化摄像机平面上的点
+   * @return 2x2 雅可比矩阵
+   */
+  static Mat22 DistortJacobianFunc(const Distortion &distortions, const Vec2 &point2d) {
+    const T k1 = distortions[0];
+    const T k2 = distortions[1];
+    const T k3 = distortions[2];
+    const T t1 = distortions[3];
+    const T t2 = distortions[4];
+
+    const T x = point2d(0), y = point2d(1);
+    const T r2 = x * x + y * y;
+    const T k_diff = r2 * (k1 + r2 * (k2 + r2 * k3));
+    // d(k_diff)/d(r2)
+    const T k_diff_dr2 = k1 + r2 * (T(2) * k2 + r2 * T(3) * k3);
+    const T cross = T(2) * x * y * k_diff_dr2 + T(2) * t1 * x + T(2) * t2 * y;
+    Mat22 J;
+    J(0, 0) = T(1) + k_diff + T(2) * x * x * k_diff_dr2 + T(6) * t2 * x + T(2) * t1 * y;
+    J(0, 1) = cross;
+    J(1, 0) = cross;
+    J(1, 1) = T(1) + k_diff + T(2) * y * y * k_diff_dr2 + T(6) * t1 * y + T(2) * t2 * x;
+    return J;
+  }
+
+  /*
+   * @brief 畸变函数的批量版本
+   * @param distortions 畸变参数
+   * @param u, v 归一化摄像机平面上的点 (SoA)
+   * @param du, dv 输出的畸变量
+   */
+  static void DistortBlock(const Distortion &distortions, const BatchRow &u, const BatchRow &v,
+                           BatchRow &du, BatchRow &dv) {
+    const T k1 = distortions[0];
+    const T k2 = distortions[1];
+    const T k3 = distortions[2];
+    const T t1 = distortions[3];
+    const T t2 = distortions[4];
+
+    const BatchRow r2 = u.square() + v.square();
+    const BatchRow k_diff = r2 * (k1 + r2 * (k2 + r2 * k3));
+    const BatchRow uv2 = T(2) * u * v;
+    du = u * k_diff + t2 * (r2 + T(2) * u.square()) + t1 * uv2;
+    dv = v * k_diff + t1 * (r2 + T(2) * v.square()) + t2 * uv2;
+  }
+
+  // 雅可比矩阵的批量版本, 与 DistortJacobianFunc 相同
+  static void DistortJacobianBlock(const Distortion &distortions, const BatchRow &u,
+                                   const BatchRow &v, BatchRow &j00, BatchRow &j01, BatchRow &j10,
+                                   BatchRow &j11) {
+    const T k1 = distortions[0];
+    const T k2 = distortions[1];
+    const T k3 = distortions[2];
+    const T t1 = distortions[3];
+    const T t2 = distortions[4];
+
+    const BatchRow r2 = u.square() + v.square();
+    const BatchRow k_diff = r2 * (k1 + r2 * (k2 + r2 * k3));
+    const BatchRow k_diff_dr2 = k1 + r2 * (T(2) * k2 + r2 * T(3) * k3);
+    j00 = T(1) + k_diff + T(2) * u.square() * k_diff_dr2 + T(6) * t2 * u + T(2) * t1 * v;
+    j01 = T(2) * u * v * k_diff_dr2 + T(2) * t1 * u + T(2) * t2 * v;
+    j10 = j01;
+    j11 = T(1) + k_diff + T(2) * v.square() * k_diff_dr2 + T(6) * t1 * v + T(2) * t2 * u;
+  }
 };
 
+// 默认使用双精度; float 版本用于稠密图像处理
+typedef PinholeCameraModelT<double> PinholeCameraModel;
+typedef PinholeCameraModelT<float> PinholeCameraModelf;
+typedef PinholeCameraBrownT<double> PinholeCameraBrown;
+typedef PinholeCameraBrownT<float> PinholeCameraBrownf;
+
+// 内参内联存储, 相机模型可以直接按值大量打包存放
+static_assert(std::is_trivially_copyable<PinholeCameraModel>::value,
+              "PinholeCameraModel must be trivially copyable");
+static_assert(std::is_trivially_copyable<PinholeCameraBrown>::value,
+              "PinholeCameraBrown must be trivially copyable");
+static_assert(std::is_trivially_copyable<PinholeCameraBrownf>::value,
+              "PinholeCameraBrownf must be trivially copyable");
+
 } // namespace camera
 } // namespace photogrammetry
 
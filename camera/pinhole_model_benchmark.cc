@@ -0,0 +1,312 @@
+#include "camera/pinhole_model.hpp"
+#include "camera/undistortion_grid.hpp"
+#include <benchmark/benchmark.h>
+#include <unsupported/Eigen/AutoDiff>
+
+using namespace photogrammetry::camera;
+
+namespace {
+template <typename T = double>
+PinholeCameraBrownT<T> MakeBrownCamera() {
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 1000.0;
+  params->fy = 1010.0;
+  params->cx = 640.0;
+  params->cy = 480.0;
+  params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+  return PinholeCameraBrownT<T>(0, 1280, 960, params);
+}
+
+PinholeCameraModel MakePinholeCamera() {
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA);
+  params->fx = 1000.0;
+  params->fy = 1010.0;
+  params->cx = 640.0;
+  params->cy = 480.0;
+  return PinholeCameraModel(0, 1280, 960, params);
+}
+
+// 广角镜头, 桶形畸变较强
+PinholeCameraBrown MakeWideAngleCamera() {
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 600.0;
+  params->fy = 600.0;
+  params->cx = 640.0;
+  params->cy = 480.0;
+  params->distortion = {-0.3, 0.09, -0.01, 0.0005, -0.0003};
+  return PinholeCameraBrown(0, 1280, 960, params);
+}
+
+Mat3X MakePoints(const Eigen::Index num_points) {
+  Mat3X X = Mat3X::Random(3, num_points);
+  X.row(2).array() += 3.0;
+  return X;
+}
+} // namespace
+
+template <typename Factory>
+static void BM_ProjectPerPoint(benchmark::State &state, Factory make_camera) {
+  const auto camera = make_camera();
+  const Mat3X X = MakePoints(state.range(0));
+  Mat2X x(2, X.cols());
+  for (auto _ : state) {
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      x.col(i) = camera.project(X.col(i));
+    }
+    benchmark::DoNotOptimize(x.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+template <typename Factory>
+static void BM_ProjectBatch(benchmark::State &state, Factory make_camera) {
+  const auto camera = make_camera();
+  const Mat3X X = MakePoints(state.range(0));
+  Mat2X x(2, X.cols());
+  for (auto _ : state) {
+    camera.projectBatch(X, x);
+    benchmark::DoNotOptimize(x.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+template <typename Factory>
+static void BM_ResidualPerPoint(benchmark::State &state, Factory make_camera) {
+  const auto camera = make_camera();
+  const Mat3X X = MakePoints(state.range(0));
+  const Mat2X observed = camera.projectBatch(X) + Mat2X::Random(2, X.cols());
+  Mat2X r(2, X.cols());
+  for (auto _ : state) {
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      r.col(i) = camera.residual(X.col(i), observed.col(i));
+    }
+    benchmark::DoNotOptimize(r.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+template <typename Factory>
+static void BM_ResidualBatch(benchmark::State &state, Factory make_camera) {
+  const auto camera = make_camera();
+  const Mat3X X = MakePoints(state.range(0));
+  const Mat2X observed = camera.projectBatch(X) + Mat2X::Random(2, X.cols());
+  Mat2X r(2, X.cols());
+  for (auto _ : state) {
+    camera.residualBatch(X, observed, r);
+    benchmark::DoNotOptimize(r.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+// 像素坐标到单位方向向量 operator()(Mat2X), 包含去畸变
+template <typename Factory>
+static void BM_BearingVectors(benchmark::State &state, Factory make_camera) {
+  const auto camera = make_camera();
+  const Mat2X x = camera.projectBatch(MakePoints(state.range(0)));
+  for (auto _ : state) {
+    Mat3X bearings = camera(x);
+    benchmark::DoNotOptimize(bearings.data());
+  }
+  state.SetItemsProcessed(state.iterations() * x.cols());
+}
+
+static void BM_UndistortPerPoint(benchmark::State &state) {
+  const PinholeCameraBrown camera = MakeBrownCamera<>();
+  const Mat2X points = camera.distortBatch(MakePoints(state.range(0)).colwise().hnormalized());
+  Mat2X out(2, points.cols());
+  for (auto _ : state) {
+    for (Eigen::Index i = 0; i < points.cols(); ++i) {
+      out.col(i) = camera.undistort(points.col(i));
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+static void BM_UndistortBatch(benchmark::State &state) {
+  const PinholeCameraBrown camera = MakeBrownCamera<>();
+  const Mat2X points = camera.distortBatch(MakePoints(state.range(0)).colwise().hnormalized());
+  Mat2X out(2, points.cols());
+  for (auto _ : state) {
+    camera.undistortBatch(points, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+static void BM_UndistortGrid(benchmark::State &state) {
+  const PinholeCameraBrown camera = MakeBrownCamera<>();
+  const Mat2X points = camera.distortBatch(MakePoints(state.range(0)).colwise().hnormalized());
+  Mat2X out(2, points.cols());
+  UndistortionGrid grid;
+  grid.Build(camera);
+  for (auto _ : state) {
+    grid.undistortBatch(camera, points, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * points.cols());
+}
+
+// 单精度与双精度的批量投影对比, 以双精度结果为基准统计最大误差(像素)
+template <typename T>
+static void BM_ProjectBatchPrecision(benchmark::State &state) {
+  const auto camera = MakeBrownCamera<T>();
+  const Mat3X X = MakePoints(state.range(0));
+  const Mat3XT<T> X_t = X.cast<T>();
+  Mat2XT<T> x(2, X.cols());
+  for (auto _ : state) {
+    camera.projectBatch(X_t, x);
+    benchmark::DoNotOptimize(x.data());
+  }
+  const Mat2X reference = MakeBrownCamera<double>().projectBatch(X);
+  state.counters["max_error_px"] = (x.template cast<double>() - reference).cwiseAbs().maxCoeff();
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+// 逐点去畸变, 统计平均迭代次数与收敛率
+template <typename Factory, typename Solver>
+static void BM_UndistortSolver(benchmark::State &state, Factory make_camera, Solver solver) {
+  const auto camera = make_camera();
+  // 在整幅图像上均匀采样畸变像素
+  const Eigen::Index num_points = state.range(0);
+  Mat2X points(2, num_points);
+  for (Eigen::Index i = 0; i < num_points; ++i) {
+    const double t = static_cast<double>(i) / num_points;
+    points.col(i) =
+        camera.ima2cam(Vec2(camera.width() * t, camera.height() * std::fmod(t * 97, 1)));
+  }
+  Mat2X out(2, num_points);
+  const UndistortOptions options;
+  double iterations = 0, converged = 0;
+  for (auto _ : state) {
+    iterations = converged = 0;
+    for (Eigen::Index i = 0; i < num_points; ++i) {
+      UndistortSummary summary;
+      out.col(i) = (camera.*solver)(points.col(i), options, &summary);
+      iterations += summary.iterations;
+      converged += summary.num_converged;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.counters["iterations"] = iterations / num_points;
+  state.counters["converged"] = converged / num_points;
+  state.SetItemsProcessed(state.iterations() * num_points);
+}
+
+// 前向自动微分, 导数依次为 点(3)、位姿(6)、内参(9)
+typedef Eigen::AutoDiffScalar<Eigen::Matrix<double, 18, 1>> AutoDiff18;
+
+const CameraExtrinsicParams kBenchmarkPose(
+    Eigen::AngleAxisd(0.3, Vec3(0.2, -1.0, 0.5).normalized()).toRotationMatrix(),
+    Vec3(0.4, -0.3, -0.5));
+
+static void BM_ProjectionMatrix(benchmark::State &state) {
+  const PinholeCameraBrown camera = MakeBrownCamera();
+  for (auto _ : state) {
+    Mat34 P = camera.ProjectionMatrix(kBenchmarkPose);
+    benchmark::DoNotOptimize(P.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ProjectJacobianAnalytic(benchmark::State &state) {
+  const PinholeCameraBrown camera = MakeBrownCamera();
+  const Mat3X X = MakePoints(state.range(0));
+  Mat2X x(2, X.cols());
+  PinholeCameraBrown::PointJacobian J_point;
+  PinholeCameraBrown::PoseJacobian J_pose;
+  PinholeCameraBrown::IntrinsicJacobian J_intrinsics;
+  for (auto _ : state) {
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      x.col(i) = camera.projectJacobian(kBenchmarkPose, X.col(i), &J_point, &J_pose, &J_intrinsics);
+      benchmark::DoNotOptimize(J_intrinsics.data());
+    }
+    benchmark::DoNotOptimize(x.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+static void BM_ProjectJacobianBatch(benchmark::State &state) {
+  const PinholeCameraBrown camera = MakeBrownCamera();
+  const Mat3X X = MakePoints(state.range(0));
+  Mat2X x(2, X.cols());
+  PinholeCameraBrown::JacobianMatrix J_point, J_pose, J_intrinsics;
+  for (auto _ : state) {
+    camera.projectJacobianBatch(kBenchmarkPose, X, x, &J_point, &J_pose, &J_intrinsics);
+    benchmark::DoNotOptimize(J_intrinsics.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+// 以标量模板化的相机模型做前向自动微分, 作为解析雅可比的对照
+static void BM_ProjectJacobianAutoDiff(benchmark::State &state) {
+  typedef PinholeCameraBrownT<AutoDiff18> AutoDiffCamera;
+  typedef Vec3T<AutoDiff18> Vec3AD;
+  const PinholeCameraBrown camera = MakeBrownCamera();
+  const std::vector<double> params = camera.getVariableParams();
+  std::vector<AutoDiff18> params_ad(params.size());
+  for (size_t k = 0; k < params.size(); ++k) {
+    params_ad[k] = AutoDiff18(params[k], 18, 9 + k);
+  }
+  AutoDiffCamera camera_ad = MakeBrownCamera<AutoDiff18>();
+  camera_ad.updateFromVariableParams(params_ad);
+  const Mat33T<AutoDiff18> R = kBenchmarkPose.Rotation().cast<AutoDiff18>();
+  Vec3AD C, w;
+  for (int k = 0; k < 3; ++k) {
+    w(k) = AutoDiff18(0.0, 18, 3 + k);
+    C(k) = AutoDiff18(kBenchmarkPose.Center()(k), 18, 6 + k);
+  }
+
+  const Mat3X X = MakePoints(state.range(0));
+  Mat2X x(2, X.cols());
+  Eigen::Matrix<double, 2, 18> J;
+  for (auto _ : state) {
+    for (Eigen::Index i = 0; i < X.cols(); ++i) {
+      Vec3AD X_ad;
+      for (int k = 0; k < 3; ++k) {
+        X_ad(k) = AutoDiff18(X(k, i), 18, k);
+      }
+      // R <- (I + [w]x) * R 在 w = 0 处的一阶展开
+      const Vec3AD X_rot = R * (X_ad - C);
+      const Vec3AD X_cam = X_rot + w.cross(X_rot);
+      const Vec2T<AutoDiff18> x_ad = camera_ad.project(X_cam);
+      x(0, i) = x_ad(0).value();
+      x(1, i) = x_ad(1).value();
+      J.row(0) = x_ad(0).derivatives().transpose();
+      J.row(1) = x_ad(1).derivatives().transpose();
+      benchmark::DoNotOptimize(J.data());
+    }
+    benchmark::DoNotOptimize(x.data());
+  }
+  state.SetItemsProcessed(state.iterations() * X.cols());
+}
+
+BENCHMARK_CAPTURE(BM_ProjectPerPoint, pinhole, MakePinholeCamera)->Range(1 << 10, 1 << 18);
+BENCHMARK_CAPTURE(BM_ProjectBatch, pinhole, MakePinholeCamera)->Range(1 << 10, 1 << 18);
+BENCHMARK_CAPTURE(BM_ProjectPerPoint, brown, MakeBrownCamera<>)->Range(1 << 10, 1 << 18);
+BENCHMARK_CAPTURE(BM_ProjectBatch, brown, MakeBrownCamera<>)->Range(1 << 10, 1 << 18);
+BENCHMARK_CAPTURE(BM_ResidualPerPoint, brown, MakeBrownCamera<>)->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_ResidualBatch, brown, MakeBrownCamera<>)->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_BearingVectors, pinhole, MakePinholeCamera)->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_BearingVectors, brown, MakeBrownCamera<>)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_ProjectionMatrix);
+BENCHMARK(BM_UndistortPerPoint)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_UndistortBatch)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_UndistortGrid)->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_UndistortSolver, heikkila, MakeBrownCamera<>,
+                  &PinholeCameraBrown::undistortHeikkila)
+    ->Arg(1 << 14);
+BENCHMARK_CAPTURE(BM_UndistortSolver, newton, MakeBrownCamera<>,
+                  &PinholeCameraBrown::undistortNewton)
+    ->Arg(1 << 14);
+BENCHMARK_CAPTURE(BM_UndistortSolver, heikkila_wide, MakeWideAngleCamera,
+                  &PinholeCameraBrown::undistortHeikkila)
+    ->Arg(1 << 14);
+BENCHMARK_CAPTURE(BM_UndistortSolver, newton_wide, MakeWideAngleCamera,
+                  &PinholeCameraBrown::undistortNewton)
+    ->Arg(1 << 14);
+BENCHMARK_TEMPLATE(BM_ProjectBatchPrecision, double)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_ProjectBatchPrecision, float)->Arg(1 << 16);
+BENCHMARK(BM_ProjectJacobianAnalytic)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_ProjectJacobianBatch)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_ProjectJacobianAutoDiff)->Range(1 << 10, 1 << 16);
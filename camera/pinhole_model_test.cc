@@ -1,3 +1,316 @@
 #include "camera/pinhole_model.hpp"
+#include "camera/undistortion_grid.hpp"
 #include <gtest/gtest.h>
 
+using namespace photogrammetry::camera;
+
+class PinholeModelTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto *pinhole_params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA);
+    pinhole_params->fx = 1000.0;
+    pinhole_params->fy = 1010.0;
+    pinhole_params->cx = 640.0;
+    pinhole_params->cy = 480.0;
+    pinhole_ = std::make_unique<PinholeCameraModel>(0, 1280, 960, pinhole_params);
+
+    auto *brown_params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+    brown_params->fx = 1000.0;
+    brown_params->fy = 1010.0;
+    brown_params->cx = 640.0;
+    brown_params->cy = 480.0;
+    brown_params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+    brown_ = std::make_unique<PinholeCameraBrown>(1, 1280, 960, brown_params);
+
+    // 随机生成位于相机前方的点
+    X_ = Mat3X::Random(3, 1000);
+    X_.row(2).array() += 3.0;
+  }
+
+  std::unique_ptr<PinholeCameraModel> pinhole_;
+  std::unique_ptr<PinholeCameraBrown> brown_;
+  Mat3X X_;
+};
+
+TEST_F(PinholeModelTest, ProjectBatchMatchesPerPoint) {
+  const Mat2X x_pinhole = pinhole_->projectBatch(X_);
+  const Mat2X x_brown = brown_->projectBatch(X_);
+  const Mat2X x_brown_no_disto = brown_->projectBatch(X_, true);
+  for (Eigen::Index i = 0; i < X_.cols(); ++i) {
+    EXPECT_TRUE(x_pinhole.col(i).isApprox(pinhole_->project(X_.col(i)), 1e-12));
+    EXPECT_TRUE(x_brown.col(i).isApprox(brown_->project(X_.col(i)), 1e-12));
+    EXPECT_TRUE(x_brown_no_disto.col(i).isApprox(brown_->project(X_.col(i), true), 1e-12));
+  }
+}
+
+TEST_F(PinholeModelTest, ResidualBatchOnMappedBuffers) {
+  const Mat2X x = brown_->projectBatch(X_).array() + 0.5;
+  std::vector<double> buffer(2 * X_.cols());
+  Eigen::Map<Mat2X> r(buffer.data(), 2, X_.cols());
+  brown_->residualBatch(X_, x, r);
+  for (Eigen::Index i = 0; i < X_.cols(); ++i) {
+    EXPECT_NEAR(r(0, i), 0.5, 1e-9);
+    EXPECT_NEAR(r(1, i), 0.5, 1e-9);
+  }
+}
+
+TEST_F(PinholeModelTest, UndistortBatchInvertsDistort) {
+  const Mat2X points = X_.colwise().hnormalized();
+  const Mat2X distorted = brown_->distortBatch(points);
+  const Mat2X undistorted = brown_->undistortBatch(distorted);
+  for (Eigen::Index i = 0; i < points.cols(); ++i) {
+    EXPECT_TRUE(distorted.col(i).isApprox(brown_->distort(points.col(i)), 1e-12));
+    EXPECT_NEAR((undistorted.col(i) - points.col(i)).norm(), 0.0, 1e-9);
+  }
+}
+
+TEST_F(PinholeModelTest, UndistortionGridMeetsAccuracyBound) {
+  UndistortionGridOptions options;
+  options.max_error = 1e-3;
+  UndistortionGrid grid(options);
+  const Mat2X points = brown_->distortBatch(X_.colwise().hnormalized());
+  const Mat2X undistorted = grid.undistortBatch(*brown_, points);
+  EXPECT_LE(grid.MaxError(), options.max_error);
+  for (Eigen::Index i = 0; i < points.cols(); ++i) {
+    const Vec2 pixel = brown_->cam2ima(points.col(i));
+    const Vec2 reprojected = brown_->cam2ima(brown_->distort(undistorted.col(i)));
+    EXPECT_LE((reprojected - pixel).norm(), options.max_error);
+  }
+}
+
+TEST_F(PinholeModelTest, UndistortionGridInvalidatedByParamsUpdate) {
+  UndistortionGrid grid;
+  const Vec2 point(0.1, -0.05);
+  const Vec2 before = grid.undistort(*brown_, point);
+
+  std::vector<double> params = brown_->getVariableParams();
+  params[4] = -0.2;
+  ASSERT_TRUE(brown_->updateFromVariableParams(params));
+  EXPECT_DOUBLE_EQ(brown_->DistortionParams()[0], -0.2);
+
+  const Vec2 after = grid.undistort(*brown_, point);
+  EXPECT_FALSE(before.isApprox(after, 1e-6));
+  EXPECT_NEAR((after - brown_->undistort(point)).norm(), 0.0, 1e-5);
+}
+
+TEST_F(PinholeModelTest, UndistortionGridDistinguishesCamerasWithSameId) {
+  UndistortionGrid grid;
+  const Vec2 point(0.1, -0.05);
+  grid.Build(*brown_);
+
+  // 拷贝后修改一次内参: 相机 ID 与版本号都与另一份拷贝相同, 但内参不同
+  PinholeCameraBrown copy1 = *brown_, copy2 = *brown_;
+  std::vector<double> params = brown_->getVariableParams();
+  params[4] = -0.2;
+  ASSERT_TRUE(copy1.updateFromVariableParams(params));
+  params[4] = 0.05;
+  ASSERT_TRUE(copy2.updateFromVariableParams(params));
+  ASSERT_EQ(copy1.CameraId(), copy2.CameraId());
+  ASSERT_EQ(copy1.ParamsVersion(), copy2.ParamsVersion());
+  EXPECT_NEAR((grid.undistort(copy1, point) - copy1.undistort(point)).norm(), 0.0, 1e-5);
+  EXPECT_NEAR((grid.undistort(copy2, point) - copy2.undistort(point)).norm(), 0.0, 1e-5);
+}
+
+TEST_F(PinholeModelTest, DistortJacobianMatchesFiniteDifference) {
+  const double h = 1e-7;
+  for (Eigen::Index i = 0; i < 100; ++i) {
+    const Vec2 p = X_.col(i).hnormalized();
+    const Mat22 J = brown_->distortJacobian(p);
+    Mat22 J_numeric;
+    for (int k = 0; k < 2; ++k) {
+      const Vec2 dp = Vec2::Unit(k) * h;
+      J_numeric.col(k) = (brown_->distort(p + dp) - brown_->distort(p - dp)) / (2 * h);
+    }
+    EXPECT_TRUE(J.isApprox(J_numeric, 1e-6));
+  }
+}
+
+TEST_F(PinholeModelTest, NewtonUndistortConvergesWhereFixedPointFails) {
+  // 强桶形畸变, 靠近图像边缘时不动点迭代不收敛
+  std::vector<double> params = brown_->getVariableParams();
+  params[4] = -0.35;
+  params[5] = 0.12;
+  ASSERT_TRUE(brown_->updateFromVariableParams(params));
+  const Vec2 point = brown_->distort(Vec2(0.75, 0.55));
+
+  UndistortOptions options;
+  UndistortSummary heikkila, newton;
+  brown_->undistortHeikkila(point, options, &heikkila);
+  const Vec2 p_u = brown_->undistortNewton(point, options, &newton);
+  EXPECT_EQ(heikkila.status, UndistortStatus::NO_CONVERGENCE);
+  EXPECT_EQ(heikkila.iterations, options.max_iterations);
+  EXPECT_EQ(newton.status, UndistortStatus::CONVERGED);
+  EXPECT_LT(newton.iterations, 10);
+  EXPECT_NEAR((p_u - Vec2(0.75, 0.55)).norm(), 0.0, 1e-9);
+}
+
+TEST_F(PinholeModelTest, NewtonUndistortBatchReportsStatus) {
+  const Mat2X points = brown_->distortBatch(X_.colwise().hnormalized());
+  Mat2X out(2, points.cols());
+  std::vector<UndistortSummary> summaries;
+  const UndistortSummary total = brown_->undistortBatch(points, out, UndistortOptions(), &summaries);
+  EXPECT_EQ(total.status, UndistortStatus::CONVERGED);
+  EXPECT_EQ(total.num_converged, static_cast<size_t>(points.cols()));
+  ASSERT_EQ(summaries.size(), static_cast<size_t>(points.cols()));
+  for (Eigen::Index i = 0; i < points.cols(); ++i) {
+    UndistortSummary summary;
+    const Vec2 expected = brown_->undistortNewton(points.col(i), UndistortOptions(), &summary);
+    EXPECT_NEAR((out.col(i) - expected).norm(), 0.0, 1e-12);
+    EXPECT_EQ(summaries[i].iterations, summary.iterations);
+  }
+
+  UndistortOptions one_step;
+  one_step.max_iterations = 1;
+  const UndistortSummary capped = brown_->undistortBatch(points, out, one_step);
+  EXPECT_EQ(capped.status, UndistortStatus::NO_CONVERGENCE);
+  EXPECT_EQ(capped.iterations, 1);
+}
+
+TEST_F(PinholeModelTest, CachedIntrinsicMatrixFollowsUpdates) {
+  std::vector<double> params = brown_->getVariableParams();
+  params[0] = 1200.0;
+  params[3] = 500.0;
+  ASSERT_TRUE(brown_->updateFromVariableParams(params));
+  const Mat33 K = (Mat33() << 1200.0, 0, 640.0, 0, 1010.0, 500.0, 0, 0, 1).finished();
+  EXPECT_TRUE(brown_->IntrinsicsMatrix().isApprox(K));
+  EXPECT_TRUE((brown_->InverseIntrinsicsMatrix() * K).isIdentity(1e-12));
+
+  // 按值拷贝后互不影响
+  PinholeCameraBrown copy = *brown_;
+  params[0] = 800.0;
+  ASSERT_TRUE(brown_->updateFromVariableParams(params));
+  EXPECT_DOUBLE_EQ(copy.IntrinsicsMatrix()(0, 0), 1200.0);
+  EXPECT_DOUBLE_EQ(brown_->IntrinsicsMatrix()(0, 0), 800.0);
+}
+
+TEST_F(PinholeModelTest, MismatchedInitParamsAreRejected) {
+  // 畸变参数个数与模型不一致: 构造时抛出异常, InitCamera 返回 false 且内参不变, 参数都被释放
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 500.0;
+  params->distortion = {-0.1};
+  EXPECT_THROW(PinholeCameraBrown(2, 1280, 960, params), std::invalid_argument);
+
+  const auto version = brown_->ParamsVersion();
+  params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 500.0;
+  EXPECT_FALSE(brown_->InitCamera(params));
+  EXPECT_FALSE(brown_->InitCamera(new PinholeCameraInitParams(CameraModelType::NONE)));
+  EXPECT_FALSE(brown_->InitCamera(nullptr));
+  EXPECT_DOUBLE_EQ(brown_->Intrinsics().FocalLengthX(), 1000.0);
+  EXPECT_EQ(brown_->ParamsVersion(), version);
+}
+
+TEST_F(PinholeModelTest, FloatModelMatchesDouble) {
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 1000.0;
+  params->fy = 1010.0;
+  params->cx = 640.0;
+  params->cy = 480.0;
+  params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+  const PinholeCameraBrownf brown_f(1, 1280, 960, params);
+
+  const Mat2X x = brown_->projectBatch(X_);
+  const Mat2Xf x_f = brown_f.projectBatch(X_.cast<float>());
+  EXPECT_LT((x_f.cast<double>() - x).cwiseAbs().maxCoeff(), 1e-3);
+  for (Eigen::Index i = 0; i < 10; ++i) {
+    EXPECT_LT((brown_f.project(X_.col(i).cast<float>()).cast<double>() - x.col(i)).norm(), 1e-3);
+  }
+
+  UndistortOptions options;
+  options.tolerance = 1e-6;
+  UndistortSummary summary;
+  const Vec2f p_u = brown_f.undistortNewton(Vec2f(0.3f, -0.2f), options, &summary);
+  EXPECT_EQ(summary.status, UndistortStatus::CONVERGED);
+  EXPECT_LT((p_u.cast<double>() - brown_->undistort(Vec2(0.3, -0.2))).norm(), 1e-5);
+}
+
+namespace {
+// 对投影函数做中心差分, 检验 projectJacobian 的解析雅可比
+template <typename CameraType>
+void CheckProjectJacobian(const CameraType &camera, const CameraExtrinsicParams &pose,
+                          const Vec3 &X, const IntrinsicParameterType adjust) {
+  const double h = 1e-6;
+  typename CameraType::PointJacobian J_point;
+  typename CameraType::PoseJacobian J_pose;
+  typename CameraType::IntrinsicJacobian J_intrinsics;
+  const Vec2 x = camera.projectJacobian(pose, X, &J_point, &J_pose, &J_intrinsics, adjust);
+  EXPECT_TRUE(x.isApprox(camera.project(pose(X)), 1e-12));
+
+  for (int k = 0; k < 3; ++k) {
+    const Vec3 dX = Vec3::Unit(k) * h;
+    const Vec2 fd = (camera.project(pose(Vec3(X + dX))) - camera.project(pose(Vec3(X - dX)))) /
+                    (2 * h);
+    EXPECT_LT((fd - J_point.col(k)).norm(), 1e-4 * (1 + fd.norm())) << "point " << k;
+  }
+  for (int k = 0; k < 6; ++k) {
+    CameraExtrinsicParams plus = pose, minus = pose;
+    if (k < 3) {
+      plus.Rotation() = Eigen::AngleAxisd(h, Vec3::Unit(k)).toRotationMatrix() * pose.Rotation();
+      minus.Rotation() = Eigen::AngleAxisd(-h, Vec3::Unit(k)).toRotationMatrix() * pose.Rotation();
+    } else {
+      plus.Center()(k - 3) += h;
+      minus.Center()(k - 3) -= h;
+    }
+    const Vec2 fd = (camera.project(plus(X)) - camera.project(minus(X))) / (2 * h);
+    EXPECT_LT((fd - J_pose.col(k)).norm(), 1e-4 * (1 + fd.norm())) << "pose " << k;
+  }
+  const std::vector<double> params = camera.getVariableParams();
+  ASSERT_EQ(static_cast<int>(params.size()), CameraType::kNumIntrinsicParams);
+  for (int k = 0; k < CameraType::kNumIntrinsicParams; ++k) {
+    const bool adjusted =
+        isIntrinsicAdjusted(adjust, k < 2   ? IntrinsicParameterType::ADJUST_FOCAL_LENGTH
+                                    : k < 4 ? IntrinsicParameterType::ADJUST_PRINCIPAL_POINT
+                                            : IntrinsicParameterType::ADJUST_DISTORTION);
+    if (!adjusted) {
+      EXPECT_TRUE(J_intrinsics.col(k).isZero()) << "intrinsic " << k;
+      continue;
+    }
+    CameraType plus = camera, minus = camera;
+    std::vector<double> params_plus = params, params_minus = params;
+    params_plus[k] += h;
+    params_minus[k] -= h;
+    ASSERT_TRUE(plus.updateFromVariableParams(params_plus));
+    ASSERT_TRUE(minus.updateFromVariableParams(params_minus));
+    const Vec2 fd = (plus.project(pose(X)) - minus.project(pose(X))) / (2 * h);
+    EXPECT_LT((fd - J_intrinsics.col(k)).norm(), 1e-4 * (1 + fd.norm())) << "intrinsic " << k;
+  }
+}
+} // namespace
+
+TEST_F(PinholeModelTest, ProjectJacobianMatchesFiniteDifference) {
+  const CameraExtrinsicParams pose(
+      Eigen::AngleAxisd(0.3, Vec3(0.2, -1.0, 0.5).normalized()).toRotationMatrix(),
+      Vec3(0.4, -0.3, -2.0));
+  const IntrinsicParameterType masks[] = {
+      IntrinsicParameterType::ADJUST_ALL, IntrinsicParameterType::ADJUST_FOCAL_LENGTH,
+      IntrinsicParameterType::ADJUST_PRINCIPAL_POINT | IntrinsicParameterType::ADJUST_DISTORTION,
+      IntrinsicParameterType::NONE};
+  for (const IntrinsicParameterType adjust : masks) {
+    for (Eigen::Index i = 0; i < 20; ++i) {
+      const Vec3 X = X_.col(i) - Vec3(0.0, 0.0, 3.0);
+      CheckProjectJacobian(*pinhole_, pose, X, adjust);
+      CheckProjectJacobian(*brown_, pose, X, adjust);
+    }
+  }
+}
+
+TEST_F(PinholeModelTest, ProjectJacobianBatchMatchesPerPoint) {
+  const CameraExtrinsicParams pose(Eigen::AngleAxisd(0.1, Vec3::UnitY()).toRotationMatrix(),
+                                   Vec3(0.1, 0.2, -0.5));
+  Mat2X x(2, X_.cols());
+  PinholeCameraBrown::JacobianMatrix J_point, J_pose, J_intrinsics;
+  brown_->projectJacobianBatch(pose, X_, x, &J_point, &J_pose, &J_intrinsics);
+  ASSERT_EQ(J_point.rows(), 2 * X_.cols());
+  ASSERT_EQ(J_intrinsics.cols(), PinholeCameraBrown::kNumIntrinsicParams);
+  for (Eigen::Index i = 0; i < X_.cols(); i += 97) {
+    PinholeCameraBrown::PointJacobian J_point_i;
+    PinholeCameraBrown::PoseJacobian J_pose_i;
+    PinholeCameraBrown::IntrinsicJacobian J_intrinsics_i;
+    const Vec2 x_i =
+        brown_->projectJacobian(pose, X_.col(i), &J_point_i, &J_pose_i, &J_intrinsics_i);
+    EXPECT_TRUE(x.col(i).isApprox(x_i));
+    EXPECT_TRUE(J_point.middleRows<2>(2 * i).isApprox(J_point_i));
+    EXPECT_TRUE(J_pose.middleRows<2>(2 * i).isApprox(J_pose_i));
+    EXPECT_TRUE(J_intrinsics.middleRows<2>(2 * i).isApprox(J_intrinsics_i));
+  }
+}
@@ -1,5 +1,6 @@
 #ifndef PHOTOGRAMMETRY_STD_TYPES_HPP
 #define PHOTOGRAMMETRY_STD_TYPES_HPP
+#include "utils/flat_hash_map.hpp"
 // std
 #include <condition_variable>
 #include <map>
@@ -32,6 +33,25 @@ const point3D_t UINvaliedPoint3DId =
 /// Standard Pair of camera_t
 using Pair = std::pair<camera_t, camera_t>;
 
+/**
+ * @brief Id of an unordered image pair, the smaller image id is stored in the upper 32 bits
+ */
+inline image_pair_t ImagePairToPairId(const image_t image_id1, const image_t image_id2) {
+  return image_id1 < image_id2
+             ? (static_cast<image_pair_t>(image_id1) << 32) | image_id2
+             : (static_cast<image_pair_t>(image_id2) << 32) | image_id1;
+}
+
+/// Inverse of ImagePairToPairId, the first image has the smaller id
+inline Pair PairIdToImagePair(const image_pair_t pair_id) {
+  return Pair(static_cast<image_t>(pair_id >> 32), static_cast<image_t>(pair_id));
+}
+
+/// True if data of the pair (image_id1, image_id2) must be swapped to match its pair id order
+inline bool SwapImagePair(const image_t image_id1, const image_t image_id2) {
+  return image_id1 > image_id2;
+}
+
 /**
  * @brief Standard Hash_Map class
  * @tparam K type of the keys
@@ -39,21 +59,28 @@ using Pair = std::pair<camera_t, camera_t>;
  */
 template <typename Key, typename Value>
 using Hash_Map = std::unordered_map<Key, Value>;
+
+/**
+ * @brief Flat open addressing hash map, for large maps of ids such as image pairs and points
+ *
+ * Entries are stored inline, so unlike Hash_Map insertions may invalidate references to entries.
+ * @tparam K type of the keys
+ * @tparam V type of the values
+ */
+template <typename Key, typename Value>
+using Flat_Hash_Map = utils::FlatHashMap<Key, Value>;
 } // namespace photogrammetry
 
 namespace std {
 /**
  * @brief 特化 std::hash 模板类，用于计算 Pair 类型的哈希值
- * @tparam K 键类型
- * @tparam V 值类型
+ *
+ * 两个 id 拼成一个 64 位整数后再混合，(a,b) 与 (b,a) 以及 (a,a) 不会互相冲突
  */
 template <> struct hash<photogrammetry::Pair> {
   size_t operator()(const photogrammetry::Pair &p) const {
-    // 实现哈希函数，将 Pair 类型转换为 size_t 类型的哈希值
-    size_t hash_value = 0;
-    hash_value ^= std::hash<photogrammetry::camera_t>{}(p.first);
-    hash_value ^= std::hash<photogrammetry::camera_t>{}(p.second);
-    return hash_value;
+    const uint64_t key = (static_cast<uint64_t>(p.first) << 32) | p.second;
+    return static_cast<size_t>(photogrammetry::utils::MixHash(key));
   }
 };
 } // namespace std
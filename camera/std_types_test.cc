@@ -0,0 +1,43 @@
+#include "camera/std_types.hpp"
+#include <gtest/gtest.h>
+#include <unordered_set>
+
+using namespace photogrammetry;
+
+TEST(StdTypesTest, PairHashIsOrderSensitive) {
+  const std::hash<Pair> hash;
+  EXPECT_NE(hash(Pair(1, 2)), hash(Pair(2, 1)));
+  EXPECT_NE(hash(Pair(3, 3)), hash(Pair(4, 4)));
+  EXPECT_NE(hash(Pair(0, 1)), hash(Pair(1, 0)));
+}
+
+TEST(StdTypesTest, PairHashHasNoCollisionsOnSmallIds) {
+  const std::hash<Pair> hash;
+  std::unordered_set<size_t> hashes;
+  for (camera_t a = 0; a < 200; ++a) {
+    for (camera_t b = 0; b < 200; ++b) {
+      hashes.insert(hash(Pair(a, b)));
+    }
+  }
+  EXPECT_EQ(hashes.size(), 200u * 200u);
+}
+
+TEST(StdTypesTest, FlatHashMapOfPairs) {
+  Flat_Hash_Map<Pair, int> matches;
+  for (camera_t a = 0; a < 100; ++a) {
+    matches[Pair(a, a + 1)] = static_cast<int>(a);
+  }
+  EXPECT_EQ(matches.size(), 100u);
+  EXPECT_EQ(matches.at(Pair(41, 42)), 41);
+  EXPECT_FALSE(matches.contains(Pair(42, 41)));
+}
+
+TEST(StdTypesTest, ImagePairId) {
+  EXPECT_EQ(ImagePairToPairId(3, 7), ImagePairToPairId(7, 3));
+  EXPECT_NE(ImagePairToPairId(3, 7), ImagePairToPairId(3, 8));
+  EXPECT_EQ(PairIdToImagePair(ImagePairToPairId(7, 3)), Pair(3, 7));
+  EXPECT_EQ(PairIdToImagePair(ImagePairToPairId(UINvaliedImageId - 1, 0)),
+            Pair(0, UINvaliedImageId - 1));
+  EXPECT_TRUE(SwapImagePair(7, 3));
+  EXPECT_FALSE(SwapImagePair(3, 7));
+}
@@ -0,0 +1,218 @@
+#ifndef PHOTOGRAMMETRY_UNDISTORTION_GRID_HPP
+#define PHOTOGRAMMETRY_UNDISTORTION_GRID_HPP
+
+#include "camera/camera_model.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace photogrammetry {
+namespace camera {
+
+struct UndistortionGridOptions {
+  // 初始网格间距(像素)
+  double cell_size = 8.0;
+  // 插值精度上限(像素), 建表后在每个网格中心检验, 超出则加密网格重建
+  double max_error = 1e-2;
+  // 最多加密(网格间距减半)的次数
+  int max_subdivisions = 3;
+  // 插值后额外进行的不动点迭代次数, 0 表示只查表
+  int refine_iterations = 0;
+  // 网格覆盖范围在图像四周向外扩展的像素数
+  double margin = 16.0;
+};
+
+/*
+ * @brief 去畸变查找表
+ * 在图像范围内建立稠密网格, 每个节点保存畸变像素对应的去畸变归一化坐标,
+ * 查询时双线性插值, 代价约等于一次查表。
+ * 查找表在第一次查询时构建, 相机的模型类型、图像尺寸或内参的值(IntrinsicsKey)变化后自动重建,
+ * 因此 updateFromVariableParams 之后, 或换用 ID 相同而内参不同的相机时, 不会使用过期的表。
+ * 超出网格范围的点退回到相机模型的迭代去畸变。
+ */
+class UndistortionGrid {
+public:
+  explicit UndistortionGrid(const UndistortionGridOptions &options = UndistortionGridOptions())
+      : options_(options) {}
+
+  UndistortionGrid(const UndistortionGrid &) = delete;
+  UndistortionGrid &operator=(const UndistortionGrid &) = delete;
+
+  const UndistortionGridOptions &Options() const { return options_; }
+
+  /*
+   * @brief 预先构建(或重建)查找表
+   * @param camera 相机模型
+   */
+  template <typename CameraType>
+  void Build(const CameraType &camera) const {
+    Acquire(camera);
+  }
+
+  // 当前查找表在网格中心处测得的最大插值误差(像素), 尚未建表时返回负数
+  double MaxError() const {
+    const std::shared_ptr<const Table> table = std::atomic_load(&table_);
+    return table ? table->max_error : -1.0;
+  }
+
+  // 当前查找表的网格间距(像素), 尚未建表时返回负数
+  double CellSize() const {
+    const std::shared_ptr<const Table> table = std::atomic_load(&table_);
+    return table ? table->cell_size : -1.0;
+  }
+
+  /*
+   * @brief 去畸变（在归一化摄像机平面上）
+   * @param camera 相机模型
+   * @param point_distorted 畸变点
+   * @return 去畸变后的点
+   */
+  template <typename CameraType>
+  Vec2 undistort(const CameraType &camera, const Vec2 &point_distorted) const {
+    const std::shared_ptr<const Table> table = Acquire(camera);
+    return Lookup(*table, camera, point_distorted);
+  }
+
+  /*
+   * @brief 批量去畸变, 每批只检查一次查找表是否有效
+   * @param camera 相机模型
+   * @param points 畸变点 (2xN)
+   * @param out 输出的去畸变点 (2xN), 需预先分配好大小
+   */
+  template <typename CameraType>
+  void undistortBatch(const CameraType &camera, const Eigen::Ref<const Mat2X> &points,
+                      Eigen::Ref<Mat2X> out) const {
+    const std::shared_ptr<const Table> table = Acquire(camera);
+    for (Eigen::Index i = 0; i < points.cols(); ++i) {
+      out.col(i) = Lookup(*table, camera, points.col(i));
+    }
+  }
+  template <typename CameraType>
+  Mat2X undistortBatch(const CameraType &camera, const Mat2X &points) const {
+    Mat2X out(2, points.cols());
+    undistortBatch(camera, points, out);
+    return out;
+  }
+
+private:
+  struct Table {
+    // 生成该表的相机
+    IntrinsicsKey key;
+    // 网格原点(像素)与间距
+    double x0, y0, cell_size;
+    Eigen::Index nx, ny;
+    // 各节点的去畸变归一化坐标, 行优先
+    std::vector<double> ux, uy;
+    double max_error;
+  };
+
+  template <typename CameraType>
+  std::shared_ptr<const Table> Acquire(const CameraType &camera) const {
+    static_assert(std::is_same<typename CameraType::Scalar, double>::value,
+                  "UndistortionGrid only supports double precision camera models");
+    std::shared_ptr<const Table> table = std::atomic_load(&table_);
+    if (table && table->key.Matches(camera)) {
+      return table;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    table = std::atomic_load(&table_);
+    if (!table || !table->key.Matches(camera)) {
+      table = BuildTable(camera);
+      std::atomic_store(&table_, table);
+    }
+    return table;
+  }
+
+  template <typename CameraType>
+  std::shared_ptr<const Table> BuildTable(const CameraType &camera) const {
+    const IntrinsicsKey key(camera);
+    double cell_size = options_.cell_size;
+    std::shared_ptr<Table> table;
+    for (int level = 0; level <= options_.max_subdivisions; ++level, cell_size *= 0.5) {
+      table = std::make_shared<Table>();
+      table->key = key;
+      table->x0 = -options_.margin;
+      table->y0 = -options_.margin;
+      table->cell_size = cell_size;
+      table->nx = static_cast<Eigen::Index>(
+                      std::ceil((camera.width() + 2 * options_.margin) / cell_size)) + 1;
+      table->ny = static_cast<Eigen::Index>(
+                      std::ceil((camera.height() + 2 * options_.margin) / cell_size)) + 1;
+      table->ux.resize(table->nx * table->ny);
+      table->uy.resize(table->nx * table->ny);
+      for (Eigen::Index j = 0; j < table->ny; ++j) {
+        for (Eigen::Index i = 0; i < table->nx; ++i) {
+          const Vec2 pixel(table->x0 + i * cell_size, table->y0 + j * cell_size);
+          const Vec2 p_u = camera.undistort(camera.ima2cam(pixel));
+          table->ux[j * table->nx + i] = p_u.x();
+          table->uy[j * table->nx + i] = p_u.y();
+        }
+      }
+      // 在网格中心检验插值误差: 对插值结果重新加畸变, 与查询像素比较
+      table->max_error = 0.0;
+      for (Eigen::Index j = 0; j + 1 < table->ny; ++j) {
+        for (Eigen::Index i = 0; i + 1 < table->nx; ++i) {
+          const Vec2 pixel(table->x0 + (i + 0.5) * cell_size, table->y0 + (j + 0.5) * cell_size);
+          Vec2 p_u = Vec2::Zero();
+          Interpolate(*table, pixel, &p_u);
+          const double error = (camera.cam2ima(camera.distort(p_u)) - pixel).norm();
+          table->max_error = std::max(table->max_error, error);
+        }
+      }
+      if (table->max_error <= options_.max_error) {
+        break;
+      }
+    }
+    return table;
+  }
+
+  /*
+   * @brief 双线性插值
+   * @return 像素位于网格范围内时返回 true
+   */
+  static bool Interpolate(const Table &table, const Vec2 &pixel, Vec2 *p_u) {
+    const double gx = (pixel.x() - table.x0) / table.cell_size;
+    const double gy = (pixel.y() - table.y0) / table.cell_size;
+    if (!(gx >= 0.0 && gy >= 0.0 && gx <= table.nx - 1 && gy <= table.ny - 1)) {
+      return false;
+    }
+    const Eigen::Index i = std::min(static_cast<Eigen::Index>(gx), table.nx - 2);
+    const Eigen::Index j = std::min(static_cast<Eigen::Index>(gy), table.ny - 2);
+    const double ax = gx - i;
+    const double ay = gy - j;
+    const Eigen::Index idx = j * table.nx + i;
+    const double w00 = (1 - ax) * (1 - ay), w10 = ax * (1 - ay);
+    const double w01 = (1 - ax) * ay, w11 = ax * ay;
+    (*p_u) << w00 * table.ux[idx] + w10 * table.ux[idx + 1] + w01 * table.ux[idx + table.nx] +
+                  w11 * table.ux[idx + table.nx + 1],
+        w00 * table.uy[idx] + w10 * table.uy[idx + 1] + w01 * table.uy[idx + table.nx] +
+            w11 * table.uy[idx + table.nx + 1];
+    return true;
+  }
+
+  template <typename CameraType>
+  Vec2 Lookup(const Table &table, const CameraType &camera, const Vec2 &point_distorted) const {
+    Vec2 p_u = Vec2::Zero();
+    if (!Interpolate(table, camera.cam2ima(point_distorted), &p_u)) {
+      return camera.undistort(point_distorted);
+    }
+    // 不动点迭代细化: p_u = p_d - (distort(p_u) - p_u)
+    for (int it = 0; it < options_.refine_iterations; ++it) {
+      p_u = point_distorted - (camera.distort(p_u) - p_u);
+    }
+    return p_u;
+  }
+
+  UndistortionGridOptions options_;
+  mutable std::mutex mutex_;
+  mutable std::shared_ptr<const Table> table_;
+};
+
+} // namespace camera
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_UNDISTORTION_GRID_HPP
@@ -42,14 +42,23 @@ macro(PHOTOGRAMMETRY_ADD_LIBRARY)
     set(multi_value_args "NAME" "SOURCES" "HEADERS" "PUBLIC_LINK_LIBRARIES" "PRIVATE_LINK_LIBRARIES")
     # Parse the arguments
     cmake_parse_arguments(PHOTOGRAMMETRY_ADD_LIBRARY "${options}" "${single_value_args}" "${multi_value_args}" ${ARGN})
-    # Add the library
-    add_library(${PHOTOGRAMMETRY_ADD_LIBRARY_NAME} STATIC ${PHOTOGRAMMETRY_ADD_LIBRARY_SOURCES} ${PHOTOGRAMMETRY_ADD_LIBRARY_HEADERS})
-    # Link the library against the specified libraries
-    target_link_libraries(${PHOTOGRAMMETRY_ADD_LIBRARY_NAME}
-        PRIVATE
-        ${PHOTOGRAMMETRY_ADD_LIBRARY_PRIVATE_LINK_LIBRARIES}
-        PUBLIC
-        ${PHOTOGRAMMETRY_ADD_LIBRARY_PUBLIC_LINK_LIBRARIES})
+    if(PHOTOGRAMMETRY_ADD_LIBRARY_SOURCES)
+        # Add the library
+        add_library(${PHOTOGRAMMETRY_ADD_LIBRARY_NAME} STATIC ${PHOTOGRAMMETRY_ADD_LIBRARY_SOURCES} ${PHOTOGRAMMETRY_ADD_LIBRARY_HEADERS})
+        # Link the library against the specified libraries
+        target_link_libraries(${PHOTOGRAMMETRY_ADD_LIBRARY_NAME}
+            PRIVATE
+            ${PHOTOGRAMMETRY_ADD_LIBRARY_PRIVATE_LINK_LIBRARIES}
+            PUBLIC
+            ${PHOTOGRAMMETRY_ADD_LIBRARY_PUBLIC_LINK_LIBRARIES})
+    else()
+        # Header-only library, nothing to compile
+        add_library(${PHOTOGRAMMETRY_ADD_LIBRARY_NAME} INTERFACE)
+        target_link_libraries(${PHOTOGRAMMETRY_ADD_LIBRARY_NAME}
+            INTERFACE
+            ${PHOTOGRAMMETRY_ADD_LIBRARY_PUBLIC_LINK_LIBRARIES}
+            ${PHOTOGRAMMETRY_ADD_LIBRARY_PRIVATE_LINK_LIBRARIES})
+    endif()
 endmacro(PHOTOGRAMMETRY_ADD_LIBRARY)
 
 # This macro will add an executable to the project.
@@ -113,6 +122,69 @@ macro(PHOTOGRAMMETRY_ADD_TEST)
     endif()
 endmacro(PHOTOGRAMMETRY_ADD_TEST)
 
+# This macro will add a benchmark to the project.
+# The usage of the macro is as follows:
+# PHOTOGRAMMETRY_ADD_BENCHMARK(
+#     NAME <benchmark name>
+#     SOURCES <source files>
+#     HEADERS <header files>
+#     PUBLIC_LINK_LIBRARIES <libraries to link against>
+#     PRIVATE_LINK_LIBRARIES <libraries to link against>
+# )
+macro(PHOTOGRAMMETRY_ADD_BENCHMARK)
+    # Set the options
+    set(options)
+    # Set the single-value arguments
+    set(single_value_args)
+    # Set the multi-value arguments
+    set(multi_value_args "NAME" "SOURCES" "HEADERS" "PUBLIC_LINK_LIBRARIES" "PRIVATE_LINK_LIBRARIES")
+    # Parse the arguments
+    cmake_parse_arguments(PHOTOGRAMMETRY_ADD_BENCHMARK "${options}" "${single_value_args}" "${multi_value_args}" ${ARGN})
+    if(BENCHMARKS_ENABLED)
+        set(PHOTOGRAMMETRY_ADD_BENCHMARK_NAME "photogrammetry_${FOLDER_NAME}_${PHOTOGRAMMETRY_ADD_BENCHMARK_NAME}")
+        add_executable(${PHOTOGRAMMETRY_ADD_BENCHMARK_NAME} ${PHOTOGRAMMETRY_ADD_BENCHMARK_SOURCES} ${PHOTOGRAMMETRY_ADD_BENCHMARK_HEADERS})
+        target_link_libraries(${PHOTOGRAMMETRY_ADD_BENCHMARK_NAME}
+            PRIVATE
+            ${PHOTOGRAMMETRY_ADD_BENCHMARK_PRIVATE_LINK_LIBRARIES}
+            benchmark::benchmark_main
+            benchmark::benchmark
+            PUBLIC
+            ${PHOTOGRAMMETRY_ADD_BENCHMARK_PUBLIC_LINK_LIBRARIES})
+        set_property(GLOBAL APPEND PROPERTY PHOTOGRAMMETRY_BENCHMARK_TARGETS ${PHOTOGRAMMETRY_ADD_BENCHMARK_NAME})
+    endif()
+endmacro(PHOTOGRAMMETRY_ADD_BENCHMARK)
+
+# This macro will add a run_benchmarks target that runs every benchmark added
+# with PHOTOGRAMMETRY_ADD_BENCHMARK and writes one JSON result file per
+# benchmark to BENCHMARK_OUTPUT_DIR. Extra arguments for all benchmarks, such
+# as --benchmark_filter or --benchmark_repetitions, are taken from
+# BENCHMARK_ARGS. Results of two runs are compared with
+# scripts/compare_benchmarks.py.
+# The usage of the macro is as follows:
+# PHOTOGRAMMETRY_ADD_BENCHMARK_RUNNER()
+macro(PHOTOGRAMMETRY_ADD_BENCHMARK_RUNNER)
+    if(BENCHMARKS_ENABLED)
+        get_property(PHOTOGRAMMETRY_BENCHMARK_TARGETS GLOBAL PROPERTY PHOTOGRAMMETRY_BENCHMARK_TARGETS)
+        set(PHOTOGRAMMETRY_BENCHMARK_COMMANDS COMMAND ${CMAKE_COMMAND} -E make_directory ${BENCHMARK_OUTPUT_DIR})
+        foreach(target ${PHOTOGRAMMETRY_BENCHMARK_TARGETS})
+            list(APPEND PHOTOGRAMMETRY_BENCHMARK_COMMANDS
+                COMMAND $<TARGET_FILE:${target}>
+                --benchmark_out=${BENCHMARK_OUTPUT_DIR}/${target}.json
+                --benchmark_out_format=json
+                ${BENCHMARK_ARGS})
+        endforeach()
+        add_custom_target(run_benchmarks
+            ${PHOTOGRAMMETRY_BENCHMARK_COMMANDS}
+            DEPENDS ${PHOTOGRAMMETRY_BENCHMARK_TARGETS}
+            COMMENT "Writing benchmark results to ${BENCHMARK_OUTPUT_DIR}"
+            VERBATIM)
+        # Clean-up.
+        unset(PHOTOGRAMMETRY_BENCHMARK_TARGETS)
+        unset(PHOTOGRAMMETRY_BENCHMARK_COMMANDS)
+        unset(target)
+    endif()
+endmacro(PHOTOGRAMMETRY_ADD_BENCHMARK_RUNNER)
+
 # This macro will remove *_test.cc files from the source group.
 # The usage of the macro is as follows:
 # PHOTOGRAMMETRY_REMOVE_TEST_FILES(
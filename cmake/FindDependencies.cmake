@@ -10,9 +10,15 @@ else()
 endif()
 
 find_package(OpenCV ${PHOTOGRAMMETRY_FIND_TYPE})
-find_package(Ceres ${PHOTOGRAMMETRY_FIND_TYPE})
+if(OpenCV_FOUND)
+    add_definitions("-DPHOTOGRAMMETRY_OPENCV_ENABLED")
+endif()
+# The optim module uses ceres::Manifold, which needs Ceres 2.1 or newer
+find_package(Ceres 2.1 ${PHOTOGRAMMETRY_FIND_TYPE})
 find_package(Eigen3 ${PHOTOGRAMMETRY_FIND_TYPE})
 
+find_package(Threads ${PHOTOGRAMMETRY_FIND_TYPE})
+
 find_package(OpenMP ${PHOTOGRAMMETRY_FIND_TYPE})
 if(OPENMP_ENABLED AND OPENMP_FOUND)
     message(STATUS "Enabling OpenMP support")
@@ -24,3 +30,7 @@ endif()
 if(TESTS_ENABLED)
     find_package(GTest ${PHOTOGRAMMETRY_FIND_TYPE})
 endif()
+
+if(BENCHMARKS_ENABLED)
+    find_package(benchmark ${PHOTOGRAMMETRY_FIND_TYPE})
+endif()
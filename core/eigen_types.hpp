@@ -3,6 +3,7 @@
 
 // Eigen library
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 
 // typedefs for eigen
 // double matricies
@@ -84,4 +85,25 @@ typedef Eigen::Matrix<float, 9, 1> Vec9f;
 typedef Eigen::Matrix<float, Eigen::Dynamic, 1> VecXf;
 typedef Eigen::Matrix<float, 14, 1> Vec14f;
 
+// scalar templated matricies, used by code shared between float, double and ceres::Jet
+template <typename T>
+using Vec2T = Eigen::Matrix<T, 2, 1>;
+template <typename T>
+using Vec3T = Eigen::Matrix<T, 3, 1>;
+template <typename T>
+using Mat22T = Eigen::Matrix<T, 2, 2>;
+template <typename T>
+using Mat33T = Eigen::Matrix<T, 3, 3>;
+template <typename T>
+using Mat34T = Eigen::Matrix<T, 3, 4>;
+template <typename T>
+using Mat2XT = Eigen::Matrix<T, 2, Eigen::Dynamic>;
+template <typename T>
+using Mat3XT = Eigen::Matrix<T, 3, Eigen::Dynamic>;
+
+// float matricies used by the float camera models
+typedef Eigen::Matrix<float, 3, 4> Mat34f;
+typedef Eigen::Matrix<float, 2, Eigen::Dynamic> Mat2Xf;
+typedef Eigen::Matrix<float, 3, Eigen::Dynamic> Mat3Xf;
+
 #endif // PHOTOGRAMMETRY_EIGEN_TYPES_HPP
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "estimators/absolute_pose.hpp"
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+#include <Eigen/LU>
+#include <cmath>
+#include <limits>
+
+namespace photogrammetry {
+namespace estimators {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+// 实系数一元三次方程 c3 x^3 + c2 x^2 + c1 x + c0 = 0 的实根, 返回根的个数
+int SolveCubic(const double c3, const double c2, const double c1, const double c0,
+               double roots[3]) {
+  if (std::abs(c3) < 1e-14 * (std::abs(c2) + std::abs(c1) + std::abs(c0))) {
+    // 退化为二次方程
+    if (std::abs(c2) < 1e-14 * (std::abs(c1) + std::abs(c0))) {
+      if (c1 == 0.0) {
+        return 0;
+      }
+      roots[0] = -c0 / c1;
+      return 1;
+    }
+    const double discriminant = c1 * c1 - 4.0 * c2 * c0;
+    if (discriminant < 0.0) {
+      return 0;
+    }
+    const double q = -0.5 * (c1 + std::copysign(std::sqrt(discriminant), c1));
+    roots[0] = q / c2;
+    roots[1] = q != 0.0 ? c0 / q : roots[0];
+    return 2;
+  }
+  const double a = c2 / c3, b = c1 / c3, c = c0 / c3;
+  const double q = (a * a - 3.0 * b) / 9.0;
+  const double r = (2.0 * a * a * a - 9.0 * a * b + 27.0 * c) / 54.0;
+  int num_roots;
+  if (r * r < q * q * q) {
+    const double theta = std::acos(r / std::sqrt(q * q * q));
+    const double scale = -2.0 * std::sqrt(q);
+    roots[0] = scale * std::cos(theta / 3.0) - a / 3.0;
+    roots[1] = scale * std::cos((theta + 2.0 * kPi) / 3.0) - a / 3.0;
+    roots[2] = scale * std::cos((theta - 2.0 * kPi) / 3.0) - a / 3.0;
+    num_roots = 3;
+  } else {
+    const double A = -std::copysign(std::cbrt(std::abs(r) + std::sqrt(r * r - q * q * q)), r);
+    const double B = A != 0.0 ? q / A : 0.0;
+    roots[0] = A + B - a / 3.0;
+    num_roots = 1;
+  }
+  // Newton 迭代修正舍入误差
+  for (int i = 0; i < num_roots; ++i) {
+    for (int iteration = 0; iteration < 2; ++iteration) {
+      const double x = roots[i];
+      const double f = ((x + a) * x + b) * x + c;
+      const double df = (3.0 * x + 2.0 * a) * x + b;
+      if (df != 0.0) {
+        roots[i] = x - f / df;
+      }
+    }
+  }
+  return num_roots;
+}
+
+// det(A + x B) 的系数, 从常数项到三次项
+void DeterminantPolynomial(const Mat33 &A, const Mat33 &B, double coeffs[4]) {
+  const auto det = [](const Vec3 &c0, const Vec3 &c1, const Vec3 &c2) {
+    return c0.dot(c1.cross(c2));
+  };
+  coeffs[0] = A.determinant();
+  coeffs[1] = det(B.col(0), A.col(1), A.col(2)) + det(A.col(0), B.col(1), A.col(2)) +
+              det(A.col(0), A.col(1), B.col(2));
+  coeffs[2] = det(A.col(0), B.col(1), B.col(2)) + det(B.col(0), A.col(1), B.col(2)) +
+              det(B.col(0), B.col(1), A.col(2));
+  coeffs[3] = B.determinant();
+}
+
+// 由相机坐标系与世界坐标系下的三个点求 P = R X + t
+void PoseFromTriangles(const Mat33 &P, const Mat33 &X, Mat33 *R, Vec3 *t) {
+  Mat33 A, B;
+  A.col(0) = X.col(0) - X.col(1);
+  A.col(1) = X.col(0) - X.col(2);
+  A.col(2) = A.col(0).cross(A.col(1));
+  B.col(0) = P.col(0) - P.col(1);
+  B.col(1) = P.col(0) - P.col(2);
+  B.col(2) = B.col(0).cross(B.col(1));
+  *R = B * A.inverse();
+  *t = P.col(0) - *R * X.col(0);
+}
+} // namespace
+
+void AbsolutePoseResiduals(const Mat3X &bearings, const Mat3X &points3D,
+                           const camera::CameraExtrinsicParams &pose,
+                           Eigen::ArrayXd *squared_residuals) {
+  const Mat3X P = pose(points3D);
+  const auto a0 = bearings.row(0).array(), a1 = bearings.row(1).array(),
+             a2 = bearings.row(2).array();
+  const auto b0 = P.row(0).array(), b1 = P.row(1).array(), b2 = P.row(2).array();
+  const Eigen::ArrayXd cross_squared_norm =
+      ((a1 * b2 - a2 * b1).square() + (a2 * b0 - a0 * b2).square() + (a0 * b1 - a1 * b0).square())
+          .transpose();
+  const Eigen::ArrayXd dot = (a0 * b0 + a1 * b1 + a2 * b2).transpose();
+  const Eigen::ArrayXd denominator =
+      (bearings.colwise().squaredNorm().array() * P.colwise().squaredNorm().array()).transpose();
+  *squared_residuals = (dot > 0.0 && denominator > 0.0)
+                           .select(cross_squared_norm / denominator,
+                                   std::numeric_limits<double>::infinity());
+}
+
+int P3PEstimator::EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &bearings,
+                                  const Eigen::Matrix<double, 3, kMinNumSamples> &points3D,
+                                  Model *models) {
+  const Mat33 y = bearings.colwise().normalized();
+  const Mat33 &X = points3D;
+  const double a12 = (X.col(0) - X.col(1)).squaredNorm();
+  const double a13 = (X.col(0) - X.col(2)).squaredNorm();
+  const double a23 = (X.col(1) - X.col(2)).squaredNorm();
+  const double b12 = -y.col(0).dot(y.col(1));
+  const double b13 = -y.col(0).dot(y.col(2));
+  const double b23 = -y.col(1).dot(y.col(2));
+  if (a12 <= 0.0 || a13 <= 0.0 || a23 <= 0.0) {
+    return 0;
+  }
+
+  // 深度 l 满足 l^T Mij l = aij, 即 |li yi - lj yj|^2 = |Xi - Xj|^2
+  Mat33 M12, M13, M23;
+  M12 << 1.0, b12, 0.0, b12, 1.0, 0.0, 0.0, 0.0, 0.0;
+  M13 << 1.0, 0.0, b13, 0.0, 0.0, 0.0, b13, 0.0, 1.0;
+  M23 << 0.0, 0.0, 0.0, 0.0, 1.0, b23, 0.0, b23, 1.0;
+  // 两个齐次的二次型 l^T D1 l = l^T D2 l = 0
+  const Mat33 D1 = a23 * M12 - a12 * M23;
+  const Mat33 D2 = a23 * M13 - a13 * M23;
+
+  // 二次曲面束 D1 + gamma D2 中退化的一个, 需有一正一负两个非零特征值, 才能分解为两个平面
+  double coeffs[4], gammas[3];
+  DeterminantPolynomial(D1, D2, coeffs);
+  const int num_gammas = SolveCubic(coeffs[3], coeffs[2], coeffs[1], coeffs[0], gammas);
+  Eigen::SelfAdjointEigenSolver<Mat33> eigen;
+  int positive = -1, negative = -1;
+  for (int g = 0; g < num_gammas && positive < 0; ++g) {
+    eigen.compute(D1 + gammas[g] * D2);
+    const Vec3 &values = eigen.eigenvalues();
+    // 特征值升序, 零特征值在中间时两侧异号
+    if (values(0) < 0.0 && values(2) > 0.0 &&
+        std::abs(values(1)) < std::min(-values(0), values(2))) {
+      negative = 0;
+      positive = 2;
+    }
+  }
+  if (positive < 0) {
+    return 0;
+  }
+  const double sigma_p = eigen.eigenvalues()(positive), sigma_n = eigen.eigenvalues()(negative);
+  const Vec3 e_p = eigen.eigenvectors().col(positive), e_n = eigen.eigenvectors().col(negative);
+  const double s = std::sqrt(-sigma_n / sigma_p);
+
+  int num_models = 0;
+  for (const double sign : {1.0, -1.0}) {
+    // 平面 (e_p - sign s e_n)^T l = 0, 其上 l = tau q1 + q2
+    const Vec3 normal = e_p - sign * s * e_n;
+    const Vec3 q1 = normal.unitOrthogonal();
+    const Vec3 q2 = normal.cross(q1).normalized();
+    const double A = q1.dot(D1 * q1), B = q1.dot(D1 * q2), C = q2.dot(D1 * q2);
+    double taus[3];
+    const int num_taus = SolveCubic(0.0, A, 2.0 * B, C, taus);
+    for (int k = 0; k < num_taus; ++k) {
+      Vec3 l = taus[k] * q1 + q2;
+      const double norm23 = l.dot(M23 * l);
+      if (norm23 <= 0.0) {
+        continue;
+      }
+      l *= std::sqrt(a23 / norm23);
+      if (l(0) < 0.0) {
+        l = -l;
+      }
+      if (l(1) <= 0.0 || l(2) <= 0.0) {
+        continue;
+      }
+      // Gauss-Newton 修正三个距离方程
+      for (int iteration = 0; iteration < 3; ++iteration) {
+        const Vec3 r(l.dot(M12 * l) - a12, l.dot(M13 * l) - a13, l.dot(M23 * l) - a23);
+        Mat33 J;
+        J.row(0) = 2.0 * (M12 * l).transpose();
+        J.row(1) = 2.0 * (M13 * l).transpose();
+        J.row(2) = 2.0 * (M23 * l).transpose();
+        const double det = J.determinant();
+        if (std::abs(det) < 1e-12) {
+          break;
+        }
+        l -= J.inverse() * r;
+      }
+      Mat33 R;
+      Vec3 t;
+      PoseFromTriangles(y * l.asDiagonal(), X, &R, &t);
+      if (!R.allFinite() || !t.allFinite()) {
+        continue;
+      }
+      models[num_models++] = Model(R, -R.transpose() * t);
+    }
+  }
+  return num_models;
+}
+
+bool P3PEstimator::EstimateNonMinimal(const Mat3X &bearings, const Mat3X &points3D,
+                                      Model *model) {
+  typedef Eigen::Matrix<double, 3, 6> Mat36;
+  Mat33 R = model->Rotation();
+  Vec3 t = model->getTranslation();
+  for (int iteration = 0; iteration < 10; ++iteration) {
+    // 残差 e = (y x p) / (y . p), p = R X + t, 更新为 R <- exp(w) R, t <- t + dt
+    Mat66 H = Mat66::Zero();
+    Vec6 g = Vec6::Zero();
+    int num_valid = 0;
+    for (Eigen::Index i = 0; i < bearings.cols(); ++i) {
+      const Vec3 y = bearings.col(i).normalized();
+      const Vec3 RX = R * points3D.col(i);
+      const Vec3 p = RX + t;
+      const double depth = y.dot(p);
+      if (depth <= 0.0) {
+        continue;
+      }
+      const Vec3 e = y.cross(p) / depth;
+      Mat33 skew_y, skew_RX;
+      skew_y << 0.0, -y(2), y(1), y(2), 0.0, -y(0), -y(1), y(0), 0.0;
+      skew_RX << 0.0, -RX(2), RX(1), RX(2), 0.0, -RX(0), -RX(1), RX(0), 0.0;
+      const Mat33 de_dp = (skew_y - e * y.transpose()) / depth;
+      Mat36 J;
+      J.leftCols<3>() = -de_dp * skew_RX;
+      J.rightCols<3>() = de_dp;
+      H.noalias() += J.transpose() * J;
+      g.noalias() += J.transpose() * e;
+      ++num_valid;
+    }
+    if (num_valid < kMinNumSamples) {
+      return false;
+    }
+    const Eigen::LDLT<Mat66> ldlt(H);
+    if (ldlt.info() != Eigen::Success || !ldlt.isPositive()) {
+      return false;
+    }
+    const Vec6 delta = -ldlt.solve(g);
+    if (!delta.allFinite()) {
+      return false;
+    }
+    const double angle = delta.head<3>().norm();
+    if (angle > 0.0) {
+      R = Eigen::AngleAxisd(angle, delta.head<3>() / angle).toRotationMatrix() * R;
+    }
+    t += delta.tail<3>();
+    if (delta.squaredNorm() < 1e-20) {
+      break;
+    }
+  }
+  *model = Model(R, -R.transpose() * t);
+  return true;
+}
+
+} // namespace estimators
+} // namespace photogrammetry
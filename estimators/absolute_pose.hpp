@@ -0,0 +1,51 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_ABSOLUTE_POSE_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_ABSOLUTE_POSE_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "core/eigen_types.hpp"
+
+namespace photogrammetry {
+namespace estimators {
+
+/*
+ * @brief 二维-三维对应在外参 pose 下的残差平方
+ * 残差为方位向量与 R (X - C) 夹角正弦的平方, 三维点在相机后方时为无穷大。
+ * @param bearings 方位向量或 ima2cam 归一化坐标的齐次形式 (3 x N)
+ * @param points3D 世界坐标系下的三维点 (3 x N)
+ */
+void AbsolutePoseResiduals(const Mat3X &bearings, const Mat3X &points3D,
+                           const camera::CameraExtrinsicParams &pose,
+                           Eigen::ArrayXd *squared_residuals);
+
+/*
+ * @brief P3P 估计已标定相机的外参 (Persson & Nordberg, 2018 的 Lambda Twist 思路)
+ * 三个点深度的三个二次方程组成二次曲面束, 取其中退化的一个(求一元三次方程)分解为两个平面,
+ * 每个平面上只需解一元二次方程, 得到至多 4 个解, 再用 Gauss-Newton 修正深度。
+ * 数据 x1 为方位向量, x2 为对应的三维点。全部为固定大小的运算, 不分配内存。
+ */
+class P3PEstimator {
+public:
+  typedef camera::CameraExtrinsicParams Model;
+  static constexpr int kMinNumSamples = 3;
+  static constexpr int kMaxNumModels = 4;
+
+  static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &bearings,
+                             const Eigen::Matrix<double, 3, kMinNumSamples> &points3D,
+                             Model *models);
+
+  /*
+   * @brief 以 *model 为初值, 用 Gauss-Newton 最小化全部点的角度误差
+   * @return 相机前方的点少于 3 个或法方程奇异时返回 false
+   */
+  static bool EstimateNonMinimal(const Mat3X &bearings, const Mat3X &points3D, Model *model);
+
+  static void Residuals(const Mat3X &bearings, const Mat3X &points3D, const Model &model,
+                        Eigen::ArrayXd *squared_residuals) {
+    AbsolutePoseResiduals(bearings, points3D, model, squared_residuals);
+  }
+};
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_ABSOLUTE_POSE_HPP
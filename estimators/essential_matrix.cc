@@ -0,0 +1,268 @@
+#include "estimators/essential_matrix.hpp"
+#include <Eigen/Eigenvalues>
+#include <Eigen/LU>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+
+namespace photogrammetry {
+namespace estimators {
+
+namespace {
+/*
+ * 次数不超过 3 的三元多项式的系数, 单项式按 kMonomials 排列: 先是 10 个三次单项式, 然后是作为
+ * 商环基的 x^2, xy, xz, y^2, yz, z^2, x, y, z, 1
+ */
+typedef Eigen::Matrix<double, 20, 1> Polynomial;
+
+constexpr int kNumMonomials = 20;
+constexpr int kNumCubicMonomials = 10;
+constexpr int kMonomials[kNumMonomials][3] = {
+    {3, 0, 0}, {2, 1, 0}, {2, 0, 1}, {1, 2, 0}, {1, 1, 1}, {1, 0, 2}, {0, 3, 0},
+    {0, 2, 1}, {0, 1, 2}, {0, 0, 3}, {2, 0, 0}, {1, 1, 0}, {1, 0, 1}, {0, 2, 0},
+    {0, 1, 1}, {0, 0, 2}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0, 0, 0}};
+// 次数为 d 的多项式只有下标不小于 kDegreeBegin[d] 的系数可能非零
+constexpr int kDegreeBegin[4] = {19, 16, 10, 0};
+// 线性多项式中 x, y, z, 1 的下标
+constexpr int kX = 16, kY = 17, kZ = 18, kOne = 19;
+
+constexpr int MonomialIndex(const int ex, const int ey, const int ez) {
+  for (int i = 0; i < kNumMonomials; ++i) {
+    if (kMonomials[i][0] == ex && kMonomials[i][1] == ey && kMonomials[i][2] == ez) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// 两个单项式之积的下标, 次数超过 3 时为 -1
+struct ProductTable {
+  int index[kNumMonomials][kNumMonomials] = {};
+};
+
+constexpr ProductTable MakeProductTable() {
+  ProductTable table;
+  for (int i = 0; i < kNumMonomials; ++i) {
+    for (int j = 0; j < kNumMonomials; ++j) {
+      table.index[i][j] = MonomialIndex(kMonomials[i][0] + kMonomials[j][0],
+                                        kMonomials[i][1] + kMonomials[j][1],
+                                        kMonomials[i][2] + kMonomials[j][2]);
+    }
+  }
+  return table;
+}
+
+constexpr ProductTable kProducts = MakeProductTable();
+
+// 次数之和不超过 3 的两个多项式之积
+Polynomial Multiply(const Polynomial &a, const int degree_a, const Polynomial &b,
+                    const int degree_b) {
+  Polynomial c = Polynomial::Zero();
+  for (int i = kDegreeBegin[degree_a]; i < kNumMonomials; ++i) {
+    for (int j = kDegreeBegin[degree_b]; j < kNumMonomials; ++j) {
+      c[kProducts.index[i][j]] += a[i] * b[j];
+    }
+  }
+  return c;
+}
+
+/*
+ * @brief 五点法的 10 个三次方程
+ * @param basis 零空间的 4 个基向量, 按行优先展开的 X, Y, Z, W
+ */
+Eigen::Matrix<double, 10, kNumMonomials> FivePointConstraints(
+    const Eigen::Matrix<double, 9, 4> &basis) {
+  Polynomial E[3][3];
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      E[r][c].setZero();
+      E[r][c][kX] = basis(3 * r + c, 0);
+      E[r][c][kY] = basis(3 * r + c, 1);
+      E[r][c][kZ] = basis(3 * r + c, 2);
+      E[r][c][kOne] = basis(3 * r + c, 3);
+    }
+  }
+
+  Eigen::Matrix<double, 10, kNumMonomials> constraints;
+  const Polynomial det = Multiply(E[0][0], 1,
+                                  Multiply(E[1][1], 1, E[2][2], 1) -
+                                      Multiply(E[1][2], 1, E[2][1], 1),
+                                  2) -
+                         Multiply(E[0][1], 1,
+                                  Multiply(E[1][0], 1, E[2][2], 1) -
+                                      Multiply(E[1][2], 1, E[2][0], 1),
+                                  2) +
+                         Multiply(E[0][2], 1,
+                                  Multiply(E[1][0], 1, E[2][1], 1) -
+                                      Multiply(E[1][1], 1, E[2][0], 1),
+                                  2);
+  constraints.row(0) = det.transpose();
+
+  Polynomial EEt[3][3];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = i; j < 3; ++j) {
+      EEt[i][j] = Multiply(E[i][0], 1, E[j][0], 1) + Multiply(E[i][1], 1, E[j][1], 1) +
+                  Multiply(E[i][2], 1, E[j][2], 1);
+      EEt[j][i] = EEt[i][j];
+    }
+  }
+  const Polynomial trace = EEt[0][0] + EEt[1][1] + EEt[2][2];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      Polynomial constraint = -Multiply(trace, 2, E[i][j], 1);
+      for (int k = 0; k < 3; ++k) {
+        constraint += 2.0 * Multiply(EEt[i][k], 2, E[k][j], 1);
+      }
+      constraints.row(1 + 3 * i + j) = constraint.transpose();
+    }
+  }
+  return constraints;
+}
+
+/*
+ * @brief 两条射线交会点的深度, x2 * depth2 = R * x1 * depth1 + t
+ * @return 射线接近平行时返回 false
+ */
+bool TriangulateDepths(const Mat33 &R, const Vec3 &t, const Vec3 &x1, const Vec3 &x2,
+                       double *depth1, double *depth2) {
+  const Vec3 Rx1 = R * x1;
+  // 最小二乘解 [Rx1, -x2] [depth1, depth2]^T = -t 的法方程
+  const double a = Rx1.squaredNorm(), b = -Rx1.dot(x2), c = x2.squaredNorm();
+  const double det = a * c - b * b;
+  if (det <= 1e-12 * a * c) {
+    return false;
+  }
+  const double r1 = -Rx1.dot(t), r2 = x2.dot(t);
+  *depth1 = (c * r1 - b * r2) / det;
+  *depth2 = (a * r2 - b * r1) / det;
+  return true;
+}
+} // namespace
+
+Mat33 ProjectToEssentialMatrix(const Mat33 &M) {
+  const Eigen::JacobiSVD<Mat33> svd(M, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  return svd.matrixU() * Vec3(1.0, 1.0, 0.0).asDiagonal() * svd.matrixV().transpose();
+}
+
+void DecomposeEssentialMatrix(const Mat33 &E, Mat33 *R1, Mat33 *R2, Vec3 *t) {
+  const Eigen::JacobiSVD<Mat33> svd(E, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Mat33 U = svd.matrixU();
+  Mat33 V = svd.matrixV();
+  if (U.determinant() < 0.0) {
+    U.col(2) = -U.col(2);
+  }
+  if (V.determinant() < 0.0) {
+    V.col(2) = -V.col(2);
+  }
+  Mat33 W;
+  W << 0.0, -1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0;
+  *R1 = U * W * V.transpose();
+  *R2 = U * W.transpose() * V.transpose();
+  *t = U.col(2).normalized();
+}
+
+size_t RelativePoseFromEssentialMatrix(const Mat33 &E, const Mat3X &x1, const Mat3X &x2,
+                                       camera::CameraExtrinsicParams *pose) {
+  Mat33 R1, R2;
+  Vec3 t;
+  DecomposeEssentialMatrix(E, &R1, &R2, &t);
+  const Mat33 rotations[4] = {R1, R1, R2, R2};
+  const Vec3 translations[4] = {t, -t, t, -t};
+
+  size_t best_num_points = 0;
+  int best = 0;
+  for (int k = 0; k < 4; ++k) {
+    size_t num_points = 0;
+    for (Eigen::Index i = 0; i < x1.cols(); ++i) {
+      double depth1, depth2;
+      if (TriangulateDepths(rotations[k], translations[k], x1.col(i), x2.col(i), &depth1,
+                            &depth2) &&
+          depth1 > 0.0 && depth2 > 0.0) {
+        ++num_points;
+      }
+    }
+    if (num_points > best_num_points) {
+      best_num_points = num_points;
+      best = k;
+    }
+  }
+  *pose = camera::CameraExtrinsicParams(rotations[best],
+                                        -rotations[best].transpose() * translations[best]);
+  return best_num_points;
+}
+
+int EssentialMatrixFivePointEstimator::EstimateMinimal(
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models) {
+  Eigen::Matrix<double, kMinNumSamples, 9> A;
+  for (int i = 0; i < kMinNumSamples; ++i) {
+    A.row(i) = internal::EpipolarRow(x1.col(i), x2.col(i));
+  }
+  // A^T 的完全 QR 分解中 Q 的后 4 列张成 A 的零空间
+  const Eigen::HouseholderQR<Eigen::Matrix<double, 9, kMinNumSamples>> qr(A.transpose());
+  const Eigen::Matrix<double, 9, 9> Q = qr.householderQ();
+  const Eigen::Matrix<double, 9, 4> basis = Q.rightCols<4>();
+
+  // 消去三次单项式: 每个三次单项式表示为商环基的线性组合
+  const Eigen::Matrix<double, 10, kNumMonomials> constraints = FivePointConstraints(basis);
+  const Eigen::Matrix<double, 10, 10> B =
+      constraints.leftCols<kNumCubicMonomials>().partialPivLu().solve(
+          constraints.rightCols<kNumMonomials - kNumCubicMonomials>());
+
+  // 乘以 x 的作用矩阵: x * b_j = sum_k M(j, k) b_k, 解处的基向量值为 M 的特征向量
+  Eigen::Matrix<double, 10, 10> M = Eigen::Matrix<double, 10, 10>::Zero();
+  for (int j = 0; j < 10; ++j) {
+    const int *exponents = kMonomials[kNumCubicMonomials + j];
+    const int index = MonomialIndex(exponents[0] + 1, exponents[1], exponents[2]);
+    if (index < kNumCubicMonomials) {
+      M.row(j) = -B.row(index);
+    } else {
+      M(j, index - kNumCubicMonomials) = 1.0;
+    }
+  }
+  const Eigen::EigenSolver<Eigen::Matrix<double, 10, 10>> solver(M);
+  // eigenvectors() 每次调用都重新计算并返回新的矩阵
+  const Eigen::Matrix<std::complex<double>, 10, 10> eigenvectors = solver.eigenvectors();
+
+  int num_models = 0;
+  for (int k = 0; k < 10; ++k) {
+    const std::complex<double> eigenvalue = solver.eigenvalues()(k);
+    if (std::abs(eigenvalue.imag()) > 1e-10 * (1.0 + std::abs(eigenvalue.real()))) {
+      continue;
+    }
+    const auto v = eigenvectors.col(k);
+    const std::complex<double> one = v(kOne - kNumCubicMonomials);
+    if (std::abs(one) < 1e-12) {
+      continue;
+    }
+    const double x = (v(kX - kNumCubicMonomials) / one).real();
+    const double y = (v(kY - kNumCubicMonomials) / one).real();
+    const double z = (v(kZ - kNumCubicMonomials) / one).real();
+    const Mat91 e = x * basis.col(0) + y * basis.col(1) + z * basis.col(2) + basis.col(3);
+    models[num_models++] =
+        Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(e.data()).normalized();
+  }
+  return num_models;
+}
+
+int EssentialMatrixEightPointEstimator::EstimateMinimal(
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models) {
+  Mat89 A;
+  for (int i = 0; i < kMinNumSamples; ++i) {
+    A.row(i) = internal::EpipolarRow(x1.col(i), x2.col(i));
+  }
+  models[0] = ProjectToEssentialMatrix(internal::EightPointNullSpace(A));
+  return 1;
+}
+
+bool EssentialMatrixEightPointEstimator::EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2,
+                                                            Model *model) {
+  if (x1.cols() < kMinNumSamples) {
+    return false;
+  }
+  *model = ProjectToEssentialMatrix(internal::LeastSquaresNullSpace(x1, x2));
+  return true;
+}
+
+} // namespace estimators
+} // namespace photogrammetry
@@ -0,0 +1,83 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_ESSENTIAL_MATRIX_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_ESSENTIAL_MATRIX_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "core/eigen_types.hpp"
+#include "estimators/fundamental_matrix.hpp"
+
+namespace photogrammetry {
+namespace estimators {
+
+/*
+ * @brief 八点法估计本质矩阵
+ * 与 FundamentalMatrixEightPointEstimator 相同的线性解, 再投影到本质矩阵流形:
+ * 奇异值取 (1, 1, 0)。输入为标定后的方位向量。
+ */
+class EssentialMatrixEightPointEstimator {
+public:
+  typedef Mat33 Model;
+  static constexpr int kMinNumSamples = 8;
+
+  static constexpr int kMaxNumModels = 1;
+
+  static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+                             const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models);
+
+  static bool EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2, Model *model);
+
+  static void Residuals(const Mat3X &x1, const Mat3X &x2, const Model &model,
+                        Eigen::ArrayXd *squared_residuals) {
+    EpipolarResiduals(x1, x2, model, squared_residuals);
+  }
+};
+
+/*
+ * @brief 五点法估计本质矩阵 (Stewenius, Engels & Nister, 2006)
+ * 五个对应点的对极约束给出 4 维零空间 E = x X + y Y + z Z + W, 代入 det(E) = 0 与
+ * 2 E E^T E - tr(E E^T) E = 0 得到 10 个三次方程。消去 10 个三次单项式后, 乘以 x 的作用矩阵的
+ * 特征向量给出至多 10 个实数解。全部为固定大小的矩阵运算, 不分配内存。
+ * 输入为 ima2cam 归一化坐标的齐次形式或方位向量。
+ */
+class EssentialMatrixFivePointEstimator {
+public:
+  typedef Mat33 Model;
+  static constexpr int kMinNumSamples = 5;
+  static constexpr int kMaxNumModels = 10;
+
+  static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+                             const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models);
+
+  // 至少 8 个点时用线性解并投影到本质矩阵
+  static bool EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2, Model *model) {
+    return EssentialMatrixEightPointEstimator::EstimateNonMinimal(x1, x2, model);
+  }
+
+  static void Residuals(const Mat3X &x1, const Mat3X &x2, const Model &model,
+                        Eigen::ArrayXd *squared_residuals) {
+    EpipolarResiduals(x1, x2, model, squared_residuals);
+  }
+};
+
+// 把 3x3 矩阵投影到最近的本质矩阵, 奇异值为 (1, 1, 0)
+Mat33 ProjectToEssentialMatrix(const Mat33 &M);
+
+/*
+ * @brief 分解本质矩阵 E = [t]x R
+ * 真实的相对位姿为 (R1, t), (R1, -t), (R2, t), (R2, -t) 之一, |t| = 1
+ */
+void DecomposeEssentialMatrix(const Mat33 &E, Mat33 *R1, Mat33 *R2, Vec3 *t);
+
+/*
+ * @brief 由本质矩阵恢复第二张影像相对第一张影像的位姿
+ * 第一张影像的外参为单位阵, 第二张影像满足 x2 ~ R x1 + t, |t| = 1。在分解的四组位姿中选择使
+ * 最多对应点位于两个相机前方的一组。
+ * @param pose 第二张影像的外参, 旋转为 R, 光心为 -R^T t
+ * @return 位于两个相机前方的对应点数, 交会角过小的对应点不计入
+ */
+size_t RelativePoseFromEssentialMatrix(const Mat33 &E, const Mat3X &x1, const Mat3X &x2,
+                                       camera::CameraExtrinsicParams *pose);
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_ESSENTIAL_MATRIX_HPP
@@ -0,0 +1,78 @@
+#include "estimators/fundamental_matrix.hpp"
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+#include <limits>
+
+namespace photogrammetry {
+namespace estimators {
+
+namespace {
+typedef Eigen::Matrix<double, 3, 3, Eigen::RowMajor> RowMat33;
+
+// 把最小奇异值置零
+Mat33 EnforceRank2(const Mat33 &F) {
+  const Eigen::JacobiSVD<Mat33> svd(F, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Vec3 singular_values = svd.singularValues();
+  singular_values(2) = 0.0;
+  return svd.matrixU() * singular_values.asDiagonal() * svd.matrixV().transpose();
+}
+} // namespace
+
+void EpipolarResiduals(const Mat3X &x1, const Mat3X &x2, const Mat33 &M,
+                       Eigen::ArrayXd *squared_residuals) {
+  const Mat3X Mx1 = M * x1;
+  const Mat3X Mtx2 = M.transpose() * x2;
+  const Eigen::ArrayXd numerator =
+      (x2.array() * Mx1.array()).colwise().sum().square().transpose();
+  const Eigen::ArrayXd denominator =
+      (Mx1.colwise().squaredNorm() + Mtx2.colwise().squaredNorm()).transpose().array();
+  *squared_residuals = (denominator > 0.0)
+                           .select(numerator / denominator,
+                                   std::numeric_limits<double>::infinity());
+}
+
+namespace internal {
+
+Mat33 EightPointNullSpace(const Mat89 &A) {
+  // A^T 的完全 QR 分解中 Q 的最后一列张成 A 的零空间, 比 SVD 快得多
+  const Eigen::HouseholderQR<Mat98> qr(A.transpose());
+  const Mat91 f = qr.householderQ() * Mat91::Unit(8);
+  return Eigen::Map<const RowMat33>(f.data());
+}
+
+Mat33 LeastSquaresNullSpace(const Mat3X &x1, const Mat3X &x2) {
+  Eigen::Matrix<double, 9, 9> AtA = Eigen::Matrix<double, 9, 9>::Zero();
+  for (Eigen::Index i = 0; i < x1.cols(); ++i) {
+    const Mat19 row = EpipolarRow(x1.col(i), x2.col(i));
+    AtA.noalias() += row.transpose() * row;
+  }
+  const Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, 9, 9>> solver(AtA);
+  const Mat91 f = solver.eigenvectors().col(0);
+  return Eigen::Map<const RowMat33>(f.data());
+}
+
+} // namespace internal
+
+int FundamentalMatrixEightPointEstimator::EstimateMinimal(
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models) {
+  Mat89 A;
+  for (int i = 0; i < kMinNumSamples; ++i) {
+    A.row(i) = internal::EpipolarRow(x1.col(i), x2.col(i));
+  }
+  models[0] = EnforceRank2(internal::EightPointNullSpace(A));
+  return 1;
+}
+
+bool FundamentalMatrixEightPointEstimator::EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2,
+                                                              Model *model) {
+  if (x1.cols() < kMinNumSamples) {
+    return false;
+  }
+  *model = EnforceRank2(internal::LeastSquaresNullSpace(x1, x2));
+  return true;
+}
+
+} // namespace estimators
+} // namespace photogrammetry
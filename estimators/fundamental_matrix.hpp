@@ -0,0 +1,62 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_FUNDAMENTAL_MATRIX_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_FUNDAMENTAL_MATRIX_HPP
+
+#include "core/eigen_types.hpp"
+#include <vector>
+
+namespace photogrammetry {
+namespace estimators {
+
+/*
+ * @brief 对极约束 x2^T M x1 = 0 的残差平方, M 为基础矩阵或本质矩阵
+ * 输入为方位向量, 残差为方位向量空间中的 Sampson 误差:
+ *   (x2^T M x1)^2 / (|M x1|^2 + |M^T x2|^2)
+ * 对单位方位向量, (x2^T M x1) / |M x1| 是 x2 与对极平面夹角的正弦, 因此残差约为两幅影像角度误差
+ * 平方的一半, 阈值以弧度给出。整批计算, 退化的点残差为无穷大。
+ */
+void EpipolarResiduals(const Mat3X &x1, const Mat3X &x2, const Mat33 &M,
+                       Eigen::ArrayXd *squared_residuals);
+
+/*
+ * @brief 八点法估计基础矩阵, 满足秩 2 约束
+ * 方位向量为单位向量, 已有良好的数值条件, 不再做 Hartley 归一化。
+ */
+class FundamentalMatrixEightPointEstimator {
+public:
+  typedef Mat33 Model;
+  static constexpr int kMinNumSamples = 8;
+
+  static constexpr int kMaxNumModels = 1;
+
+  static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+                             const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models);
+
+  static bool EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2, Model *model);
+
+  static void Residuals(const Mat3X &x1, const Mat3X &x2, const Model &model,
+                        Eigen::ArrayXd *squared_residuals) {
+    EpipolarResiduals(x1, x2, model, squared_residuals);
+  }
+};
+
+namespace internal {
+
+// 对极约束的一行系数, 与行优先展开的 3x3 矩阵相乘即 x2^T M x1
+inline Mat19 EpipolarRow(const Vec3 &x1, const Vec3 &x2) {
+  Mat19 row;
+  row << x2(0) * x1.transpose(), x2(1) * x1.transpose(), x2(2) * x1.transpose();
+  return row;
+}
+
+// 八个点的系数矩阵的零空间, 按行优先还原为 3x3 矩阵
+Mat33 EightPointNullSpace(const Mat89 &A);
+
+// 多个点的最小二乘解: A^T A 最小特征值对应的特征向量
+Mat33 LeastSquaresNullSpace(const Mat3X &x1, const Mat3X &x2);
+
+} // namespace internal
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_FUNDAMENTAL_MATRIX_HPP
@@ -0,0 +1,68 @@
+#include "estimators/homography_matrix.hpp"
+#include <Eigen/Eigenvalues>
+#include <Eigen/SVD>
+#include <limits>
+
+namespace photogrammetry {
+namespace estimators {
+
+namespace {
+typedef Eigen::Matrix<double, 3, 3, Eigen::RowMajor> RowMat33;
+
+// x2 x (H x1) = 0 的三行系数, 与行优先展开的 H 相乘
+Eigen::Matrix<double, 3, 9> CrossProductRows(const Vec3 &a, const Vec3 &b) {
+  Eigen::Matrix<double, 3, 9> rows;
+  rows << Eigen::RowVector3d::Zero(), -b(2) * a.transpose(), b(1) * a.transpose(),
+      b(2) * a.transpose(), Eigen::RowVector3d::Zero(), -b(0) * a.transpose(),
+      -b(1) * a.transpose(), b(0) * a.transpose(), Eigen::RowVector3d::Zero();
+  return rows;
+}
+} // namespace
+
+int HomographyMatrixEstimator::EstimateMinimal(
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+    const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models) {
+  Eigen::Matrix<double, 3 * kMinNumSamples, 9> A;
+  for (int i = 0; i < kMinNumSamples; ++i) {
+    A.middleRows<3>(3 * i) = CrossProductRows(x1.col(i), x2.col(i));
+  }
+  const Eigen::JacobiSVD<Eigen::Matrix<double, 3 * kMinNumSamples, 9>> svd(A,
+                                                                           Eigen::ComputeFullV);
+  const Mat91 h = svd.matrixV().col(8);
+  models[0] = Eigen::Map<const RowMat33>(h.data());
+  return 1;
+}
+
+bool HomographyMatrixEstimator::EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2,
+                                                   Model *model) {
+  if (x1.cols() < kMinNumSamples) {
+    return false;
+  }
+  Eigen::Matrix<double, 9, 9> AtA = Eigen::Matrix<double, 9, 9>::Zero();
+  for (Eigen::Index i = 0; i < x1.cols(); ++i) {
+    const Eigen::Matrix<double, 3, 9> rows = CrossProductRows(x1.col(i), x2.col(i));
+    AtA.noalias() += rows.transpose() * rows;
+  }
+  const Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, 9, 9>> solver(AtA);
+  const Mat91 h = solver.eigenvectors().col(0);
+  *model = Eigen::Map<const RowMat33>(h.data());
+  return true;
+}
+
+void HomographyMatrixEstimator::Residuals(const Mat3X &x1, const Mat3X &x2, const Model &model,
+                                          Eigen::ArrayXd *squared_residuals) {
+  const Mat3X Hx1 = model * x1;
+  const auto a0 = x2.row(0).array(), a1 = x2.row(1).array(), a2 = x2.row(2).array();
+  const auto b0 = Hx1.row(0).array(), b1 = Hx1.row(1).array(), b2 = Hx1.row(2).array();
+  const Eigen::ArrayXd cross_squared_norm =
+      ((a1 * b2 - a2 * b1).square() + (a2 * b0 - a0 * b2).square() + (a0 * b1 - a1 * b0).square())
+          .transpose();
+  const Eigen::ArrayXd denominator =
+      (Hx1.colwise().squaredNorm().array() * x2.colwise().squaredNorm().array()).transpose();
+  *squared_residuals = (denominator > 0.0)
+                           .select(cross_squared_norm / denominator,
+                                   std::numeric_limits<double>::infinity());
+}
+
+} // namespace estimators
+} // namespace photogrammetry
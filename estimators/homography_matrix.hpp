@@ -0,0 +1,35 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_HOMOGRAPHY_MATRIX_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_HOMOGRAPHY_MATRIX_HPP
+
+#include "core/eigen_types.hpp"
+#include <vector>
+
+namespace photogrammetry {
+namespace estimators {
+
+/*
+ * @brief 四点 DLT 估计单应 x2 ~ H x1
+ * 每对方位向量由 x2 x (H x1) = 0 给出三行方程(其中两行独立), 三行都使用, 对大视场的方位向量
+ * (z 接近 0) 同样稳定。
+ * 残差为 x2 与 H x1 夹角正弦的平方, 退化的点残差为无穷大。
+ */
+class HomographyMatrixEstimator {
+public:
+  typedef Mat33 Model;
+  static constexpr int kMinNumSamples = 4;
+
+  static constexpr int kMaxNumModels = 1;
+
+  static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+                             const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models);
+
+  static bool EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2, Model *model);
+
+  static void Residuals(const Mat3X &x1, const Mat3X &x2, const Model &model,
+                        Eigen::ArrayXd *squared_residuals);
+};
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_HOMOGRAPHY_MATRIX_HPP
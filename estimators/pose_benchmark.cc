@@ -0,0 +1,67 @@
+#include "estimators/absolute_pose.hpp"
+#include "estimators/essential_matrix.hpp"
+#include "estimators/ransac.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+using namespace photogrammetry;
+using namespace photogrammetry::estimators;
+
+namespace {
+// num_samples 组最小样本, 两个相机观测同一组三维点
+void MakeSamples(const int num_points, Mat3X *x1, Mat3X *x2, Mat3X *points) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const camera::CameraExtrinsicParams pose(
+      Eigen::AngleAxisd(0.2, Vec3(0.1, 1.0, 0.2).normalized()).toRotationMatrix(),
+      Vec3(1.0, 0.2, 0.1));
+  points->resize(3, num_points);
+  for (int i = 0; i < num_points; ++i) {
+    points->col(i) = Vec3(uniform(rng), uniform(rng), 4.0 + uniform(rng));
+  }
+  *x1 = points->colwise().hnormalized().colwise().homogeneous();
+  *x2 = pose(*points).colwise().hnormalized().colwise().homogeneous();
+}
+
+template <typename Estimator>
+void SolveBatch(benchmark::State &state, const bool absolute) {
+  const int num_samples = static_cast<int>(state.range(0));
+  Mat3X x1, x2, points;
+  MakeSamples(num_samples * Estimator::kMinNumSamples, &x1, &x2, &points);
+  std::vector<typename Estimator::Model> models(num_samples * Estimator::kMaxNumModels);
+  std::vector<int> num_models(num_samples);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(EstimateMinimalBatch<Estimator>(
+        absolute ? x2 : x1, absolute ? points : x2, models.data(), num_models.data()));
+  }
+  state.counters["hypotheses/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * num_samples, benchmark::Counter::kIsRate);
+}
+} // namespace
+
+static void BM_FivePoint(benchmark::State &state) {
+  SolveBatch<EssentialMatrixFivePointEstimator>(state, false);
+}
+BENCHMARK(BM_FivePoint)->Arg(256);
+
+static void BM_EightPoint(benchmark::State &state) {
+  SolveBatch<EssentialMatrixEightPointEstimator>(state, false);
+}
+BENCHMARK(BM_EightPoint)->Arg(256);
+
+static void BM_P3P(benchmark::State &state) { SolveBatch<P3PEstimator>(state, true); }
+BENCHMARK(BM_P3P)->Arg(256);
+
+// 由本质矩阵恢复相对位姿, 对 state.range(0) 个对应点做 cheirality 检验
+static void BM_RelativePose(benchmark::State &state) {
+  Mat3X x1, x2, points;
+  MakeSamples(static_cast<int>(state.range(0)), &x1, &x2, &points);
+  Mat33 E;
+  EssentialMatrixEightPointEstimator::EstimateNonMinimal(x1, x2, &E);
+  camera::CameraExtrinsicParams pose;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RelativePoseFromEssentialMatrix(E, x1, x2, &pose));
+  }
+}
+BENCHMARK(BM_RelativePose)->Arg(1000);
@@ -0,0 +1,173 @@
+#include "estimators/absolute_pose.hpp"
+#include "estimators/essential_matrix.hpp"
+#include "estimators/ransac.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace photogrammetry {
+namespace estimators {
+namespace {
+
+using camera::CameraExtrinsicParams;
+
+Mat33 Skew(const Vec3 &v) {
+  Mat33 S;
+  S << 0, -v(2), v(1), v(2), 0, -v(0), -v(1), v(0), 0;
+  return S;
+}
+
+CameraExtrinsicParams RandomPose(std::mt19937 *rng) {
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const Vec3 axis = Vec3(uniform(*rng), uniform(*rng), uniform(*rng)).normalized();
+  const Mat33 R = Eigen::AngleAxisd(0.3 * uniform(*rng), axis).toRotationMatrix();
+  return CameraExtrinsicParams(R, Vec3(uniform(*rng), uniform(*rng), -2.0 + 0.5 * uniform(*rng)));
+}
+
+// 世界坐标系原点附近的三维点
+Mat3X RandomPoints(const int num_points, std::mt19937 *rng) {
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  Mat3X points(3, num_points);
+  for (int i = 0; i < num_points; ++i) {
+    points.col(i) = Vec3(uniform(*rng), uniform(*rng), 2.0 + uniform(*rng));
+  }
+  return points;
+}
+
+// 归一化坐标的齐次形式, 与 ima2cam 的输出一致
+Mat3X Observe(const CameraExtrinsicParams &pose, const Mat3X &points) {
+  return pose(points).colwise().hnormalized().colwise().homogeneous();
+}
+
+double PoseError(const CameraExtrinsicParams &a, const CameraExtrinsicParams &b) {
+  return (a.Rotation() - b.Rotation()).norm() + (a.Center() - b.Center()).norm();
+}
+
+double MatrixDistance(const Mat33 &a, const Mat33 &b) {
+  const Mat33 an = a.normalized(), bn = b.normalized();
+  return std::min((an - bn).norm(), (an + bn).norm());
+}
+
+TEST(EssentialMatrixFivePointEstimator, OneSolutionIsExact) {
+  std::mt19937 rng(1);
+  for (int trial = 0; trial < 20; ++trial) {
+    const CameraExtrinsicParams pose = RandomPose(&rng);
+    const Mat3X points = RandomPoints(5, &rng);
+    const Mat3X x1 = points.colwise().hnormalized().colwise().homogeneous();
+    const Mat3X x2 = Observe(pose, points);
+    const Mat33 E_true = Skew(pose.getTranslation()) * pose.Rotation();
+
+    Mat33 models[EssentialMatrixFivePointEstimator::kMaxNumModels];
+    const int num_models = EssentialMatrixFivePointEstimator::EstimateMinimal(x1, x2, models);
+    ASSERT_GT(num_models, 0);
+    double best = std::numeric_limits<double>::max();
+    for (int m = 0; m < num_models; ++m) {
+      Eigen::ArrayXd residuals;
+      EssentialMatrixFivePointEstimator::Residuals(x1, x2, models[m], &residuals);
+      EXPECT_LT(residuals.maxCoeff(), 1e-16);
+      best = std::min(best, MatrixDistance(models[m], E_true));
+    }
+    EXPECT_LT(best, 1e-6) << trial;
+  }
+}
+
+TEST(RelativePose, RecoversPoseFromEssentialMatrix) {
+  std::mt19937 rng(2);
+  const CameraExtrinsicParams pose = RandomPose(&rng);
+  const Mat3X points = RandomPoints(50, &rng);
+  const Mat3X x1 = points.colwise().hnormalized().colwise().homogeneous();
+  const Mat3X x2 = Observe(pose, points);
+  // E 的尺度与符号任意
+  const Mat33 E = -3.0 * Skew(pose.getTranslation()) * pose.Rotation();
+
+  CameraExtrinsicParams relative;
+  EXPECT_EQ(RelativePoseFromEssentialMatrix(E, x1, x2, &relative), 50u);
+  EXPECT_LT((relative.Rotation() - pose.Rotation()).norm(), 1e-9);
+  EXPECT_LT((relative.getTranslation() - pose.getTranslation().normalized()).norm(), 1e-9);
+}
+
+TEST(P3PEstimator, OneSolutionIsExact) {
+  std::mt19937 rng(3);
+  for (int trial = 0; trial < 50; ++trial) {
+    const CameraExtrinsicParams pose = RandomPose(&rng);
+    const Mat3X points = RandomPoints(3, &rng);
+    const Mat3X bearings = Observe(pose, points);
+
+    CameraExtrinsicParams models[P3PEstimator::kMaxNumModels];
+    const int num_models = P3PEstimator::EstimateMinimal(bearings, points, models);
+    ASSERT_GT(num_models, 0);
+    double best = std::numeric_limits<double>::max();
+    for (int m = 0; m < num_models; ++m) {
+      EXPECT_NEAR(models[m].Rotation().determinant(), 1.0, 1e-6);
+      best = std::min(best, PoseError(models[m], pose));
+    }
+    EXPECT_LT(best, 1e-6) << trial;
+  }
+}
+
+TEST(P3PEstimator, NonMinimalRefinesPose) {
+  std::mt19937 rng(4);
+  const CameraExtrinsicParams pose = RandomPose(&rng);
+  const Mat3X points = RandomPoints(30, &rng);
+  const Mat3X bearings = Observe(pose, points);
+
+  CameraExtrinsicParams perturbed(
+      Eigen::AngleAxisd(0.05, Vec3::UnitY()).toRotationMatrix() * pose.Rotation(),
+      pose.Center() + Vec3(0.05, -0.05, 0.02));
+  ASSERT_TRUE(P3PEstimator::EstimateNonMinimal(bearings, points, &perturbed));
+  EXPECT_LT(PoseError(perturbed, pose), 1e-9);
+
+  Eigen::ArrayXd residuals;
+  P3PEstimator::Residuals(bearings, points, pose, &residuals);
+  EXPECT_LT(residuals.maxCoeff(), 1e-20);
+  // 相机后方的点残差为无穷大
+  P3PEstimator::Residuals(-bearings, points, pose, &residuals);
+  EXPECT_TRUE(std::isinf(residuals.minCoeff()));
+}
+
+TEST(P3PEstimator, RansacWithOutliers) {
+  std::mt19937 rng(5);
+  const CameraExtrinsicParams pose = RandomPose(&rng);
+  const Mat3X points = RandomPoints(100, &rng);
+  Mat3X bearings = Observe(pose, points);
+  bearings.rightCols(40).setRandom();
+  bearings.rightCols(40).row(2).setOnes();
+
+  RansacOptions options;
+  options.max_error = 1e-3;
+  const auto report = Ransac<P3PEstimator>(options).Estimate(bearings, points);
+  ASSERT_TRUE(report.success);
+  EXPECT_GE(report.num_inliers, 60u);
+  EXPECT_LT(PoseError(report.model, pose), 1e-8);
+}
+
+TEST(EstimateMinimalBatch, MatchesSingleCalls) {
+  std::mt19937 rng(6);
+  const int num_samples = 16;
+  const CameraExtrinsicParams pose = RandomPose(&rng);
+  const Mat3X points = RandomPoints(3 * num_samples, &rng);
+  const Mat3X bearings = Observe(pose, points);
+
+  std::vector<CameraExtrinsicParams> models(num_samples * P3PEstimator::kMaxNumModels);
+  std::vector<int> num_models(num_samples);
+  const size_t total =
+      EstimateMinimalBatch<P3PEstimator>(bearings, points, models.data(), num_models.data());
+  size_t expected_total = 0;
+  for (int i = 0; i < num_samples; ++i) {
+    CameraExtrinsicParams single[P3PEstimator::kMaxNumModels];
+    const int num_single = P3PEstimator::EstimateMinimal(bearings.middleCols<3>(3 * i),
+                                                         points.middleCols<3>(3 * i), single);
+    ASSERT_EQ(num_models[i], num_single);
+    for (int m = 0; m < num_single; ++m) {
+      EXPECT_EQ(PoseError(models[i * P3PEstimator::kMaxNumModels + m], single[m]), 0.0);
+    }
+    expected_total += num_single;
+  }
+  EXPECT_EQ(total, expected_total);
+  EXPECT_THROW(EstimateMinimalBatch<P3PEstimator>(bearings.leftCols(4), points.leftCols(4),
+                                                  models.data(), num_models.data()),
+               std::invalid_argument);
+}
+
+} // namespace
+} // namespace estimators
+} // namespace photogrammetry
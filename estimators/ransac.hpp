@@ -0,0 +1,258 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_RANSAC_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_RANSAC_HPP
+
+#include "core/eigen_types.hpp"
+#include "estimators/sampler.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace photogrammetry {
+namespace estimators {
+
+namespace internal {
+// Eigen 矩阵的默认构造不初始化, 置零; 其他类型值初始化
+template <typename Model>
+Model InitialModel() {
+  if constexpr (std::is_base_of<Eigen::MatrixBase<Model>, Model>::value) {
+    return Model::Zero();
+  } else {
+    return Model();
+  }
+}
+} // namespace internal
+
+struct RansacOptions {
+  // 内点的最大残差, 单位与估计器的 Residuals 相同(其平方与残差比较)
+  double max_error = 0.0;
+  // 至少有一次抽样全为内点的置信度, 决定自适应的试验次数
+  double confidence = 0.999;
+  // 假设的最小内点比例, 限制试验次数的上界
+  double min_inlier_ratio = 0.1;
+  int min_num_trials = 0;
+  int max_num_trials = 10000;
+  // 每得到一个更好的模型后, 用其内点做非最小估计的最大次数(LO-RANSAC), 0 表示不做局部优化
+  int num_local_optimization_iterations = 10;
+  uint64_t random_seed = 0;
+
+  bool Check() const {
+    return max_error > 0.0 && confidence > 0.0 && confidence < 1.0 && min_inlier_ratio > 0.0 &&
+           min_inlier_ratio <= 1.0 && min_num_trials >= 0 && max_num_trials >= min_num_trials &&
+           num_local_optimization_iterations >= 0;
+  }
+};
+
+template <typename Model>
+struct RansacReport {
+  bool success = false;
+  size_t num_trials = 0;
+  size_t num_inliers = 0;
+  // 截断二次损失(MSAC)之和, 越小越好
+  double score = std::numeric_limits<double>::max();
+  std::vector<char> inlier_mask;
+  // 没有得到任何模型时为零或默认值, 且 success 为 false
+  Model model = internal::InitialModel<Model>();
+};
+
+/*
+ * @brief 通用 RANSAC
+ * 估计器需提供:
+ *   typedef ... Model;
+ *   static constexpr int kMinNumSamples;
+ *   // 最小问题解的个数上限
+ *   static constexpr int kMaxNumModels;
+ *   // 由最小样本估计模型, 写入 models[0, n) 并返回 n, 不分配内存
+ *   static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &x1,
+ *                              const Eigen::Matrix<double, 3, kMinNumSamples> &x2, Model *models);
+ *   // 由多于最小数目的数据估计, 用于局部优化; 调用时 *model 为当前模型, 迭代的估计器以其为初值
+ *   static bool EstimateNonMinimal(const Mat3X &x1, const Mat3X &x2, Model *model);
+ *   // 全部数据在模型下的残差平方, 整批用 Eigen 数组运算计算
+ *   static void Residuals(const Mat3X &x1, const Mat3X &x2, const Model &model,
+ *                         Eigen::ArrayXd *squared_residuals);
+ * 数据为两组一一对应的方位向量 (3 x N)。
+ * 每个假设对全部数据整批计算残差后按 MSAC 评分; 得到更好的模型时做局部优化, 并按内点比例更新所需
+ * 的试验次数, 达到后提前结束。Sampler 为 RandomSampler 或 ProgressiveSampler (PROSAC)。
+ * Estimate 不修改成员, 可以被多个线程同时调用。
+ */
+template <typename Estimator, typename Sampler = RandomSampler>
+class Ransac {
+public:
+  typedef typename Estimator::Model Model;
+  typedef RansacReport<Model> Report;
+  static constexpr int kMinNumSamples = Estimator::kMinNumSamples;
+  typedef Eigen::Matrix<double, 3, kMinNumSamples> SampleMatrix;
+
+  explicit Ransac(const RansacOptions &options) : options_(options) {
+    if (!options_.Check()) {
+      throw std::invalid_argument("Invalid RANSAC options");
+    }
+  }
+
+  /*
+   * @brief 自适应的试验次数
+   * 内点比例为 w 时, 一次抽样全为内点的概率为 w^s, 使至少一次成功的概率达到 confidence
+   */
+  static size_t ComputeNumTrials(const size_t num_inliers, const size_t num_total,
+                                 const double confidence) {
+    const double inlier_ratio = static_cast<double>(num_inliers) / num_total;
+    const double all_inliers = std::pow(inlier_ratio, kMinNumSamples);
+    if (all_inliers >= 1.0) {
+      return 1;
+    }
+    if (all_inliers <= 0.0) {
+      return std::numeric_limits<size_t>::max();
+    }
+    const double num_trials = std::ceil(std::log1p(-confidence) / std::log1p(-all_inliers));
+    return num_trials < 1e18 ? static_cast<size_t>(num_trials)
+                             : std::numeric_limits<size_t>::max();
+  }
+
+  Report Estimate(const Mat3X &x1, const Mat3X &x2) const {
+    Report report;
+    const size_t num_total = static_cast<size_t>(x1.cols());
+    if (x2.cols() != x1.cols()) {
+      throw std::invalid_argument("RANSAC inputs must have the same size");
+    }
+    if (num_total < static_cast<size_t>(kMinNumSamples)) {
+      return report;
+    }
+    PHOTOGRAMMETRY_PROFILE_SCOPE("estimators/ransac");
+
+    const double max_squared_error = options_.max_error * options_.max_error;
+    const size_t max_num_trials = std::min(
+        static_cast<size_t>(options_.max_num_trials),
+        ComputeNumTrials(static_cast<size_t>(std::ceil(options_.min_inlier_ratio * num_total)),
+                         num_total, options_.confidence));
+    Sampler sampler(kMinNumSamples, options_.random_seed);
+    sampler.Initialize(num_total, max_num_trials);
+
+    int sample[kMinNumSamples];
+    SampleMatrix sample_x1, sample_x2;
+    std::array<Model, Estimator::kMaxNumModels> models;
+    Eigen::ArrayXd squared_residuals(num_total);
+    size_t dynamic_num_trials = max_num_trials;
+    bool has_model = false;
+
+    for (report.num_trials = 0;
+         report.num_trials < std::max(dynamic_num_trials, size_t(options_.min_num_trials));
+         ++report.num_trials) {
+      sampler.Sample(sample);
+      for (int i = 0; i < kMinNumSamples; ++i) {
+        sample_x1.col(i) = x1.col(sample[i]);
+        sample_x2.col(i) = x2.col(sample[i]);
+      }
+      const int num_models = Estimator::EstimateMinimal(sample_x1, sample_x2, models.data());
+      for (int m = 0; m < num_models; ++m) {
+        const Model &model = models[m];
+        Estimator::Residuals(x1, x2, model, &squared_residuals);
+        const double score = Score(squared_residuals, max_squared_error);
+        if (score >= report.score) {
+          continue;
+        }
+        report.model = model;
+        report.score = score;
+        has_model = true;
+        LocalOptimization(x1, x2, max_squared_error, &squared_residuals, &report);
+        const size_t num_inliers = (squared_residuals <= max_squared_error).count();
+        dynamic_num_trials = std::min(
+            dynamic_num_trials, ComputeNumTrials(num_inliers, num_total, options_.confidence));
+      }
+    }
+    PHOTOGRAMMETRY_PROFILE_HISTOGRAM("estimators/ransac_trials", report.num_trials);
+    // 最小问题可能没有解(如五点法与 P3P), 所有试验都没有模型时失败
+    if (!has_model) {
+      return report;
+    }
+
+    Estimator::Residuals(x1, x2, report.model, &squared_residuals);
+    report.inlier_mask.resize(num_total);
+    report.num_inliers = 0;
+    for (size_t i = 0; i < num_total; ++i) {
+      report.inlier_mask[i] = squared_residuals[i] <= max_squared_error;
+      report.num_inliers += report.inlier_mask[i];
+    }
+    report.success = report.num_inliers >= static_cast<size_t>(kMinNumSamples);
+    return report;
+  }
+
+private:
+  // MSAC: 内点计残差平方, 外点计阈值平方
+  static double Score(const Eigen::ArrayXd &squared_residuals, const double max_squared_error) {
+    return squared_residuals.min(max_squared_error).sum();
+  }
+
+  /*
+   * @brief 用当前模型的内点反复做非最小估计, 直到评分不再下降
+   * 调用时 squared_residuals 为 report->model 的残差, 返回时为最终模型的残差
+   */
+  void LocalOptimization(const Mat3X &x1, const Mat3X &x2, const double max_squared_error,
+                         Eigen::ArrayXd *squared_residuals, Report *report) const {
+    Mat3X inliers1, inliers2;
+    Eigen::ArrayXd refined_residuals(squared_residuals->size());
+    for (int iteration = 0; iteration < options_.num_local_optimization_iterations; ++iteration) {
+      const Eigen::Index num_inliers = (*squared_residuals <= max_squared_error).count();
+      if (num_inliers <= kMinNumSamples) {
+        return;
+      }
+      inliers1.resize(3, num_inliers);
+      inliers2.resize(3, num_inliers);
+      for (Eigen::Index i = 0, j = 0; i < squared_residuals->size(); ++i) {
+        if ((*squared_residuals)[i] <= max_squared_error) {
+          inliers1.col(j) = x1.col(i);
+          inliers2.col(j++) = x2.col(i);
+        }
+      }
+      Model refined = report->model;
+      if (!Estimator::EstimateNonMinimal(inliers1, inliers2, &refined)) {
+        return;
+      }
+      Estimator::Residuals(x1, x2, refined, &refined_residuals);
+      const double score = Score(refined_residuals, max_squared_error);
+      if (score >= report->score) {
+        return;
+      }
+      report->model = refined;
+      report->score = score;
+      squared_residuals->swap(refined_residuals);
+    }
+  }
+
+  RansacOptions options_;
+};
+
+/*
+ * @brief 批量求解最小问题, 不分配内存
+ * @param x1, x2 依次排列的 num_samples 组最小样本, 3 x (num_samples * kMinNumSamples)
+ * @param models 长度至少为 num_samples * kMaxNumModels, 第 i 组的解从 models[i * kMaxNumModels]
+ *        开始
+ * @param num_models 长度为 num_samples, 第 i 组的解的个数
+ * @return 解的总数
+ */
+template <typename Estimator>
+size_t EstimateMinimalBatch(const Eigen::Ref<const Mat3X> &x1, const Eigen::Ref<const Mat3X> &x2,
+                            typename Estimator::Model *models, int *num_models) {
+  constexpr int kMinNumSamples = Estimator::kMinNumSamples;
+  if (x1.cols() != x2.cols() || x1.cols() % kMinNumSamples != 0) {
+    throw std::invalid_argument("Batch must consist of complete minimal samples");
+  }
+  size_t total = 0;
+  const Eigen::Index num_samples = x1.cols() / kMinNumSamples;
+  for (Eigen::Index i = 0; i < num_samples; ++i) {
+    num_models[i] = Estimator::EstimateMinimal(
+        x1.template middleCols<kMinNumSamples>(i * kMinNumSamples),
+        x2.template middleCols<kMinNumSamples>(i * kMinNumSamples),
+        models + i * Estimator::kMaxNumModels);
+    total += num_models[i];
+  }
+  return total;
+}
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_RANSAC_HPP
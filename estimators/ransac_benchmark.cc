@@ -0,0 +1,81 @@
+#include "estimators/essential_matrix.hpp"
+#include "estimators/ransac.hpp"
+#include "estimators/two_view_geometry.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::estimators;
+
+namespace {
+// 一般场景的方位向量, 前 (1 - outlier_ratio) 部分为内点
+void MakeCorrespondences(const int num_points, const double outlier_ratio, Mat3X *x1,
+                         Mat3X *x2) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const Mat33 R = Eigen::AngleAxisd(0.1, Vec3(0.2, 1.0, 0.1).normalized()).toRotationMatrix();
+  const Vec3 t(1.0, 0.1, 0.2);
+  const int num_inliers = static_cast<int>(num_points * (1.0 - outlier_ratio));
+  x1->resize(3, num_points);
+  x2->resize(3, num_points);
+  for (int i = 0; i < num_points; ++i) {
+    const Vec3 X(2.0 * uniform(rng), 2.0 * uniform(rng), 4.0 + uniform(rng));
+    x1->col(i) = X.normalized();
+    x2->col(i) = i < num_inliers ? Vec3((R * X + t).normalized())
+                                 : Vec3(uniform(rng), uniform(rng), 1.0).normalized();
+  }
+}
+} // namespace
+
+// 一个假设对全部对应点的残差
+static void BM_EpipolarResiduals(benchmark::State &state) {
+  Mat3X x1, x2;
+  MakeCorrespondences(static_cast<int>(state.range(0)), 0.0, &x1, &x2);
+  const Mat33 E = Mat33::Random();
+  Eigen::ArrayXd residuals;
+  for (auto _ : state) {
+    EssentialMatrixEightPointEstimator::Residuals(x1, x2, E, &residuals);
+    benchmark::DoNotOptimize(residuals.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EpipolarResiduals)->Arg(1000)->Arg(10000);
+
+// 30% 错误匹配时估计本质矩阵, 参数为是否做局部优化
+static void BM_EssentialRansac(benchmark::State &state) {
+  Mat3X x1, x2;
+  MakeCorrespondences(2000, 0.3, &x1, &x2);
+  RansacOptions options;
+  options.max_error = 1e-3;
+  options.num_local_optimization_iterations = static_cast<int>(state.range(0));
+  const Ransac<EssentialMatrixEightPointEstimator> ransac(options);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ransac.Estimate(x1, x2));
+  }
+}
+BENCHMARK(BM_EssentialRansac)->Arg(0)->Arg(10)->Unit(benchmark::kMillisecond);
+
+// 并行校验 state.range(0) 个影像对
+static void BM_VerifyPairs(benchmark::State &state) {
+  const int num_pairs = static_cast<int>(state.range(0));
+  Mat3X x1, x2;
+  MakeCorrespondences(1000, 0.3, &x1, &x2);
+  std::vector<Mat3X> bearings;
+  Flat_Hash_Map<image_pair_t, matching::FeatureMatches> matches;
+  matching::FeatureMatches pair_matches;
+  for (point2D_t i = 0; i < 1000; ++i) {
+    pair_matches.push_back({i, i});
+  }
+  for (int i = 0; i < num_pairs; ++i) {
+    bearings.push_back(x1);
+    bearings.push_back(x2);
+    matches[ImagePairToPairId(2 * i, 2 * i + 1)] = pair_matches;
+  }
+  TwoViewGeometryVerifier verifier;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(verifier.Verify(bearings, matches));
+  }
+  state.counters["pairs/s"] = benchmark::Counter(state.iterations() * num_pairs,
+                                                 benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_VerifyPairs)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
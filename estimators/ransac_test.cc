@@ -0,0 +1,205 @@
+#include "estimators/essential_matrix.hpp"
+#include "estimators/fundamental_matrix.hpp"
+#include "estimators/homography_matrix.hpp"
+#include "estimators/ransac.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace photogrammetry {
+namespace estimators {
+namespace {
+
+Mat33 Skew(const Vec3 &v) {
+  Mat33 S;
+  S << 0, -v(2), v(1), v(2), 0, -v(0), -v(1), v(0), 0;
+  return S;
+}
+
+// 第二个相机 x2 ~ R x1 + t, 返回归一化的真值本质矩阵
+struct TwoViewScene {
+  Mat33 R;
+  Vec3 t;
+  Mat3X x1, x2;
+
+  Mat33 E() const { return (Skew(t) * R).normalized(); }
+};
+
+// planar 为真时三维点位于平面 z = 4 上
+TwoViewScene MakeScene(const int num_points, const bool planar, std::mt19937 *rng) {
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  TwoViewScene scene;
+  scene.R = Eigen::AngleAxisd(0.1, Vec3(0.2, 1.0, 0.1).normalized()).toRotationMatrix();
+  scene.t = Vec3(1.0, 0.1, 0.2);
+  scene.x1.resize(3, num_points);
+  scene.x2.resize(3, num_points);
+  for (int i = 0; i < num_points; ++i) {
+    const Vec3 X(2.0 * uniform(*rng), 2.0 * uniform(*rng), planar ? 4.0 : 4.0 + uniform(*rng));
+    scene.x1.col(i) = X.normalized();
+    scene.x2.col(i) = (scene.R * X + scene.t).normalized();
+  }
+  return scene;
+}
+
+// 把后 num_outliers 个对应点替换为随机方向
+void AddOutliers(const int num_outliers, std::mt19937 *rng, Mat3X *x2) {
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for (Eigen::Index i = x2->cols() - num_outliers; i < x2->cols(); ++i) {
+    x2->col(i) = Vec3(uniform(*rng), uniform(*rng), 1.0).normalized();
+  }
+}
+
+// 比较相差尺度与符号的两个矩阵
+double MatrixDistance(const Mat33 &a, const Mat33 &b) {
+  const Mat33 an = a.normalized(), bn = b.normalized();
+  return std::min((an - bn).norm(), (an + bn).norm());
+}
+
+TEST(EightPointEstimator, MinimalSolutionIsExact) {
+  std::mt19937 rng(1);
+  const TwoViewScene scene = MakeScene(8, false, &rng);
+  Mat33 E, F;
+  ASSERT_EQ(EssentialMatrixEightPointEstimator::EstimateMinimal(scene.x1, scene.x2, &E), 1);
+  EXPECT_LT(MatrixDistance(E, scene.E()), 1e-8);
+
+  ASSERT_EQ(FundamentalMatrixEightPointEstimator::EstimateMinimal(scene.x1, scene.x2, &F), 1);
+  EXPECT_NEAR(F.determinant(), 0.0, 1e-12);
+  Eigen::ArrayXd residuals;
+  FundamentalMatrixEightPointEstimator::Residuals(scene.x1, scene.x2, F, &residuals);
+  EXPECT_LT(residuals.maxCoeff(), 1e-20);
+}
+
+TEST(EightPointEstimator, NonMinimalSolutionIsExact) {
+  std::mt19937 rng(2);
+  const TwoViewScene scene = MakeScene(100, false, &rng);
+  Mat33 E;
+  ASSERT_TRUE(EssentialMatrixEightPointEstimator::EstimateNonMinimal(scene.x1, scene.x2, &E));
+  EXPECT_LT(MatrixDistance(E, scene.E()), 1e-8);
+  const Eigen::JacobiSVD<Mat33> svd(E);
+  EXPECT_NEAR(svd.singularValues()(0), 1.0, 1e-12);
+  EXPECT_NEAR(svd.singularValues()(1), 1.0, 1e-12);
+  EXPECT_NEAR(svd.singularValues()(2), 0.0, 1e-12);
+  EXPECT_FALSE(EssentialMatrixEightPointEstimator::EstimateNonMinimal(
+      scene.x1.leftCols(7), scene.x2.leftCols(7), &E));
+}
+
+TEST(HomographyMatrixEstimator, RecoversPlaneInducedHomography) {
+  std::mt19937 rng(3);
+  const TwoViewScene scene = MakeScene(50, true, &rng);
+  // 平面 n^T X = d 诱导的单应 H = R + t n^T / d
+  const Mat33 H_true = scene.R + scene.t * Vec3(0.0, 0.0, 1.0).transpose() / 4.0;
+
+  Mat33 H;
+  ASSERT_EQ(HomographyMatrixEstimator::EstimateMinimal(scene.x1.leftCols<4>(),
+                                                       scene.x2.leftCols<4>(), &H),
+            1);
+  EXPECT_LT(MatrixDistance(H, H_true), 1e-8);
+
+  ASSERT_TRUE(HomographyMatrixEstimator::EstimateNonMinimal(scene.x1, scene.x2, &H));
+  EXPECT_LT(MatrixDistance(H, H_true), 1e-8);
+  Eigen::ArrayXd residuals;
+  HomographyMatrixEstimator::Residuals(scene.x1, scene.x2, H, &residuals);
+  EXPECT_EQ(residuals.size(), 50);
+  EXPECT_LT(residuals.maxCoeff(), 1e-20);
+}
+
+TEST(Ransac, ComputeNumTrials) {
+  typedef Ransac<EssentialMatrixEightPointEstimator> EssentialRansac;
+  EXPECT_EQ(EssentialRansac::ComputeNumTrials(100, 100, 0.99), 1u);
+  EXPECT_EQ(EssentialRansac::ComputeNumTrials(0, 100, 0.99), std::numeric_limits<size_t>::max());
+  // log(0.01) / log(1 - 0.5^8) = 1176.6
+  EXPECT_EQ(EssentialRansac::ComputeNumTrials(50, 100, 0.99), 1177u);
+  EXPECT_EQ(EssentialRansac::ComputeNumTrials(1, 1000000, 0.99),
+            std::numeric_limits<size_t>::max());
+}
+
+TEST(Ransac, RejectsOutliers) {
+  std::mt19937 rng(4);
+  TwoViewScene scene = MakeScene(200, false, &rng);
+  AddOutliers(80, &rng, &scene.x2);
+
+  RansacOptions options;
+  options.max_error = 1e-4;
+  EXPECT_THROW(Ransac<EssentialMatrixEightPointEstimator>{RansacOptions()},
+               std::invalid_argument);
+  for (const int num_local_optimization_iterations : {0, 10}) {
+    options.num_local_optimization_iterations = num_local_optimization_iterations;
+    const auto report =
+        Ransac<EssentialMatrixEightPointEstimator>(options).Estimate(scene.x1, scene.x2);
+    ASSERT_TRUE(report.success);
+    EXPECT_EQ(report.num_inliers, 120u);
+    EXPECT_LT(report.num_trials, 1000u);
+    for (int i = 0; i < 200; ++i) {
+      EXPECT_EQ(report.inlier_mask[i], i < 120) << i;
+    }
+    EXPECT_LT(MatrixDistance(report.model, scene.E()), 1e-6);
+  }
+}
+
+TEST(Ransac, ProgressiveSamplingFindsOrderedInliers) {
+  std::mt19937 rng(5);
+  // 前 60 个对应点为内点, 按质量排列时 PROSAC 先在其中抽样
+  TwoViewScene scene = MakeScene(300, false, &rng);
+  AddOutliers(240, &rng, &scene.x2);
+
+  // 20% 的内点, 均匀抽样 200 次得到全为内点的样本的概率约为 5e-4
+  RansacOptions options;
+  options.max_error = 1e-4;
+  options.min_inlier_ratio = 0.05;
+  options.max_num_trials = 200;
+  const auto report = Ransac<EssentialMatrixEightPointEstimator, ProgressiveSampler>(options)
+                          .Estimate(scene.x1, scene.x2);
+  ASSERT_TRUE(report.success);
+  EXPECT_EQ(report.num_inliers, 60u);
+  EXPECT_LT(MatrixDistance(report.model, scene.E()), 1e-6);
+
+  const auto uniform_report =
+      Ransac<EssentialMatrixEightPointEstimator>(options).Estimate(scene.x1, scene.x2);
+  EXPECT_LT(uniform_report.num_inliers, 60u);
+}
+
+TEST(Ransac, NotEnoughData) {
+  RansacOptions options;
+  options.max_error = 1e-3;
+  const Mat3X x = Mat3X::Random(3, 5);
+  const auto report = Ransac<HomographyMatrixEstimator>(options).Estimate(x, x);
+  EXPECT_TRUE(report.success);
+  const auto epipolar_report = Ransac<EssentialMatrixEightPointEstimator>(options).Estimate(x, x);
+  EXPECT_FALSE(epipolar_report.success);
+  EXPECT_EQ(epipolar_report.num_trials, 0u);
+  EXPECT_THROW(Ransac<HomographyMatrixEstimator>(options).Estimate(x, x.leftCols(4)),
+               std::invalid_argument);
+}
+
+// 最小问题总是无解的估计器
+struct NoSolutionEstimator {
+  typedef Mat33 Model;
+  static constexpr int kMinNumSamples = 4;
+  static constexpr int kMaxNumModels = 1;
+
+  static int EstimateMinimal(const Eigen::Matrix<double, 3, kMinNumSamples> &,
+                             const Eigen::Matrix<double, 3, kMinNumSamples> &, Model *) {
+    return 0;
+  }
+  static bool EstimateNonMinimal(const Mat3X &, const Mat3X &, Model *) { return false; }
+  static void Residuals(const Mat3X &x1, const Mat3X &, const Model &,
+                        Eigen::ArrayXd *squared_residuals) {
+    squared_residuals->setZero(x1.cols());
+  }
+};
+
+TEST(Ransac, NoModelFails) {
+  RansacOptions options;
+  options.max_error = 1e-3;
+  options.max_num_trials = 50;
+  const Mat3X x = Mat3X::Random(3, 20);
+  const auto report = Ransac<NoSolutionEstimator>(options).Estimate(x, x);
+  EXPECT_FALSE(report.success);
+  EXPECT_EQ(report.num_trials, 50u);
+  EXPECT_EQ(report.num_inliers, 0u);
+  EXPECT_TRUE(report.inlier_mask.empty());
+  EXPECT_TRUE(report.model.isZero());
+}
+
+} // namespace
+} // namespace estimators
+} // namespace photogrammetry
@@ -0,0 +1,115 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_SAMPLER_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_SAMPLER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace photogrammetry {
+namespace estimators {
+
+/*
+ * @brief 均匀随机抽取互不相同的样本
+ */
+class RandomSampler {
+public:
+  RandomSampler(const int num_samples, const uint64_t seed)
+      : num_samples_(num_samples), rng_(seed) {}
+
+  // max_num_trials 仅为与 ProgressiveSampler 保持接口一致
+  void Initialize(const size_t num_total, const size_t /*max_num_trials*/) {
+    if (num_total < static_cast<size_t>(num_samples_)) {
+      throw std::invalid_argument("Not enough data to sample from");
+    }
+    num_total_ = num_total;
+  }
+
+  // 抽取 num_samples 个不同的下标, 写入 indices[0, num_samples)
+  void Sample(int *indices) {
+    for (int i = 0; i < num_samples_; ++i) {
+      for (;;) {
+        const int index = static_cast<int>(rng_() % num_total_);
+        if (std::find(indices, indices + i, index) == indices + i) {
+          indices[i] = index;
+          break;
+        }
+      }
+    }
+  }
+
+private:
+  int num_samples_;
+  size_t num_total_ = 0;
+  std::mt19937_64 rng_;
+};
+
+/*
+ * @brief PROSAC 渐进抽样(Chum & Matas, 2005)
+ * 数据须按质量从高到低排列(例如匹配的比值检验结果)。开始时只在质量最高的 num_samples 个数据中
+ * 抽样, 按增长函数逐步扩大到全部数据; 试验次数达到 max_num_trials 时等同于均匀抽样。
+ * 对高质量数据中内点比例高的情形, 通常很少的试验就能得到足够多内点的模型并提前结束。
+ */
+class ProgressiveSampler {
+public:
+  ProgressiveSampler(const int num_samples, const uint64_t seed)
+      : num_samples_(num_samples), rng_(seed) {}
+
+  void Initialize(const size_t num_total, const size_t max_num_trials) {
+    if (num_total < static_cast<size_t>(num_samples_)) {
+      throw std::invalid_argument("Not enough data to sample from");
+    }
+    num_total_ = num_total;
+    t_ = 0;
+    n_ = num_samples_;
+    // T_n: 在前 n 个数据中抽样的期望次数, 以 T_N = max_num_trials 为基准
+    T_n_ = static_cast<double>(max_num_trials);
+    for (int i = 0; i < num_samples_; ++i) {
+      T_n_ *= static_cast<double>(num_samples_ - i) / static_cast<double>(num_total - i);
+    }
+    T_n_prime_ = 1;
+  }
+
+  void Sample(int *indices) {
+    ++t_;
+    if (t_ == T_n_prime_ && n_ < num_total_) {
+      const double T_n_plus_1 = T_n_ * (n_ + 1) / static_cast<double>(n_ + 1 - num_samples_);
+      T_n_prime_ += static_cast<size_t>(std::ceil(T_n_plus_1 - T_n_));
+      T_n_ = T_n_plus_1;
+      ++n_;
+    }
+    // 新加入的第 n 个数据必选, 其余从前 n - 1 个中抽取; 超过增长函数后从前 n 个中抽取
+    int num_random = num_samples_;
+    size_t range = n_;
+    if (T_n_prime_ >= t_) {
+      indices[num_samples_ - 1] = static_cast<int>(n_ - 1);
+      num_random = num_samples_ - 1;
+      range = n_ - 1;
+    }
+    for (int i = 0; i < num_random; ++i) {
+      for (;;) {
+        const int index = static_cast<int>(rng_() % range);
+        if (std::find(indices, indices + i, index) == indices + i) {
+          indices[i] = index;
+          break;
+        }
+      }
+    }
+  }
+
+private:
+  int num_samples_;
+  size_t num_total_ = 0;
+  size_t t_ = 0;
+  size_t n_ = 0;
+  double T_n_ = 0.0;
+  size_t T_n_prime_ = 1;
+  std::mt19937_64 rng_;
+};
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_SAMPLER_HPP
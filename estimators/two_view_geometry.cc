@@ -0,0 +1,131 @@
+#include "estimators/two_view_geometry.hpp"
+#include "estimators/essential_matrix.hpp"
+#include "estimators/fundamental_matrix.hpp"
+#include "estimators/homography_matrix.hpp"
+#include "utils/flat_hash_map.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+namespace photogrammetry {
+namespace estimators {
+
+namespace {
+template <typename Estimator>
+RansacReport<typename Estimator::Model> RunRansac(const RansacOptions &options,
+                                                  const bool progressive_sampling,
+                                                  const Mat3X &x1, const Mat3X &x2) {
+  if (progressive_sampling) {
+    return Ransac<Estimator, ProgressiveSampler>(options).Estimate(x1, x2);
+  }
+  return Ransac<Estimator, RandomSampler>(options).Estimate(x1, x2);
+}
+} // namespace
+
+TwoViewGeometryVerifier::TwoViewGeometryVerifier(const TwoViewGeometryOptions &options)
+    : options_(options) {
+  if (!options_.Check()) {
+    throw std::invalid_argument("Invalid two-view geometry options");
+  }
+  ransac_options_ = options_.ransac;
+  ransac_options_.max_error = options_.max_angular_error;
+  thread_pool_ = std::make_unique<utils::ThreadPool>(options_.num_threads);
+}
+
+TwoViewGeometry TwoViewGeometryVerifier::Verify(const Mat3X &bearings1, const Mat3X &bearings2,
+                                                const matching::FeatureMatches &matches,
+                                                const uint64_t seed) const {
+  TwoViewGeometry geometry;
+  if (matches.size() < static_cast<size_t>(options_.min_num_inliers)) {
+    return geometry;
+  }
+  const Eigen::Index num_matches = static_cast<Eigen::Index>(matches.size());
+  Mat3X x1(3, num_matches), x2(3, num_matches);
+  for (Eigen::Index i = 0; i < num_matches; ++i) {
+    const matching::FeatureMatch &match = matches[i];
+    if (match.point2D_idx1 >= bearings1.cols() || match.point2D_idx2 >= bearings2.cols()) {
+      throw std::invalid_argument("Match references a point without bearing vector");
+    }
+    x1.col(i) = bearings1.col(match.point2D_idx1);
+    x2.col(i) = bearings2.col(match.point2D_idx2);
+  }
+
+  RansacOptions ransac_options = ransac_options_;
+  ransac_options.random_seed = utils::MixHash(ransac_options_.random_seed ^ seed);
+  const auto E_report = RunRansac<EssentialMatrixFivePointEstimator>(
+      ransac_options, options_.progressive_sampling, x1, x2);
+  const auto F_report = RunRansac<FundamentalMatrixEightPointEstimator>(
+      ransac_options, options_.progressive_sampling, x1, x2);
+  geometry.E = E_report.model;
+  geometry.F = F_report.model;
+  geometry.num_E_inliers = E_report.success ? E_report.num_inliers : 0;
+  geometry.num_F_inliers = F_report.success ? F_report.num_inliers : 0;
+
+  const size_t min_num_inliers = static_cast<size_t>(options_.min_num_inliers);
+  const size_t num_epipolar_inliers = std::max(geometry.num_E_inliers, geometry.num_F_inliers);
+  if (num_epipolar_inliers < min_num_inliers) {
+    // 单应的内点一定满足对极约束, 不必再估计
+    return geometry;
+  }
+  const auto H_report = RunRansac<HomographyMatrixEstimator>(
+      ransac_options, options_.progressive_sampling, x1, x2);
+  geometry.H = H_report.model;
+  geometry.num_H_inliers = H_report.success ? H_report.num_inliers : 0;
+  const std::vector<char> *inlier_mask = nullptr;
+  if (geometry.num_E_inliers >= min_num_inliers &&
+      geometry.num_E_inliers >= options_.min_E_F_inlier_ratio * geometry.num_F_inliers) {
+    geometry.config = TwoViewConfiguration::CALIBRATED;
+    inlier_mask = &E_report.inlier_mask;
+  } else {
+    geometry.config = TwoViewConfiguration::UNCALIBRATED;
+    inlier_mask = &F_report.inlier_mask;
+  }
+  if (geometry.num_H_inliers >= min_num_inliers &&
+      geometry.num_H_inliers > options_.max_H_inlier_ratio * num_epipolar_inliers) {
+    geometry.config = TwoViewConfiguration::PLANAR_OR_PANORAMIC;
+    inlier_mask = &H_report.inlier_mask;
+  }
+  for (Eigen::Index i = 0; i < num_matches; ++i) {
+    if ((*inlier_mask)[i]) {
+      geometry.inlier_matches.push_back(matches[i]);
+    }
+  }
+  return geometry;
+}
+
+Flat_Hash_Map<image_pair_t, TwoViewGeometry> TwoViewGeometryVerifier::Verify(
+    const std::vector<Mat3X> &bearings,
+    const Flat_Hash_Map<image_pair_t, matching::FeatureMatches> &matches) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("estimators/verify_pairs");
+  // 先检查全部影像对, 避免抛出异常时仍有任务引用输入
+  for (const auto &pair_matches : matches) {
+    const Pair pair = PairIdToImagePair(pair_matches.first);
+    if (pair.first >= bearings.size() || pair.second >= bearings.size()) {
+      throw std::invalid_argument("Image pair references an image without bearing vectors");
+    }
+  }
+  std::vector<std::pair<image_pair_t, std::future<TwoViewGeometry>>> futures;
+  futures.reserve(matches.size());
+  for (const auto &pair_matches : matches) {
+    const image_pair_t pair_id = pair_matches.first;
+    const Pair pair = PairIdToImagePair(pair_id);
+    const matching::FeatureMatches *pair_matches_ptr = &pair_matches.second;
+    futures.emplace_back(pair_id, thread_pool_->AddTask([=, &bearings]() {
+      return Verify(bearings[pair.first], bearings[pair.second], *pair_matches_ptr, pair_id);
+    }));
+  }
+  Flat_Hash_Map<image_pair_t, TwoViewGeometry> geometries;
+  geometries.reserve(futures.size());
+  size_t num_verified = 0;
+  for (auto &future : futures) {
+    TwoViewGeometry geometry = future.second.get();
+    num_verified += geometry.config != TwoViewConfiguration::DEGENERATE;
+    geometries.emplace(future.first, std::move(geometry));
+  }
+  PHOTOGRAMMETRY_PROFILE_COUNT("estimators/verified_pairs", num_verified);
+  return geometries;
+}
+
+} // namespace estimators
+} // namespace photogrammetry
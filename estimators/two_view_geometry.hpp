@@ -0,0 +1,103 @@
+#ifndef PHOTOGRAMMETRY_ESTIMATORS_TWO_VIEW_GEOMETRY_HPP
+#define PHOTOGRAMMETRY_ESTIMATORS_TWO_VIEW_GEOMETRY_HPP
+
+#include "camera/std_types.hpp"
+#include "core/eigen_types.hpp"
+#include "estimators/ransac.hpp"
+#include "matching/matcher.hpp"
+#include "utils/thread_pool.hpp"
+#include <memory>
+#include <vector>
+
+namespace photogrammetry {
+namespace estimators {
+
+enum class TwoViewConfiguration : uint8_t {
+  // 内点不足, 几何校验失败
+  DEGENERATE = 0,
+  // 本质矩阵解释了(几乎)全部基础矩阵的内点, 相机内参可信
+  CALIBRATED,
+  // 只有基础矩阵成立, 内参可能有误
+  UNCALIBRATED,
+  // 单应解释了大部分内点: 平面场景或纯旋转, 不适合作为初始影像对
+  PLANAR_OR_PANORAMIC,
+};
+
+struct TwoViewGeometry {
+  TwoViewConfiguration config = TwoViewConfiguration::DEGENERATE;
+  Mat33 E = Mat33::Zero();
+  Mat33 F = Mat33::Zero();
+  Mat33 H = Mat33::Zero();
+  size_t num_E_inliers = 0;
+  size_t num_F_inliers = 0;
+  size_t num_H_inliers = 0;
+  // 所选模型的内点匹配
+  matching::FeatureMatches inlier_matches;
+};
+
+struct TwoViewGeometryOptions {
+  // 内点的最大角度误差(弧度), 约为像素误差除以焦距
+  double max_angular_error = 0.004;
+  int min_num_inliers = 15;
+  // 本质矩阵内点数不少于基础矩阵内点数的该比例时视为 CALIBRATED
+  double min_E_F_inlier_ratio = 0.95;
+  // 单应内点数与对极几何内点数之比超过该值时视为 PLANAR_OR_PANORAMIC
+  double max_H_inlier_ratio = 0.8;
+  // 匹配按质量从高到低排列时使用 PROSAC 渐进抽样
+  bool progressive_sampling = false;
+  // max_error 被 max_angular_error 覆盖
+  RansacOptions ransac;
+  // 并行校验影像对的线程数, -1 表示使用全部硬件线程
+  int num_threads = -1;
+
+  bool Check() const {
+    RansacOptions checked = ransac;
+    checked.max_error = max_angular_error;
+    return max_angular_error > 0.0 && min_num_inliers >= 8 && min_E_F_inlier_ratio > 0.0 &&
+           max_H_inlier_ratio > 0.0 && checked.Check();
+  }
+};
+
+/*
+ * @brief 两视几何校验
+ * 对每个影像对分别用 RANSAC 估计本质矩阵、基础矩阵与单应, 按三者的内点数判断影像对的构型并
+ * 保留所选模型的内点匹配。输入为相机模型 operator()(Mat2X) 给出的方位向量, 残差与阈值均为
+ * 角度, 与相机模型和焦距无关。
+ */
+class TwoViewGeometryVerifier {
+public:
+  explicit TwoViewGeometryVerifier(
+      const TwoViewGeometryOptions &options = TwoViewGeometryOptions());
+
+  TwoViewGeometryVerifier(const TwoViewGeometryVerifier &) = delete;
+  TwoViewGeometryVerifier &operator=(const TwoViewGeometryVerifier &) = delete;
+
+  /*
+   * @brief 校验一个影像对
+   * @param bearings1 第一张影像全部特征点的方位向量, 以 point2D_t 为列下标
+   * @param seed 随机种子, 与 options.ransac.random_seed 组合
+   * @throw std::invalid_argument 匹配引用了不存在的特征点
+   */
+  TwoViewGeometry Verify(const Mat3X &bearings1, const Mat3X &bearings2,
+                         const matching::FeatureMatches &matches, uint64_t seed = 0) const;
+
+  /*
+   * @brief 在线程池中并行校验多个影像对
+   * @param bearings 以 image_t 为下标的各影像方位向量
+   * @param matches FeatureMatcher::Match 的结果, 第一张影像为 id 较小的影像
+   * @return 所有影像对的结果, 包括 DEGENERATE 的影像对
+   */
+  Flat_Hash_Map<image_pair_t, TwoViewGeometry>
+  Verify(const std::vector<Mat3X> &bearings,
+         const Flat_Hash_Map<image_pair_t, matching::FeatureMatches> &matches);
+
+private:
+  TwoViewGeometryOptions options_;
+  RansacOptions ransac_options_;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+};
+
+} // namespace estimators
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_ESTIMATORS_TWO_VIEW_GEOMETRY_HPP
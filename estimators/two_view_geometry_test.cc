@@ -0,0 +1,108 @@
+#include "estimators/two_view_geometry.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace photogrammetry {
+namespace estimators {
+namespace {
+
+// 两张影像各 num_points 个特征点, 第 i 个特征点相互匹配, 后 num_outliers 个匹配为错误匹配
+struct TwoViewData {
+  Mat3X bearings1, bearings2;
+  matching::FeatureMatches matches;
+};
+
+TwoViewData MakeData(const int num_points, const int num_outliers, const bool planar,
+                     const uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const Mat33 R = Eigen::AngleAxisd(0.1, Vec3(0.2, 1.0, 0.1).normalized()).toRotationMatrix();
+  const Vec3 t(1.0, 0.1, 0.2);
+  TwoViewData data;
+  data.bearings1.resize(3, num_points);
+  data.bearings2.resize(3, num_points);
+  for (int i = 0; i < num_points; ++i) {
+    const Vec3 X(2.0 * uniform(rng), 2.0 * uniform(rng), planar ? 4.0 : 4.0 + uniform(rng));
+    data.bearings1.col(i) = X.normalized();
+    data.bearings2.col(i) = (R * X + t).normalized();
+    if (i >= num_points - num_outliers) {
+      data.bearings2.col(i) = Vec3(uniform(rng), uniform(rng), 1.0).normalized();
+    }
+    data.matches.push_back({static_cast<point2D_t>(i), static_cast<point2D_t>(i)});
+  }
+  return data;
+}
+
+TEST(TwoViewGeometryVerifier, GeneralSceneIsCalibrated) {
+  const TwoViewData data = MakeData(200, 60, false, 1);
+  TwoViewGeometryVerifier verifier;
+  const TwoViewGeometry geometry = verifier.Verify(data.bearings1, data.bearings2, data.matches);
+  EXPECT_EQ(geometry.config, TwoViewConfiguration::CALIBRATED);
+  // 错误匹配偶尔恰好落在对极线附近
+  EXPECT_GE(geometry.num_E_inliers, 140u);
+  EXPECT_LE(geometry.num_E_inliers, 145u);
+  EXPECT_GE(geometry.num_F_inliers, 140u);
+  EXPECT_LT(geometry.num_H_inliers, 100u);
+  ASSERT_EQ(geometry.inlier_matches.size(), geometry.num_E_inliers);
+  for (size_t i = 0; i < 140; ++i) {
+    EXPECT_EQ(geometry.inlier_matches[i].point2D_idx1, i);
+  }
+}
+
+TEST(TwoViewGeometryVerifier, PlanarSceneAndDegenerateCases) {
+  const TwoViewData planar = MakeData(100, 20, true, 2);
+  TwoViewGeometryVerifier verifier;
+  const TwoViewGeometry geometry =
+      verifier.Verify(planar.bearings1, planar.bearings2, planar.matches);
+  EXPECT_EQ(geometry.config, TwoViewConfiguration::PLANAR_OR_PANORAMIC);
+  EXPECT_EQ(geometry.inlier_matches.size(), 80u);
+
+  const TwoViewData few = MakeData(10, 0, false, 3);
+  EXPECT_EQ(verifier.Verify(few.bearings1, few.bearings2, few.matches).config,
+            TwoViewConfiguration::DEGENERATE);
+  const TwoViewData outliers = MakeData(100, 100, false, 4);
+  EXPECT_EQ(verifier.Verify(outliers.bearings1, outliers.bearings2, outliers.matches).config,
+            TwoViewConfiguration::DEGENERATE);
+
+  matching::FeatureMatches invalid = planar.matches;
+  invalid[3].point2D_idx2 = 100;
+  EXPECT_THROW(verifier.Verify(planar.bearings1, planar.bearings2, invalid),
+               std::invalid_argument);
+  TwoViewGeometryOptions options;
+  options.max_angular_error = 0.0;
+  EXPECT_THROW(TwoViewGeometryVerifier{options}, std::invalid_argument);
+}
+
+TEST(TwoViewGeometryVerifier, VerifiesPairsInParallel) {
+  // 影像 0 与 1、1 与 2 为一般场景, 0 与 2 全为错误匹配
+  const TwoViewData data01 = MakeData(150, 30, false, 5);
+  const TwoViewData data02 = MakeData(150, 150, false, 6);
+  std::vector<Mat3X> bearings(3);
+  bearings[0] = data01.bearings1;
+  bearings[1] = data01.bearings2;
+  bearings[2] = data02.bearings2;
+  Flat_Hash_Map<image_pair_t, matching::FeatureMatches> matches;
+  matches[ImagePairToPairId(0, 1)] = data01.matches;
+  matches[ImagePairToPairId(1, 2)] = data01.matches;
+  matches[ImagePairToPairId(0, 2)] = data02.matches;
+
+  TwoViewGeometryOptions options;
+  options.progressive_sampling = true;
+  options.num_threads = 3;
+  options.ransac.max_num_trials = 2000;
+  TwoViewGeometryVerifier verifier(options);
+  const auto geometries = verifier.Verify(bearings, matches);
+  ASSERT_EQ(geometries.size(), 3u);
+  EXPECT_EQ(geometries.at(ImagePairToPairId(0, 1)).config, TwoViewConfiguration::CALIBRATED);
+  EXPECT_GE(geometries.at(ImagePairToPairId(0, 1)).inlier_matches.size(), 120u);
+  EXPECT_EQ(geometries.at(ImagePairToPairId(0, 2)).config, TwoViewConfiguration::DEGENERATE);
+  // 影像 1 与 2 的匹配把影像 1 的方位向量当作第一张影像, 对极几何不成立
+  EXPECT_NE(geometries.at(ImagePairToPairId(1, 2)).config, TwoViewConfiguration::CALIBRATED);
+
+  bearings.pop_back();
+  EXPECT_THROW(verifier.Verify(bearings, matches), std::invalid_argument);
+}
+
+} // namespace
+} // namespace estimators
+} // namespace photogrammetry
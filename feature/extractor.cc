@@ -0,0 +1,483 @@
+#include "feature/extractor.hpp"
+#include "utils/profiler.hpp"
+#include <Eigen/Core>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <future>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#ifdef PHOTOGRAMMETRY_OPENCV_ENABLED
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#endif
+
+namespace photogrammetry {
+namespace feature {
+
+namespace {
+
+typedef Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowArray;
+
+constexpr int kNumPairs = 256;
+constexpr int kDescriptorBytes = kNumPairs / 8;
+// 描述子采样点到中心的最大距离, 旋转后不超过 13 * sqrt(2) < 19
+constexpr int kPatternRadius = 13;
+// 灰度质心方向的圆形区域半径
+constexpr int kOrientationRadius = 15;
+// 特征点到图像边界的最小距离, 保证方向和描述子的采样都在图像内
+constexpr int kBorder = 19;
+constexpr int kNumAngleBins = 32;
+// 5 阶二项式核, 用作 Harris 窗口和描述子采样前的平滑
+constexpr float kBinomial[5] = {1.0f / 16, 4.0f / 16, 6.0f / 16, 4.0f / 16, 1.0f / 16};
+constexpr int kBinomialRadius = 2;
+constexpr double kPi = 3.14159265358979323846;
+
+/*
+ * @brief BRIEF 采样点对
+ * 点坐标服从截断到 kPatternRadius 的二维高斯分布 (sigma = 31 / 5), 用固定种子生成。
+ * rotated[b] 为旋转 b * 2pi / kNumAngleBins 后取整的点对 (ax, ay, bx, by)。
+ */
+struct BriefPattern {
+  std::array<std::array<std::array<int, 4>, kNumPairs>, kNumAngleBins> rotated;
+
+  BriefPattern() {
+    std::mt19937 rng(0x5eed);
+    auto uniform = [&rng]() { return (static_cast<double>(rng()) + 0.5) / 4294967296.0; };
+    auto gaussian = [&]() {
+      for (;;) {
+        // Box-Muller, 超出半径的样本重新抽取
+        const double value =
+            31.0 / 5.0 * std::sqrt(-2.0 * std::log(uniform())) * std::cos(2.0 * kPi * uniform());
+        if (std::abs(value) <= kPatternRadius) {
+          return value;
+        }
+      }
+    };
+    std::array<std::array<double, 4>, kNumPairs> pairs;
+    for (auto &pair : pairs) {
+      for (double &coordinate : pair) {
+        coordinate = std::round(gaussian());
+      }
+    }
+    for (int bin = 0; bin < kNumAngleBins; ++bin) {
+      const double angle = 2.0 * kPi * bin / kNumAngleBins;
+      const double c = std::cos(angle);
+      const double s = std::sin(angle);
+      for (int i = 0; i < kNumPairs; ++i) {
+        for (int p = 0; p < 4; p += 2) {
+          const double x = pairs[i][p];
+          const double y = pairs[i][p + 1];
+          rotated[bin][i][p] = static_cast<int>(std::lround(c * x - s * y));
+          rotated[bin][i][p + 1] = static_cast<int>(std::lround(s * x + c * y));
+        }
+      }
+    }
+  }
+};
+
+const BriefPattern &Pattern() {
+  static const BriefPattern pattern;
+  return pattern;
+}
+
+// 方向区域每一行的半宽, 使区域为半径 kOrientationRadius 的圆
+const std::array<int, kOrientationRadius + 1> &OrientationRowRadii() {
+  static const std::array<int, kOrientationRadius + 1> radii = []() {
+    std::array<int, kOrientationRadius + 1> r;
+    for (int dy = 0; dy <= kOrientationRadius; ++dy) {
+      r[dy] = static_cast<int>(
+          std::floor(std::sqrt(double(kOrientationRadius * kOrientationRadius - dy * dy))));
+    }
+    return r;
+  }();
+  return radii;
+}
+
+// 每个线程重复使用的分块内存
+struct Scratch {
+  RowArray padded, ix, iy, product, vertical, sxx, syy, sxy, response, smooth;
+};
+
+Scratch &ThreadScratch() {
+  thread_local Scratch scratch;
+  return scratch;
+}
+
+// 候选点, 坐标为所在层的亚像素坐标
+struct Candidate {
+  float response;
+  float x;
+  float y;
+};
+
+/*
+ * @brief 复制第 [r0, r1) 行, 上下各扩展 pad_rows 行, 左右各扩展 pad_cols 列, 超出图像的取边界像素
+ */
+void GatherPadded(const image::Image &level, const int r0, const int r1, const int pad_rows,
+                  const int pad_cols, RowArray *padded) {
+  const int width = level.width();
+  const int height = level.height();
+  padded->resize(r1 - r0 + 2 * pad_rows, width + 2 * pad_cols);
+  for (int i = 0; i < padded->rows(); ++i) {
+    const int y = std::min(std::max(r0 - pad_rows + i, 0), height - 1);
+    const float *src = level.Row<float>(y);
+    auto row = padded->row(i);
+    row.segment(pad_cols, width) = Eigen::Map<const Eigen::ArrayXf>(src, width).transpose();
+    row.head(pad_cols).setConstant(src[0]);
+    row.tail(pad_cols).setConstant(src[width - 1]);
+  }
+}
+
+// 二项式窗口加权求和, 输入比输出上下左右各多 kBinomialRadius
+void BinomialWindow(const RowArray &input, RowArray *vertical, RowArray *output) {
+  const int rows = static_cast<int>(input.rows()) - 2 * kBinomialRadius;
+  const int cols = static_cast<int>(input.cols()) - 2 * kBinomialRadius;
+  *vertical = kBinomial[0] * input.topRows(rows);
+  for (int k = 1; k < 5; ++k) {
+    *vertical += kBinomial[k] * input.middleRows(k, rows);
+  }
+  *output = kBinomial[0] * vertical->leftCols(cols);
+  for (int k = 1; k < 5; ++k) {
+    *output += kBinomial[k] * vertical->middleCols(k, cols);
+  }
+}
+
+// 第 [r0, r1) 行的 Harris 响应, 存入 scratch->response
+void HarrisResponse(const image::Image &level, const int r0, const int r1, const float k,
+                    Scratch *scratch) {
+  // 中心差分梯度需要 1 个像素, 窗口需要 kBinomialRadius 个像素
+  const int pad = kBinomialRadius + 1;
+  GatherPadded(level, r0, r1, pad, pad, &scratch->padded);
+  const RowArray &p = scratch->padded;
+  const int rows = static_cast<int>(p.rows()) - 2;
+  const int cols = static_cast<int>(p.cols()) - 2;
+  scratch->ix = 0.5f * (p.block(1, 2, rows, cols) - p.block(1, 0, rows, cols));
+  scratch->iy = 0.5f * (p.block(2, 1, rows, cols) - p.block(0, 1, rows, cols));
+
+  scratch->product = scratch->ix.square();
+  BinomialWindow(scratch->product, &scratch->vertical, &scratch->sxx);
+  scratch->product = scratch->iy.square();
+  BinomialWindow(scratch->product, &scratch->vertical, &scratch->syy);
+  scratch->product = scratch->ix * scratch->iy;
+  BinomialWindow(scratch->product, &scratch->vertical, &scratch->sxy);
+
+  scratch->response = scratch->sxx * scratch->syy - scratch->sxy.square() -
+                      k * (scratch->sxx + scratch->syy).square();
+}
+
+// 3x3 非极大值抑制与抛物线亚像素插值, 收集一层中响应超过阈值的候选点
+void DetectLevel(const image::Image &level, const FeatureExtractorOptions &options,
+                 Scratch *scratch, std::vector<Candidate> *candidates) {
+  const int width = level.width();
+  const int height = level.height();
+  for (int y0 = kBorder; y0 < height - kBorder; y0 += options.band_rows) {
+    const int y1 = std::min(height - kBorder, y0 + options.band_rows);
+    // 上下各多算一行, 供非极大值抑制使用
+    HarrisResponse(level, y0 - 1, y1 + 1, options.harris_k, scratch);
+    const RowArray &response = scratch->response;
+    for (int y = y0; y < y1; ++y) {
+      const float *above = &response(y - y0, 0);
+      const float *row = &response(y - y0 + 1, 0);
+      const float *below = &response(y - y0 + 2, 0);
+      for (int x = kBorder; x < width - kBorder; ++x) {
+        const float v = row[x];
+        if (v <= options.min_response) {
+          continue;
+        }
+        // 相等的响应只保留扫描顺序中的第一个
+        if (!(v > above[x - 1] && v > above[x] && v > above[x + 1] && v > row[x - 1] &&
+              v >= row[x + 1] && v >= below[x - 1] && v >= below[x] && v >= below[x + 1])) {
+          continue;
+        }
+        const float dxx = row[x - 1] - 2.0f * v + row[x + 1];
+        const float dyy = above[x] - 2.0f * v + below[x];
+        const float dx = dxx < 0.0f ? 0.5f * (row[x - 1] - row[x + 1]) / dxx : 0.0f;
+        const float dy = dyy < 0.0f ? 0.5f * (above[x] - below[x]) / dyy : 0.0f;
+        candidates->push_back({v, x + std::min(0.5f, std::max(-0.5f, dx)),
+                               y + std::min(0.5f, std::max(-0.5f, dy))});
+      }
+    }
+  }
+}
+
+/*
+ * @brief 按响应在网格中均匀选点
+ * 第一遍每格最多取 2 倍平均数, 数量不足时第二遍按响应补齐
+ */
+std::vector<Candidate> SelectCandidates(std::vector<Candidate> candidates, const int width,
+                                        const int height, const int cell_size,
+                                        const size_t budget) {
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) { return a.response > b.response; });
+  if (candidates.size() <= budget) {
+    return candidates;
+  }
+  const int num_cols = (width + cell_size - 1) / cell_size;
+  const int num_rows = (height + cell_size - 1) / cell_size;
+  const size_t num_cells = static_cast<size_t>(num_cols) * num_rows;
+  const size_t cell_capacity = std::max<size_t>(1, (2 * budget + num_cells - 1) / num_cells);
+  std::vector<size_t> cell_counts(num_cells, 0);
+  std::vector<Candidate> selected;
+  std::vector<Candidate> rejected;
+  selected.reserve(budget);
+  for (const Candidate &candidate : candidates) {
+    if (selected.size() == budget) {
+      break;
+    }
+    const size_t cell = static_cast<size_t>(candidate.y) / cell_size * num_cols +
+                        static_cast<size_t>(candidate.x) / cell_size;
+    if (cell_counts[cell] < cell_capacity) {
+      ++cell_counts[cell];
+      selected.push_back(candidate);
+    } else {
+      rejected.push_back(candidate);
+    }
+  }
+  for (size_t i = 0; i < rejected.size() && selected.size() < budget; ++i) {
+    selected.push_back(rejected[i]);
+  }
+  std::stable_sort(selected.begin(), selected.end(),
+                   [](const Candidate &a, const Candidate &b) { return a.response > b.response; });
+  return selected;
+}
+
+// 二项式平滑第 [r0, r1) 行, 存入 scratch->smooth
+void SmoothRows(const image::Image &level, const int r0, const int r1, Scratch *scratch) {
+  GatherPadded(level, r0, r1, kBinomialRadius, kBinomialRadius, &scratch->padded);
+  BinomialWindow(scratch->padded, &scratch->vertical, &scratch->smooth);
+}
+
+/*
+ * @brief 计算一层特征点的方向与描述子
+ * @param keypoints 该层的特征点, 方向被写入
+ * @param first_row 第一个特征点在描述子矩阵中的行号
+ */
+void DescribeLevel(const image::Image &level, const std::vector<Candidate> &selected,
+                   const int band_rows, Scratch *scratch, Keypoint *keypoints,
+                   FeatureDescriptors *descriptors, const size_t first_row) {
+  const int width = level.width();
+  const BriefPattern &pattern = Pattern();
+  const std::array<int, kOrientationRadius + 1> &row_radii = OrientationRowRadii();
+  // 每个方向的采样点相对中心的内存偏移
+  std::vector<std::array<int, 2 * kNumPairs>> offsets(kNumAngleBins);
+  for (int bin = 0; bin < kNumAngleBins; ++bin) {
+    for (int i = 0; i < kNumPairs; ++i) {
+      const std::array<int, 4> &pair = pattern.rotated[bin][i];
+      offsets[bin][2 * i] = pair[1] * width + pair[0];
+      offsets[bin][2 * i + 1] = pair[3] * width + pair[2];
+    }
+  }
+  const Eigen::ArrayXf xs =
+      Eigen::ArrayXf::LinSpaced(2 * kOrientationRadius + 1, -kOrientationRadius,
+                                kOrientationRadius);
+
+  // 按行分块, 每块只平滑其特征点需要的行
+  std::vector<size_t> order(selected.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](const size_t a, const size_t b) { return selected[a].y < selected[b].y; });
+  size_t begin = 0;
+  while (begin < order.size()) {
+    const int band_y0 = static_cast<int>(std::lround(selected[order[begin]].y));
+    size_t end = begin;
+    while (end < order.size() &&
+           std::lround(selected[order[end]].y) < band_y0 + band_rows) {
+      ++end;
+    }
+    const int band_y1 = static_cast<int>(std::lround(selected[order[end - 1]].y)) + 1;
+    const int r0 = band_y0 - kBorder;
+    SmoothRows(level, r0, band_y1 + kBorder, scratch);
+    const RowArray &smooth = scratch->smooth;
+
+    for (size_t i = begin; i < end; ++i) {
+      const size_t index = order[i];
+      const int cx = static_cast<int>(std::lround(selected[index].x));
+      const int cy = static_cast<int>(std::lround(selected[index].y));
+      // 灰度质心方向
+      float m10 = 0.0f;
+      float m01 = 0.0f;
+      for (int dy = -kOrientationRadius; dy <= kOrientationRadius; ++dy) {
+        const int r = row_radii[std::abs(dy)];
+        const auto segment = smooth.row(cy + dy - r0).segment(cx - r, 2 * r + 1).transpose();
+        m10 += (segment * xs.segment(kOrientationRadius - r, 2 * r + 1)).sum();
+        m01 += dy * segment.sum();
+      }
+      const float angle = std::atan2(m01, m10);
+      keypoints[index].orientation = angle;
+      int bin = static_cast<int>(std::lround(angle / (2.0 * kPi) * kNumAngleBins));
+      bin = (bin % kNumAngleBins + kNumAngleBins) % kNumAngleBins;
+
+      const float *center = &smooth(cy - r0, cx);
+      const int *offset = offsets[bin].data();
+      uint8_t *descriptor = descriptors->Row<uint8_t>(first_row + index);
+      for (int byte = 0; byte < kDescriptorBytes; ++byte) {
+        uint8_t value = 0;
+        for (int bit = 0; bit < 8; ++bit, offset += 2) {
+          value |= static_cast<uint8_t>(center[offset[0]] < center[offset[1]]) << bit;
+        }
+        descriptor[byte] = value;
+      }
+    }
+    begin = end;
+  }
+}
+
+} // namespace
+
+bool FeatureExtractorOptions::Check() const {
+  return max_num_features > 0 && harris_k > 0.0f && cell_size > 0 && band_rows > 0;
+}
+
+FeatureExtractor::FeatureExtractor(const FeatureExtractorOptions &options) : options_(options) {
+  if (!options_.Check()) {
+    throw std::invalid_argument("Invalid feature extractor options");
+  }
+#ifndef PHOTOGRAMMETRY_OPENCV_ENABLED
+  if (options_.type != FeatureExtractorType::HARRIS_BRIEF) {
+    throw std::invalid_argument("OpenCV feature extractors require OpenCV support");
+  }
+#endif
+  thread_pool_ = std::make_unique<utils::ThreadPool>(options_.num_threads);
+}
+
+DescriptorType FeatureExtractor::Type() const {
+  return options_.type == FeatureExtractorType::OPENCV_SIFT ? DescriptorType::FLOAT32
+                                                            : DescriptorType::BINARY;
+}
+
+int FeatureExtractor::Dimension() const {
+  return options_.type == FeatureExtractorType::OPENCV_SIFT ? 128 : kDescriptorBytes;
+}
+
+FeatureSet FeatureExtractor::Extract(const image::ImagePyramid &pyramid) const {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("feature/extract");
+  for (const image::Image &level : pyramid.levels) {
+    if (level.channels() != 1 || level.type() != image::PixelType::FLOAT32) {
+      throw std::invalid_argument("Expected a FLOAT32 gray pyramid");
+    }
+  }
+  FeatureSet features = options_.type == FeatureExtractorType::HARRIS_BRIEF
+                            ? ExtractHarrisBrief(pyramid)
+                            : ExtractOpenCV(pyramid);
+  PHOTOGRAMMETRY_PROFILE_COUNT("feature/keypoints", features.size());
+  return features;
+}
+
+std::vector<FeatureSet>
+FeatureExtractor::Extract(const std::vector<image::ImagePyramid> &pyramids) {
+  std::vector<std::future<FeatureSet>> futures;
+  futures.reserve(pyramids.size());
+  for (const image::ImagePyramid &pyramid : pyramids) {
+    futures.push_back(thread_pool_->AddTask([this, &pyramid]() { return Extract(pyramid); }));
+  }
+  // 先等待全部任务结束, 再取结果(可能重新抛出异常), 任务不会在返回后继续访问 pyramids
+  for (std::future<FeatureSet> &future : futures) {
+    future.wait();
+  }
+  std::vector<FeatureSet> features;
+  features.reserve(pyramids.size());
+  for (std::future<FeatureSet> &future : futures) {
+    features.push_back(future.get());
+  }
+  return features;
+}
+
+FeatureSet FeatureExtractor::ExtractHarrisBrief(const image::ImagePyramid &pyramid) const {
+  Scratch &scratch = ThreadScratch();
+  const int num_levels = pyramid.NumLevels();
+
+  // 各层的特征点数与面积成正比, 某层候选点不足时余额顺延到下一层
+  double total_weight = 0.0;
+  for (int level = 0; level < num_levels; ++level) {
+    total_weight += std::pow(0.25, level);
+  }
+  std::vector<std::vector<Candidate>> selected(num_levels);
+  size_t carry = 0;
+  for (int level = 0; level < num_levels; ++level) {
+    const image::Image &image = pyramid.levels[level];
+    const size_t budget =
+        carry + static_cast<size_t>(options_.max_num_features * std::pow(0.25, level) /
+                                    total_weight);
+    std::vector<Candidate> candidates;
+    DetectLevel(image, options_, &scratch, &candidates);
+    selected[level] = SelectCandidates(std::move(candidates), image.width(), image.height(),
+                                       options_.cell_size, budget);
+    carry = budget - selected[level].size();
+  }
+
+  size_t num_features = 0;
+  for (const std::vector<Candidate> &level_selected : selected) {
+    num_features += level_selected.size();
+  }
+  FeatureSet features;
+  features.keypoints.resize(num_features);
+  features.descriptors = FeatureDescriptors(DescriptorType::BINARY, kDescriptorBytes, num_features);
+  size_t first_row = 0;
+  for (int level = 0; level < num_levels; ++level) {
+    const float scale = pyramid.Scale(level);
+    Keypoint *keypoints = features.keypoints.data() + first_row;
+    for (size_t i = 0; i < selected[level].size(); ++i) {
+      const Candidate &candidate = selected[level][i];
+      keypoints[i].x = candidate.x * scale;
+      keypoints[i].y = candidate.y * scale;
+      keypoints[i].scale = scale;
+      keypoints[i].response = candidate.response;
+      keypoints[i].level = level;
+    }
+    DescribeLevel(pyramid.levels[level], selected[level], options_.band_rows, &scratch, keypoints,
+                  &features.descriptors, first_row);
+    first_row += selected[level].size();
+  }
+  return features;
+}
+
+#ifdef PHOTOGRAMMETRY_OPENCV_ENABLED
+FeatureSet FeatureExtractor::ExtractOpenCV(const image::ImagePyramid &pyramid) const {
+  // OpenCV 自行构建金字塔, 只使用第 0 层
+  const image::Image &level = pyramid.levels.at(0);
+  const cv::Mat gray(level.height(), level.width(), CV_32F, const_cast<uint8_t *>(level.data()),
+                     level.stride());
+  cv::Mat gray8;
+  gray.convertTo(gray8, CV_8U, 255.0);
+
+  cv::Ptr<cv::Feature2D> detector;
+  if (options_.type == FeatureExtractorType::OPENCV_SIFT) {
+    detector = cv::SIFT::create(options_.max_num_features);
+  } else {
+    detector = cv::ORB::create(options_.max_num_features);
+  }
+  std::vector<cv::KeyPoint> cv_keypoints;
+  cv::Mat cv_descriptors;
+  detector->detectAndCompute(gray8, cv::noArray(), cv_keypoints, cv_descriptors);
+
+  FeatureSet features;
+  features.keypoints.resize(cv_keypoints.size());
+  features.descriptors = FeatureDescriptors(Type(), Dimension(), cv_keypoints.size());
+  for (size_t i = 0; i < cv_keypoints.size(); ++i) {
+    const cv::KeyPoint &cv_keypoint = cv_keypoints[i];
+    Keypoint &keypoint = features.keypoints[i];
+    keypoint.x = cv_keypoint.pt.x;
+    keypoint.y = cv_keypoint.pt.y;
+    // 以 31 像素的 ORB 采样窗口为单位
+    keypoint.scale = cv_keypoint.size / 31.0f;
+    keypoint.orientation = static_cast<float>(cv_keypoint.angle * kPi / 180.0);
+    keypoint.response = cv_keypoint.response;
+    keypoint.level = std::max(0, cv_keypoint.octave & 0xff);
+    std::copy(cv_descriptors.ptr<uint8_t>(static_cast<int>(i)),
+              cv_descriptors.ptr<uint8_t>(static_cast<int>(i)) +
+                  Dimension() * features.descriptors.ElementSize(),
+              features.descriptors.Row<uint8_t>(i));
+  }
+  return features;
+}
+#else
+FeatureSet FeatureExtractor::ExtractOpenCV(const image::ImagePyramid &) const {
+  throw std::invalid_argument("OpenCV feature extractors require OpenCV support");
+}
+#endif
+
+} // namespace feature
+} // namespace photogrammetry
@@ -0,0 +1,78 @@
+#ifndef PHOTOGRAMMETRY_FEATURE_EXTRACTOR_HPP
+#define PHOTOGRAMMETRY_FEATURE_EXTRACTOR_HPP
+
+#include "feature/types.hpp"
+#include "image/preprocessor.hpp"
+#include "utils/thread_pool.hpp"
+#include <memory>
+#include <vector>
+
+namespace photogrammetry {
+namespace feature {
+
+enum class FeatureExtractorType : uint8_t {
+  // 金字塔上的 Harris 角点 + 灰度质心方向 + 旋转 BRIEF 二值描述子 (256 位)
+  HARRIS_BRIEF = 0,
+  // OpenCV 实现, 作为参考, 需要编译时定义 PHOTOGRAMMETRY_OPENCV_ENABLED
+  OPENCV_ORB,
+  OPENCV_SIFT,
+};
+
+struct FeatureExtractorOptions {
+  FeatureExtractorType type = FeatureExtractorType::HARRIS_BRIEF;
+  // 每张影像最多的特征点数, 按各层面积分配到金字塔各层
+  int max_num_features = 8192;
+  // Harris 响应 det(M) - k trace(M)^2 的系数与阈值(灰度范围 [0, 1])
+  float harris_k = 0.04f;
+  float min_response = 1e-7f;
+  // 各层按 cell_size x cell_size 的网格均匀选点, 每格最多分得平均数的 2 倍
+  int cell_size = 32;
+  // 按行分块处理时每块的行数
+  int band_rows = 64;
+  // 并行处理影像的线程数, -1 表示使用全部硬件线程
+  int num_threads = -1;
+
+  bool Check() const;
+};
+
+/*
+ * @brief 特征提取
+ * 输入为 image::ImagePreprocessor 构建的灰度金字塔。HARRIS_BRIEF 逐层按行分块计算 Harris 响应
+ * (梯度、结构张量与 5 阶二项式窗口均为 Eigen 数组运算, 随编译目标自动向量化), 3x3 非极大值抑制后
+ * 在网格中按响应选点, 然后在平滑后的分块上计算方向与描述子。描述子的采样偏移按 32 个方向预先
+ * 旋转, 每个特征点只需查表取样与比较。分块的临时内存属于各线程并被重复使用。
+ * 多张影像由内部线程池并行处理, 单张影像的 Extract 可以被多个线程同时调用。
+ * 输出的特征点按层、再按响应从大到小排列, 其下标即 point2D_t。
+ */
+class FeatureExtractor {
+public:
+  explicit FeatureExtractor(const FeatureExtractorOptions &options = FeatureExtractorOptions());
+
+  FeatureExtractor(const FeatureExtractor &) = delete;
+  FeatureExtractor &operator=(const FeatureExtractor &) = delete;
+
+  // 提取一张影像的特征
+  FeatureSet Extract(const image::ImagePyramid &pyramid) const;
+
+  // 在线程池中并行提取多张影像的特征, 结果与输入一一对应
+  // 任一影像出错时, 等待全部任务结束后抛出按输入顺序的第一个异常
+  std::vector<FeatureSet> Extract(const std::vector<image::ImagePyramid> &pyramids);
+
+  // 描述子类型与维度
+  DescriptorType Type() const;
+  int Dimension() const;
+
+  const FeatureExtractorOptions &Options() const { return options_; }
+
+private:
+  FeatureSet ExtractHarrisBrief(const image::ImagePyramid &pyramid) const;
+  FeatureSet ExtractOpenCV(const image::ImagePyramid &pyramid) const;
+
+  FeatureExtractorOptions options_;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+};
+
+} // namespace feature
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_FEATURE_EXTRACTOR_HPP
@@ -0,0 +1,57 @@
+#include "feature/extractor.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+
+namespace {
+// Smoothed noise, textured everywhere like an aerial image
+image::ImagePyramid MakePyramid(const int width, const int height, const unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+  image::Image image = image::Image::Allocate(width, height, 1, image::PixelType::FLOAT32);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      image.At<float>(x, y) = noise(rng);
+    }
+  }
+  image::PreprocessorOptions options;
+  options.num_levels = 4;
+  options.initial_sigma = 1.5;
+  return image::ImagePreprocessor(options).BuildPyramid(image);
+}
+} // namespace
+
+static void BM_ExtractSingle(benchmark::State &state) {
+  const int width = static_cast<int>(state.range(0));
+  const image::ImagePyramid pyramid = MakePyramid(width, width * 3 / 4, 0);
+  FeatureExtractor extractor;
+  size_t num_features = 0;
+  for (auto _ : state) {
+    const FeatureSet features = extractor.Extract(pyramid);
+    num_features = features.size();
+    benchmark::DoNotOptimize(features.descriptors.data());
+  }
+  state.counters["features"] = static_cast<double>(num_features);
+  state.counters["images/s"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ExtractSingle)->Arg(1024)->Arg(2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Images of a batch are processed by the thread pool in parallel
+static void BM_ExtractBatch(benchmark::State &state) {
+  std::vector<image::ImagePyramid> pyramids;
+  for (unsigned seed = 0; seed < 16; ++seed) {
+    pyramids.push_back(MakePyramid(1024, 768, seed));
+  }
+  FeatureExtractorOptions options;
+  options.num_threads = static_cast<int>(state.range(0));
+  FeatureExtractor extractor(options);
+  for (auto _ : state) {
+    const std::vector<FeatureSet> features = extractor.Extract(pyramids);
+    benchmark::DoNotOptimize(features.data());
+  }
+  state.counters["images/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * pyramids.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ExtractBatch)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
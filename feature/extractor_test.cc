@@ -0,0 +1,179 @@
+#include "feature/extractor.hpp"
+#include <gtest/gtest.h>
+#include <bitset>
+#include <cmath>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+
+namespace {
+
+// 随机排布的亮暗方块, 方块的角点是稳定的 Harris 角点
+image::Image MakeBlocksImage(const int width, const int height, const unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> position(0, std::max(width, height));
+  std::uniform_int_distribution<int> size(8, 40);
+  std::uniform_real_distribution<float> intensity(0.0f, 1.0f);
+  image::Image image = image::Image::Allocate(width, height, 1, image::PixelType::FLOAT32);
+  for (int y = 0; y < height; ++y) {
+    std::fill(image.Row<float>(y), image.Row<float>(y) + width, 0.5f);
+  }
+  for (int i = 0; i < width * height / 400; ++i) {
+    const int x0 = position(rng) % width;
+    const int y0 = position(rng) % height;
+    const int w = size(rng);
+    const int h = size(rng);
+    const float value = intensity(rng);
+    for (int y = y0; y < std::min(height, y0 + h); ++y) {
+      for (int x = x0; x < std::min(width, x0 + w); ++x) {
+        image.At<float>(x, y) = value;
+      }
+    }
+  }
+  return image;
+}
+
+// 逆时针旋转 90 度: 输出 (x', y') = (y, w - 1 - x)
+image::Image Rotate90(const image::Image &image) {
+  image::Image rotated =
+      image::Image::Allocate(image.height(), image.width(), 1, image::PixelType::FLOAT32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      rotated.At<float>(y, image.width() - 1 - x) = image.At<float>(x, y);
+    }
+  }
+  return rotated;
+}
+
+image::ImagePyramid BuildPyramid(const image::Image &image) {
+  image::PreprocessorOptions options;
+  options.num_levels = 3;
+  options.initial_sigma = 0.7;
+  image::ImagePreprocessor preprocessor(options);
+  return preprocessor.BuildPyramid(image);
+}
+
+int HammingDistance(const uint8_t *a, const uint8_t *b, const int num_bytes) {
+  int distance = 0;
+  for (int i = 0; i < num_bytes; ++i) {
+    distance += static_cast<int>(std::bitset<8>(a[i] ^ b[i]).count());
+  }
+  return distance;
+}
+
+} // namespace
+
+TEST(FeatureExtractorTest, ExtractsKeypointsAndDescriptors) {
+  FeatureExtractorOptions options;
+  options.max_num_features = 500;
+  FeatureExtractor extractor(options);
+  const image::ImagePyramid pyramid = BuildPyramid(MakeBlocksImage(320, 240, 1));
+  const FeatureSet features = extractor.Extract(pyramid);
+
+  ASSERT_GT(features.size(), 100u);
+  EXPECT_LE(features.size(), 500u);
+  ASSERT_EQ(features.descriptors.size(), features.size());
+  EXPECT_EQ(features.descriptors.type(), DescriptorType::BINARY);
+  EXPECT_EQ(features.descriptors.dimension(), 32);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(features.descriptors.data()) %
+                FeatureDescriptors::kAlignment,
+            0u);
+  int last_level = 0;
+  for (const Keypoint &keypoint : features.keypoints) {
+    EXPECT_GE(keypoint.x, 0.0f);
+    EXPECT_LT(keypoint.x, 320.0f);
+    EXPECT_GE(keypoint.y, 0.0f);
+    EXPECT_LT(keypoint.y, 240.0f);
+    EXPECT_EQ(keypoint.scale, static_cast<float>(1 << keypoint.level));
+    EXPECT_GE(keypoint.level, last_level);
+    last_level = keypoint.level;
+  }
+}
+
+TEST(FeatureExtractorTest, DescriptorsAreRotationInvariant) {
+  FeatureExtractorOptions options;
+  options.max_num_features = 1000;
+  FeatureExtractor extractor(options);
+  const image::Image image = MakeBlocksImage(256, 256, 2);
+  const FeatureSet features = extractor.Extract(BuildPyramid(image));
+  const FeatureSet rotated = extractor.Extract(BuildPyramid(Rotate90(image)));
+
+  // 对第 0 层中能在旋转影像里找到对应位置的特征点, 比较描述子距离
+  int num_compared = 0;
+  int num_close = 0;
+  for (size_t i = 0; i < features.size(); ++i) {
+    const Keypoint &keypoint = features.keypoints[i];
+    if (keypoint.level != 0) {
+      continue;
+    }
+    const float x = keypoint.y;
+    const float y = image.width() - 1 - keypoint.x;
+    for (size_t j = 0; j < rotated.size(); ++j) {
+      const Keypoint &other = rotated.keypoints[j];
+      if (other.level == 0 && std::abs(other.x - x) < 0.5f && std::abs(other.y - y) < 0.5f) {
+        ++num_compared;
+        const int distance = HammingDistance(features.descriptors.Row<uint8_t>(i),
+                                             rotated.descriptors.Row<uint8_t>(j), 32);
+        num_close += distance < 40 ? 1 : 0;
+        break;
+      }
+    }
+  }
+  ASSERT_GT(num_compared, 50);
+  EXPECT_GT(num_close, 0.8 * num_compared);
+}
+
+TEST(FeatureExtractorTest, ParallelMatchesSequential) {
+  FeatureExtractorOptions options;
+  options.max_num_features = 300;
+  options.num_threads = 4;
+  FeatureExtractor extractor(options);
+  std::vector<image::ImagePyramid> pyramids;
+  for (unsigned seed = 0; seed < 8; ++seed) {
+    pyramids.push_back(BuildPyramid(MakeBlocksImage(200, 150, seed)));
+  }
+  const std::vector<FeatureSet> features = extractor.Extract(pyramids);
+  ASSERT_EQ(features.size(), pyramids.size());
+  for (size_t i = 0; i < pyramids.size(); ++i) {
+    const FeatureSet expected = extractor.Extract(pyramids[i]);
+    ASSERT_EQ(features[i].size(), expected.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      EXPECT_EQ(features[i].keypoints[j].x, expected.keypoints[j].x);
+      EXPECT_EQ(features[i].keypoints[j].y, expected.keypoints[j].y);
+    }
+    EXPECT_TRUE(std::equal(expected.descriptors.data(),
+                           expected.descriptors.data() + expected.size() * 32,
+                           features[i].descriptors.data()));
+  }
+}
+
+TEST(FeatureExtractorTest, ParallelRejectsInvalidPyramid) {
+  FeatureExtractorOptions options;
+  options.num_threads = 4;
+  FeatureExtractor extractor(options);
+  std::vector<image::ImagePyramid> pyramids;
+  for (unsigned seed = 0; seed < 8; ++seed) {
+    pyramids.push_back(BuildPyramid(MakeBlocksImage(200, 150, seed)));
+  }
+  // 第一张影像无效, 其余任务仍在运行时就会出错
+  pyramids[0].levels[0] = image::Image::Allocate(64, 64, 3, image::PixelType::UINT8);
+  EXPECT_THROW(extractor.Extract(pyramids), std::invalid_argument);
+  pyramids.erase(pyramids.begin());
+  EXPECT_EQ(extractor.Extract(pyramids).size(), pyramids.size());
+}
+
+TEST(FeatureExtractorTest, RejectsInvalidInput) {
+  FeatureExtractorOptions options;
+  options.max_num_features = 0;
+  EXPECT_THROW(FeatureExtractor extractor(options), std::invalid_argument);
+
+  FeatureExtractor extractor;
+  image::ImagePyramid pyramid;
+  pyramid.levels.push_back(image::Image::Allocate(64, 64, 3, image::PixelType::UINT8));
+  EXPECT_THROW(extractor.Extract(pyramid), std::invalid_argument);
+
+  // 小于边界的影像没有特征点
+  const FeatureSet features = extractor.Extract(BuildPyramid(MakeBlocksImage(30, 30, 0)));
+  EXPECT_EQ(features.size(), 0u);
+}
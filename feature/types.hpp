@@ -0,0 +1,102 @@
+#ifndef PHOTOGRAMMETRY_FEATURE_TYPES_HPP
+#define PHOTOGRAMMETRY_FEATURE_TYPES_HPP
+
+#include "camera/std_types.hpp"
+#include "utils/aligned_allocator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace photogrammetry {
+namespace feature {
+
+// 特征点, 坐标为第 0 层的像素坐标
+struct Keypoint {
+  float x = 0.0f;
+  float y = 0.0f;
+  // 检测所在的金字塔层相对第 0 层的缩放
+  float scale = 1.0f;
+  // 主方向(弧度), 在像素坐标系中由 +x 轴转向 +y 轴为正; y 轴向下, 显示时为顺时针
+  float orientation = 0.0f;
+  float response = 0.0f;
+  int level = 0;
+};
+
+// 特征点按 point2D_t 编号, 第 i 个特征点的 point2D_t 为 i
+typedef std::vector<Keypoint> FeatureKeypoints;
+
+// BINARY: 按位比较的描述子, 每个元素一个字节, 用 Hamming 距离匹配; FLOAT32: 用 L2 距离匹配
+enum class DescriptorType : uint8_t { BINARY = 0, FLOAT32 };
+
+/*
+ * @brief 描述子矩阵
+ * 所有描述子存放在一块按 kAlignment 对齐的连续内存中, 第 i 行为第 i 个特征点的描述子,
+ * 行距为 kRowAlignment 的整数倍, 行尾填充为 0, 便于 SIMD 按整行加载。
+ */
+class FeatureDescriptors {
+public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kRowAlignment = 32;
+
+  FeatureDescriptors() = default;
+
+  /*
+   * @param dimension 每个描述子的元素数, BINARY 为字节数, FLOAT32 为浮点数个数
+   */
+  FeatureDescriptors(const DescriptorType type, const int dimension, const size_t num_rows = 0)
+      : type_(type), dimension_(dimension) {
+    if (dimension <= 0) {
+      throw std::invalid_argument("Descriptor dimension must be positive");
+    }
+    const size_t row_bytes = dimension * ElementSize();
+    stride_ = (row_bytes + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+    resize(num_rows);
+  }
+
+  DescriptorType type() const { return type_; }
+  int dimension() const { return dimension_; }
+  size_t size() const { return num_rows_; }
+  bool empty() const { return num_rows_ == 0; }
+  // 相邻两行相距的字节数
+  size_t stride() const { return stride_; }
+  size_t ElementSize() const { return type_ == DescriptorType::BINARY ? 1 : sizeof(float); }
+
+  // 调整行数, 已有的行保持不变, 新增的行为 0
+  void resize(const size_t num_rows) {
+    data_.resize(num_rows * stride_, 0);
+    num_rows_ = num_rows;
+  }
+
+  uint8_t *data() { return data_.data(); }
+  const uint8_t *data() const { return data_.data(); }
+
+  template <typename T>
+  T *Row(const size_t i) {
+    return reinterpret_cast<T *>(data_.data() + i * stride_);
+  }
+  template <typename T>
+  const T *Row(const size_t i) const {
+    return reinterpret_cast<const T *>(data_.data() + i * stride_);
+  }
+
+private:
+  DescriptorType type_ = DescriptorType::BINARY;
+  int dimension_ = 0;
+  size_t stride_ = 0;
+  size_t num_rows_ = 0;
+  utils::AlignedVector<uint8_t, kAlignment> data_;
+};
+
+// 一张影像的特征
+struct FeatureSet {
+  FeatureKeypoints keypoints;
+  FeatureDescriptors descriptors;
+
+  size_t size() const { return keypoints.size(); }
+};
+
+} // namespace feature
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_FEATURE_TYPES_HPP
@@ -0,0 +1,124 @@
+#ifndef PHOTOGRAMMETRY_IMAGE_HPP
+#define PHOTOGRAMMETRY_IMAGE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace photogrammetry {
+namespace image {
+
+enum class PixelType : uint8_t { UINT8 = 0, UINT16, FLOAT32 };
+
+inline size_t BytesPerChannel(const PixelType type) {
+  switch (type) {
+  case PixelType::UINT16:
+    return 2;
+  case PixelType::FLOAT32:
+    return 4;
+  case PixelType::UINT8:
+  default:
+    return 1;
+  }
+}
+
+/*
+ * @brief 图像缓冲区
+ * 像素按行存放, 通道交错 (彩色图像为 RGB 顺序), 相邻两行相距 stride 字节。
+ * 像素内存由共享的 owner 持有, 可以是对齐的堆内存, 也可以是文件的内存映射(零拷贝),
+ * 拷贝 Image 只增加引用计数, 最后一个引用释放时 owner 的删除器被调用。
+ */
+class Image {
+public:
+  // 新分配图像的行对齐字节数, 便于 SIMD 按行处理
+  static constexpr size_t kRowAlignment = 64;
+
+  Image() = default;
+
+  // 每行字节数按 kRowAlignment 对齐后的行距
+  static size_t AlignedStride(const int width, const int channels, const PixelType type) {
+    const size_t row_bytes = static_cast<size_t>(width) * channels * BytesPerChannel(type);
+    return (row_bytes + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+  }
+
+  // 分配一幅未初始化的图像, 每行按 kRowAlignment 对齐
+  static Image Allocate(const int width, const int height, const int channels,
+                        const PixelType type) {
+    const size_t stride = AlignedStride(width, channels, type);
+    const size_t num_bytes = std::max<size_t>(stride * height, kRowAlignment);
+    void *data = std::aligned_alloc(kRowAlignment, num_bytes);
+    if (data == nullptr) {
+      throw std::bad_alloc();
+    }
+    std::shared_ptr<uint8_t> owner(static_cast<uint8_t *>(data), std::free);
+    return Image(std::move(owner), static_cast<uint8_t *>(data), width, height, channels, type,
+                 stride);
+  }
+
+  /*
+   * @brief 包装外部内存(如内存映射), 不拷贝像素
+   * @param owner 持有内存的对象, 像素数据在其生命周期内有效, 最后一个引用释放时调用其删除器
+   * @param data 第一行像素的地址
+   */
+  static Image Wrap(std::shared_ptr<uint8_t> owner, uint8_t *data, const int width,
+                    const int height, const int channels, const PixelType type,
+                    const size_t stride) {
+    return Image(std::move(owner), data, width, height, channels, type, stride);
+  }
+
+  bool empty() const { return data_ == nullptr; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int channels() const { return channels_; }
+  PixelType type() const { return type_; }
+  size_t stride() const { return stride_; }
+  size_t BytesPerPixel() const { return channels_ * BytesPerChannel(type_); }
+  // 像素数据占用的字节数(不含行尾填充)
+  size_t SizeInBytes() const { return static_cast<size_t>(width_) * height_ * BytesPerPixel(); }
+  // 像素内存占用的字节数(含行尾填充)
+  size_t BufferSizeInBytes() const { return stride_ * height_; }
+  // 像素内存的持有者, 可用于构造共享同一块内存的 Image
+  const std::shared_ptr<uint8_t> &owner() const { return owner_; }
+
+  uint8_t *data() { return data_; }
+  const uint8_t *data() const { return data_; }
+
+  template <typename T>
+  T *Row(const int y) {
+    return reinterpret_cast<T *>(data_ + y * stride_);
+  }
+  template <typename T>
+  const T *Row(const int y) const {
+    return reinterpret_cast<const T *>(data_ + y * stride_);
+  }
+  template <typename T>
+  T &At(const int x, const int y, const int c = 0) {
+    return Row<T>(y)[x * channels_ + c];
+  }
+  template <typename T>
+  const T &At(const int x, const int y, const int c = 0) const {
+    return Row<T>(y)[x * channels_ + c];
+  }
+
+private:
+  Image(std::shared_ptr<uint8_t> owner, uint8_t *data, const int width, const int height,
+        const int channels, const PixelType type, const size_t stride)
+      : owner_(std::move(owner)), data_(data), width_(width), height_(height),
+        channels_(channels), type_(type), stride_(stride) {}
+
+  std::shared_ptr<uint8_t> owner_;
+  uint8_t *data_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  int channels_ = 0;
+  PixelType type_ = PixelType::UINT8;
+  size_t stride_ = 0;
+};
+
+} // namespace image
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_IMAGE_HPP
@@ -0,0 +1,322 @@
+#include "image/image_io.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef PHOTOGRAMMETRY_OPENCV_ENABLED
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#endif
+
+namespace photogrammetry {
+namespace image {
+
+namespace {
+
+void SetError(std::string *error, const std::string &message) {
+  if (error != nullptr) {
+    *error = message;
+  }
+}
+
+// 文件头探测只需读取开头的少量字节
+std::vector<uint8_t> ReadFilePrefix(const std::string &path, const size_t num_bytes) {
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> buffer(num_bytes);
+  file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(num_bytes));
+  buffer.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+  return buffer;
+}
+
+uint32_t ReadBigEndian16(const uint8_t *data) { return (uint32_t(data[0]) << 8) | data[1]; }
+
+uint32_t ReadBigEndian32(const uint8_t *data) {
+  return (ReadBigEndian16(data) << 16) | ReadBigEndian16(data + 2);
+}
+
+/*
+ * @brief 解析二进制 PNM 文件头 (P5 灰度 / P6 彩色)
+ * @param data_offset 输出的像素数据起始偏移
+ */
+bool ParsePnmHeader(const uint8_t *data, const size_t size, ImageHeader *header,
+                    size_t *data_offset) {
+  if (size < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) {
+    return false;
+  }
+  size_t pos = 2;
+  int values[3];
+  for (int &value : values) {
+    // 跳过空白与注释
+    while (pos < size && (std::isspace(data[pos]) || data[pos] == '#')) {
+      if (data[pos] == '#') {
+        while (pos < size && data[pos] != '\n') {
+          ++pos;
+        }
+      } else {
+        ++pos;
+      }
+    }
+    if (pos == size || !std::isdigit(data[pos])) {
+      return false;
+    }
+    value = 0;
+    while (pos < size && std::isdigit(data[pos])) {
+      value = value * 10 + (data[pos++] - '0');
+    }
+  }
+  // 最大值之后紧跟一个空白字符, 然后是像素数据
+  if (pos == size || !std::isspace(data[pos]) || values[0] <= 0 || values[1] <= 0 ||
+      values[2] <= 0 || values[2] > 65535) {
+    return false;
+  }
+  header->width = values[0];
+  header->height = values[1];
+  header->channels = data[1] == '5' ? 1 : 3;
+  header->type = values[2] < 256 ? PixelType::UINT8 : PixelType::UINT16;
+  header->mappable = header->type == PixelType::UINT8;
+  *data_offset = pos + 1;
+  return true;
+}
+
+bool ParsePngHeader(const uint8_t *data, const size_t size, ImageHeader *header) {
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (size < 26 || std::memcmp(data, kSignature, 8) != 0 || std::memcmp(data + 12, "IHDR", 4)) {
+    return false;
+  }
+  header->width = static_cast<int>(ReadBigEndian32(data + 16));
+  header->height = static_cast<int>(ReadBigEndian32(data + 20));
+  const int bit_depth = data[24];
+  const int color_type = data[25];
+  // 灰度(0)与带透明通道的灰度(4)解码为单通道, 其余解码为 RGB
+  header->channels = (color_type == 0 || color_type == 4) ? 1 : 3;
+  header->type = bit_depth == 16 ? PixelType::UINT16 : PixelType::UINT8;
+  header->mappable = false;
+  return header->width > 0 && header->height > 0;
+}
+
+// JPEG 的尺寸位于 SOF 段, 需要逐段跳过之前的数据
+bool ParseJpegHeader(const std::string &path, ImageHeader *header) {
+  std::ifstream file(path, std::ios::binary);
+  uint8_t marker[4];
+  if (!file.read(reinterpret_cast<char *>(marker), 2) || marker[0] != 0xFF || marker[1] != 0xD8) {
+    return false;
+  }
+  while (file.read(reinterpret_cast<char *>(marker), 4)) {
+    if (marker[0] != 0xFF) {
+      return false;
+    }
+    const uint8_t type = marker[1];
+    const uint32_t length = ReadBigEndian16(marker + 2);
+    // SOF0 ~ SOF15, 不含 DHT(C4), JPG(C8), DAC(CC)
+    if (type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC) {
+      uint8_t sof[6];
+      if (!file.read(reinterpret_cast<char *>(sof), 6)) {
+        return false;
+      }
+      header->height = static_cast<int>(ReadBigEndian16(sof + 1));
+      header->width = static_cast<int>(ReadBigEndian16(sof + 3));
+      header->channels = sof[5] == 1 ? 1 : 3;
+      header->type = sof[0] > 8 ? PixelType::UINT16 : PixelType::UINT8;
+      header->mappable = false;
+      return header->width > 0 && header->height > 0;
+    }
+    if (type == 0xD9 || type == 0xDA || length < 2) {
+      return false;
+    }
+    file.seekg(length - 2, std::ios::cur);
+  }
+  return false;
+}
+
+// 内存映射整个文件, 映射为写时复制, 修改像素不会写回文件
+std::shared_ptr<uint8_t> MapFile(const std::string &path, size_t *size) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t num_bytes = static_cast<size_t>(st.st_size);
+  void *data = ::mmap(nullptr, num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  // 映射建立后即可关闭文件描述符
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  *size = num_bytes;
+  return std::shared_ptr<uint8_t>(static_cast<uint8_t *>(data),
+                                  [num_bytes](uint8_t *ptr) { ::munmap(ptr, num_bytes); });
+}
+
+// 分配像素内存; 设置了 on_release 时, 最后一个引用释放内存后以字节数回调
+Image AllocateImage(const int width, const int height, const int channels, const PixelType type,
+                    const ReadImageOptions &options) {
+  Image image = Image::Allocate(width, height, channels, type);
+  if (!options.on_release) {
+    return image;
+  }
+  const size_t num_bytes = image.BufferSizeInBytes();
+  uint8_t *data = image.data();
+  std::shared_ptr<uint8_t> owner(
+      data, [image, on_release = options.on_release, num_bytes](uint8_t *) mutable {
+        image = Image();
+        on_release(num_bytes);
+      });
+  return Image::Wrap(std::move(owner), data, width, height, channels, type, image.stride());
+}
+
+bool ReadPnm(const std::string &path, const ReadImageOptions &options, Image *image,
+             std::string *error) {
+  size_t file_size = 0;
+  const std::shared_ptr<uint8_t> mapping = MapFile(path, &file_size);
+  if (!mapping) {
+    SetError(error, "Failed to map " + path);
+    return false;
+  }
+  ImageHeader header;
+  size_t offset = 0;
+  if (!ParsePnmHeader(mapping.get(), file_size, &header, &offset)) {
+    SetError(error, "Invalid PNM header in " + path);
+    return false;
+  }
+  const size_t row_bytes =
+      static_cast<size_t>(header.width) * header.channels * BytesPerChannel(header.type);
+  if (offset + row_bytes * header.height > file_size) {
+    SetError(error, "Truncated PNM data in " + path);
+    return false;
+  }
+  const uint8_t *pixels = mapping.get() + offset;
+  if (header.mappable && options.use_mmap) {
+    *image = Image::Wrap(mapping, mapping.get() + offset, header.width, header.height,
+                         header.channels, header.type, row_bytes);
+    return true;
+  }
+  *image = AllocateImage(header.width, header.height, header.channels, header.type, options);
+  for (int y = 0; y < header.height; ++y) {
+    const uint8_t *src = pixels + y * row_bytes;
+    uint8_t *dst = image->Row<uint8_t>(y);
+    if (header.type == PixelType::UINT16) {
+      // PNM 的 16 位数据为大端序
+      for (size_t i = 0; i < row_bytes; i += 2) {
+        dst[i] = src[i + 1];
+        dst[i + 1] = src[i];
+      }
+    } else {
+      std::memcpy(dst, src, row_bytes);
+    }
+  }
+  return true;
+}
+
+#ifdef PHOTOGRAMMETRY_OPENCV_ENABLED
+bool ReadWithOpenCV(const std::string &path, const ReadImageOptions &options, Image *image,
+                    std::string *error) {
+  const cv::Mat mat = cv::imread(path, cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR);
+  if (mat.empty()) {
+    SetError(error, "Failed to decode " + path);
+    return false;
+  }
+  PixelType type;
+  switch (mat.depth()) {
+  case CV_8U:
+    type = PixelType::UINT8;
+    break;
+  case CV_16U:
+    type = PixelType::UINT16;
+    break;
+  case CV_32F:
+    type = PixelType::FLOAT32;
+    break;
+  default:
+    SetError(error, "Unsupported pixel depth in " + path);
+    return false;
+  }
+  const int channels = mat.channels() == 1 ? 1 : 3;
+  *image = AllocateImage(mat.cols, mat.rows, channels, type, options);
+  // 直接解码/转换到 Image 的内存中, 不产生额外拷贝
+  cv::Mat dst(mat.rows, mat.cols, CV_MAKETYPE(mat.depth(), channels), image->data(),
+              image->stride());
+  if (mat.channels() == 1) {
+    mat.copyTo(dst);
+  } else if (mat.channels() == 4) {
+    cv::cvtColor(mat, dst, cv::COLOR_BGRA2RGB);
+  } else {
+    cv::cvtColor(mat, dst, cv::COLOR_BGR2RGB);
+  }
+  return true;
+}
+#endif
+
+} // namespace
+
+size_t ImageHeader::DecodedSizeInBytes() const {
+  return std::max(Image::AlignedStride(width, channels, type) * height, Image::kRowAlignment);
+}
+
+bool ReadImageHeader(const std::string &path, ImageHeader *header) {
+  // 足够容纳 PNM 文件头(含较短的注释)与 PNG 的 IHDR 段
+  const std::vector<uint8_t> prefix = ReadFilePrefix(path, 512);
+  size_t offset = 0;
+  if (ParsePnmHeader(prefix.data(), prefix.size(), header, &offset) ||
+      ParsePngHeader(prefix.data(), prefix.size(), header)) {
+    return true;
+  }
+  return ParseJpegHeader(path, header);
+}
+
+bool ReadImage(const std::string &path, const ReadImageOptions &options, Image *image,
+               std::string *error) {
+  const std::vector<uint8_t> magic = ReadFilePrefix(path, 2);
+  if (magic.size() < 2) {
+    SetError(error, "Failed to read " + path);
+    return false;
+  }
+  if (magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6')) {
+    return ReadPnm(path, options, image, error);
+  }
+#ifdef PHOTOGRAMMETRY_OPENCV_ENABLED
+  return ReadWithOpenCV(path, options, image, error);
+#else
+  SetError(error, "Unsupported image format (built without OpenCV): " + path);
+  return false;
+#endif
+}
+
+bool WritePnm(const std::string &path, const Image &image) {
+  if (image.empty() || (image.channels() != 1 && image.channels() != 3) ||
+      image.type() == PixelType::FLOAT32) {
+    return false;
+  }
+  std::ofstream file(path, std::ios::binary);
+  const bool is_16bit = image.type() == PixelType::UINT16;
+  file << (image.channels() == 1 ? "P5" : "P6") << "\n"
+       << image.width() << " " << image.height() << "\n"
+       << (is_16bit ? 65535 : 255) << "\n";
+  const size_t row_bytes = static_cast<size_t>(image.width()) * image.BytesPerPixel();
+  std::vector<uint8_t> row(row_bytes);
+  for (int y = 0; y < image.height(); ++y) {
+    const uint8_t *src = image.Row<uint8_t>(y);
+    if (is_16bit) {
+      for (size_t i = 0; i < row_bytes; i += 2) {
+        row[i] = src[i + 1];
+        row[i + 1] = src[i];
+      }
+    } else {
+      std::memcpy(row.data(), src, row_bytes);
+    }
+    file.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row_bytes));
+  }
+  return static_cast<bool>(file);
+}
+
+} // namespace image
+} // namespace photogrammetry
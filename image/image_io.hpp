@@ -0,0 +1,62 @@
+#ifndef PHOTOGRAMMETRY_IMAGE_IO_HPP
+#define PHOTOGRAMMETRY_IMAGE_IO_HPP
+
+#include "image/image.hpp"
+#include <functional>
+#include <string>
+
+namespace photogrammetry {
+namespace image {
+
+// 不解码像素即可得到的图像信息
+struct ImageHeader {
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  PixelType type = PixelType::UINT8;
+  // 像素数据是否未压缩, 可以直接内存映射
+  bool mappable = false;
+
+  // 解码后像素占用的字节数上界(含行对齐填充)
+  size_t DecodedSizeInBytes() const;
+};
+
+/*
+ * @brief 只读取文件头, 获取图像尺寸
+ * 支持 PNM(P5/P6), PNG 与 JPEG, 其余格式返回 false
+ * @param path 图像路径
+ * @param header 输出的图像信息
+ * @return 是否成功
+ */
+bool ReadImageHeader(const std::string &path, ImageHeader *header);
+
+struct ReadImageOptions {
+  // 对未压缩且无需转换的数据(8 位 PNM)使用内存映射, 不拷贝像素
+  bool use_mmap = true;
+  // 新分配的像素内存(非内存映射)在最后一个引用释放后的回调, 参数为 BufferSizeInBytes;
+  // 可能在任意持有图像的线程中调用
+  std::function<void(size_t)> on_release;
+};
+
+/*
+ * @brief 读取图像
+ * 8 位 PNM 直接内存映射, 16 位 PNM 拷贝并转换字节序; 其他格式需要 OpenCV 解码
+ * (编译时定义 PHOTOGRAMMETRY_OPENCV_ENABLED), 彩色图像统一为 RGB 顺序
+ * @param path 图像路径
+ * @param image 输出的图像
+ * @param error 可选, 失败时的错误信息
+ * @return 是否成功
+ */
+bool ReadImage(const std::string &path, const ReadImageOptions &options, Image *image,
+               std::string *error = nullptr);
+
+/*
+ * @brief 以二进制 PNM 格式(P5/P6)写图像, 支持 1 或 3 通道的 8/16 位图像
+ * @return 是否成功
+ */
+bool WritePnm(const std::string &path, const Image &image);
+
+} // namespace image
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_IMAGE_IO_HPP
@@ -0,0 +1,153 @@
+#include "image/loader.hpp"
+#include "image/image_io.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace photogrammetry {
+namespace image {
+
+bool MemoryBudget::Acquire(const size_t ticket, const size_t num_bytes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [&]() {
+    return cancelled_ ||
+           (ticket == next_ticket_ &&
+            (budget_ == 0 || used_ == 0 || used_ + num_bytes <= budget_));
+  });
+  if (cancelled_) {
+    return false;
+  }
+  ++next_ticket_;
+  used_ += num_bytes;
+  peak_used_ = std::max(peak_used_, used_);
+  // 下一张图像可能已在等待
+  condition_.notify_all();
+  return true;
+}
+
+void MemoryBudget::ForceAcquire(const size_t num_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  used_ += num_bytes;
+  peak_used_ = std::max(peak_used_, used_);
+}
+
+void MemoryBudget::Release(const size_t num_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    used_ -= std::min(used_, num_bytes);
+  }
+  condition_.notify_all();
+}
+
+void MemoryBudget::Cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+  }
+  condition_.notify_all();
+}
+
+size_t MemoryBudget::Used() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return used_;
+}
+
+size_t MemoryBudget::PeakUsed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return peak_used_;
+}
+
+ImageLoader::ImageLoader(const ImageLoaderOptions &options, std::vector<std::string> paths,
+                         std::vector<size_t> order)
+    : options_(options), paths_(std::move(paths)), order_(std::move(order)),
+      budget_(std::make_shared<MemoryBudget>(options.memory_budget)),
+      thread_pool_(std::min(utils::GetEffectiveNumThreads(options.num_threads),
+                            std::max(1, options.prefetch_depth))) {
+  if (order_.empty()) {
+    order_.resize(paths_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+  }
+  for (const size_t index : order_) {
+    if (index >= paths_.size()) {
+      throw std::out_of_range("Image loading order refers to a non-existent path");
+    }
+  }
+  Schedule();
+}
+
+ImageLoader::~ImageLoader() {
+  // 先拒绝等待中的额度申请, 否则线程池结束时可能一直等待消费者释放图像
+  budget_->Cancel();
+  thread_pool_.Stop();
+}
+
+bool ImageLoader::Next(LoadedImage *loaded) {
+  if (pending_.empty()) {
+    return false;
+  }
+  {
+    // 消费者等待预取结果的时间, 持续偏高说明解码跟不上
+    PHOTOGRAMMETRY_PROFILE_SCOPE("image/loader_wait");
+    *loaded = pending_.front().get();
+  }
+  pending_.pop_front();
+  Schedule();
+  return true;
+}
+
+void ImageLoader::Schedule() {
+  const size_t depth = static_cast<size_t>(std::max(1, options_.prefetch_depth));
+  while (pending_.size() < depth && next_scheduled_ < order_.size()) {
+    pending_.push_back(thread_pool_.AddTask(&ImageLoader::Load, this, next_scheduled_++));
+  }
+}
+
+LoadedImage ImageLoader::Load(const size_t sequence) const {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("image/load");
+  LoadedImage loaded;
+  loaded.index = order_[sequence];
+  loaded.path = paths_[loaded.index];
+
+  // 能从文件头得到尺寸时先申请额度再解码, 否则只占用顺序, 解码后再计入
+  ImageHeader header;
+  size_t reserved = 0;
+  if (ReadImageHeader(loaded.path, &header)) {
+    reserved = header.DecodedSizeInBytes();
+  }
+  if (!budget_->Acquire(sequence, reserved)) {
+    loaded.error = "Image loading cancelled";
+    return loaded;
+  }
+
+  ReadImageOptions read_options;
+  read_options.use_mmap = options_.use_mmap;
+  Image decoded;
+  if (!ReadImage(loaded.path, read_options, &decoded, &loaded.error)) {
+    budget_->Release(reserved);
+    return loaded;
+  }
+
+  // 按实际占用修正额度
+  const size_t num_bytes = decoded.BufferSizeInBytes();
+  PHOTOGRAMMETRY_PROFILE_HISTOGRAM("image/decoded_kilobytes", num_bytes >> 10);
+  if (num_bytes > reserved) {
+    budget_->ForceAcquire(num_bytes - reserved);
+  } else {
+    budget_->Release(reserved - num_bytes);
+  }
+
+  // 与解码结果共享同一块内存, 最后一个引用释放时归还额度
+  const std::shared_ptr<MemoryBudget> budget = budget_;
+  std::shared_ptr<uint8_t> owner(decoded.data(),
+                                 [decoded, budget, num_bytes](uint8_t *) {
+                                   budget->Release(num_bytes);
+                                 });
+  loaded.image = Image::Wrap(std::move(owner), decoded.data(), decoded.width(), decoded.height(),
+                             decoded.channels(), decoded.type(), decoded.stride());
+  loaded.ok = true;
+  return loaded;
+}
+
+} // namespace image
+} // namespace photogrammetry
@@ -0,0 +1,127 @@
+#ifndef PHOTOGRAMMETRY_IMAGE_LOADER_HPP
+#define PHOTOGRAMMETRY_IMAGE_LOADER_HPP
+
+#include "image/image.hpp"
+#include "utils/thread_pool.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace photogrammetry {
+namespace image {
+
+struct ImageLoaderOptions {
+  // 解码线程数, -1 表示使用全部硬件线程
+  int num_threads = -1;
+  // 最多提前调度的图像数(正在解码与已解码未取走的图像之和)
+  int prefetch_depth = 8;
+  // 像素内存预算(字节), 已解码但未被消费者释放的图像都计入其中, 0 表示不限制
+  size_t memory_budget = size_t(4) << 30;
+  // 未压缩的输入使用内存映射, 见 ReadImageOptions::use_mmap
+  bool use_mmap = true;
+};
+
+/*
+ * @brief 图像内存预算
+ * 按加载顺序依次发放额度: 第 k 张图像的额度发放之后才会考虑第 k + 1 张, 因此乱序完成的解码
+ * 不会挤占消费者正在等待的那张图像的额度。额度不足时等待, 直到有图像被释放;
+ * 当前占用为 0 时总是发放, 保证单张超过预算的图像也能加载。
+ */
+class MemoryBudget {
+public:
+  explicit MemoryBudget(const size_t budget) : budget_(budget) {}
+
+  /*
+   * @brief 为第 ticket 张图像申请 num_bytes 字节, 阻塞直到轮到该图像且额度足够
+   * @return 预算已取消时返回 false
+   */
+  bool Acquire(const size_t ticket, const size_t num_bytes);
+
+  // 不等待地追加占用, 用于解码前无法得知大小的图像
+  void ForceAcquire(const size_t num_bytes);
+
+  void Release(const size_t num_bytes);
+
+  // 唤醒并拒绝所有等待中的申请
+  void Cancel();
+
+  size_t Used() const;
+  size_t PeakUsed() const;
+
+private:
+  const size_t budget_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  size_t used_ = 0;
+  size_t peak_used_ = 0;
+  size_t next_ticket_ = 0;
+  bool cancelled_ = false;
+};
+
+// 加载结果
+struct LoadedImage {
+  // 图像在输入路径列表中的下标
+  size_t index = 0;
+  std::string path;
+  Image image;
+  bool ok = false;
+  std::string error;
+};
+
+/*
+ * @brief 流式图像加载器
+ * 在线程池中异步解码, 按给定顺序提前预取至多 prefetch_depth 张图像, 并受内存预算的反压:
+ * 预算用尽时解码线程等待消费者释放图像。图像像素通过 ReadImage 读取, 8 位 PNM 直接内存映射。
+ * 返回的 Image 持有其额度, 最后一个引用释放时额度归还, 消费者应及时释放不再使用的图像,
+ * 否则加载会一直等待。
+ * @note 能从文件头得到尺寸的格式(PNM/PNG/JPEG)严格遵守预算; 其他格式先解码再计入,
+ *       可能短暂超出预算。
+ */
+class ImageLoader {
+public:
+  /*
+   * @param paths 图像路径
+   * @param order 加载顺序(paths 的下标), 为空时按 paths 的顺序加载全部图像
+   */
+  ImageLoader(const ImageLoaderOptions &options, std::vector<std::string> paths,
+              std::vector<size_t> order = {});
+  ~ImageLoader();
+
+  ImageLoader(const ImageLoader &) = delete;
+  ImageLoader &operator=(const ImageLoader &) = delete;
+
+  /*
+   * @brief 按加载顺序取下一张图像, 阻塞直到其解码完成
+   * @param loaded 输出的加载结果, 解码失败时 ok 为 false 且 error 给出原因
+   * @return 所有图像都已取出时返回 false
+   */
+  bool Next(LoadedImage *loaded);
+
+  size_t NumImages() const { return order_.size(); }
+  // 当前计入预算的字节数
+  size_t MemoryUsed() const { return budget_->Used(); }
+  size_t PeakMemoryUsed() const { return budget_->PeakUsed(); }
+
+private:
+  void Schedule();
+  LoadedImage Load(const size_t sequence) const;
+
+  const ImageLoaderOptions options_;
+  const std::vector<std::string> paths_;
+  std::vector<size_t> order_;
+  // 图像可能比加载器存活更久, 额度的归还需要预算对象仍然有效
+  std::shared_ptr<MemoryBudget> budget_;
+  std::deque<std::future<LoadedImage>> pending_;
+  size_t next_scheduled_ = 0;
+  utils::ThreadPool thread_pool_;
+};
+
+} // namespace image
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_IMAGE_LOADER_HPP
@@ -0,0 +1,215 @@
+#include "image/loader.hpp"
+#include "image/image_io.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace photogrammetry::image;
+
+class ImageLoaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    char dir_template[] = "/tmp/photogrammetry_loader_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    dir_ = dir_template;
+    for (int i = 0; i < kNumImages; ++i) {
+      // 交替生成灰度与彩色图像, 像素值由图像序号与位置决定
+      const int channels = i % 2 == 0 ? 1 : 3;
+      Image image = Image::Allocate(kWidth, kHeight, channels, PixelType::UINT8);
+      for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth * channels; ++x) {
+          image.Row<uint8_t>(y)[x] = ExpectedPixel(i, x, y);
+        }
+      }
+      paths_.push_back(dir_ + "/image" + std::to_string(i) + (channels == 1 ? ".pgm" : ".ppm"));
+      ASSERT_TRUE(WritePnm(paths_.back(), image));
+    }
+  }
+
+  void TearDown() override {
+    for (const std::string &path : paths_) {
+      std::remove(path.c_str());
+    }
+    rmdir(dir_.c_str());
+  }
+
+  static uint8_t ExpectedPixel(const int image, const int x, const int y) {
+    return static_cast<uint8_t>(image * 31 + x * 7 + y * 13);
+  }
+
+  static void ExpectPixels(const LoadedImage &loaded) {
+    ASSERT_TRUE(loaded.ok) << loaded.error;
+    const Image &image = loaded.image;
+    ASSERT_EQ(image.width(), kWidth);
+    ASSERT_EQ(image.height(), kHeight);
+    ASSERT_EQ(image.channels(), loaded.index % 2 == 0 ? 1 : 3);
+    for (int y = 0; y < kHeight; ++y) {
+      for (int x = 0; x < kWidth * image.channels(); ++x) {
+        ASSERT_EQ(image.Row<uint8_t>(y)[x], ExpectedPixel(static_cast<int>(loaded.index), x, y));
+      }
+    }
+  }
+
+  static constexpr int kNumImages = 12;
+  static constexpr int kWidth = 67;
+  static constexpr int kHeight = 41;
+
+  std::string dir_;
+  std::vector<std::string> paths_;
+};
+
+TEST_F(ImageLoaderTest, ReadsHeaderWithoutDecoding) {
+  ImageHeader header;
+  ASSERT_TRUE(ReadImageHeader(paths_[1], &header));
+  EXPECT_EQ(header.width, kWidth);
+  EXPECT_EQ(header.height, kHeight);
+  EXPECT_EQ(header.channels, 3);
+  EXPECT_EQ(header.type, PixelType::UINT8);
+  EXPECT_TRUE(header.mappable);
+}
+
+TEST_F(ImageLoaderTest, ReadsSixteenBitPnm) {
+  Image image = Image::Allocate(5, 3, 1, PixelType::UINT16);
+  for (int y = 0; y < 3; ++y) {
+    for (int x = 0; x < 5; ++x) {
+      image.At<uint16_t>(x, y) = static_cast<uint16_t>(1000 * y + 251 * x);
+    }
+  }
+  const std::string path = dir_ + "/depth.pgm";
+  ASSERT_TRUE(WritePnm(path, image));
+  Image read;
+  ASSERT_TRUE(ReadImage(path, ReadImageOptions(), &read));
+  std::remove(path.c_str());
+  ASSERT_EQ(read.type(), PixelType::UINT16);
+  for (int y = 0; y < 3; ++y) {
+    for (int x = 0; x < 5; ++x) {
+      EXPECT_EQ(read.At<uint16_t>(x, y), image.At<uint16_t>(x, y));
+    }
+  }
+}
+
+TEST_F(ImageLoaderTest, ReleaseCallbackReportsAllocatedBytes) {
+  std::vector<size_t> released;
+  ReadImageOptions options;
+  options.on_release = [&released](const size_t num_bytes) { released.push_back(num_bytes); };
+
+  // 内存映射的图像不回调
+  Image mapped;
+  ASSERT_TRUE(ReadImage(paths_[0], options, &mapped));
+  mapped = Image();
+  EXPECT_TRUE(released.empty());
+
+  options.use_mmap = false;
+  Image image;
+  ASSERT_TRUE(ReadImage(paths_[1], options, &image));
+  const size_t num_bytes = image.BufferSizeInBytes();
+  EXPECT_EQ(image.Row<uint8_t>(3)[2], ExpectedPixel(1, 2, 3));
+  Image copy = image;
+  image = Image();
+  EXPECT_TRUE(released.empty());
+  copy = Image();
+  ASSERT_EQ(released.size(), 1u);
+  EXPECT_EQ(released[0], num_bytes);
+}
+
+TEST_F(ImageLoaderTest, MappedImageIsCopyOnWrite) {
+  Image image;
+  ASSERT_TRUE(ReadImage(paths_[0], ReadImageOptions(), &image));
+  image.At<uint8_t>(0, 0) = 255 - ExpectedPixel(0, 0, 0);
+  Image reread;
+  ASSERT_TRUE(ReadImage(paths_[0], ReadImageOptions(), &reread));
+  EXPECT_EQ(reread.At<uint8_t>(0, 0), ExpectedPixel(0, 0, 0));
+}
+
+TEST_F(ImageLoaderTest, LoadsInRequestedOrder) {
+  const std::vector<size_t> order = {5, 0, 11, 3, 3, 7};
+  for (const bool use_mmap : {true, false}) {
+    ImageLoaderOptions options;
+    options.num_threads = 3;
+    options.prefetch_depth = 4;
+    options.use_mmap = use_mmap;
+    ImageLoader loader(options, paths_, order);
+    ASSERT_EQ(loader.NumImages(), order.size());
+    LoadedImage loaded;
+    for (const size_t index : order) {
+      ASSERT_TRUE(loader.Next(&loaded));
+      EXPECT_EQ(loaded.index, index);
+      EXPECT_EQ(loaded.path, paths_[index]);
+      ExpectPixels(loaded);
+    }
+    EXPECT_FALSE(loader.Next(&loaded));
+  }
+}
+
+TEST_F(ImageLoaderTest, HonorsMemoryBudget) {
+  ImageHeader header;
+  ASSERT_TRUE(ReadImageHeader(paths_[1], &header));
+  // 预算只够同时容纳两张彩色图像
+  ImageLoaderOptions options;
+  options.num_threads = 4;
+  options.prefetch_depth = 8;
+  options.use_mmap = false;
+  options.memory_budget = 2 * header.DecodedSizeInBytes();
+  ImageLoader loader(options, paths_);
+  LoadedImage loaded;
+  size_t num_loaded = 0;
+  while (loader.Next(&loaded)) {
+    ExpectPixels(loaded);
+    EXPECT_LE(loader.MemoryUsed(), options.memory_budget);
+    ++num_loaded;
+  }
+  EXPECT_EQ(num_loaded, paths_.size());
+  EXPECT_LE(loader.PeakMemoryUsed(), options.memory_budget);
+  // 释放最后一张图像后额度全部归还
+  loaded = LoadedImage();
+  EXPECT_EQ(loader.MemoryUsed(), 0u);
+}
+
+TEST_F(ImageLoaderTest, ImagesOutliveLoader) {
+  LoadedImage loaded;
+  {
+    ImageLoader loader(ImageLoaderOptions(), paths_);
+    ASSERT_TRUE(loader.Next(&loaded));
+  }
+  ExpectPixels(loaded);
+}
+
+TEST_F(ImageLoaderTest, ReportsMissingFiles) {
+  std::vector<std::string> paths = {paths_[0], dir_ + "/missing.pgm", paths_[2]};
+  ImageLoader loader(ImageLoaderOptions(), paths);
+  LoadedImage loaded;
+  ASSERT_TRUE(loader.Next(&loaded));
+  ExpectPixels(loaded);
+  ASSERT_TRUE(loader.Next(&loaded));
+  EXPECT_FALSE(loaded.ok);
+  EXPECT_FALSE(loaded.error.empty());
+  ASSERT_TRUE(loader.Next(&loaded));
+  ExpectPixels(loaded);
+  EXPECT_FALSE(loader.Next(&loaded));
+}
+
+TEST(MemoryBudgetTest, GrantsInTicketOrder) {
+  MemoryBudget budget(100);
+  ASSERT_TRUE(budget.Acquire(0, 60));
+  // 第 2 张的额度足够, 但必须等待额度不足的第 1 张
+  std::thread second([&]() { EXPECT_TRUE(budget.Acquire(2, 10)); });
+  std::thread first([&]() { EXPECT_TRUE(budget.Acquire(1, 50)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(budget.Used(), 60u);
+  budget.Release(60);
+  first.join();
+  second.join();
+  EXPECT_EQ(budget.Used(), 60u);
+  EXPECT_EQ(budget.PeakUsed(), 60u);
+}
+
+TEST(MemoryBudgetTest, CancelWakesWaiters) {
+  MemoryBudget budget(100);
+  ASSERT_TRUE(budget.Acquire(0, 100));
+  std::thread waiter([&]() { EXPECT_FALSE(budget.Acquire(1, 1)); });
+  budget.Cancel();
+  waiter.join();
+}
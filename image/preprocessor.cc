@@ -0,0 +1,295 @@
+#include "image/preprocessor.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread_pool.hpp"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#include <omp.h>
+#endif
+
+namespace photogrammetry {
+namespace image {
+
+namespace {
+
+typedef Eigen::Map<Eigen::ArrayXf> RowMap;
+typedef Eigen::Map<const Eigen::ArrayXf> ConstRowMap;
+
+int CurrentThread() {
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+// 归一化的一维高斯核, 半径为 ceil(3 sigma); sigma <= 0 时为单位核
+std::vector<float> GaussianKernel(const double sigma) {
+  if (sigma <= 0.0) {
+    return {1.0f};
+  }
+  const int radius = std::max(1, static_cast<int>(std::ceil(3.0 * sigma)));
+  std::vector<float> kernel(2 * radius + 1);
+  double sum = 0.0;
+  for (int i = -radius; i <= radius; ++i) {
+    const double weight = std::exp(-0.5 * i * i / (sigma * sigma));
+    kernel[i + radius] = static_cast<float>(weight);
+    sum += weight;
+  }
+  for (float &weight : kernel) {
+    weight = static_cast<float>(weight / sum);
+  }
+  return kernel;
+}
+
+void CheckGray(const Image &image) {
+  if (image.empty() || image.channels() != 1 || image.type() != PixelType::FLOAT32) {
+    throw std::invalid_argument("Expected a single channel FLOAT32 image");
+  }
+}
+
+/*
+ * @brief 一行的水平滤波
+ * @param padded 临时内存, 至少 width + 2 * radius 个元素, 存放按边界像素扩展后的行
+ */
+void ConvolveRow(const float *src, const int width, const std::vector<float> &kernel,
+                 float *padded, float *dst) {
+  const int radius = static_cast<int>(kernel.size() / 2);
+  std::fill(padded, padded + radius, src[0]);
+  std::copy(src, src + width, padded + radius);
+  std::fill(padded + radius + width, padded + 2 * radius + width, src[width - 1]);
+  RowMap out(dst, width);
+  out = kernel[0] * ConstRowMap(padded, width);
+  for (size_t k = 1; k < kernel.size(); ++k) {
+    out += kernel[k] * ConstRowMap(padded + k, width);
+  }
+}
+
+// 单行灰度化, scale 将像素值归一化到 [0, 1]
+template <typename T>
+void ConvertRowToGray(const T *src, const int width, const int channels, const float scale,
+                      float *dst) {
+  typedef Eigen::Array<T, Eigen::Dynamic, 1> SourceRow;
+  RowMap out(dst, width);
+  if (channels == 1) {
+    out = Eigen::Map<const SourceRow>(src, width).template cast<float>() * scale;
+    return;
+  }
+  typedef Eigen::Map<const SourceRow, 0, Eigen::InnerStride<>> Channel;
+  const Eigen::InnerStride<> stride(channels);
+  out = (0.299f * scale) * Channel(src, width, stride).template cast<float>() +
+        (0.587f * scale) * Channel(src + 1, width, stride).template cast<float>() +
+        (0.114f * scale) * Channel(src + 2, width, stride).template cast<float>();
+}
+
+template <typename T>
+void ConvertToGray(const Image &image, const float scale, [[maybe_unused]] const int num_threads,
+                   Image *gray) {
+  const int height = image.height();
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+#endif
+  for (int y = 0; y < height; ++y) {
+    ConvertRowToGray(image.Row<T>(y), image.width(), image.channels(), scale,
+                     gray->Row<float>(y));
+  }
+}
+
+} // namespace
+
+ImageBufferPool::State::~State() {
+  for (auto &buffers : free_buffers) {
+    for (uint8_t *buffer : buffers.second) {
+      std::free(buffer);
+    }
+  }
+}
+
+ImageBufferPool::ImageBufferPool() : state_(std::make_shared<State>()) {}
+
+Image ImageBufferPool::Acquire(const int width, const int height, const int channels,
+                               const PixelType type) {
+  const size_t stride = Image::AlignedStride(width, channels, type);
+  const size_t num_bytes = std::max(stride * height, Image::kRowAlignment);
+  uint8_t *data = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    const auto it = state_->free_buffers.find(num_bytes);
+    if (it != state_->free_buffers.end() && !it->second.empty()) {
+      data = it->second.back();
+      it->second.pop_back();
+    }
+  }
+  if (data == nullptr) {
+    data = static_cast<uint8_t *>(std::aligned_alloc(Image::kRowAlignment, num_bytes));
+    if (data == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+  const std::weak_ptr<State> weak_state = state_;
+  std::shared_ptr<uint8_t> owner(data, [weak_state, num_bytes](uint8_t *buffer) {
+    if (const std::shared_ptr<State> state = weak_state.lock()) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->free_buffers[num_bytes].push_back(buffer);
+    } else {
+      std::free(buffer);
+    }
+  });
+  return Image::Wrap(std::move(owner), data, width, height, channels, type, stride);
+}
+
+size_t ImageBufferPool::NumFreeBuffers() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  size_t num_buffers = 0;
+  for (const auto &buffers : state_->free_buffers) {
+    num_buffers += buffers.second.size();
+  }
+  return num_buffers;
+}
+
+size_t ImageBufferPool::FreeBytes() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  size_t num_bytes = 0;
+  for (const auto &buffers : state_->free_buffers) {
+    num_bytes += buffers.first * buffers.second.size();
+  }
+  return num_bytes;
+}
+
+void ImageBufferPool::Clear() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  for (auto &buffers : state_->free_buffers) {
+    for (uint8_t *buffer : buffers.second) {
+      std::free(buffer);
+    }
+  }
+  state_->free_buffers.clear();
+}
+
+ImagePreprocessor::ImagePreprocessor(const PreprocessorOptions &options)
+    : options_(options), scratch_(NumThreads()) {}
+
+int ImagePreprocessor::NumThreads() const {
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+  return utils::GetEffectiveNumThreads(options_.num_threads);
+#else
+  return 1;
+#endif
+}
+
+int ImagePreprocessor::BandRows(const int width, const int radius) const {
+  // 分块内水平滤波的结果(含上下各 radius 行)不超过 tile_bytes
+  const size_t row_bytes = static_cast<size_t>(width) * sizeof(float);
+  const int rows = static_cast<int>(options_.tile_bytes / row_bytes) - 2 * radius;
+  return std::max(8, rows);
+}
+
+float *ImagePreprocessor::Scratch(const int thread, const size_t num_floats) {
+  std::vector<float> &scratch = scratch_[thread];
+  if (scratch.size() < num_floats) {
+    scratch.resize(num_floats);
+  }
+  return scratch.data();
+}
+
+Image ImagePreprocessor::ToGray(const Image &image) {
+  if (image.empty() || image.channels() == 2) {
+    throw std::invalid_argument("Expected a single channel or color image");
+  }
+  Image gray = pool_.Acquire(image.width(), image.height(), 1, PixelType::FLOAT32);
+  switch (image.type()) {
+  case PixelType::UINT8:
+    ConvertToGray<uint8_t>(image, 1.0f / 255.0f, NumThreads(), &gray);
+    break;
+  case PixelType::UINT16:
+    ConvertToGray<uint16_t>(image, 1.0f / 65535.0f, NumThreads(), &gray);
+    break;
+  case PixelType::FLOAT32:
+    ConvertToGray<float>(image, 1.0f, NumThreads(), &gray);
+    break;
+  }
+  return gray;
+}
+
+Image ImagePreprocessor::GaussianBlur(const Image &gray, const double sigma) {
+  CheckGray(gray);
+  Image blurred = pool_.Acquire(gray.width(), gray.height(), 1, PixelType::FLOAT32);
+  Filter(gray, GaussianKernel(sigma), 1, &blurred);
+  return blurred;
+}
+
+Image ImagePreprocessor::PyrDown(const Image &gray, const double sigma) {
+  CheckGray(gray);
+  Image down =
+      pool_.Acquire((gray.width() + 1) / 2, (gray.height() + 1) / 2, 1, PixelType::FLOAT32);
+  Filter(gray, GaussianKernel(sigma), 2, &down);
+  return down;
+}
+
+ImagePyramid ImagePreprocessor::BuildPyramid(const Image &image) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("image/build_pyramid");
+  ImagePyramid pyramid;
+  Image gray = image.channels() == 1 && image.type() == PixelType::FLOAT32 ? image : ToGray(image);
+  if (options_.initial_sigma > 0.0) {
+    gray = GaussianBlur(gray, options_.initial_sigma);
+  }
+  pyramid.levels.push_back(gray);
+  while (pyramid.NumLevels() < options_.num_levels) {
+    const Image &last = pyramid.levels.back();
+    if (std::min((last.width() + 1) / 2, (last.height() + 1) / 2) < options_.min_level_size) {
+      break;
+    }
+    pyramid.levels.push_back(PyrDown(last, options_.level_sigma));
+  }
+  return pyramid;
+}
+
+void ImagePreprocessor::Filter(const Image &src, const std::vector<float> &kernel, const int step,
+                               Image *dst) {
+  const int width = src.width();
+  const int height = src.height();
+  const int radius = static_cast<int>(kernel.size() / 2);
+  const int out_width = dst->width();
+  const int out_height = dst->height();
+  const int band_rows = BandRows(width, radius);
+  const int num_bands = (out_height + band_rows - 1) / band_rows;
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp parallel for schedule(static) num_threads(NumThreads())
+#endif
+  for (int band = 0; band < num_bands; ++band) {
+    const int out_y0 = band * band_rows;
+    const int out_y1 = std::min(out_height, out_y0 + band_rows);
+    // 分块需要的输入行, 超出图像的行取最近的边界行
+    const int y0 = step * out_y0 - radius;
+    const int y1 = step * (out_y1 - 1) + radius + 1;
+    const size_t padded_size = width + 2 * radius;
+    float *padded = Scratch(CurrentThread(), padded_size + (y1 - y0 + 1) * size_t(width));
+    float *rows = padded + padded_size;
+    // 降采样时垂直滤波的整行结果, 再隔列取出
+    float *full_row = rows + (y1 - y0) * size_t(width);
+
+    for (int y = y0; y < y1; ++y) {
+      const int src_y = std::min(std::max(y, 0), height - 1);
+      ConvolveRow(src.Row<float>(src_y), width, kernel, padded, rows + (y - y0) * size_t(width));
+    }
+    for (int out_y = out_y0; out_y < out_y1; ++out_y) {
+      const float *window = rows + (step * out_y - radius - y0) * size_t(width);
+      RowMap out(step == 1 ? dst->Row<float>(out_y) : full_row, width);
+      out = kernel[0] * ConstRowMap(window, width);
+      for (size_t k = 1; k < kernel.size(); ++k) {
+        out += kernel[k] * ConstRowMap(window + k * width, width);
+      }
+      if (step != 1) {
+        RowMap decimated(dst->Row<float>(out_y), out_width);
+        decimated = Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<>>(
+            full_row, out_width, Eigen::InnerStride<>(step));
+      }
+    }
+  }
+}
+
+} // namespace image
+} // namespace photogrammetry
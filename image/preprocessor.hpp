@@ -0,0 +1,120 @@
+#ifndef PHOTOGRAMMETRY_IMAGE_PREPROCESSOR_HPP
+#define PHOTOGRAMMETRY_IMAGE_PREPROCESSOR_HPP
+
+#include "image/image.hpp"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace photogrammetry {
+namespace image {
+
+/*
+ * @brief 图像缓冲池
+ * 按缓冲区字节数缓存已释放的像素内存, 同样尺寸的图像反复处理时不再重新分配。
+ * Acquire 返回的 Image 最后一个引用释放时, 内存自动归还池中; 池先于图像销毁时直接释放。
+ */
+class ImageBufferPool {
+public:
+  ImageBufferPool();
+
+  ImageBufferPool(const ImageBufferPool &) = delete;
+  ImageBufferPool &operator=(const ImageBufferPool &) = delete;
+
+  // 获取一幅未初始化的图像, 行距与 Image::Allocate 相同
+  Image Acquire(const int width, const int height, const int channels, const PixelType type);
+
+  // 池中空闲缓冲区的个数与总字节数
+  size_t NumFreeBuffers() const;
+  size_t FreeBytes() const;
+
+  // 释放所有空闲缓冲区
+  void Clear();
+
+private:
+  struct State {
+    ~State();
+    std::mutex mutex;
+    // 缓冲区字节数 -> 空闲缓冲区
+    std::unordered_map<size_t, std::vector<uint8_t *>> free_buffers;
+  };
+  std::shared_ptr<State> state_;
+};
+
+struct PreprocessorOptions {
+  // 金字塔层数(含第 0 层), 图像尺寸小于 min_level_size 后不再下采样
+  int num_levels = 4;
+  int min_level_size = 16;
+  // 每次下采样前的抗混叠高斯平滑
+  double level_sigma = 1.0;
+  // 第 0 层的高斯平滑, 0 表示不平滑
+  double initial_sigma = 0.0;
+  // 每个分块的中间结果字节数, 应与 L2 缓存大小相当
+  size_t tile_bytes = 256 * 1024;
+  // 线程数, -1 表示使用全部硬件线程, 仅在启用 OpenMP 时生效
+  int num_threads = -1;
+};
+
+// 灰度图像金字塔, 第 l 层相对第 0 层缩小 2^l 倍
+struct ImagePyramid {
+  std::vector<Image> levels;
+
+  int NumLevels() const { return static_cast<int>(levels.size()); }
+  // 第 level 层像素坐标乘以该值得到第 0 层像素坐标
+  float Scale(const int level) const { return static_cast<float>(1 << level); }
+};
+
+/*
+ * @brief 图像预处理: 灰度化, 可分离高斯滤波, 下采样与金字塔构建
+ * 输出均为单通道 FLOAT32 图像, 灰度取值范围 [0, 1]。逐行运算通过 Eigen 向量化;
+ * 滤波按行分块, 每个分块先做水平滤波再做垂直滤波, 中间结果停留在缓存中,
+ * 分块之间由 OpenMP 并行处理(定义 PHOTOGRAMMETRY_OPENMP_ENABLED 时)。
+ * 输出图像与各线程的临时内存都来自内部缓冲池, 处理同样尺寸的图像序列时不再分配内存。
+ * @note 同一个对象不能被多个线程同时调用
+ */
+class ImagePreprocessor {
+public:
+  explicit ImagePreprocessor(const PreprocessorOptions &options = PreprocessorOptions());
+
+  /*
+   * @brief 转换为灰度图像 (0.299 R + 0.587 G + 0.114 B)
+   * @param image UINT8/UINT16/FLOAT32 图像, 单通道或至少 3 通道(只使用前 3 个通道)
+   */
+  Image ToGray(const Image &image);
+
+  // 可分离高斯滤波, 边界取最近像素
+  Image GaussianBlur(const Image &gray, const double sigma);
+
+  // 高斯平滑后隔行隔列采样, 输出尺寸为 ((w + 1) / 2, (h + 1) / 2)
+  Image PyrDown(const Image &gray, const double sigma);
+
+  // 构建灰度金字塔, 彩色图像先转换为灰度
+  ImagePyramid BuildPyramid(const Image &image);
+
+  const PreprocessorOptions &Options() const { return options_; }
+  ImageBufferPool &Pool() { return pool_; }
+
+private:
+  // 每个分块的输出行数
+  int BandRows(const int width, const int radius) const;
+  int NumThreads() const;
+  // 第 thread 个线程的临时内存, 至少 num_floats 个元素
+  float *Scratch(const int thread, const size_t num_floats);
+
+  /*
+   * @brief 分块滤波
+   * @param step 输出第 y 行对应输入第 step * y 行, 输出第 x 列对应输入第 step * x 列
+   */
+  void Filter(const Image &src, const std::vector<float> &kernel, const int step, Image *dst);
+
+  PreprocessorOptions options_;
+  ImageBufferPool pool_;
+  std::vector<std::vector<float>> scratch_;
+};
+
+} // namespace image
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_IMAGE_PREPROCESSOR_HPP
@@ -0,0 +1,150 @@
+#include "image/preprocessor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace photogrammetry::image;
+
+namespace {
+
+Image RandomGray(const int width, const int height, const unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  Image image = Image::Allocate(width, height, 1, PixelType::FLOAT32);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      image.At<float>(x, y) = uniform(rng);
+    }
+  }
+  return image;
+}
+
+// 逐像素的二维高斯滤波参考实现, 边界取最近像素
+float ReferenceBlur(const Image &image, const double sigma, const int x, const int y) {
+  const int radius = std::max(1, static_cast<int>(std::ceil(3.0 * sigma)));
+  double sum = 0.0;
+  double weight_sum = 0.0;
+  for (int dy = -radius; dy <= radius; ++dy) {
+    for (int dx = -radius; dx <= radius; ++dx) {
+      const double weight = std::exp(-0.5 * (dx * dx + dy * dy) / (sigma * sigma));
+      const int sx = std::min(std::max(x + dx, 0), image.width() - 1);
+      const int sy = std::min(std::max(y + dy, 0), image.height() - 1);
+      sum += weight * image.At<float>(sx, sy);
+      weight_sum += weight;
+    }
+  }
+  return static_cast<float>(sum / weight_sum);
+}
+
+} // namespace
+
+TEST(ImagePreprocessorTest, ConvertsColorToGray) {
+  Image color = Image::Allocate(19, 7, 3, PixelType::UINT8);
+  for (int y = 0; y < color.height(); ++y) {
+    for (int x = 0; x < color.width(); ++x) {
+      color.At<uint8_t>(x, y, 0) = static_cast<uint8_t>(10 * x);
+      color.At<uint8_t>(x, y, 1) = static_cast<uint8_t>(30 * y);
+      color.At<uint8_t>(x, y, 2) = static_cast<uint8_t>(x * y);
+    }
+  }
+  ImagePreprocessor preprocessor;
+  const Image gray = preprocessor.ToGray(color);
+  ASSERT_EQ(gray.channels(), 1);
+  ASSERT_EQ(gray.type(), PixelType::FLOAT32);
+  for (int y = 0; y < color.height(); ++y) {
+    for (int x = 0; x < color.width(); ++x) {
+      const float expected = (0.299f * color.At<uint8_t>(x, y, 0) +
+                              0.587f * color.At<uint8_t>(x, y, 1) +
+                              0.114f * color.At<uint8_t>(x, y, 2)) /
+                             255.0f;
+      EXPECT_NEAR(gray.At<float>(x, y), expected, 1e-6f);
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, GaussianBlurMatchesReference) {
+  const Image image = RandomGray(53, 37, 1);
+  // 很小的分块强制每个分块只有几行, 验证分块边界的处理
+  for (const size_t tile_bytes : {size_t(1), size_t(1) << 20}) {
+    PreprocessorOptions options;
+    options.tile_bytes = tile_bytes;
+    ImagePreprocessor preprocessor(options);
+    for (const double sigma : {0.8, 1.6, 3.0}) {
+      const Image blurred = preprocessor.GaussianBlur(image, sigma);
+      for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+          ASSERT_NEAR(blurred.At<float>(x, y), ReferenceBlur(image, sigma, x, y), 1e-5f)
+              << "sigma " << sigma << " at " << x << ", " << y;
+        }
+      }
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, PyrDownSamplesBlurredImage) {
+  const Image image = RandomGray(41, 30, 2);
+  PreprocessorOptions options;
+  options.tile_bytes = 1;
+  ImagePreprocessor preprocessor(options);
+  const Image down = preprocessor.PyrDown(image, 1.0);
+  ASSERT_EQ(down.width(), 21);
+  ASSERT_EQ(down.height(), 15);
+  for (int y = 0; y < down.height(); ++y) {
+    for (int x = 0; x < down.width(); ++x) {
+      ASSERT_NEAR(down.At<float>(x, y), ReferenceBlur(image, 1.0, 2 * x, 2 * y), 1e-5f);
+    }
+  }
+}
+
+TEST(ImagePreprocessorTest, BuildsPyramid) {
+  Image color = Image::Allocate(160, 100, 3, PixelType::UINT16);
+  std::fill(color.data(), color.data() + color.BufferSizeInBytes(), 0x80);
+  PreprocessorOptions options;
+  options.num_levels = 10;
+  options.min_level_size = 12;
+  ImagePreprocessor preprocessor(options);
+  const ImagePyramid pyramid = preprocessor.BuildPyramid(color);
+  // 100 -> 50 -> 25 -> 13, 下一层 7 小于 min_level_size
+  ASSERT_EQ(pyramid.NumLevels(), 4);
+  EXPECT_EQ(pyramid.levels[3].width(), 20);
+  EXPECT_EQ(pyramid.levels[3].height(), 13);
+  EXPECT_EQ(pyramid.Scale(3), 8.0f);
+  // 常数图像经过归一化的滤波后保持不变
+  const float value = 0x8080 / 65535.0f;
+  for (const Image &level : pyramid.levels) {
+    for (int y = 0; y < level.height(); ++y) {
+      for (int x = 0; x < level.width(); ++x) {
+        ASSERT_NEAR(level.At<float>(x, y), value, 1e-5f);
+      }
+    }
+  }
+}
+
+TEST(ImageBufferPoolTest, ReusesReleasedBuffers) {
+  ImageBufferPool pool;
+  const uint8_t *data = nullptr;
+  {
+    const Image image = pool.Acquire(100, 20, 1, PixelType::FLOAT32);
+    data = image.data();
+    EXPECT_EQ(pool.NumFreeBuffers(), 0u);
+  }
+  EXPECT_EQ(pool.NumFreeBuffers(), 1u);
+  EXPECT_EQ(pool.FreeBytes(), Image::AlignedStride(100, 1, PixelType::FLOAT32) * 20);
+  const Image reused = pool.Acquire(100, 20, 1, PixelType::FLOAT32);
+  EXPECT_EQ(reused.data(), data);
+  EXPECT_EQ(pool.NumFreeBuffers(), 0u);
+  // 不同尺寸的请求不会拿到缓存的缓冲区
+  const Image other = pool.Acquire(10, 20, 1, PixelType::FLOAT32);
+  EXPECT_NE(other.data(), data);
+}
+
+TEST(ImageBufferPoolTest, ImagesOutlivePool) {
+  Image image;
+  {
+    ImageBufferPool pool;
+    image = pool.Acquire(8, 8, 1, PixelType::UINT8);
+  }
+  image.At<uint8_t>(7, 7) = 1;
+  EXPECT_EQ(image.At<uint8_t>(7, 7), 1);
+}
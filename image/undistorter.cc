@@ -0,0 +1,151 @@
+#include "image/undistorter.hpp"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace photogrammetry {
+namespace image {
+
+namespace {
+
+typedef Eigen::Array<float, Eigen::Dynamic, 1> RowArray;
+typedef Eigen::Array<int, Eigen::Dynamic, 1> IndexArray;
+
+// 一段输出像素的双线性插值参数, 由各线程复用
+struct SampleBuffer {
+  void Resize(const int size) {
+    if (ax.size() < size) {
+      ax.resize(size);
+      ay.resize(size);
+      x0.resize(size);
+      y0.resize(size);
+      valid.resize(size);
+      p00.resize(size);
+      p10.resize(size);
+      p01.resize(size);
+      p11.resize(size);
+      value.resize(size);
+    }
+  }
+  RowArray ax, ay;
+  IndexArray x0, y0, valid;
+  RowArray p00, p10, p01, p11, value;
+};
+
+template <typename T>
+T SaturateCast(const float value) {
+  if constexpr (std::is_same<T, float>::value) {
+    return value;
+  } else {
+    const float rounded = std::nearbyint(value);
+    return static_cast<T>(std::min(std::max(rounded, float(std::numeric_limits<T>::min())),
+                                   float(std::numeric_limits<T>::max())));
+  }
+}
+
+/*
+ * @brief 重采样输出图像一行中的 [u0, u0 + n)
+ * 插值权重与四邻域下标整段向量化计算, 取像素为逐点访存, 混合再整段向量化
+ */
+template <typename T>
+void RemapSegment(const Image &src, const float *map_x, const float *map_y, const int n,
+                  const float fill_value, SampleBuffer *buffer, T *dst) {
+  const int width = src.width();
+  const int height = src.height();
+  const int channels = src.channels();
+  buffer->Resize(n);
+  const Eigen::Map<const RowArray> gx(map_x, n);
+  const Eigen::Map<const RowArray> gy(map_y, n);
+  auto x0 = buffer->x0.head(n);
+  auto y0 = buffer->y0.head(n);
+  auto valid = buffer->valid.head(n);
+  // 采样位置落在 [0, w - 1] x [0, h - 1] 内才有效, 边缘像素的右/下邻居取自身
+  valid = ((gx >= 0.0f) && (gy >= 0.0f) && (gx <= float(width - 1)) && (gy <= float(height - 1)))
+              .cast<int>();
+  const RowArray fx = gx.max(0.0f).min(float(width - 1));
+  const RowArray fy = gy.max(0.0f).min(float(height - 1));
+  x0 = fx.floor().cast<int>();
+  y0 = fy.floor().cast<int>();
+  auto ax = buffer->ax.head(n);
+  auto ay = buffer->ay.head(n);
+  ax = fx - x0.cast<float>();
+  ay = fy - y0.cast<float>();
+
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < n; ++i) {
+      const int x1 = std::min(x0[i] + 1, width - 1);
+      const T *row0 = src.Row<T>(y0[i]);
+      const T *row1 = src.Row<T>(std::min(y0[i] + 1, height - 1));
+      buffer->p00[i] = static_cast<float>(row0[x0[i] * channels + c]);
+      buffer->p10[i] = static_cast<float>(row0[x1 * channels + c]);
+      buffer->p01[i] = static_cast<float>(row1[x0[i] * channels + c]);
+      buffer->p11[i] = static_cast<float>(row1[x1 * channels + c]);
+    }
+    auto value = buffer->value.head(n);
+    const auto top = buffer->p00.head(n) + ax * (buffer->p10.head(n) - buffer->p00.head(n));
+    const auto bottom = buffer->p01.head(n) + ax * (buffer->p11.head(n) - buffer->p01.head(n));
+    value = top + ay * (bottom - top);
+    for (int i = 0; i < n; ++i) {
+      dst[i * channels + c] = SaturateCast<T>(valid[i] ? value[i] : fill_value);
+    }
+  }
+}
+
+template <typename T>
+void RemapImage(const Image &src, const RemapTable &table, const ImageUndistorterOptions &options,
+                Image *dst) {
+  const int width = table.intrinsics.width;
+  const int height = table.intrinsics.height;
+  const int tile_width = std::max(1, options.tile_width);
+  const int tile_height = std::max(1, options.tile_height);
+  const int num_tiles_x = (width + tile_width - 1) / tile_width;
+  const int num_tiles = num_tiles_x * ((height + tile_height - 1) / tile_height);
+  [[maybe_unused]] const int num_threads = utils::GetEffectiveNumThreads(options.num_threads);
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp parallel num_threads(num_threads)
+#endif
+  {
+    SampleBuffer buffer;
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp for schedule(dynamic)
+#endif
+    for (int tile = 0; tile < num_tiles; ++tile) {
+      const int u0 = (tile % num_tiles_x) * tile_width;
+      const int v0 = (tile / num_tiles_x) * tile_height;
+      const int n = std::min(tile_width, width - u0);
+      for (int v = v0; v < std::min(height, v0 + tile_height); ++v) {
+        const size_t offset = static_cast<size_t>(v) * width + u0;
+        RemapSegment<T>(src, table.map_x.data() + offset, table.map_y.data() + offset, n,
+                        options.fill_value, &buffer, dst->Row<T>(v) + u0 * src.channels());
+      }
+    }
+  }
+}
+
+} // namespace
+
+void Remap(const Image &src, const RemapTable &table, const ImageUndistorterOptions &options,
+           Image *dst) {
+  if (src.empty() || dst->width() != table.intrinsics.width ||
+      dst->height() != table.intrinsics.height || dst->channels() != src.channels() ||
+      dst->type() != src.type()) {
+    throw std::invalid_argument("Remap output does not match the table and source image");
+  }
+  switch (src.type()) {
+  case PixelType::UINT8:
+    RemapImage<uint8_t>(src, table, options, dst);
+    break;
+  case PixelType::UINT16:
+    RemapImage<uint16_t>(src, table, options, dst);
+    break;
+  case PixelType::FLOAT32:
+    RemapImage<float>(src, table, options, dst);
+    break;
+  }
+}
+
+} // namespace image
+} // namespace photogrammetry
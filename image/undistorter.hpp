@@ -0,0 +1,257 @@
+#ifndef PHOTOGRAMMETRY_IMAGE_UNDISTORTER_HPP
+#define PHOTOGRAMMETRY_IMAGE_UNDISTORTER_HPP
+
+#include "camera/camera_model.hpp"
+#include "camera/std_types.hpp"
+#include "core/eigen_types.hpp"
+#include "image/image.hpp"
+#include "image/preprocessor.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace photogrammetry {
+namespace image {
+
+// 去畸变图像的视场选择
+enum class UndistortedRegion : uint8_t {
+  // 沿用原相机的焦距与主点(按 scale 缩放)
+  KEEP_INTRINSICS = 0,
+  // 缩小视场, 使输出图像中没有空白像素
+  VALID_PIXELS,
+  // 扩大视场, 使原图像的所有像素都出现在输出图像中
+  ALL_PIXELS,
+};
+
+struct ImageUndistorterOptions {
+  UndistortedRegion region = UndistortedRegion::KEEP_INTRINSICS;
+  // 输出图像尺寸相对原图像的比例
+  double scale = 1.0;
+  // 计算视场时在图像边界上的采样间隔(像素)
+  int border_step = 8;
+  // 映射表之外的像素填充值
+  float fill_value = 0.0f;
+  // 分块大小(输出像素), 一个分块内访问的原图像区域应能放入缓存
+  int tile_width = 256;
+  int tile_height = 32;
+  // 线程数, -1 表示使用全部硬件线程, 仅在启用 OpenMP 时生效
+  int num_threads = -1;
+};
+
+// 去畸变图像对应的无畸变针孔内参
+struct UndistortedIntrinsics {
+  int width = 0;
+  int height = 0;
+  double fx = 0.0;
+  double fy = 0.0;
+  double cx = 0.0;
+  double cy = 0.0;
+};
+
+/*
+ * @brief 去畸变映射表
+ * 输出图像每个像素在原(畸变)图像中的采样位置, 行优先存放
+ */
+struct RemapTable {
+  UndistortedIntrinsics intrinsics;
+  std::vector<float> map_x;
+  std::vector<float> map_y;
+};
+
+/*
+ * @brief 按映射表双线性重采样
+ * 输出按分块并行(OpenMP), 每个分块逐行先向量化计算插值权重, 再取四邻域像素并向量化混合。
+ * 采样位置超出原图像时填充 fill_value。
+ * @param src 原图像, UINT8/UINT16/FLOAT32, 任意通道数
+ * @param table 映射表
+ * @param dst 输出图像, 尺寸与映射表一致, 类型与通道数与原图像一致, 需预先分配好
+ */
+void Remap(const Image &src, const RemapTable &table, const ImageUndistorterOptions &options,
+           Image *dst);
+
+/*
+ * @brief 计算相机模型的去畸变映射表
+ * 输出像素 -> 归一化坐标(无畸变内参) -> distort -> cam2ima 得到原图像的采样位置,
+ * 只用到正向畸变; 迭代去畸变(undistort)只在选择视场时用于图像边界上的少量采样点。
+ */
+template <typename CameraType>
+std::shared_ptr<const RemapTable> ComputeRemapTable(const CameraType &camera,
+                                                    const ImageUndistorterOptions &options) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("image/compute_remap_table");
+  typedef typename CameraType::Vec2 Vec2;
+  typedef typename CameraType::Mat2X Mat2X;
+  const int width = static_cast<int>(camera.width());
+  const int height = static_cast<int>(camera.height());
+  auto table = std::make_shared<RemapTable>();
+  UndistortedIntrinsics &intrinsics = table->intrinsics;
+  intrinsics.width = std::max(1, static_cast<int>(std::lround(width * options.scale)));
+  intrinsics.height = std::max(1, static_cast<int>(std::lround(height * options.scale)));
+
+  // 输出图像覆盖的无畸变归一化坐标范围
+  double min_x, max_x, min_y, max_y;
+  if (options.region == UndistortedRegion::KEEP_INTRINSICS) {
+    const Vec2 corner_min = camera.ima2cam(Vec2(-0.5, -0.5));
+    const Vec2 corner_max = camera.ima2cam(Vec2(width - 0.5, height - 0.5));
+    min_x = corner_min.x();
+    min_y = corner_min.y();
+    max_x = corner_max.x();
+    max_y = corner_max.y();
+  } else {
+    // 原图像四条边(像素边缘)上的采样点去畸变; ALL_PIXELS 取所有采样点的外包矩形,
+    // VALID_PIXELS 取每条边向内最深处围成的内接矩形
+    const auto samples = [&options](const int size) {
+      std::vector<double> positions;
+      for (int i = 0; i < size; i += std::max(1, options.border_step)) {
+        positions.push_back(i - 0.5);
+      }
+      positions.push_back(size - 0.5);
+      return positions;
+    };
+    const bool all = options.region == UndistortedRegion::ALL_PIXELS;
+    min_x = min_y = all ? HUGE_VAL : -HUGE_VAL;
+    max_x = max_y = all ? -HUGE_VAL : HUGE_VAL;
+    const auto undistort = [&camera](const double x, const double y) {
+      return camera.undistort(camera.ima2cam(Vec2(x, y))).template cast<double>().eval();
+    };
+    for (const double x : samples(width)) {
+      const Eigen::Vector2d top = undistort(x, -0.5);
+      const Eigen::Vector2d bottom = undistort(x, height - 0.5);
+      min_y = all ? std::min(min_y, top.y()) : std::max(min_y, top.y());
+      max_y = all ? std::max(max_y, bottom.y()) : std::min(max_y, bottom.y());
+      if (all) {
+        min_x = std::min({min_x, top.x(), bottom.x()});
+        max_x = std::max({max_x, top.x(), bottom.x()});
+      }
+    }
+    for (const double y : samples(height)) {
+      const Eigen::Vector2d left = undistort(-0.5, y);
+      const Eigen::Vector2d right = undistort(width - 0.5, y);
+      min_x = all ? std::min(min_x, left.x()) : std::max(min_x, left.x());
+      max_x = all ? std::max(max_x, right.x()) : std::min(max_x, right.x());
+      if (all) {
+        min_y = std::min({min_y, left.y(), right.y()});
+        max_y = std::max({max_y, left.y(), right.y()});
+      }
+    }
+  }
+  // 输出图像的像素边缘 [-0.5, w - 0.5] 恰好覆盖 [min, max]
+  intrinsics.fx = intrinsics.width / (max_x - min_x);
+  intrinsics.fy = intrinsics.height / (max_y - min_y);
+  intrinsics.cx = -0.5 - min_x * intrinsics.fx;
+  intrinsics.cy = -0.5 - min_y * intrinsics.fy;
+
+  const size_t num_pixels = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+  table->map_x.resize(num_pixels);
+  table->map_y.resize(num_pixels);
+  [[maybe_unused]] const int num_threads = utils::GetEffectiveNumThreads(options.num_threads);
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+#endif
+  for (int v = 0; v < intrinsics.height; ++v) {
+    // 逐行批量加畸变
+    Mat2X points(2, intrinsics.width);
+    for (int u = 0; u < intrinsics.width; ++u) {
+      points(0, u) = (u - intrinsics.cx) / intrinsics.fx;
+      points(1, u) = (v - intrinsics.cy) / intrinsics.fy;
+    }
+    Mat2X distorted(2, intrinsics.width);
+    camera.distortBatch(points, distorted);
+    const size_t offset = static_cast<size_t>(v) * intrinsics.width;
+    for (int u = 0; u < intrinsics.width; ++u) {
+      const Vec2 pixel = camera.cam2ima(distorted.col(u));
+      table->map_x[offset + u] = static_cast<float>(pixel.x());
+      table->map_y[offset + u] = static_cast<float>(pixel.y());
+    }
+  }
+  return table;
+}
+
+/*
+ * @brief 整幅图像去畸变
+ * 映射表按相机 ID 缓存, 同一相机(共享内参)的所有帧复用一张表; 缓存的表与相机的模型类型、
+ * 图像尺寸或内参的值(IntrinsicsKey)不一致时重建, ID 相同而内参不同的相机不会共用一张表。
+ * 输出图像来自内部缓冲池。
+ * @note 可被多个线程同时调用
+ */
+class ImageUndistorter {
+public:
+  explicit ImageUndistorter(const ImageUndistorterOptions &options = ImageUndistorterOptions())
+      : options_(options) {}
+
+  ImageUndistorter(const ImageUndistorter &) = delete;
+  ImageUndistorter &operator=(const ImageUndistorter &) = delete;
+
+  const ImageUndistorterOptions &Options() const { return options_; }
+
+  // 相机对应的映射表, 不存在或已过期时构建
+  template <typename CameraType>
+  std::shared_ptr<const RemapTable> Table(const CameraType &camera) {
+    const camera_t camera_id = camera.CameraId();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it = tables_.find(camera_id);
+      if (it != tables_.end() && it->second.key.Matches(camera)) {
+        PHOTOGRAMMETRY_PROFILE_COUNT("image/remap_table_cache_hits", 1);
+        return it->second.table;
+      }
+    }
+    // 构建期间不持有锁, 不同相机可以并行建表; 同一相机并发建表时保留任意一份
+    std::shared_ptr<const RemapTable> table = ComputeRemapTable(camera, options_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_[camera_id] = CachedTable{camera::IntrinsicsKey(camera), table};
+    return table;
+  }
+
+  // 去畸变图像的内参
+  template <typename CameraType>
+  UndistortedIntrinsics Intrinsics(const CameraType &camera) {
+    return Table(camera)->intrinsics;
+  }
+
+  /*
+   * @brief 去畸变一帧图像
+   * @param camera 拍摄该图像的相机模型, 图像尺寸应与相机一致
+   * @param image 原图像
+   * @return 去畸变后的图像, 类型与通道数与原图像一致
+   */
+  template <typename CameraType>
+  Image Undistort(const CameraType &camera, const Image &image) {
+    PHOTOGRAMMETRY_PROFILE_SCOPE("image/undistort");
+    const std::shared_ptr<const RemapTable> table = Table(camera);
+    Image undistorted = pool_.Acquire(table->intrinsics.width, table->intrinsics.height,
+                                      image.channels(), image.type());
+    Remap(image, *table, options_, &undistorted);
+    return undistorted;
+  }
+
+  // 缓存的映射表个数
+  size_t NumCachedTables() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tables_.size();
+  }
+
+  void ClearCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_.clear();
+  }
+
+private:
+  struct CachedTable {
+    camera::IntrinsicsKey key;
+    std::shared_ptr<const RemapTable> table;
+  };
+
+  ImageUndistorterOptions options_;
+  mutable std::mutex mutex_;
+  Hash_Map<camera_t, CachedTable> tables_;
+  ImageBufferPool pool_;
+};
+
+} // namespace image
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_IMAGE_UNDISTORTER_HPP
@@ -0,0 +1,197 @@
+#include "image/undistorter.hpp"
+#include "camera/pinhole_model.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace photogrammetry;
+using namespace photogrammetry::camera;
+using namespace photogrammetry::image;
+
+namespace {
+
+PinholeCameraBrown MakeCamera(const camera_t camera_id, const double k1) {
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 210.0;
+  params->fy = 205.0;
+  params->cx = 79.5;
+  params->cy = 61.0;
+  params->distortion = {k1, 0.02, 0.0, 0.001, -0.0005};
+  return PinholeCameraBrown(camera_id, 160, 120, params);
+}
+
+// 无畸变归一化平面上的平滑图案
+float Pattern(const Vec2 &p) {
+  return static_cast<float>(100.0 + 40.0 * std::sin(9.0 * p.x()) * std::cos(7.0 * p.y()));
+}
+
+// 畸变图像: 每个像素取其去畸变位置处的图案值
+Image RenderDistorted(const PinholeCameraBrown &camera) {
+  Image image = Image::Allocate(static_cast<int>(camera.width()),
+                                static_cast<int>(camera.height()), 1, PixelType::FLOAT32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      image.At<float>(x, y) = Pattern(camera.undistort(camera.ima2cam(Vec2(x, y))));
+    }
+  }
+  return image;
+}
+
+Vec2 UndistortedToNormalized(const UndistortedIntrinsics &intrinsics, const double u,
+                             const double v) {
+  return Vec2((u - intrinsics.cx) / intrinsics.fx, (v - intrinsics.cy) / intrinsics.fy);
+}
+
+} // namespace
+
+TEST(ImageUndistorterTest, RemapTableMatchesCameraModel) {
+  const PinholeCameraBrown camera = MakeCamera(1, -0.15);
+  ImageUndistorterOptions options;
+  options.scale = 0.75;
+  const std::shared_ptr<const RemapTable> table = ComputeRemapTable(camera, options);
+  const UndistortedIntrinsics &intrinsics = table->intrinsics;
+  ASSERT_EQ(intrinsics.width, 120);
+  ASSERT_EQ(intrinsics.height, 90);
+  // 保持内参时焦距只按比例缩放
+  EXPECT_NEAR(intrinsics.fx, 0.75 * 210.0, 1e-9);
+  EXPECT_NEAR(intrinsics.fy, 0.75 * 205.0, 1e-9);
+  for (int v = 0; v < intrinsics.height; v += 7) {
+    for (int u = 0; u < intrinsics.width; u += 5) {
+      const Vec2 pixel =
+          camera.cam2ima(camera.distort(UndistortedToNormalized(intrinsics, u, v)));
+      const size_t index = static_cast<size_t>(v) * intrinsics.width + u;
+      EXPECT_NEAR(table->map_x[index], pixel.x(), 1e-3);
+      EXPECT_NEAR(table->map_y[index], pixel.y(), 1e-3);
+    }
+  }
+}
+
+TEST(ImageUndistorterTest, UndistortsImage) {
+  const PinholeCameraBrown camera = MakeCamera(1, -0.15);
+  const Image distorted = RenderDistorted(camera);
+  ImageUndistorterOptions options;
+  options.tile_width = 37;
+  options.tile_height = 5;
+  ImageUndistorter undistorter(options);
+  const Image undistorted = undistorter.Undistort(camera, distorted);
+  const UndistortedIntrinsics intrinsics = undistorter.Intrinsics(camera);
+  ASSERT_EQ(undistorted.width(), intrinsics.width);
+  ASSERT_EQ(undistorted.height(), intrinsics.height);
+  const std::shared_ptr<const RemapTable> table = undistorter.Table(camera);
+  int num_checked = 0;
+  for (int v = 0; v < undistorted.height(); ++v) {
+    for (int u = 0; u < undistorted.width(); ++u) {
+      const size_t index = static_cast<size_t>(v) * intrinsics.width + u;
+      const float x = table->map_x[index];
+      const float y = table->map_y[index];
+      if (x < 0.0f || y < 0.0f || x > distorted.width() - 1 || y > distorted.height() - 1) {
+        EXPECT_EQ(undistorted.At<float>(u, v), options.fill_value);
+        continue;
+      }
+      // 双线性插值的误差与图案的二阶导数同阶
+      EXPECT_NEAR(undistorted.At<float>(u, v),
+                  Pattern(UndistortedToNormalized(intrinsics, u, v)), 0.5f);
+      ++num_checked;
+    }
+  }
+  EXPECT_GT(num_checked, undistorted.width() * undistorted.height() / 2);
+}
+
+TEST(ImageUndistorterTest, RemapsMultiChannelIntegerImages) {
+  const PinholeCameraBrown camera = MakeCamera(1, 0.0);
+  Image color = Image::Allocate(160, 120, 3, PixelType::UINT8);
+  for (int y = 0; y < color.height(); ++y) {
+    for (int x = 0; x < color.width(); ++x) {
+      for (int c = 0; c < 3; ++c) {
+        color.At<uint8_t>(x, y, c) = static_cast<uint8_t>(x + 50 * c);
+      }
+    }
+  }
+  ImageUndistorter undistorter;
+  const Image undistorted = undistorter.Undistort(camera, color);
+  ASSERT_EQ(undistorted.channels(), 3);
+  ASSERT_EQ(undistorted.type(), PixelType::UINT8);
+  // 残余的切向畸变很小, 图像中心附近的像素几乎不动
+  for (int c = 0; c < 3; ++c) {
+    EXPECT_NEAR(undistorted.At<uint8_t>(80, 60, c), 80 + 50 * c, 1);
+  }
+}
+
+TEST(ImageUndistorterTest, CachesTablesPerCamera) {
+  PinholeCameraBrown camera = MakeCamera(1, -0.15);
+  const PinholeCameraBrown other = MakeCamera(2, -0.05);
+  const Image distorted = RenderDistorted(camera);
+  ImageUndistorter undistorter;
+  const std::shared_ptr<const RemapTable> table = undistorter.Table(camera);
+  for (int frame = 0; frame < 3; ++frame) {
+    undistorter.Undistort(camera, distorted);
+  }
+  EXPECT_EQ(undistorter.Table(camera), table);
+  EXPECT_EQ(undistorter.NumCachedTables(), 1u);
+  undistorter.Undistort(other, distorted);
+  EXPECT_EQ(undistorter.NumCachedTables(), 2u);
+
+  // 内参更新后重新建表
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 250.0;
+  params->fy = 250.0;
+  params->cx = 80.0;
+  params->cy = 60.0;
+  params->distortion = {-0.1, 0.0, 0.0, 0.0, 0.0};
+  ASSERT_TRUE(camera.InitCamera(params));
+  EXPECT_NE(undistorter.Table(camera), table);
+  EXPECT_EQ(undistorter.NumCachedTables(), 2u);
+}
+
+TEST(ImageUndistorterTest, CameraWithSameIdButDifferentParamsGetsOwnTable) {
+  // 两个相机的 ID 与内参版本号都相同, 畸变与图像尺寸不同
+  const PinholeCameraBrown camera = MakeCamera(5, -0.15);
+  PinholeCameraBrown other = MakeCamera(5, 0.1);
+  ASSERT_EQ(camera.ParamsVersion(), other.ParamsVersion());
+  ImageUndistorter undistorter;
+  const std::shared_ptr<const RemapTable> table = undistorter.Table(camera);
+  const std::shared_ptr<const RemapTable> other_table = undistorter.Table(other);
+  EXPECT_NE(other_table, table);
+  const std::shared_ptr<const RemapTable> expected = ComputeRemapTable(other, undistorter.Options());
+  EXPECT_EQ(other_table->map_x, expected->map_x);
+  EXPECT_EQ(other_table->map_y, expected->map_y);
+
+  other = MakeCamera(5, -0.15);
+  other.SetWidth(200);
+  const std::shared_ptr<const RemapTable> wide_table = undistorter.Table(other);
+  EXPECT_EQ(wide_table->intrinsics.width, 200);
+  EXPECT_EQ(undistorter.Table(camera)->intrinsics.width, 160);
+  EXPECT_EQ(undistorter.NumCachedTables(), 1u);
+}
+
+TEST(ImageUndistorterTest, FitsRequestedRegion) {
+  // 桶形畸变: 去畸变后图像四角向外伸展
+  const PinholeCameraBrown camera = MakeCamera(1, -0.3);
+  ImageUndistorterOptions options;
+  options.border_step = 4;
+
+  options.region = UndistortedRegion::VALID_PIXELS;
+  const std::shared_ptr<const RemapTable> valid = ComputeRemapTable(camera, options);
+  // 所有输出像素都采样自原图像之内
+  for (size_t i = 0; i < valid->map_x.size(); ++i) {
+    ASSERT_GE(valid->map_x[i], -0.5f - 1e-2f);
+    ASSERT_LE(valid->map_x[i], 159.5f + 1e-2f);
+    ASSERT_GE(valid->map_y[i], -0.5f - 1e-2f);
+    ASSERT_LE(valid->map_y[i], 119.5f + 1e-2f);
+  }
+
+  options.region = UndistortedRegion::ALL_PIXELS;
+  const std::shared_ptr<const RemapTable> all = ComputeRemapTable(camera, options);
+  const UndistortedIntrinsics &intrinsics = all->intrinsics;
+  // 原图像的四个角都落在输出图像之内
+  for (const Vec2 &corner : {Vec2(-0.5, -0.5), Vec2(159.5, -0.5), Vec2(-0.5, 119.5),
+                             Vec2(159.5, 119.5)}) {
+    const Vec2 p = camera.undistort(camera.ima2cam(corner));
+    const double u = intrinsics.fx * p.x() + intrinsics.cx;
+    const double v = intrinsics.fy * p.y() + intrinsics.cy;
+    EXPECT_GE(u, -0.5 - 1e-6);
+    EXPECT_LE(u, intrinsics.width - 0.5 + 1e-6);
+    EXPECT_GE(v, -0.5 - 1e-6);
+    EXPECT_LE(v, intrinsics.height - 0.5 + 1e-6);
+  }
+  EXPECT_LT(intrinsics.fx, valid->intrinsics.fx);
+}
@@ -0,0 +1,74 @@
+#ifndef PHOTOGRAMMETRY_MATCHING_DISTANCE_HPP
+#define PHOTOGRAMMETRY_MATCHING_DISTANCE_HPP
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace photogrammetry {
+namespace matching {
+
+/*
+ * @brief 两个二值描述子的 Hamming 距离
+ * num_bytes 为 32 的倍数, 即 feature::FeatureDescriptors 的行距, 行尾填充的 0 不影响结果。
+ * 编译目标支持 AVX512 VPOPCNTDQ 时直接按 64 位计数, 支持 AVX2 时按 4 位查表计数, 否则按 64 位
+ * 调用 popcount。
+ */
+inline int HammingDistance(const uint8_t *a, const uint8_t *b, const size_t num_bytes) {
+#if defined(__AVX512VPOPCNTDQ__) && defined(__AVX512VL__)
+  __m256i sum = _mm256_setzero_si256();
+  for (size_t i = 0; i < num_bytes; i += 32) {
+    const __m256i x =
+        _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+                         _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+    sum = _mm256_add_epi64(sum, _mm256_popcnt_epi64(x));
+  }
+  const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  return static_cast<int>(_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+#elif defined(__AVX2__)
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1,
+                       2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i sum = _mm256_setzero_si256();
+  for (size_t i = 0; i < num_bytes; i += 32) {
+    const __m256i x =
+        _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+                         _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+    const __m256i count =
+        _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low_mask)),
+                        _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4),
+                                                                     low_mask)));
+    // 每 8 个字节的计数求和到一个 64 位整数
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+  }
+  const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  return static_cast<int>(_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+#else
+  int distance = 0;
+  for (size_t i = 0; i < num_bytes; i += 8) {
+    uint64_t x, y;
+    std::memcpy(&x, a + i, 8);
+    std::memcpy(&y, b + i, 8);
+    distance += __builtin_popcountll(x ^ y);
+  }
+  return distance;
+#endif
+}
+
+// 两个浮点描述子的欧氏距离的平方, 由 Eigen 向量化求和
+inline float SquaredL2Distance(const float *a, const float *b, const int dimension) {
+  return (Eigen::Map<const Eigen::VectorXf>(a, dimension) -
+          Eigen::Map<const Eigen::VectorXf>(b, dimension))
+      .squaredNorm();
+}
+
+} // namespace matching
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_MATCHING_DISTANCE_HPP
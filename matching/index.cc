@@ -0,0 +1,294 @@
+#include "matching/index.hpp"
+#include "matching/distance.hpp"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+namespace photogrammetry {
+namespace matching {
+
+namespace {
+
+using feature::DescriptorType;
+using feature::FeatureDescriptors;
+
+void CheckQueries(const FeatureDescriptors &descriptors, const FeatureDescriptors &queries) {
+  if (queries.type() != descriptors.type() || queries.dimension() != descriptors.dimension()) {
+    throw std::invalid_argument(
+        "Query descriptors must have the same type and dimension as the index");
+  }
+}
+
+/*
+ * @brief 随机 KD 树森林
+ * 节点存放在数组中, 叶子节点的 split_dim 为 -1, child 为 indices 中的区间 [begin, end)。
+ */
+class KdForestIndex final : public DescriptorIndex {
+public:
+  KdForestIndex(const FeatureDescriptors &descriptors, const IndexOptions &options)
+      : descriptors_(descriptors), max_checks_(options.max_checks) {
+    trees_.resize(options.num_trees);
+    for (int t = 0; t < options.num_trees; ++t) {
+      Tree &tree = trees_[t];
+      tree.indices.resize(descriptors_.size());
+      std::iota(tree.indices.begin(), tree.indices.end(), point2D_t(0));
+      std::mt19937 rng(t + 1);
+      BuildNode(&tree, 0, static_cast<int>(tree.indices.size()), &rng);
+    }
+  }
+
+  std::vector<NearestNeighbors> Search(const FeatureDescriptors &queries) const override;
+
+  size_t size() const override { return descriptors_.size(); }
+
+private:
+  static constexpr int kLeafSize = 8;
+  // 估计方差所用的样本数, 以及随机选择划分维度的范围
+  static constexpr int kNumVarianceSamples = 128;
+  static constexpr int kNumRandomDims = 5;
+
+  struct Node {
+    int split_dim = -1;
+    float split_value = 0.0f;
+    int child[2] = {0, 0};
+  };
+
+  struct Tree {
+    std::vector<Node> nodes;
+    std::vector<point2D_t> indices;
+  };
+
+  // 从树中查询时待访问的分支, 按下界从小到大出队
+  struct Branch {
+    float bound;
+    int tree;
+    int node;
+    bool operator<(const Branch &other) const { return bound > other.bound; }
+  };
+
+  int BuildNode(Tree *tree, int begin, int end, std::mt19937 *rng);
+
+  const FeatureDescriptors &descriptors_;
+  int max_checks_;
+  std::vector<Tree> trees_;
+};
+
+int KdForestIndex::BuildNode(Tree *tree, const int begin, const int end, std::mt19937 *rng) {
+  const int node_id = static_cast<int>(tree->nodes.size());
+  tree->nodes.emplace_back();
+  if (end - begin <= kLeafSize) {
+    tree->nodes[node_id].child[0] = begin;
+    tree->nodes[node_id].child[1] = end;
+    return node_id;
+  }
+
+  const int dimension = descriptors_.dimension();
+  const int step = std::max(1, (end - begin) / kNumVarianceSamples);
+  Eigen::ArrayXd sum = Eigen::ArrayXd::Zero(dimension);
+  Eigen::ArrayXd squared_sum = Eigen::ArrayXd::Zero(dimension);
+  int count = 0;
+  for (int i = begin; i < end; i += step, ++count) {
+    const Eigen::Map<const Eigen::ArrayXf> row(descriptors_.Row<float>(tree->indices[i]),
+                                               dimension);
+    sum += row.cast<double>();
+    squared_sum += row.cast<double>().square();
+  }
+  const Eigen::ArrayXd mean = sum / count;
+  const Eigen::ArrayXd variance = squared_sum / count - mean.square();
+  std::vector<int> dims(dimension);
+  std::iota(dims.begin(), dims.end(), 0);
+  const int num_candidates = std::min(kNumRandomDims, dimension);
+  std::partial_sort(dims.begin(), dims.begin() + num_candidates, dims.end(),
+                    [&variance](const int a, const int b) { return variance[a] > variance[b]; });
+  const int split_dim = dims[(*rng)() % num_candidates];
+
+  float split_value = static_cast<float>(mean[split_dim]);
+  auto value = [this, split_dim](const point2D_t index) {
+    return descriptors_.Row<float>(index)[split_dim];
+  };
+  const auto first = tree->indices.begin() + begin;
+  const auto last = tree->indices.begin() + end;
+  int middle = static_cast<int>(
+      std::partition(first, last,
+                     [&](const point2D_t index) { return value(index) < split_value; }) -
+      tree->indices.begin());
+  if (middle == begin || middle == end) {
+    // 所有描述子在均值的同一侧(例如大量相同的描述子), 改为按中位数划分
+    middle = (begin + end) / 2;
+    std::nth_element(first, tree->indices.begin() + middle, last,
+                     [&](const point2D_t a, const point2D_t b) { return value(a) < value(b); });
+    split_value = value(tree->indices[middle]);
+  }
+  tree->nodes[node_id].split_dim = split_dim;
+  tree->nodes[node_id].split_value = split_value;
+  const int left = BuildNode(tree, begin, middle, rng);
+  const int right = BuildNode(tree, middle, end, rng);
+  tree->nodes[node_id].child[0] = left;
+  tree->nodes[node_id].child[1] = right;
+  return node_id;
+}
+
+std::vector<NearestNeighbors> KdForestIndex::Search(const FeatureDescriptors &queries) const {
+  CheckQueries(descriptors_, queries);
+  const int dimension = descriptors_.dimension();
+  std::vector<NearestNeighbors> neighbors(queries.size());
+  std::vector<uint32_t> visited(descriptors_.size(), 0);
+  std::priority_queue<Branch> branches;
+  for (size_t q = 0; q < queries.size(); ++q) {
+    const float *query = queries.Row<float>(q);
+    const uint32_t stamp = static_cast<uint32_t>(q + 1);
+    NearestNeighbors &nn = neighbors[q];
+    int num_checks = 0;
+    branches = std::priority_queue<Branch>();
+
+    // 从 node 下降到叶子, 沿途把另一侧分支放入队列, 距离均为平方
+    auto descend = [&](const int t, int node_id, const float bound) {
+      const Tree &tree = trees_[t];
+      while (tree.nodes[node_id].split_dim >= 0) {
+        const Node &node = tree.nodes[node_id];
+        const float diff = query[node.split_dim] - node.split_value;
+        const float far_bound = bound + diff * diff;
+        if (far_bound < nn.distance2) {
+          branches.push({far_bound, t, node.child[diff < 0.0f ? 1 : 0]});
+        }
+        node_id = node.child[diff < 0.0f ? 0 : 1];
+      }
+      const Node &leaf = tree.nodes[node_id];
+      for (int i = leaf.child[0]; i < leaf.child[1]; ++i) {
+        const point2D_t index = tree.indices[i];
+        if (visited[index] != stamp) {
+          visited[index] = stamp;
+          nn.Update(index, SquaredL2Distance(query, descriptors_.Row<float>(index), dimension));
+          ++num_checks;
+        }
+      }
+    };
+
+    for (int t = 0; t < static_cast<int>(trees_.size()); ++t) {
+      descend(t, 0, 0.0f);
+    }
+    while (!branches.empty() && num_checks < max_checks_) {
+      const Branch branch = branches.top();
+      branches.pop();
+      if (branch.bound >= nn.distance2) {
+        break;
+      }
+      descend(branch.tree, branch.node, branch.bound);
+    }
+    nn.distance1 = nn.index1 == UINvaliedPoint2DId ? nn.distance1 : std::sqrt(nn.distance1);
+    nn.distance2 = nn.index2 == UINvaliedPoint2DId ? nn.distance2 : std::sqrt(nn.distance2);
+  }
+  return neighbors;
+}
+
+/*
+ * @brief 按位采样的多探测 LSH
+ * 每个哈希表的桶按键排成 CSR 数组: 键为 k 的描述子编号为 indices[offsets[k], offsets[k + 1])。
+ */
+class LshIndex final : public DescriptorIndex {
+public:
+  LshIndex(const FeatureDescriptors &descriptors, const IndexOptions &options)
+      : descriptors_(descriptors) {
+    key_bits_ = options.hash_key_bits;
+    if (key_bits_ == 0) {
+      // 平均每个桶约 2 个描述子
+      const int log_size = static_cast<int>(std::log2(std::max<size_t>(descriptors_.size(), 1)));
+      key_bits_ = std::min(std::max(log_size - 1, 4), 20);
+    }
+    const int num_bits = descriptors_.dimension() * 8;
+    key_bits_ = std::min(key_bits_, num_bits);
+
+    tables_.resize(options.num_hash_tables);
+    for (int t = 0; t < options.num_hash_tables; ++t) {
+      Table &table = tables_[t];
+      std::vector<int> positions(num_bits);
+      std::iota(positions.begin(), positions.end(), 0);
+      std::mt19937 rng(t + 1);
+      std::shuffle(positions.begin(), positions.end(), rng);
+      table.bits.assign(positions.begin(), positions.begin() + key_bits_);
+
+      std::vector<uint32_t> keys(descriptors_.size());
+      table.offsets.assign((size_t(1) << key_bits_) + 1, 0);
+      for (size_t i = 0; i < descriptors_.size(); ++i) {
+        keys[i] = Key(table, descriptors_.Row<uint8_t>(i));
+        ++table.offsets[keys[i] + 1];
+      }
+      std::partial_sum(table.offsets.begin(), table.offsets.end(), table.offsets.begin());
+      std::vector<uint32_t> next(table.offsets.begin(), table.offsets.end() - 1);
+      table.indices.resize(descriptors_.size());
+      for (size_t i = 0; i < descriptors_.size(); ++i) {
+        table.indices[next[keys[i]]++] = static_cast<point2D_t>(i);
+      }
+    }
+  }
+
+  std::vector<NearestNeighbors> Search(const FeatureDescriptors &queries) const override {
+    CheckQueries(descriptors_, queries);
+    const size_t stride = descriptors_.stride();
+    std::vector<NearestNeighbors> neighbors(queries.size());
+    std::vector<uint32_t> visited(descriptors_.size(), 0);
+    for (size_t q = 0; q < queries.size(); ++q) {
+      const uint8_t *query = queries.Row<uint8_t>(q);
+      const uint32_t stamp = static_cast<uint32_t>(q + 1);
+      NearestNeighbors &nn = neighbors[q];
+      for (const Table &table : tables_) {
+        const uint32_t key = Key(table, query);
+        // 探测原键以及翻转任一位后的键
+        for (int flip = -1; flip < key_bits_; ++flip) {
+          const uint32_t probe = flip < 0 ? key : key ^ (uint32_t(1) << flip);
+          for (uint32_t i = table.offsets[probe]; i < table.offsets[probe + 1]; ++i) {
+            const point2D_t index = table.indices[i];
+            if (visited[index] != stamp) {
+              visited[index] = stamp;
+              nn.Update(index, static_cast<float>(HammingDistance(
+                                   query, descriptors_.Row<uint8_t>(index), stride)));
+            }
+          }
+        }
+      }
+    }
+    return neighbors;
+  }
+
+  size_t size() const override { return descriptors_.size(); }
+
+private:
+  struct Table {
+    std::vector<int> bits;
+    std::vector<uint32_t> offsets;
+    std::vector<point2D_t> indices;
+  };
+
+  uint32_t Key(const Table &table, const uint8_t *row) const {
+    uint32_t key = 0;
+    for (int b = 0; b < key_bits_; ++b) {
+      const int position = table.bits[b];
+      key |= static_cast<uint32_t>((row[position >> 3] >> (position & 7)) & 1) << b;
+    }
+    return key;
+  }
+
+  const FeatureDescriptors &descriptors_;
+  int key_bits_ = 0;
+  std::vector<Table> tables_;
+};
+
+} // namespace
+
+std::unique_ptr<DescriptorIndex> DescriptorIndex::Create(const FeatureDescriptors &descriptors,
+                                                         const IndexOptions &options) {
+  if (!options.Check()) {
+    throw std::invalid_argument("Invalid descriptor index options");
+  }
+  if (descriptors.type() == DescriptorType::BINARY) {
+    return std::make_unique<LshIndex>(descriptors, options);
+  }
+  return std::make_unique<KdForestIndex>(descriptors, options);
+}
+
+} // namespace matching
+} // namespace photogrammetry
@@ -0,0 +1,74 @@
+#ifndef PHOTOGRAMMETRY_MATCHING_INDEX_HPP
+#define PHOTOGRAMMETRY_MATCHING_INDEX_HPP
+
+#include "camera/std_types.hpp"
+#include "feature/types.hpp"
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace photogrammetry {
+namespace matching {
+
+// 最近的两个邻居, 距离为 Hamming 距离或欧氏距离
+struct NearestNeighbors {
+  point2D_t index1 = UINvaliedPoint2DId;
+  point2D_t index2 = UINvaliedPoint2DId;
+  float distance1 = std::numeric_limits<float>::max();
+  float distance2 = std::numeric_limits<float>::max();
+
+  void Update(const point2D_t index, const float distance) {
+    if (distance < distance1) {
+      index2 = index1;
+      distance2 = distance1;
+      index1 = index;
+      distance1 = distance;
+    } else if (distance < distance2) {
+      index2 = index;
+      distance2 = distance;
+    }
+  }
+};
+
+struct IndexOptions {
+  // 浮点描述子: 随机 KD 树的棵数, 每次查询最多计算距离的描述子数
+  int num_trees = 4;
+  int max_checks = 256;
+  // 二值描述子: LSH 哈希表个数与每个键的位数, 0 表示按描述子数自动选择
+  int num_hash_tables = 8;
+  int hash_key_bits = 0;
+
+  bool Check() const {
+    return num_trees > 0 && max_checks > 0 && num_hash_tables > 0 && hash_key_bits >= 0 &&
+           hash_key_bits <= 24;
+  }
+};
+
+/*
+ * @brief 描述子的近似最近邻索引
+ * 浮点描述子使用随机 KD 树森林: 每个节点在方差最大的几个维度中随机选一个, 以均值划分, 查询时
+ * 所有树共用一个优先队列按下界由近到远访问, 计算 max_checks 个描述子后停止。
+ * 二值描述子使用按位采样的 LSH: 每个哈希表随机取 hash_key_bits 位作为键, 查询时同时探测翻转任一位
+ * 的键, 对落入这些桶的描述子计算精确的 Hamming 距离。
+ * 索引只保存描述子的指针, 描述子必须在索引的生命期内保持不变。Search 可以被多个线程同时调用。
+ */
+class DescriptorIndex {
+public:
+  virtual ~DescriptorIndex() = default;
+
+  // 按描述子类型创建索引
+  static std::unique_ptr<DescriptorIndex> Create(const feature::FeatureDescriptors &descriptors,
+                                                 const IndexOptions &options = IndexOptions());
+
+  // 为 queries 的每一行搜索索引中最近的两个描述子
+  // queries 的类型或维度与索引不一致时抛出 std::invalid_argument
+  virtual std::vector<NearestNeighbors>
+  Search(const feature::FeatureDescriptors &queries) const = 0;
+
+  virtual size_t size() const = 0;
+};
+
+} // namespace matching
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_MATCHING_INDEX_HPP
@@ -0,0 +1,254 @@
+#include "matching/matcher.hpp"
+#include "matching/distance.hpp"
+#include "utils/profiler.hpp"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+
+namespace photogrammetry {
+namespace matching {
+
+namespace {
+
+using feature::DescriptorType;
+using feature::FeatureDescriptors;
+
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrix;
+typedef Eigen::Map<const RowMatrix, Eigen::Unaligned, Eigen::OuterStride<>> ConstRowMatrixMap;
+
+// 二值描述子分块: 一块训练描述子 256 x 32 字节留在 L1 缓存中
+constexpr size_t kBinaryQueryTile = 64;
+constexpr size_t kBinaryTrainTile = 256;
+// 浮点描述子分块: 一块距离矩阵 128 x 512
+constexpr size_t kFloatQueryTile = 128;
+constexpr size_t kFloatTrainTile = 512;
+
+void CheckCompatible(const FeatureDescriptors &descriptors1,
+                     const FeatureDescriptors &descriptors2) {
+  if (descriptors1.type() != descriptors2.type() ||
+      descriptors1.dimension() != descriptors2.dimension()) {
+    throw std::invalid_argument("Descriptors must have the same type and dimension");
+  }
+}
+
+/*
+ * @brief 分块穷举二值描述子, 同时更新两个方向的最近邻
+ */
+void BruteForceBinary(const FeatureDescriptors &descriptors1,
+                      const FeatureDescriptors &descriptors2,
+                      std::vector<NearestNeighbors> *neighbors12,
+                      std::vector<NearestNeighbors> *neighbors21) {
+  const size_t stride = descriptors1.stride();
+  for (size_t q0 = 0; q0 < descriptors1.size(); q0 += kBinaryQueryTile) {
+    const size_t q1 = std::min(q0 + kBinaryQueryTile, descriptors1.size());
+    for (size_t t0 = 0; t0 < descriptors2.size(); t0 += kBinaryTrainTile) {
+      const size_t t1 = std::min(t0 + kBinaryTrainTile, descriptors2.size());
+      for (size_t q = q0; q < q1; ++q) {
+        const uint8_t *query = descriptors1.Row<uint8_t>(q);
+        NearestNeighbors &nn = (*neighbors12)[q];
+        for (size_t t = t0; t < t1; ++t) {
+          const float distance =
+              static_cast<float>(HammingDistance(query, descriptors2.Row<uint8_t>(t), stride));
+          nn.Update(static_cast<point2D_t>(t), distance);
+          (*neighbors21)[t].Update(static_cast<point2D_t>(q), distance);
+        }
+      }
+    }
+  }
+}
+
+/*
+ * @brief 分块穷举浮点描述子, 一块的距离平方为 |a|^2 + |b|^2 - 2 A B^T
+ * 行尾的填充为 0, 按整个行距参与计算不影响结果。
+ */
+void BruteForceFloat(const FeatureDescriptors &descriptors1,
+                     const FeatureDescriptors &descriptors2,
+                     std::vector<NearestNeighbors> *neighbors12,
+                     std::vector<NearestNeighbors> *neighbors21) {
+  const Eigen::Index cols = static_cast<Eigen::Index>(descriptors1.stride() / sizeof(float));
+  const ConstRowMatrixMap all1(descriptors1.Row<float>(0), descriptors1.size(), cols,
+                               Eigen::OuterStride<>(cols));
+  const ConstRowMatrixMap all2(descriptors2.Row<float>(0), descriptors2.size(), cols,
+                               Eigen::OuterStride<>(cols));
+  const Eigen::VectorXf norms1 = all1.rowwise().squaredNorm();
+  const Eigen::RowVectorXf norms2 = all2.rowwise().squaredNorm().transpose();
+
+  RowMatrix distances;
+  for (size_t q0 = 0; q0 < descriptors1.size(); q0 += kFloatQueryTile) {
+    const Eigen::Index rows = std::min(kFloatQueryTile, descriptors1.size() - q0);
+    for (size_t t0 = 0; t0 < descriptors2.size(); t0 += kFloatTrainTile) {
+      const Eigen::Index train_rows = std::min(kFloatTrainTile, descriptors2.size() - t0);
+      distances.noalias() = -2.0f * all1.middleRows(q0, rows) *
+                            all2.middleRows(t0, train_rows).transpose();
+      distances.colwise() += norms1.segment(q0, rows);
+      distances.rowwise() += norms2.segment(t0, train_rows);
+      for (Eigen::Index i = 0; i < rows; ++i) {
+        NearestNeighbors &nn = (*neighbors12)[q0 + i];
+        for (Eigen::Index j = 0; j < train_rows; ++j) {
+          const float distance = std::max(distances(i, j), 0.0f);
+          nn.Update(static_cast<point2D_t>(t0 + j), distance);
+          (*neighbors21)[t0 + j].Update(static_cast<point2D_t>(q0 + i), distance);
+        }
+      }
+    }
+  }
+  for (std::vector<NearestNeighbors> *neighbors : {neighbors12, neighbors21}) {
+    for (NearestNeighbors &nn : *neighbors) {
+      nn.distance1 = std::sqrt(nn.distance1);
+      nn.distance2 = std::sqrt(nn.distance2);
+    }
+  }
+}
+
+} // namespace
+
+FeatureMatcher::FeatureMatcher(const FeatureMatcherOptions &options) : options_(options) {
+  if (!options_.Check()) {
+    throw std::invalid_argument("Invalid feature matcher options");
+  }
+  thread_pool_ = std::make_unique<utils::ThreadPool>(options_.num_threads);
+}
+
+FeatureMatches FeatureMatcher::Match(const FeatureDescriptors &descriptors1,
+                                     const FeatureDescriptors &descriptors2) const {
+  CheckCompatible(descriptors1, descriptors2);
+  if (descriptors1.empty() || descriptors2.empty()) {
+    return FeatureMatches();
+  }
+  if (options_.type == FeatureMatcherType::BRUTE_FORCE) {
+    return MatchBruteForce(descriptors1, descriptors2);
+  }
+  const std::unique_ptr<DescriptorIndex> index1 =
+      DescriptorIndex::Create(descriptors1, options_.index);
+  const std::unique_ptr<DescriptorIndex> index2 =
+      DescriptorIndex::Create(descriptors2, options_.index);
+  return MatchIndexed(descriptors1, *index1, descriptors2, *index2);
+}
+
+Flat_Hash_Map<image_pair_t, FeatureMatches>
+FeatureMatcher::Match(const std::vector<FeatureDescriptors> &descriptors,
+                      const std::vector<Pair> &image_pairs) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("matching/match_pairs");
+  // 去掉重复的影像对, 并把较小的 id 放在前面
+  std::vector<Pair> pairs;
+  pairs.reserve(image_pairs.size());
+  Flat_Hash_Map<image_pair_t, bool> seen;
+  for (const Pair &image_pair : image_pairs) {
+    if (image_pair.first >= descriptors.size() || image_pair.second >= descriptors.size()) {
+      throw std::invalid_argument("Image pair references an image without descriptors");
+    }
+    // 在派发任何任务前检查全部影像对, 出错时不会有任务仍在使用 descriptors
+    CheckCompatible(descriptors[image_pair.first], descriptors[image_pair.second]);
+    const image_pair_t pair_id = ImagePairToPairId(image_pair.first, image_pair.second);
+    if (image_pair.first != image_pair.second && seen.try_emplace(pair_id, true).second) {
+      pairs.push_back(PairIdToImagePair(pair_id));
+    }
+  }
+
+  // 每张影像的索引只建立一次
+  std::vector<std::unique_ptr<DescriptorIndex>> indices(descriptors.size());
+  if (options_.type == FeatureMatcherType::APPROXIMATE) {
+    std::vector<std::pair<image_t, std::future<std::unique_ptr<DescriptorIndex>>>> futures;
+    std::vector<bool> needed(descriptors.size(), false);
+    for (const Pair &pair : pairs) {
+      for (const image_t image_id : {pair.first, pair.second}) {
+        if (!needed[image_id]) {
+          needed[image_id] = true;
+          futures.emplace_back(image_id, thread_pool_->AddTask([this, &descriptors, image_id]() {
+            return DescriptorIndex::Create(descriptors[image_id], options_.index);
+          }));
+        }
+      }
+    }
+    // 先等待全部任务结束, 再取结果(可能重新抛出异常), 任务不会在返回后继续访问 indices
+    for (auto &future : futures) {
+      future.second.wait();
+    }
+    for (auto &future : futures) {
+      indices[future.first] = future.second.get();
+    }
+  }
+
+  std::vector<std::future<FeatureMatches>> futures;
+  futures.reserve(pairs.size());
+  for (const Pair &pair : pairs) {
+    futures.push_back(thread_pool_->AddTask([this, &descriptors, &indices, pair]() {
+      const FeatureDescriptors &descriptors1 = descriptors[pair.first];
+      const FeatureDescriptors &descriptors2 = descriptors[pair.second];
+      if (descriptors1.empty() || descriptors2.empty()) {
+        return FeatureMatches();
+      }
+      if (options_.type == FeatureMatcherType::BRUTE_FORCE) {
+        return MatchBruteForce(descriptors1, descriptors2);
+      }
+      return MatchIndexed(descriptors1, *indices[pair.first], descriptors2,
+                          *indices[pair.second]);
+    }));
+  }
+
+  for (std::future<FeatureMatches> &future : futures) {
+    future.wait();
+  }
+  Flat_Hash_Map<image_pair_t, FeatureMatches> matches;
+  matches.reserve(pairs.size());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    FeatureMatches pair_matches = futures[i].get();
+    PHOTOGRAMMETRY_PROFILE_HISTOGRAM("matching/num_matches", pair_matches.size());
+    if (pair_matches.size() >= static_cast<size_t>(options_.min_num_matches)) {
+      matches.emplace(ImagePairToPairId(pairs[i].first, pairs[i].second), std::move(pair_matches));
+    }
+  }
+  return matches;
+}
+
+FeatureMatches FeatureMatcher::Filter(const std::vector<NearestNeighbors> &neighbors12,
+                                      const std::vector<NearestNeighbors> &neighbors21) const {
+  FeatureMatches matches;
+  for (size_t i = 0; i < neighbors12.size(); ++i) {
+    const NearestNeighbors &nn = neighbors12[i];
+    if (nn.index1 == UINvaliedPoint2DId || nn.distance1 > options_.max_distance) {
+      continue;
+    }
+    // 只有一个候选时没有次近邻, 不做比值检验
+    if (nn.index2 != UINvaliedPoint2DId && nn.distance1 > options_.max_ratio * nn.distance2) {
+      continue;
+    }
+    if (!neighbors21.empty() && neighbors21[nn.index1].index1 != i) {
+      continue;
+    }
+    matches.push_back({static_cast<point2D_t>(i), nn.index1});
+  }
+  return matches;
+}
+
+FeatureMatches FeatureMatcher::MatchBruteForce(const FeatureDescriptors &descriptors1,
+                                               const FeatureDescriptors &descriptors2) const {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("matching/brute_force");
+  std::vector<NearestNeighbors> neighbors12(descriptors1.size());
+  std::vector<NearestNeighbors> neighbors21(descriptors2.size());
+  if (descriptors1.type() == DescriptorType::BINARY) {
+    BruteForceBinary(descriptors1, descriptors2, &neighbors12, &neighbors21);
+  } else {
+    BruteForceFloat(descriptors1, descriptors2, &neighbors12, &neighbors21);
+  }
+  if (!options_.cross_check) {
+    neighbors21.clear();
+  }
+  return Filter(neighbors12, neighbors21);
+}
+
+FeatureMatches FeatureMatcher::MatchIndexed(const FeatureDescriptors &descriptors1,
+                                            const DescriptorIndex &index1,
+                                            const FeatureDescriptors &descriptors2,
+                                            const DescriptorIndex &index2) const {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("matching/approximate");
+  const std::vector<NearestNeighbors> neighbors12 = index2.Search(descriptors1);
+  const std::vector<NearestNeighbors> neighbors21 =
+      options_.cross_check ? index1.Search(descriptors2) : std::vector<NearestNeighbors>();
+  return Filter(neighbors12, neighbors21);
+}
+
+} // namespace matching
+} // namespace photogrammetry
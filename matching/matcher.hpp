@@ -0,0 +1,104 @@
+#ifndef PHOTOGRAMMETRY_MATCHING_MATCHER_HPP
+#define PHOTOGRAMMETRY_MATCHING_MATCHER_HPP
+
+#include "camera/std_types.hpp"
+#include "feature/types.hpp"
+#include "matching/index.hpp"
+#include "utils/thread_pool.hpp"
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace photogrammetry {
+namespace matching {
+
+// 一对匹配的特征点, 分别为影像对中第一张与第二张影像的 point2D_t
+struct FeatureMatch {
+  point2D_t point2D_idx1 = UINvaliedPoint2DId;
+  point2D_t point2D_idx2 = UINvaliedPoint2DId;
+};
+
+typedef std::vector<FeatureMatch> FeatureMatches;
+
+enum class FeatureMatcherType : uint8_t {
+  // 分块穷举所有描述子对
+  BRUTE_FORCE = 0,
+  // 在 DescriptorIndex 中近似搜索, 适合描述子很多的影像
+  APPROXIMATE,
+};
+
+struct FeatureMatcherOptions {
+  FeatureMatcherType type = FeatureMatcherType::BRUTE_FORCE;
+  // 最近距离与次近距离之比的上限
+  float max_ratio = 0.8f;
+  // 最近距离的上限, 二值描述子为 Hamming 距离, 浮点描述子为欧氏距离
+  float max_distance = std::numeric_limits<float>::max();
+  // 只保留互为最近邻的匹配
+  bool cross_check = true;
+  // 匹配数少于该值的影像对不输出
+  int min_num_matches = 15;
+  // 并行匹配影像对的线程数, -1 表示使用全部硬件线程
+  int num_threads = -1;
+  IndexOptions index;
+
+  bool Check() const {
+    return max_ratio > 0.0f && max_ratio <= 1.0f && max_distance >= 0.0f && min_num_matches >= 0 &&
+           index.Check();
+  }
+};
+
+/*
+ * @brief 特征匹配
+ * BRUTE_FORCE 把两组描述子分成小块, 每块内计算全部距离并同时更新两个方向的最近邻, 块的大小使
+ * 训练集的一块留在 L1/L2 缓存中。二值描述子用 HammingDistance 逐行计算(AVX2/AVX-512 按整行),
+ * 浮点描述子用 |a|^2 + |b|^2 - 2 a.b 把一块距离化为 Eigen 矩阵乘法。
+ * APPROXIMATE 为每张影像建立一次 DescriptorIndex, 在同一影像参与的所有影像对中重复使用。
+ * 两种方式都经过比值检验、距离阈值与(可选的)互为最近邻检验。
+ */
+class FeatureMatcher {
+public:
+  explicit FeatureMatcher(const FeatureMatcherOptions &options = FeatureMatcherOptions());
+
+  FeatureMatcher(const FeatureMatcher &) = delete;
+  FeatureMatcher &operator=(const FeatureMatcher &) = delete;
+
+  /*
+   * @brief 匹配两组描述子, 不检查 min_num_matches
+   * @throw std::invalid_argument 两组描述子的类型或维度不同
+   */
+  FeatureMatches Match(const feature::FeatureDescriptors &descriptors1,
+                       const feature::FeatureDescriptors &descriptors2) const;
+
+  /*
+   * @brief 在线程池中并行匹配多个影像对
+   * @param descriptors 以 image_t 为下标的各影像描述子
+   * @param image_pairs 待匹配的影像对, (a, b) 与 (b, a) 视为同一对
+   * @return 以 ImagePairToPairId 为键的匹配, 其中第一张影像为 id 较小的影像
+   * @note 任一影像对的描述子类型或维度不一致时, 在开始匹配前抛出 std::invalid_argument
+   */
+  Flat_Hash_Map<image_pair_t, FeatureMatches>
+  Match(const std::vector<feature::FeatureDescriptors> &descriptors,
+        const std::vector<Pair> &image_pairs);
+
+  const FeatureMatcherOptions &Options() const { return options_; }
+
+private:
+  // 按比值、距离与互为最近邻筛选, neighbors21 为空时不做互为最近邻检验
+  FeatureMatches Filter(const std::vector<NearestNeighbors> &neighbors12,
+                        const std::vector<NearestNeighbors> &neighbors21) const;
+
+  FeatureMatches MatchBruteForce(const feature::FeatureDescriptors &descriptors1,
+                                 const feature::FeatureDescriptors &descriptors2) const;
+  FeatureMatches MatchIndexed(const feature::FeatureDescriptors &descriptors1,
+                              const DescriptorIndex &index1,
+                              const feature::FeatureDescriptors &descriptors2,
+                              const DescriptorIndex &index2) const;
+
+  FeatureMatcherOptions options_;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+};
+
+} // namespace matching
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_MATCHING_MATCHER_HPP
@@ -0,0 +1,62 @@
+#include "matching/matcher.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+using namespace photogrammetry::matching;
+
+namespace {
+FeatureDescriptors RandomDescriptors(const DescriptorType type, const size_t num_rows,
+                                     const unsigned seed) {
+  std::mt19937 rng(seed);
+  const int dimension = type == DescriptorType::BINARY ? 32 : 128;
+  FeatureDescriptors descriptors(type, dimension, num_rows);
+  std::uniform_real_distribution<float> value(0.0f, 1.0f);
+  for (size_t i = 0; i < num_rows; ++i) {
+    for (int j = 0; j < dimension; ++j) {
+      if (type == DescriptorType::BINARY) {
+        descriptors.Row<uint8_t>(i)[j] = static_cast<uint8_t>(rng());
+      } else {
+        descriptors.Row<float>(i)[j] = value(rng);
+      }
+    }
+  }
+  return descriptors;
+}
+
+// Matches one pair of images with state.range(0) descriptors each
+void MatchPair(benchmark::State &state, const DescriptorType descriptor_type,
+               const FeatureMatcherType matcher_type) {
+  const size_t num_rows = static_cast<size_t>(state.range(0));
+  const FeatureDescriptors descriptors1 = RandomDescriptors(descriptor_type, num_rows, 1);
+  const FeatureDescriptors descriptors2 = RandomDescriptors(descriptor_type, num_rows, 2);
+  FeatureMatcherOptions options;
+  options.type = matcher_type;
+  FeatureMatcher matcher(options);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matcher.Match(descriptors1, descriptors2));
+  }
+  state.counters["pairs/s"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+} // namespace
+
+static void BM_BruteForceBinary(benchmark::State &state) {
+  MatchPair(state, DescriptorType::BINARY, FeatureMatcherType::BRUTE_FORCE);
+}
+BENCHMARK(BM_BruteForceBinary)->Arg(1024)->Arg(8192)->Unit(benchmark::kMillisecond);
+
+static void BM_ApproximateBinary(benchmark::State &state) {
+  MatchPair(state, DescriptorType::BINARY, FeatureMatcherType::APPROXIMATE);
+}
+BENCHMARK(BM_ApproximateBinary)->Arg(1024)->Arg(8192)->Unit(benchmark::kMillisecond);
+
+static void BM_BruteForceFloat(benchmark::State &state) {
+  MatchPair(state, DescriptorType::FLOAT32, FeatureMatcherType::BRUTE_FORCE);
+}
+BENCHMARK(BM_BruteForceFloat)->Arg(1024)->Arg(8192)->Unit(benchmark::kMillisecond);
+
+static void BM_ApproximateFloat(benchmark::State &state) {
+  MatchPair(state, DescriptorType::FLOAT32, FeatureMatcherType::APPROXIMATE);
+}
+BENCHMARK(BM_ApproximateFloat)->Arg(1024)->Arg(8192)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,228 @@
+#include "matching/matcher.hpp"
+#include "matching/distance.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+using namespace photogrammetry::matching;
+
+namespace {
+
+FeatureDescriptors RandomBinary(const size_t num_rows, std::mt19937 *rng) {
+  FeatureDescriptors descriptors(DescriptorType::BINARY, 32, num_rows);
+  for (size_t i = 0; i < num_rows; ++i) {
+    for (int j = 0; j < 32; ++j) {
+      descriptors.Row<uint8_t>(i)[j] = static_cast<uint8_t>((*rng)());
+    }
+  }
+  return descriptors;
+}
+
+FeatureDescriptors RandomFloat(const size_t num_rows, std::mt19937 *rng) {
+  std::uniform_real_distribution<float> value(0.0f, 1.0f);
+  FeatureDescriptors descriptors(DescriptorType::FLOAT32, 128, num_rows);
+  for (size_t i = 0; i < num_rows; ++i) {
+    for (int j = 0; j < 128; ++j) {
+      descriptors.Row<float>(i)[j] = value(*rng);
+    }
+  }
+  return descriptors;
+}
+
+/*
+ * 第二组描述子为第一组的前 num_inliers 个加噪声后打乱顺序, 再加上 num_outliers 个随机描述子。
+ * permutation[i] 为第一组第 i 个描述子在第二组中的位置。
+ */
+FeatureDescriptors MakeSecondSet(const FeatureDescriptors &descriptors1, const size_t num_inliers,
+                                 const size_t num_outliers, std::mt19937 *rng,
+                                 std::vector<point2D_t> *permutation) {
+  const bool binary = descriptors1.type() == DescriptorType::BINARY;
+  FeatureDescriptors descriptors2 =
+      binary ? RandomBinary(num_inliers + num_outliers, rng)
+             : RandomFloat(num_inliers + num_outliers, rng);
+  permutation->resize(num_inliers + num_outliers);
+  std::iota(permutation->begin(), permutation->end(), point2D_t(0));
+  std::shuffle(permutation->begin(), permutation->end(), *rng);
+  std::normal_distribution<float> noise(0.0f, 0.02f);
+  for (size_t i = 0; i < num_inliers; ++i) {
+    const size_t row = (*permutation)[i];
+    std::copy(descriptors1.Row<uint8_t>(i), descriptors1.Row<uint8_t>(i) + descriptors1.stride(),
+              descriptors2.Row<uint8_t>(row));
+    if (binary) {
+      // 翻转 8 个随机位
+      for (int k = 0; k < 8; ++k) {
+        const int bit = (*rng)() % 256;
+        descriptors2.Row<uint8_t>(row)[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+      }
+    } else {
+      for (int k = 0; k < 128; ++k) {
+        descriptors2.Row<float>(row)[k] += noise(*rng);
+      }
+    }
+  }
+  return descriptors2;
+}
+
+size_t CountCorrect(const FeatureMatches &matches, const std::vector<point2D_t> &permutation,
+                    const size_t num_inliers) {
+  size_t num_correct = 0;
+  for (const FeatureMatch &match : matches) {
+    num_correct += match.point2D_idx1 < num_inliers &&
+                   permutation[match.point2D_idx1] == match.point2D_idx2;
+  }
+  return num_correct;
+}
+
+} // namespace
+
+TEST(DistanceTest, HammingDistanceMatchesBitCount) {
+  std::mt19937 rng(1);
+  const FeatureDescriptors descriptors = RandomBinary(20, &rng);
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    int expected = 0;
+    for (int j = 0; j < 32; ++j) {
+      expected += static_cast<int>(
+          std::bitset<8>(descriptors.Row<uint8_t>(0)[j] ^ descriptors.Row<uint8_t>(i)[j]).count());
+    }
+    EXPECT_EQ(HammingDistance(descriptors.Row<uint8_t>(0), descriptors.Row<uint8_t>(i),
+                              descriptors.stride()),
+              expected);
+  }
+}
+
+TEST(FeatureMatcherTest, BruteForceBinary) {
+  std::mt19937 rng(2);
+  const FeatureDescriptors descriptors1 = RandomBinary(700, &rng);
+  std::vector<point2D_t> permutation;
+  const FeatureDescriptors descriptors2 = MakeSecondSet(descriptors1, 500, 300, &rng, &permutation);
+  FeatureMatcher matcher;
+  const FeatureMatches matches = matcher.Match(descriptors1, descriptors2);
+  EXPECT_EQ(CountCorrect(matches, permutation, 500), 500u);
+  EXPECT_LT(matches.size(), 510u);
+}
+
+TEST(FeatureMatcherTest, BruteForceFloatMatchesNaiveSearch) {
+  std::mt19937 rng(3);
+  const FeatureDescriptors descriptors1 = RandomFloat(300, &rng);
+  const FeatureDescriptors descriptors2 = RandomFloat(700, &rng);
+  FeatureMatcherOptions options;
+  options.max_ratio = 1.0f;
+  options.cross_check = false;
+  FeatureMatcher matcher(options);
+  const FeatureMatches matches = matcher.Match(descriptors1, descriptors2);
+  ASSERT_EQ(matches.size(), descriptors1.size());
+  for (const FeatureMatch &match : matches) {
+    point2D_t best = 0;
+    for (point2D_t j = 1; j < descriptors2.size(); ++j) {
+      if (SquaredL2Distance(descriptors1.Row<float>(match.point2D_idx1), descriptors2.Row<float>(j),
+                            128) <
+          SquaredL2Distance(descriptors1.Row<float>(match.point2D_idx1),
+                            descriptors2.Row<float>(best), 128)) {
+        best = j;
+      }
+    }
+    EXPECT_EQ(match.point2D_idx2, best);
+  }
+}
+
+TEST(FeatureMatcherTest, ApproximateBinaryAndFloat) {
+  std::mt19937 rng(4);
+  FeatureMatcherOptions options;
+  options.type = FeatureMatcherType::APPROXIMATE;
+  FeatureMatcher matcher(options);
+  for (const bool binary : {true, false}) {
+    const FeatureDescriptors descriptors1 =
+        binary ? RandomBinary(3000, &rng) : RandomFloat(3000, &rng);
+    std::vector<point2D_t> permutation;
+    const FeatureDescriptors descriptors2 =
+        MakeSecondSet(descriptors1, 2000, 1000, &rng, &permutation);
+    const FeatureMatches matches = matcher.Match(descriptors1, descriptors2);
+    const size_t num_correct = CountCorrect(matches, permutation, 2000);
+    EXPECT_GT(num_correct, 1800u) << (binary ? "binary" : "float");
+    EXPECT_LT(matches.size(), num_correct + 50);
+  }
+}
+
+TEST(FeatureMatcherTest, MatchImagePairs) {
+  std::mt19937 rng(5);
+  std::vector<FeatureDescriptors> descriptors;
+  descriptors.push_back(RandomBinary(400, &rng));
+  std::vector<point2D_t> permutation;
+  descriptors.push_back(MakeSecondSet(descriptors[0], 300, 100, &rng, &permutation));
+  descriptors.push_back(RandomBinary(400, &rng));
+
+  for (const FeatureMatcherType type :
+       {FeatureMatcherType::BRUTE_FORCE, FeatureMatcherType::APPROXIMATE}) {
+    FeatureMatcherOptions options;
+    options.type = type;
+    options.num_threads = 2;
+    FeatureMatcher matcher(options);
+    // (1, 0) 与 (0, 1) 为同一对, 随机描述子之间几乎没有通过检验的匹配
+    const Flat_Hash_Map<image_pair_t, FeatureMatches> matches =
+        matcher.Match(descriptors, {{1, 0}, {0, 1}, {2, 1}, {0, 2}});
+    ASSERT_EQ(matches.size(), 1u);
+    const FeatureMatches &pair_matches = matches.at(ImagePairToPairId(0, 1));
+    EXPECT_GT(CountCorrect(pair_matches, permutation, 300), 280u);
+  }
+}
+
+TEST(FeatureMatcherTest, MatchImagePairsRejectsIncompatiblePair) {
+  std::mt19937 rng(8);
+  std::vector<FeatureDescriptors> descriptors;
+  for (int i = 0; i < 6; ++i) {
+    descriptors.push_back(RandomBinary(200, &rng));
+  }
+  descriptors.push_back(RandomFloat(200, &rng));
+  std::vector<Pair> pairs;
+  for (image_t i = 0; i < 6; ++i) {
+    for (image_t j = i + 1; j < 6; ++j) {
+      pairs.push_back({i, j});
+    }
+  }
+  // 不兼容的影像对排在最后, 此前的影像对都已可以派发
+  pairs.push_back({3, 6});
+
+  for (const FeatureMatcherType type :
+       {FeatureMatcherType::BRUTE_FORCE, FeatureMatcherType::APPROXIMATE}) {
+    FeatureMatcherOptions options;
+    options.type = type;
+    options.num_threads = 4;
+    FeatureMatcher matcher(options);
+    EXPECT_THROW(matcher.Match(descriptors, pairs), std::invalid_argument);
+    // 出错后匹配器仍可使用
+    pairs.pop_back();
+    EXPECT_NO_THROW(matcher.Match(descriptors, pairs));
+    pairs.push_back({3, 6});
+  }
+}
+
+TEST(DescriptorIndexTest, RejectsIncompatibleQueries) {
+  std::mt19937 rng(7);
+  for (const FeatureDescriptors &descriptors : {RandomBinary(50, &rng), RandomFloat(50, &rng)}) {
+    const std::unique_ptr<DescriptorIndex> index = DescriptorIndex::Create(descriptors);
+    const DescriptorType other_type = descriptors.type() == DescriptorType::BINARY
+                                          ? DescriptorType::FLOAT32
+                                          : DescriptorType::BINARY;
+    EXPECT_THROW(index->Search(FeatureDescriptors(other_type, descriptors.dimension(), 1)),
+                 std::invalid_argument);
+    EXPECT_THROW(
+        index->Search(FeatureDescriptors(descriptors.type(), descriptors.dimension() / 2, 1)),
+        std::invalid_argument);
+    EXPECT_EQ(index->Search(descriptors).size(), descriptors.size());
+  }
+}
+
+TEST(FeatureMatcherTest, RejectsIncompatibleDescriptors) {
+  std::mt19937 rng(6);
+  FeatureMatcher matcher;
+  EXPECT_THROW(matcher.Match(RandomBinary(10, &rng), RandomFloat(10, &rng)),
+               std::invalid_argument);
+  EXPECT_TRUE(matcher.Match(RandomBinary(10, &rng), RandomBinary(0, &rng)).empty());
+  FeatureMatcherOptions options;
+  options.max_ratio = 1.5f;
+  EXPECT_THROW(FeatureMatcher invalid(options), std::invalid_argument);
+}
@@ -0,0 +1,111 @@
+#include "optim/bundle_adjustment.hpp"
+#include "utils/logger.hpp"
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace photogrammetry {
+namespace optim {
+
+ceres::LossFunction *BundleAdjustmentOptions::CreateLossFunction() const {
+  switch (loss_function_type) {
+  case LossFunctionType::SOFT_L1:
+    return new ceres::SoftLOneLoss(loss_function_scale);
+  case LossFunctionType::CAUCHY:
+    return new ceres::CauchyLoss(loss_function_scale);
+  case LossFunctionType::HUBER:
+    return new ceres::HuberLoss(loss_function_scale);
+  case LossFunctionType::TRIVIAL:
+  default:
+    return new ceres::TrivialLoss();
+  }
+}
+
+ceres::Solver::Options BundleAdjustmentOptions::CreateSolverOptions(const size_t num_images) const {
+  ceres::Solver::Options options = solver_options;
+  if (options.num_threads <= 0) {
+    options.num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  if (!auto_select_solver) {
+    return options;
+  }
+
+  // 影像较少时稠密 Schur 补最快; 有稀疏库时使用稀疏 Schur 补;
+  // 影像上千后 Schur 补矩阵的分解代价过高, 改用 Schur-Jacobi 预条件的共轭梯度
+  const bool has_sparse =
+      ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
+      ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE) ||
+      ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::ACCELERATE_SPARSE);
+  if (num_images <= static_cast<size_t>(max_num_images_direct_dense_solver)) {
+    options.linear_solver_type = ceres::DENSE_SCHUR;
+  } else if (has_sparse &&
+             num_images <= static_cast<size_t>(max_num_images_direct_sparse_solver)) {
+    options.linear_solver_type = ceres::SPARSE_SCHUR;
+  } else {
+    options.linear_solver_type = ceres::ITERATIVE_SCHUR;
+    options.preconditioner_type = ceres::SCHUR_JACOBI;
+  }
+  return options;
+}
+
+bool BundleAdjustmentOptions::Check() const {
+  if (loss_function_scale <= 0.0) {
+    PHOTOGRAMMETRY_LOG(ERROR, "BundleAdjustmentOptions check failed: loss_function_scale must "
+                              "be positive");
+    return false;
+  }
+  if (max_num_images_direct_dense_solver < 0 || max_num_images_direct_sparse_solver < 0) {
+    PHOTOGRAMMETRY_LOG(ERROR, "BundleAdjustmentOptions check failed: solver thresholds must be "
+                              "non-negative");
+    return false;
+  }
+  std::string error;
+  if (!solver_options.IsValid(&error)) {
+    PHOTOGRAMMETRY_LOG(ERROR, "BundleAdjustmentOptions check failed: {}", error);
+    return false;
+  }
+  return true;
+}
+
+void BundleAdjustmentTimings::Accumulate(const ceres::Solver::Summary &summary) {
+  preprocessor += summary.preprocessor_time_in_seconds;
+  residual_evaluation += summary.residual_evaluation_time_in_seconds;
+  jacobian_evaluation += summary.jacobian_evaluation_time_in_seconds;
+  linear_solver += summary.linear_solver_time_in_seconds;
+  minimizer += summary.minimizer_time_in_seconds;
+  postprocessor += summary.postprocessor_time_in_seconds;
+}
+
+std::string BundleAdjustmentTimings::Report() const {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(4);
+  ss << "Bundle adjustment timings (s):\n";
+  ss << "  setup:               " << setup << "\n";
+  ss << "  preprocessor:        " << preprocessor << "\n";
+  ss << "  residual evaluation: " << residual_evaluation << "\n";
+  ss << "  jacobian evaluation: " << jacobian_evaluation << "\n";
+  ss << "  linear solver:       " << linear_solver << "\n";
+  ss << "  minimizer:           " << minimizer << "\n";
+  ss << "  postprocessor:       " << postprocessor << "\n";
+  ss << "  write back:          " << write_back << "\n";
+  ss << "  total:               " << total << "\n";
+  return ss.str();
+}
+
+void LogBundleAdjustmentSummary(const ceres::Solver::Summary &summary,
+                                const BundleAdjustmentTimings &timings) {
+  PHOTOGRAMMETRY_LOG(INFO, "Bundle adjustment {}: {} residuals, {} iterations, cost {} -> {}",
+                     ceres::TerminationTypeToString(summary.termination_type),
+                     summary.num_residuals, summary.iterations.size(), summary.initial_cost,
+                     summary.final_cost);
+  PHOTOGRAMMETRY_LOG(INFO,
+                     "Bundle adjustment timings (s): setup {}, preprocessor {}, residual "
+                     "evaluation {}, jacobian evaluation {}, linear solver {}, minimizer {}, "
+                     "postprocessor {}, write back {}, total {}",
+                     timings.setup, timings.preprocessor, timings.residual_evaluation,
+                     timings.jacobian_evaluation, timings.linear_solver, timings.minimizer,
+                     timings.postprocessor, timings.write_back, timings.total);
+}
+
+} // namespace optim
+} // namespace photogrammetry
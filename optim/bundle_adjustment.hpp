@@ -0,0 +1,366 @@
+#ifndef PHOTOGRAMMETRY_BUNDLE_ADJUSTMENT_HPP
+#define PHOTOGRAMMETRY_BUNDLE_ADJUSTMENT_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "camera/std_types.hpp"
+#include "core/eigen_types.hpp"
+#include "optim/cost_functions.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <ceres/ceres.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace photogrammetry {
+namespace optim {
+
+enum class LossFunctionType { TRIVIAL, SOFT_L1, CAUCHY, HUBER };
+
+struct BundleAdjustmentOptions {
+  // 鲁棒核函数及其尺度(像素)
+  LossFunctionType loss_function_type = LossFunctionType::TRIVIAL;
+  double loss_function_scale = 1.0;
+
+  // 未在 BundleAdjustmentConfig 中单独指定的相机使用的内参优化选项
+  camera::IntrinsicParameterType refine_intrinsics = camera::IntrinsicParameterType::ADJUST_ALL;
+  // 是否优化影像位姿
+  bool refine_extrinsics = true;
+
+  // 线性求解器, 为 true 时按影像数量自动选择 DENSE_SCHUR / SPARSE_SCHUR / ITERATIVE_SCHUR,
+  // 否则使用 solver_options 中的设置
+  bool auto_select_solver = true;
+  // 自动选择时, 影像数不超过该值使用稠密 Schur 补
+  int max_num_images_direct_dense_solver = 50;
+  // 自动选择时, 影像数不超过该值使用稀疏 Schur 补, 否则使用预条件共轭梯度 (ITERATIVE_SCHUR)
+  int max_num_images_direct_sparse_solver = 1000;
+
+  // 是否以 INFO 级别记录求解摘要和各阶段耗时 (见 utils/logger.hpp)
+  bool print_summary = false;
+
+  // ceres 求解器选项, num_threads 为 -1 时使用全部硬件线程
+  ceres::Solver::Options solver_options;
+
+  BundleAdjustmentOptions() {
+    solver_options.function_tolerance = 0.0;
+    solver_options.gradient_tolerance = 1e-10;
+    solver_options.parameter_tolerance = 0.0;
+    solver_options.max_num_iterations = 100;
+    solver_options.max_linear_solver_iterations = 200;
+    solver_options.max_num_consecutive_invalid_steps = 10;
+    solver_options.num_threads = -1;
+  }
+
+  // 根据选项创建核函数, 返回的对象由调用者释放
+  ceres::LossFunction *CreateLossFunction() const;
+
+  // 根据影像数量生成最终的 ceres 求解器选项
+  ceres::Solver::Options CreateSolverOptions(size_t num_images) const;
+
+  bool Check() const;
+};
+
+/*
+ * @brief 参与平差的参数配置
+ * 不在配置中的影像和点按选项全部优化; 常量位姿、常量中心和常量点在整个求解中保持不变,
+ * 至少固定一个位姿和一个中心(或通过常量点)才能消除尺度与坐标系的自由度
+ */
+class BundleAdjustmentConfig {
+public:
+  void SetConstantPose(const image_t image_id) { constant_poses_.insert(image_id); }
+  void SetVariablePose(const image_t image_id) { constant_poses_.erase(image_id); }
+  bool HasConstantPose(const image_t image_id) const { return constant_poses_.count(image_id) > 0; }
+
+  // 只固定相机中心, 旋转仍参与优化, 常用于固定第二张影像以确定尺度
+  void SetConstantCenter(const image_t image_id) { constant_centers_.insert(image_id); }
+  bool HasConstantCenter(const image_t image_id) const {
+    return constant_centers_.count(image_id) > 0;
+  }
+
+  void SetConstantPoint(const point3D_t point3D_id) { constant_points_.insert(point3D_id); }
+  void SetVariablePoint(const point3D_t point3D_id) { constant_points_.erase(point3D_id); }
+  bool HasConstantPoint(const point3D_t point3D_id) const {
+    return constant_points_.count(point3D_id) > 0;
+  }
+
+  // 单独指定某个相机(被其所有影像共享)的内参优化选项
+  void SetIntrinsicsAdjust(const camera_t camera_id, const camera::IntrinsicParameterType adjust) {
+    intrinsics_adjust_[camera_id] = adjust;
+  }
+  camera::IntrinsicParameterType IntrinsicsAdjust(const camera_t camera_id,
+                                                  const camera::IntrinsicParameterType
+                                                      default_adjust) const {
+    const auto it = intrinsics_adjust_.find(camera_id);
+    return it == intrinsics_adjust_.end() ? default_adjust : it->second;
+  }
+
+private:
+  std::unordered_set<image_t> constant_poses_;
+  std::unordered_set<image_t> constant_centers_;
+  std::unordered_set<point3D_t> constant_points_;
+  Hash_Map<camera_t, camera::IntrinsicParameterType> intrinsics_adjust_;
+};
+
+// 参与平差的影像: 所属相机与位姿
+struct BundleAdjustmentImage {
+  camera_t camera_id;
+  camera::CameraExtrinsicParams pose;
+};
+
+// 二维观测: 影像中的像素坐标对应某个三维点
+struct BundleAdjustmentObservation {
+  image_t image_id;
+  point3D_t point3D_id;
+  Vec2 point2D;
+};
+
+/*
+ * @brief 平差场景, 同一相机的内参被其所有影像共享
+ * @tparam CameraType 相机模型
+ */
+template <typename CameraType>
+struct BundleAdjustmentScene {
+  Hash_Map<camera_t, CameraType> cameras;
+  Hash_Map<image_t, BundleAdjustmentImage> images;
+  Hash_Map<point3D_t, Vec3> points3D;
+  std::vector<BundleAdjustmentObservation> observations;
+};
+
+// 各阶段耗时(秒)
+struct BundleAdjustmentTimings {
+  // 参数拷贝与残差块构建
+  double setup = 0.0;
+  // ceres 内部阶段, 来自 ceres::Solver::Summary
+  double preprocessor = 0.0;
+  double residual_evaluation = 0.0;
+  double jacobian_evaluation = 0.0;
+  double linear_solver = 0.0;
+  double minimizer = 0.0;
+  double postprocessor = 0.0;
+  // 结果写回场景
+  double write_back = 0.0;
+  double total = 0.0;
+
+  void Accumulate(const ceres::Solver::Summary &summary);
+
+  // 可读的耗时报告, 每个阶段一行
+  std::string Report() const;
+};
+
+// 以 INFO 级别记录求解摘要与各阶段耗时
+void LogBundleAdjustmentSummary(const ceres::Solver::Summary &summary,
+                                const BundleAdjustmentTimings &timings);
+
+/*
+ * @brief 基于 ceres 的光束法平差
+ * 参数块: 每个三维点 3 维, 每张影像一个旋转四元数(4 维, EigenQuaternionManifold)与一个相机中心
+ * (3 维), 每个相机一个内参块 (getVariableParams 的长度)。内参部分固定时使用 SubsetManifold,
+ * 全部固定或位姿固定时将参数块设为常量。三维点被放在 Schur 消元的第一组。
+ * @tparam CameraType 相机模型
+ */
+template <typename CameraType>
+class BundleAdjuster {
+public:
+  BundleAdjuster(const BundleAdjustmentOptions &options, const BundleAdjustmentConfig &config)
+      : options_(options), config_(config) {}
+
+  /*
+   * @brief 求解并将结果写回场景
+   * @param scene 平差场景, 不存在的影像或三维点的观测会被忽略
+   * @return 求解结果可用时返回 true
+   */
+  bool Solve(BundleAdjustmentScene<CameraType> *scene);
+
+  const ceres::Solver::Summary &Summary() const { return summary_; }
+  const BundleAdjustmentTimings &Timings() const { return timings_; }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  static constexpr int kNumIntrinsicParams = CameraType::kNumIntrinsicParams;
+
+  static double Seconds(const Clock::time_point &start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  void SetUp(BundleAdjustmentScene<CameraType> *scene, ceres::Problem *problem);
+  void WriteBack(BundleAdjustmentScene<CameraType> *scene) const;
+
+  BundleAdjustmentOptions options_;
+  BundleAdjustmentConfig config_;
+  ceres::Solver::Summary summary_;
+  BundleAdjustmentTimings timings_;
+  std::unique_ptr<ceres::LossFunction> loss_function_;
+  std::shared_ptr<ceres::ParameterBlockOrdering> ordering_;
+
+  // 连续存放的参数块, 下标由以下映射给出
+  std::vector<double> points_, quaternions_, centers_, intrinsics_;
+  Flat_Hash_Map<point3D_t, size_t> point_index_;
+  Flat_Hash_Map<image_t, size_t> image_index_;
+  Flat_Hash_Map<camera_t, size_t> camera_index_;
+};
+
+template <typename CameraType>
+bool BundleAdjuster<CameraType>::Solve(BundleAdjustmentScene<CameraType> *scene) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("optim/bundle_adjustment");
+  timings_ = BundleAdjustmentTimings();
+  const Clock::time_point start = Clock::now();
+  if (!options_.Check()) {
+    return false;
+  }
+
+  ceres::Problem::Options problem_options;
+  problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  ceres::Problem problem(problem_options);
+  loss_function_.reset(options_.CreateLossFunction());
+  SetUp(scene, &problem);
+  timings_.setup = Seconds(start);
+
+  if (problem.NumResiduals() == 0) {
+    timings_.total = Seconds(start);
+    return false;
+  }
+
+  ceres::Solver::Options solver_options = options_.CreateSolverOptions(image_index_.size());
+  if (solver_options.linear_solver_type == ceres::DENSE_SCHUR ||
+      solver_options.linear_solver_type == ceres::SPARSE_SCHUR ||
+      solver_options.linear_solver_type == ceres::ITERATIVE_SCHUR) {
+    solver_options.linear_solver_ordering = ordering_;
+  }
+  {
+    PHOTOGRAMMETRY_PROFILE_SCOPE("optim/bundle_adjustment/solve");
+    ceres::Solve(solver_options, &problem, &summary_);
+  }
+  PHOTOGRAMMETRY_PROFILE_COUNT("optim/bundle_adjustment/residuals", problem.NumResiduals());
+  PHOTOGRAMMETRY_PROFILE_COUNT("optim/bundle_adjustment/iterations", summary_.iterations.size());
+  timings_.Accumulate(summary_);
+
+  const Clock::time_point write_back_start = Clock::now();
+  if (summary_.IsSolutionUsable()) {
+    WriteBack(scene);
+  }
+  timings_.write_back = Seconds(write_back_start);
+  timings_.total = Seconds(start);
+
+  if (options_.print_summary) {
+    LogBundleAdjustmentSummary(summary_, timings_);
+  }
+  return summary_.IsSolutionUsable();
+}
+
+template <typename CameraType>
+void BundleAdjuster<CameraType>::SetUp(BundleAdjustmentScene<CameraType> *scene,
+                                       ceres::Problem *problem) {
+  // 只为出现在观测中的参数分配参数块
+  point_index_.clear();
+  image_index_.clear();
+  camera_index_.clear();
+  std::vector<const CameraType *> cameras;
+  for (const BundleAdjustmentObservation &observation : scene->observations) {
+    const auto image_it = scene->images.find(observation.image_id);
+    if (image_it == scene->images.end() || scene->points3D.count(observation.point3D_id) == 0) {
+      continue;
+    }
+    point_index_.emplace(observation.point3D_id, point_index_.size());
+    if (image_index_.emplace(observation.image_id, image_index_.size()).second) {
+      const camera_t camera_id = image_it->second.camera_id;
+      if (camera_index_.emplace(camera_id, camera_index_.size()).second) {
+        cameras.push_back(&scene->cameras.at(camera_id));
+      }
+    }
+  }
+
+  points_.resize(3 * point_index_.size());
+  quaternions_.resize(4 * image_index_.size());
+  centers_.resize(3 * image_index_.size());
+  intrinsics_.resize(kNumIntrinsicParams * camera_index_.size());
+  for (const auto &item : point_index_) {
+    Eigen::Map<Vec3> point(&points_[3 * item.second]);
+    point = scene->points3D.at(item.first);
+  }
+  for (const auto &item : image_index_) {
+    const camera::CameraExtrinsicParams &pose = scene->images.at(item.first).pose;
+    Eigen::Map<Eigen::Quaterniond> quaternion(&quaternions_[4 * item.second]);
+    Eigen::Map<Vec3> center(&centers_[3 * item.second]);
+    quaternion = Eigen::Quaterniond(pose.Rotation()).normalized();
+    center = pose.Center();
+  }
+  for (const auto &item : camera_index_) {
+    const std::vector<double> params = scene->cameras.at(item.first).getVariableParams();
+    std::copy(params.begin(), params.end(), &intrinsics_[kNumIntrinsicParams * item.second]);
+  }
+
+  for (const BundleAdjustmentObservation &observation : scene->observations) {
+    const auto image_it = image_index_.find(observation.image_id);
+    const auto point_it = point_index_.find(observation.point3D_id);
+    if (image_it == image_index_.end() || point_it == point_index_.end()) {
+      continue;
+    }
+    const camera_t camera_id = scene->images.at(observation.image_id).camera_id;
+    const size_t camera_idx = camera_index_.at(camera_id);
+    ceres::CostFunction *cost_function = new ReprojectionErrorCostFunction<CameraType>(
+        cameras[camera_idx], observation.point2D,
+        config_.IntrinsicsAdjust(camera_id, options_.refine_intrinsics));
+    problem->AddResidualBlock(cost_function, loss_function_.get(), &points_[3 * point_it->second],
+                              &quaternions_[4 * image_it->second], &centers_[3 * image_it->second],
+                              &intrinsics_[kNumIntrinsicParams * camera_idx]);
+  }
+
+  // 常量参数与流形; 三维点为 Schur 消元的第 0 组, 其余参数为第 1 组
+  ordering_ = std::make_shared<ceres::ParameterBlockOrdering>();
+  for (const auto &item : point_index_) {
+    double *point = &points_[3 * item.second];
+    ordering_->AddElementToGroup(point, 0);
+    if (config_.HasConstantPoint(item.first)) {
+      problem->SetParameterBlockConstant(point);
+    }
+  }
+  for (const auto &item : image_index_) {
+    double *quaternion = &quaternions_[4 * item.second];
+    double *center = &centers_[3 * item.second];
+    ordering_->AddElementToGroup(quaternion, 1);
+    ordering_->AddElementToGroup(center, 1);
+    problem->SetManifold(quaternion, new ceres::EigenQuaternionManifold);
+    if (!options_.refine_extrinsics || config_.HasConstantPose(item.first)) {
+      problem->SetParameterBlockConstant(quaternion);
+      problem->SetParameterBlockConstant(center);
+    } else if (config_.HasConstantCenter(item.first)) {
+      problem->SetParameterBlockConstant(center);
+    }
+  }
+  for (const auto &item : camera_index_) {
+    double *intrinsics = &intrinsics_[kNumIntrinsicParams * item.second];
+    ordering_->AddElementToGroup(intrinsics, 1);
+    const std::vector<int> constant_indices = CameraType::IntrinsicParams::ConstantParamIndices(
+        config_.IntrinsicsAdjust(item.first, options_.refine_intrinsics));
+    if (constant_indices.size() == static_cast<size_t>(kNumIntrinsicParams)) {
+      problem->SetParameterBlockConstant(intrinsics);
+    } else if (!constant_indices.empty()) {
+      problem->SetManifold(intrinsics,
+                           new ceres::SubsetManifold(kNumIntrinsicParams, constant_indices));
+    }
+  }
+}
+
+template <typename CameraType>
+void BundleAdjuster<CameraType>::WriteBack(BundleAdjustmentScene<CameraType> *scene) const {
+  for (const auto &item : point_index_) {
+    scene->points3D.at(item.first) = Eigen::Map<const Vec3>(&points_[3 * item.second]);
+  }
+  for (const auto &item : image_index_) {
+    camera::CameraExtrinsicParams &pose = scene->images.at(item.first).pose;
+    pose.Rotation() =
+        Eigen::Map<const Eigen::Quaterniond>(&quaternions_[4 * item.second]).toRotationMatrix();
+    pose.Center() = Eigen::Map<const Vec3>(&centers_[3 * item.second]);
+  }
+  for (const auto &item : camera_index_) {
+    scene->cameras.at(item.first).updateFromVariableParams(
+        &intrinsics_[kNumIntrinsicParams * item.second]);
+  }
+}
+
+} // namespace optim
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_BUNDLE_ADJUSTMENT_HPP
@@ -0,0 +1,166 @@
+#include "optim/bundle_adjustment.hpp"
+#include "camera/pinhole_model.hpp"
+#include <gtest/gtest.h>
+
+using namespace photogrammetry;
+using namespace photogrammetry::camera;
+using namespace photogrammetry::optim;
+
+class BundleAdjustmentTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+    params->fx = 1000.0;
+    params->fy = 1010.0;
+    params->cx = 640.0;
+    params->cy = 480.0;
+    params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+    scene_.cameras.emplace(0, PinholeCameraBrown(0, 1280, 960, params));
+
+    // 影像位于 z = -6 平面上, 朝向 +z 方向, 共享同一个相机
+    for (image_t image_id = 0; image_id < 8; ++image_id) {
+      const double t = image_id / 7.0;
+      BundleAdjustmentImage image;
+      image.camera_id = 0;
+      image.pose = CameraExtrinsicParams(
+          Eigen::AngleAxisd(0.1 * (t - 0.5), Vec3(0.3, 1.0, 0.1).normalized()).toRotationMatrix(),
+          Vec3(4.0 * t - 2.0, std::sin(3.0 * t), -6.0));
+      scene_.images.emplace(image_id, image);
+    }
+    const Mat3X X = Mat3X::Random(3, 300);
+    for (point3D_t point3D_id = 0; point3D_id < static_cast<point3D_t>(X.cols()); ++point3D_id) {
+      scene_.points3D.emplace(point3D_id, X.col(point3D_id));
+    }
+    const PinholeCameraBrown &camera = scene_.cameras.at(0);
+    for (const auto &image : scene_.images) {
+      for (const auto &point : scene_.points3D) {
+        scene_.observations.push_back(
+            {image.first, point.first, camera.project(image.second.pose(point.second))});
+      }
+    }
+    ground_truth_ = scene_;
+  }
+
+  void PerturbPointsAndPoses() {
+    for (auto &point : scene_.points3D) {
+      point.second += 0.02 * Vec3::Random();
+    }
+    for (auto &image : scene_.images) {
+      if (image.first < 2) {
+        continue;
+      }
+      image.second.pose.Rotation() =
+          Eigen::AngleAxisd(0.01, Vec3::Random().normalized()).toRotationMatrix() *
+          image.second.pose.Rotation();
+      image.second.pose.Center() += 0.05 * Vec3::Random();
+    }
+  }
+
+  // 固定第一张影像的位姿与第二张影像的中心, 消除坐标系与尺度的自由度
+  BundleAdjustmentConfig GaugeFixedConfig() const {
+    BundleAdjustmentConfig config;
+    config.SetConstantPose(0);
+    config.SetConstantCenter(1);
+    return config;
+  }
+
+  double MaxPointError() const {
+    double max_error = 0.0;
+    for (const auto &point : scene_.points3D) {
+      max_error =
+          std::max(max_error, (point.second - ground_truth_.points3D.at(point.first)).norm());
+    }
+    return max_error;
+  }
+
+  BundleAdjustmentScene<PinholeCameraBrown> scene_;
+  BundleAdjustmentScene<PinholeCameraBrown> ground_truth_;
+};
+
+TEST_F(BundleAdjustmentTest, CostFunctionMatchesNumericDerivatives) {
+  const PinholeCameraBrown &camera = scene_.cameras.at(0);
+  const BundleAdjustmentImage &image = scene_.images.at(3);
+  Vec3 X = scene_.points3D.at(5);
+  Eigen::Quaterniond q(image.pose.Rotation());
+  Vec3 C = image.pose.Center();
+  std::vector<double> intrinsics = camera.getVariableParams();
+  const ReprojectionErrorCostFunction<PinholeCameraBrown> cost_function(
+      &camera, Vec2(700.0, 500.0), IntrinsicParameterType::ADJUST_ALL);
+
+  const ceres::EigenQuaternionManifold quaternion_manifold;
+  const std::vector<const ceres::Manifold *> manifolds = {nullptr, &quaternion_manifold, nullptr,
+                                                          nullptr};
+  const ceres::GradientChecker checker(&cost_function, &manifolds, ceres::NumericDiffOptions());
+  const double *parameters[] = {X.data(), q.coeffs().data(), C.data(), intrinsics.data()};
+  ceres::GradientChecker::ProbeResults results;
+  EXPECT_TRUE(checker.Probe(parameters, 1e-6, &results)) << results.error_log;
+}
+
+TEST_F(BundleAdjustmentTest, RecoversPerturbedPointsAndPoses) {
+  PerturbPointsAndPoses();
+  BundleAdjustmentOptions options;
+  options.refine_intrinsics = IntrinsicParameterType::NONE;
+  BundleAdjuster<PinholeCameraBrown> bundle_adjuster(options, GaugeFixedConfig());
+  ASSERT_TRUE(bundle_adjuster.Solve(&scene_));
+  EXPECT_LT(bundle_adjuster.Summary().final_cost, 1e-8);
+  EXPECT_LT(MaxPointError(), 1e-5);
+  for (const auto &image : scene_.images) {
+    const CameraExtrinsicParams &pose = ground_truth_.images.at(image.first).pose;
+    EXPECT_LT((image.second.pose.Center() - pose.Center()).norm(), 1e-5);
+    EXPECT_TRUE(image.second.pose.Rotation().isApprox(pose.Rotation(), 1e-6));
+  }
+}
+
+TEST_F(BundleAdjustmentTest, RefinesSharedIntrinsicsPerMask) {
+  std::vector<double> params = scene_.cameras.at(0).getVariableParams();
+  params[0] *= 1.01;
+  params[1] *= 0.99;
+  ASSERT_TRUE(scene_.cameras.at(0).updateFromVariableParams(params));
+
+  BundleAdjustmentOptions options;
+  BundleAdjustmentConfig config = GaugeFixedConfig();
+  config.SetIntrinsicsAdjust(0, IntrinsicParameterType::ADJUST_FOCAL_LENGTH);
+  BundleAdjuster<PinholeCameraBrown> bundle_adjuster(options, config);
+  ASSERT_TRUE(bundle_adjuster.Solve(&scene_));
+
+  const std::vector<double> refined = scene_.cameras.at(0).getVariableParams();
+  const std::vector<double> expected = ground_truth_.cameras.at(0).getVariableParams();
+  EXPECT_NEAR(refined[0], expected[0], 1e-4);
+  EXPECT_NEAR(refined[1], expected[1], 1e-4);
+  // 未参与优化的内参保持不变
+  for (size_t i = 2; i < refined.size(); ++i) {
+    EXPECT_EQ(refined[i], params[i]);
+  }
+}
+
+TEST_F(BundleAdjustmentTest, ConstantBlocksAreUntouched) {
+  PerturbPointsAndPoses();
+  const BundleAdjustmentScene<PinholeCameraBrown> initial = scene_;
+  BundleAdjustmentOptions options;
+  options.refine_intrinsics = IntrinsicParameterType::NONE;
+  options.refine_extrinsics = false;
+  BundleAdjuster<PinholeCameraBrown> bundle_adjuster(options, BundleAdjustmentConfig());
+  ASSERT_TRUE(bundle_adjuster.Solve(&scene_));
+  EXPECT_EQ(scene_.cameras.at(0).getVariableParams(),
+            initial.cameras.at(0).getVariableParams());
+  for (const auto &image : scene_.images) {
+    const CameraExtrinsicParams &pose = initial.images.at(image.first).pose;
+    EXPECT_EQ(image.second.pose.Center(), pose.Center());
+    EXPECT_TRUE(image.second.pose.Rotation().isApprox(pose.Rotation(), 1e-12));
+  }
+}
+
+TEST_F(BundleAdjustmentTest, ReportsTimingsAndSolverSelection) {
+  BundleAdjustmentOptions options;
+  options.loss_function_type = LossFunctionType::CAUCHY;
+  BundleAdjuster<PinholeCameraBrown> bundle_adjuster(options, GaugeFixedConfig());
+  ASSERT_TRUE(bundle_adjuster.Solve(&scene_));
+  const BundleAdjustmentTimings &timings = bundle_adjuster.Timings();
+  EXPECT_GT(timings.total, 0.0);
+  EXPECT_GE(timings.total, timings.setup + timings.write_back);
+  EXPECT_NE(timings.Report().find("linear solver"), std::string::npos);
+  EXPECT_EQ(bundle_adjuster.Summary().linear_solver_type_used, ceres::DENSE_SCHUR);
+
+  EXPECT_EQ(options.CreateSolverOptions(10000).linear_solver_type, ceres::ITERATIVE_SCHUR);
+  EXPECT_GE(options.CreateSolverOptions(1).num_threads, 1);
+}
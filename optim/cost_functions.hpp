@@ -0,0 +1,95 @@
+#ifndef PHOTOGRAMMETRY_COST_FUNCTIONS_HPP
+#define PHOTOGRAMMETRY_COST_FUNCTIONS_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "core/eigen_types.hpp"
+#include <ceres/ceres.h>
+
+namespace photogrammetry {
+namespace optim {
+
+/*
+ * @brief 四元数参数块 (x, y, z, w) 对左乘旋转扰动 w 的雅可比 dw/dq
+ * @note 对单位四元数 q 及切向增量 dq: exp([w]x) = R(dq * q^-1), 即 w = 2 * vec(dq * q^-1),
+ *       与 ceres::EigenQuaternionManifold 的 PlusJacobian 相乘后得到切空间上的雅可比
+ */
+inline Eigen::Matrix<double, 3, 4> QuaternionToRotationVectorJacobian(const double *quaternion) {
+  const double x = quaternion[0], y = quaternion[1], z = quaternion[2], w = quaternion[3];
+  Eigen::Matrix<double, 3, 4> J;
+  J << w, -z, y, -x, z, w, -x, -y, -y, x, w, -z;
+  return 2.0 * J;
+}
+
+/*
+ * @brief 重投影误差, 使用相机模型的解析雅可比
+ * 参数块依次为: 三维点(3), 旋转四元数(4, Eigen 顺序 x, y, z, w), 相机中心(3), 内参(K)。
+ * 残差为 投影 - 观测 (像素)。
+ * @tparam CameraType 相机模型, 需提供 projectJacobian 与 updateFromVariableParams(const double *)
+ * @note 代价函数只保存相机模型的指针, 每个观测的内存开销与相机模型大小无关;
+ *       相机对象在求解期间必须保持有效, 其内参在每次求值时由参数块覆盖
+ */
+template <typename CameraType>
+class ReprojectionErrorCostFunction
+    : public ceres::SizedCostFunction<2, 3, 4, 3, CameraType::kNumIntrinsicParams> {
+public:
+  static constexpr int kNumIntrinsicParams = CameraType::kNumIntrinsicParams;
+
+  ReprojectionErrorCostFunction(const CameraType *camera, const Vec2 &point2D,
+                                const camera::IntrinsicParameterType adjust)
+      : camera_(camera), point2D_(point2D), adjust_(adjust) {}
+
+  bool Evaluate(double const *const *parameters, double *residuals,
+                double **jacobians) const override {
+    CameraType camera = *camera_;
+    camera.updateFromVariableParams(parameters[3]);
+
+    const Eigen::Map<const Vec3> X(parameters[0]);
+    const Mat33 R = Eigen::Map<const Eigen::Quaterniond>(parameters[1]).toRotationMatrix();
+    const Eigen::Map<const Vec3> C(parameters[2]);
+
+    typename CameraType::PointJacobian J_point;
+    typename CameraType::PoseJacobian J_pose;
+    typename CameraType::IntrinsicJacobian J_intrinsics;
+    const bool need_point = jacobians != nullptr && jacobians[0] != nullptr;
+    const bool need_pose =
+        jacobians != nullptr && (jacobians[1] != nullptr || jacobians[2] != nullptr);
+    const bool need_intrinsics = jacobians != nullptr && jacobians[3] != nullptr;
+    const Vec2 x = camera.projectJacobian(R, C, X, need_point ? &J_point : nullptr,
+                                          need_pose ? &J_pose : nullptr,
+                                          need_intrinsics ? &J_intrinsics : nullptr, adjust_);
+    Eigen::Map<Vec2> residual(residuals);
+    residual = x - point2D_;
+    if (jacobians == nullptr) {
+      return true;
+    }
+
+    // ceres 的雅可比按行优先存储
+    if (need_point) {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[0]);
+      J = J_point;
+    }
+    if (jacobians[1] != nullptr) {
+      Eigen::Map<Eigen::Matrix<double, 2, 4, Eigen::RowMajor>> J(jacobians[1]);
+      J = J_pose.template leftCols<3>() * QuaternionToRotationVectorJacobian(parameters[1]);
+    }
+    if (jacobians[2] != nullptr) {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[2]);
+      J = J_pose.template rightCols<3>();
+    }
+    if (need_intrinsics) {
+      Eigen::Map<Eigen::Matrix<double, 2, kNumIntrinsicParams, Eigen::RowMajor>> J(jacobians[3]);
+      J = J_intrinsics;
+    }
+    return true;
+  }
+
+private:
+  const CameraType *camera_;
+  Vec2 point2D_;
+  camera::IntrinsicParameterType adjust_;
+};
+
+} // namespace optim
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_COST_FUNCTIONS_HPP
@@ -0,0 +1,214 @@
+#include "retrieval/image_index.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <stdexcept>
+
+namespace photogrammetry {
+namespace retrieval {
+
+namespace {
+// RetrievePairs 中每个任务查询的影像数
+constexpr size_t kQueryChunkSize = 64;
+constexpr uint32_t kNoImage = std::numeric_limits<uint32_t>::max();
+} // namespace
+
+ImageIndex::ImageIndex(const VocabularyTree *vocabulary, const ImageIndexOptions &options)
+    : vocabulary_(vocabulary), options_(options) {
+  if (vocabulary_ == nullptr || vocabulary_->empty()) {
+    throw std::invalid_argument("Image index requires a trained vocabulary");
+  }
+  if (!options_.Check()) {
+    throw std::invalid_argument("Invalid image index options");
+  }
+  thread_pool_ = std::make_unique<utils::ThreadPool>(options_.num_threads);
+}
+
+void ImageIndex::AddImage(const image_t image_id, const feature::FeatureDescriptors &descriptors) {
+  AddWords(image_id, vocabulary_->Quantize(descriptors));
+}
+
+void ImageIndex::AddImages(const std::vector<feature::FeatureDescriptors> &descriptors) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("retrieval/add_images");
+  // 派发任务前检查全部影像, 出错时索引保持不变
+  for (size_t image_id = 0; image_id < descriptors.size(); ++image_id) {
+    if (descriptors[image_id].type() != vocabulary_->Type() ||
+        descriptors[image_id].dimension() != vocabulary_->Dimension()) {
+      throw std::invalid_argument("Descriptors do not match the vocabulary");
+    }
+    if (image_indices_.count(static_cast<image_t>(image_id)) > 0) {
+      throw std::invalid_argument("Image " + std::to_string(image_id) + " is already indexed");
+    }
+  }
+  std::vector<std::future<std::vector<word_t>>> futures;
+  futures.reserve(descriptors.size());
+  for (const feature::FeatureDescriptors &image_descriptors : descriptors) {
+    futures.push_back(thread_pool_->AddTask(
+        [this, &image_descriptors]() { return vocabulary_->Quantize(image_descriptors); }));
+  }
+  // 等待全部任务结束并取得全部结果后再加入索引, 任一任务出错时索引保持不变
+  for (std::future<std::vector<word_t>> &future : futures) {
+    future.wait();
+  }
+  std::vector<std::vector<word_t>> words(futures.size());
+  for (size_t image_id = 0; image_id < futures.size(); ++image_id) {
+    words[image_id] = futures[image_id].get();
+  }
+  for (size_t image_id = 0; image_id < words.size(); ++image_id) {
+    AddWords(static_cast<image_t>(image_id), std::move(words[image_id]));
+  }
+}
+
+void ImageIndex::AddWords(const image_t image_id, std::vector<word_t> words) {
+  if (!image_indices_.try_emplace(image_id, static_cast<uint32_t>(image_ids_.size())).second) {
+    throw std::invalid_argument("Image " + std::to_string(image_id) + " is already indexed");
+  }
+  std::sort(words.begin(), words.end());
+  image_ids_.push_back(image_id);
+  image_words_.push_back(std::move(words));
+}
+
+void ImageIndex::Finalize() {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("retrieval/finalize");
+  const size_t num_words = vocabulary_->NumWords();
+  const size_t num_images = image_ids_.size();
+
+  // 包含各单词的影像数
+  std::vector<uint32_t> document_frequency(num_words, 0);
+  for (const std::vector<word_t> &words : image_words_) {
+    for (size_t i = 0; i < words.size(); ++i) {
+      if (i == 0 || words[i] != words[i - 1]) {
+        ++document_frequency[words[i]];
+      }
+    }
+  }
+  idf_.assign(num_words, 0.0f);
+  for (size_t w = 0; w < num_words; ++w) {
+    if (document_frequency[w] > 0) {
+      idf_[w] = static_cast<float>(std::log(double(num_images) / document_frequency[w]));
+    }
+  }
+
+  std::vector<WeightedWords> weighted(num_images);
+  posting_offsets_.assign(num_words + 1, 0);
+  for (size_t i = 0; i < num_images; ++i) {
+    weighted[i] = Weigh(image_words_[i]);
+    for (const auto &word : weighted[i]) {
+      ++posting_offsets_[word.first + 1];
+    }
+  }
+  for (size_t w = 0; w < num_words; ++w) {
+    posting_offsets_[w + 1] += posting_offsets_[w];
+  }
+  postings_.resize(posting_offsets_.back());
+  std::vector<uint32_t> next(posting_offsets_.begin(), posting_offsets_.end() - 1);
+  for (size_t i = 0; i < num_images; ++i) {
+    for (const auto &word : weighted[i]) {
+      postings_[next[word.first]++] = {static_cast<uint32_t>(i), word.second};
+    }
+  }
+  num_finalized_images_ = num_images;
+}
+
+ImageIndex::WeightedWords ImageIndex::Weigh(std::vector<word_t> words) const {
+  std::sort(words.begin(), words.end());
+  WeightedWords weighted;
+  double squared_norm = 0.0;
+  for (size_t begin = 0, end = 0; begin < words.size(); begin = end) {
+    while (end < words.size() && words[end] == words[begin]) {
+      ++end;
+    }
+    // 单词频率乘 IDF, 出现在所有影像中的单词权重为 0, 不参与计算
+    const float weight = static_cast<float>(end - begin) * idf_[words[begin]];
+    if (weight > 0.0f) {
+      weighted.emplace_back(words[begin], weight);
+      squared_norm += double(weight) * weight;
+    }
+  }
+  const float scale = squared_norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(squared_norm)) : 0.0f;
+  for (auto &word : weighted) {
+    word.second *= scale;
+  }
+  return weighted;
+}
+
+std::vector<ImageScore> ImageIndex::Score(const WeightedWords &query, const int num_neighbors,
+                                          const uint32_t exclude,
+                                          std::vector<float> *scores) const {
+  std::vector<uint32_t> touched;
+  for (const auto &word : query) {
+    for (uint32_t p = posting_offsets_[word.first]; p < posting_offsets_[word.first + 1]; ++p) {
+      const Posting &posting = postings_[p];
+      float &score = (*scores)[posting.image_index];
+      if (score == 0.0f) {
+        touched.push_back(posting.image_index);
+      }
+      score += word.second * posting.weight;
+    }
+  }
+
+  std::vector<ImageScore> result;
+  result.reserve(touched.size());
+  for (const uint32_t image_index : touched) {
+    if (image_index != exclude) {
+      result.push_back({image_ids_[image_index], (*scores)[image_index]});
+    }
+    (*scores)[image_index] = 0.0f;
+  }
+  const size_t num_results = std::min(result.size(), static_cast<size_t>(num_neighbors));
+  std::partial_sort(result.begin(), result.begin() + num_results, result.end(),
+                    [](const ImageScore &a, const ImageScore &b) {
+                      return a.score > b.score || (a.score == b.score && a.image_id < b.image_id);
+                    });
+  result.resize(num_results);
+  return result;
+}
+
+std::vector<ImageScore> ImageIndex::Query(const feature::FeatureDescriptors &descriptors,
+                                          const int num_neighbors) const {
+  CheckFinalized();
+  std::vector<float> scores(num_finalized_images_, 0.0f);
+  return Score(Weigh(vocabulary_->Quantize(descriptors)), num_neighbors, kNoImage, &scores);
+}
+
+std::vector<Pair> ImageIndex::RetrievePairs() const {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("retrieval/retrieve_pairs");
+  CheckFinalized();
+  const size_t num_images = num_finalized_images_;
+  std::vector<std::future<std::vector<Pair>>> futures;
+  for (size_t begin = 0; begin < num_images; begin += kQueryChunkSize) {
+    const size_t end = std::min(begin + kQueryChunkSize, num_images);
+    futures.push_back(thread_pool_->AddTask([this, begin, end, num_images]() {
+      std::vector<float> scores(num_images, 0.0f);
+      std::vector<Pair> pairs;
+      for (size_t i = begin; i < end; ++i) {
+        for (const ImageScore &neighbor : Score(Weigh(image_words_[i]), options_.num_neighbors,
+                                                static_cast<uint32_t>(i), &scores)) {
+          pairs.emplace_back(std::min(image_ids_[i], neighbor.image_id),
+                             std::max(image_ids_[i], neighbor.image_id));
+        }
+      }
+      return pairs;
+    }));
+  }
+  std::vector<Pair> pairs;
+  for (std::future<std::vector<Pair>> &future : futures) {
+    const std::vector<Pair> chunk_pairs = future.get();
+    pairs.insert(pairs.end(), chunk_pairs.begin(), chunk_pairs.end());
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  PHOTOGRAMMETRY_PROFILE_COUNT("retrieval/pairs", pairs.size());
+  return pairs;
+}
+
+void ImageIndex::CheckFinalized() const {
+  if (num_finalized_images_ != image_ids_.size()) {
+    throw std::runtime_error("Image index must be finalized after adding images");
+  }
+}
+
+} // namespace retrieval
+} // namespace photogrammetry
@@ -0,0 +1,112 @@
+#ifndef PHOTOGRAMMETRY_RETRIEVAL_IMAGE_INDEX_HPP
+#define PHOTOGRAMMETRY_RETRIEVAL_IMAGE_INDEX_HPP
+
+#include "camera/std_types.hpp"
+#include "feature/types.hpp"
+#include "retrieval/vocabulary_tree.hpp"
+#include "utils/thread_pool.hpp"
+#include <memory>
+#include <vector>
+
+namespace photogrammetry {
+namespace retrieval {
+
+struct ImageScore {
+  image_t image_id = UINvaliedImageId;
+  float score = 0.0f;
+};
+
+struct ImageIndexOptions {
+  // RetrievePairs 中每张影像保留的最相似影像数
+  int num_neighbors = 50;
+  // 量化与查询的线程数, -1 表示使用全部硬件线程
+  int num_threads = -1;
+
+  bool Check() const { return num_neighbors > 0; }
+};
+
+/*
+ * @brief 基于 TF-IDF 倒排文件的影像检索
+ * 每张影像表示为单词频率乘 IDF 并归一化的稀疏向量, 两张影像的相似度为向量的点积, 只需遍历
+ * 查询影像中各单词的倒排列表。倒排列表按单词连续存放(CSR)。
+ * 用法: AddImage/AddImages 加入影像, Finalize 计算 IDF 并建立倒排文件, 然后查询。
+ * Finalize 之后可以继续加入影像, 再次 Finalize 后生效。查询可以被多个线程同时调用。
+ */
+class ImageIndex {
+public:
+  /*
+   * @param vocabulary 词汇树, 必须在索引的生命期内有效
+   */
+  explicit ImageIndex(const VocabularyTree *vocabulary,
+                      const ImageIndexOptions &options = ImageIndexOptions());
+
+  ImageIndex(const ImageIndex &) = delete;
+  ImageIndex &operator=(const ImageIndex &) = delete;
+
+  // 量化并加入一张影像, 重复的 image_id 抛出 std::invalid_argument
+  void AddImage(image_t image_id, const feature::FeatureDescriptors &descriptors);
+
+  // 在线程池中并行量化并加入全部影像, descriptors 以 image_t 为下标
+  // 描述子与词汇树不匹配或 image_id 已存在时抛出 std::invalid_argument, 索引保持不变
+  void AddImages(const std::vector<feature::FeatureDescriptors> &descriptors);
+
+  // 计算 IDF 权重与各影像的向量, 建立倒排文件
+  void Finalize();
+
+  /*
+   * @brief 查询与一组描述子最相似的影像
+   * @return 至多 num_neighbors 个影像, 按相似度从大到小排列, 不含相似度为 0 的影像
+   */
+  std::vector<ImageScore> Query(const feature::FeatureDescriptors &descriptors,
+                                int num_neighbors) const;
+
+  /*
+   * @brief 对每张加入的影像并行查询 num_neighbors 个最相似的影像, 得到待匹配的影像对
+   * @return 去重后的影像对, 较小的 id 在前, 按 id 排序
+   */
+  std::vector<Pair> RetrievePairs() const;
+
+  size_t NumImages() const { return image_ids_.size(); }
+
+private:
+  struct Posting {
+    uint32_t image_index;
+    float weight;
+  };
+
+  // 单词及其权重, 按单词排序
+  typedef std::vector<std::pair<word_t, float>> WeightedWords;
+
+  void AddWords(image_t image_id, std::vector<word_t> words);
+  WeightedWords Weigh(std::vector<word_t> words) const;
+
+  /*
+   * @brief 按倒排文件累加相似度并取前 num_neighbors 个
+   * @param scores 长度为影像数的临时数组, 调用前后全为 0
+   * @param exclude 不参与排序的影像下标, 用于排除查询影像自身
+   */
+  std::vector<ImageScore> Score(const WeightedWords &query, int num_neighbors, uint32_t exclude,
+                                std::vector<float> *scores) const;
+
+  void CheckFinalized() const;
+
+  const VocabularyTree *vocabulary_;
+  ImageIndexOptions options_;
+  std::unique_ptr<utils::ThreadPool> thread_pool_;
+
+  std::vector<image_t> image_ids_;
+  Flat_Hash_Map<image_t, uint32_t> image_indices_;
+  // 每张影像的单词, 按单词排序
+  std::vector<std::vector<word_t>> image_words_;
+
+  // Finalize 之后有效
+  size_t num_finalized_images_ = 0;
+  std::vector<float> idf_;
+  std::vector<uint32_t> posting_offsets_;
+  std::vector<Posting> postings_;
+};
+
+} // namespace retrieval
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_RETRIEVAL_IMAGE_INDEX_HPP
@@ -0,0 +1,63 @@
+#include "retrieval/image_index.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+using namespace photogrammetry::retrieval;
+
+namespace {
+FeatureDescriptors RandomDescriptors(const size_t num_rows, std::mt19937 *rng) {
+  FeatureDescriptors descriptors(DescriptorType::BINARY, 32, num_rows);
+  for (size_t i = 0; i < num_rows; ++i) {
+    for (int j = 0; j < 32; ++j) {
+      descriptors.Row<uint8_t>(i)[j] = static_cast<uint8_t>((*rng)());
+    }
+  }
+  return descriptors;
+}
+
+// Vocabulary of 10^4 words trained once and shared by all benchmarks
+const VocabularyTree &Vocabulary() {
+  static const VocabularyTree vocabulary = []() {
+    std::mt19937 rng(1);
+    VocabularyTreeOptions options;
+    options.depth = 4;
+    return VocabularyTree::Train(RandomDescriptors(100000, &rng), options);
+  }();
+  return vocabulary;
+}
+} // namespace
+
+static void BM_Quantize(benchmark::State &state) {
+  std::mt19937 rng(2);
+  const FeatureDescriptors descriptors = RandomDescriptors(8192, &rng);
+  const VocabularyTree &vocabulary = Vocabulary();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(vocabulary.Quantize(descriptors));
+  }
+  state.SetItemsProcessed(state.iterations() * descriptors.size());
+}
+BENCHMARK(BM_Quantize)->Unit(benchmark::kMillisecond);
+
+// Top-k queries for every image of the index, compared to state.range(0)^2 / 2 exhaustive pairs
+static void BM_RetrievePairs(benchmark::State &state) {
+  std::mt19937 rng(3);
+  std::vector<FeatureDescriptors> images;
+  for (int i = 0; i < state.range(0); ++i) {
+    images.push_back(RandomDescriptors(1000, &rng));
+  }
+  ImageIndexOptions options;
+  options.num_neighbors = 20;
+  ImageIndex index(&Vocabulary(), options);
+  index.AddImages(images);
+  index.Finalize();
+  size_t num_pairs = 0;
+  for (auto _ : state) {
+    num_pairs = index.RetrievePairs().size();
+  }
+  state.counters["pairs"] = static_cast<double>(num_pairs);
+  state.counters["images/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * images.size()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RetrievePairs)->Arg(1000)->Arg(4000)->Unit(benchmark::kMillisecond)->UseRealTime();
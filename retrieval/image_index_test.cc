@@ -0,0 +1,130 @@
+#include "retrieval/image_index.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+using namespace photogrammetry::retrieval;
+
+namespace {
+
+FeatureDescriptors RandomDescriptors(const size_t num_rows, std::mt19937 *rng) {
+  FeatureDescriptors descriptors(DescriptorType::BINARY, 32, num_rows);
+  for (size_t i = 0; i < num_rows; ++i) {
+    for (int j = 0; j < 32; ++j) {
+      descriptors.Row<uint8_t>(i)[j] = static_cast<uint8_t>((*rng)());
+    }
+  }
+  return descriptors;
+}
+
+/*
+ * 沿一条航线拍摄的影像: 场景由 num_images + 1 段组成, 第 i 张影像看到第 i 与 i + 1 段,
+ * 相邻影像共享一段的描述子。
+ */
+std::vector<FeatureDescriptors> MakeStrip(const size_t num_images, std::mt19937 *rng) {
+  std::vector<FeatureDescriptors> segments;
+  for (size_t i = 0; i <= num_images; ++i) {
+    segments.push_back(RandomDescriptors(100, rng));
+  }
+  std::vector<FeatureDescriptors> images;
+  for (size_t i = 0; i < num_images; ++i) {
+    FeatureDescriptors descriptors(DescriptorType::BINARY, 32, 200);
+    std::copy(segments[i].data(), segments[i].data() + 100 * 32, descriptors.Row<uint8_t>(0));
+    std::copy(segments[i + 1].data(), segments[i + 1].data() + 100 * 32,
+              descriptors.Row<uint8_t>(100));
+    images.push_back(std::move(descriptors));
+  }
+  return images;
+}
+
+FeatureDescriptors Concatenate(const std::vector<FeatureDescriptors> &images) {
+  size_t num_rows = 0;
+  for (const FeatureDescriptors &descriptors : images) {
+    num_rows += descriptors.size();
+  }
+  FeatureDescriptors all(DescriptorType::BINARY, 32, num_rows);
+  uint8_t *out = all.data();
+  for (const FeatureDescriptors &descriptors : images) {
+    out = std::copy(descriptors.data(), descriptors.data() + descriptors.size() * 32, out);
+  }
+  return all;
+}
+
+} // namespace
+
+TEST(ImageIndexTest, RetrievesOverlappingImages) {
+  std::mt19937 rng(1);
+  const std::vector<FeatureDescriptors> images = MakeStrip(40, &rng);
+  VocabularyTreeOptions tree_options;
+  tree_options.branching = 8;
+  tree_options.depth = 4;
+  const VocabularyTree vocabulary = VocabularyTree::Train(Concatenate(images), tree_options);
+
+  ImageIndexOptions options;
+  options.num_neighbors = 2;
+  options.num_threads = 2;
+  ImageIndex index(&vocabulary, options);
+  index.AddImages(images);
+  EXPECT_THROW(index.RetrievePairs(), std::runtime_error);
+  index.Finalize();
+  EXPECT_EQ(index.NumImages(), 40u);
+
+  const std::vector<ImageScore> scores = index.Query(images[10], 3);
+  ASSERT_EQ(scores.size(), 3u);
+  EXPECT_EQ(scores[0].image_id, 10u);
+  EXPECT_NEAR(scores[0].score, 1.0f, 1e-4f);
+  EXPECT_TRUE((scores[1].image_id == 9 && scores[2].image_id == 11) ||
+              (scores[1].image_id == 11 && scores[2].image_id == 9));
+
+  // 中间影像的两个最相似影像就是相邻影像, 两端的影像各多一对, 而穷举为 780 对
+  const std::vector<Pair> pairs = index.RetrievePairs();
+  EXPECT_LE(pairs.size(), 41u);
+  EXPECT_TRUE(std::is_sorted(pairs.begin(), pairs.end()));
+  for (image_t i = 0; i < 39; ++i) {
+    EXPECT_TRUE(std::binary_search(pairs.begin(), pairs.end(), Pair(i, i + 1))) << i;
+  }
+}
+
+TEST(ImageIndexTest, FailedAddImagesLeavesIndexUnchanged) {
+  std::mt19937 rng(3);
+  std::vector<FeatureDescriptors> images = MakeStrip(8, &rng);
+  const VocabularyTree vocabulary = VocabularyTree::Train(Concatenate(images));
+  ImageIndexOptions options;
+  options.num_threads = 4;
+  ImageIndex index(&vocabulary, options);
+
+  // 最后一张影像的描述子类型与词汇树不一致
+  const FeatureDescriptors last = images.back();
+  images.back() = FeatureDescriptors(DescriptorType::FLOAT32, 32, 10);
+  EXPECT_THROW(index.AddImages(images), std::invalid_argument);
+  images.back() = last;
+  index.AddImages(images);
+  EXPECT_THROW(index.AddImages(images), std::invalid_argument);
+  index.Finalize();
+  const std::vector<ImageScore> scores = index.Query(images[7], 1);
+  ASSERT_EQ(scores.size(), 1u);
+  EXPECT_EQ(scores[0].image_id, 7u);
+}
+
+TEST(ImageIndexTest, IncrementalAdditions) {
+  std::mt19937 rng(2);
+  const std::vector<FeatureDescriptors> images = MakeStrip(6, &rng);
+  const VocabularyTree vocabulary = VocabularyTree::Train(Concatenate(images));
+  ImageIndex index(&vocabulary);
+  for (image_t image_id = 0; image_id < 3; ++image_id) {
+    index.AddImage(100 + image_id, images[image_id]);
+  }
+  EXPECT_THROW(index.AddImage(100, images[0]), std::invalid_argument);
+  index.Finalize();
+  EXPECT_LE(index.Query(images[5], 5).size(), 3u);
+
+  index.AddImage(105, images[5]);
+  EXPECT_THROW(index.Query(images[5], 5), std::runtime_error);
+  index.Finalize();
+  const std::vector<ImageScore> scores = index.Query(images[5], 5);
+  ASSERT_FALSE(scores.empty());
+  EXPECT_EQ(scores[0].image_id, 105u);
+  EXPECT_NEAR(scores[0].score, 1.0f, 1e-4f);
+}
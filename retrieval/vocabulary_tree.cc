@@ -0,0 +1,339 @@
+#include "retrieval/vocabulary_tree.hpp"
+#include "matching/distance.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+namespace photogrammetry {
+namespace retrieval {
+
+using feature::DescriptorType;
+using feature::FeatureDescriptors;
+
+/*
+ * 文件与内存布局(小端): Header | Node[num_nodes] | 中心[num_nodes][stride]
+ * 节点数组与中心数组的起点按 kAlignment 对齐, 根节点的中心不使用。
+ */
+struct VocabularyTree::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t type;
+  uint32_t dimension;
+  uint32_t stride;
+  uint32_t num_nodes;
+  uint32_t num_words;
+  uint64_t nodes_offset;
+  uint64_t centers_offset;
+  uint64_t size;
+};
+
+// 叶子节点的 num_children 为 0, first_child 为单词编号
+struct VocabularyTree::Node {
+  uint32_t first_child;
+  uint32_t num_children;
+};
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'G', 'V', 'O', 'C', 'A', 'B', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kAlignment = 64;
+
+size_t AlignUp(const size_t offset) { return (offset + kAlignment - 1) / kAlignment * kAlignment; }
+
+// 与 FeatureDescriptors 一致的行距, 中心与查询描述子按相同行距参与距离计算
+size_t RowStride(const DescriptorType type, const size_t dimension) {
+  const size_t element_size = type == DescriptorType::BINARY ? 1 : sizeof(float);
+  return (dimension * element_size + FeatureDescriptors::kRowAlignment - 1) /
+         FeatureDescriptors::kRowAlignment * FeatureDescriptors::kRowAlignment;
+}
+
+// 二值描述子为 Hamming 距离, 浮点描述子为欧氏距离的平方
+float Distance(const DescriptorType type, const uint8_t *a, const uint8_t *b, const int dimension,
+               const size_t stride) {
+  if (type == DescriptorType::BINARY) {
+    return static_cast<float>(matching::HammingDistance(a, b, stride));
+  }
+  return matching::SquaredL2Distance(reinterpret_cast<const float *>(a),
+                                     reinterpret_cast<const float *>(b), dimension);
+}
+
+/*
+ * @brief 对 members 中的描述子做 k-means
+ * 初始中心为随机选取的 k 个不同描述子, 二值描述子的中心取各位的多数。
+ * @param centers 输出 k 个中心, 每个占 stride 字节
+ * @param assignment 输出每个成员所属的类
+ */
+void KMeans(const FeatureDescriptors &descriptors, const std::vector<uint32_t> &members,
+            const int k, const int max_iterations, const uint32_t seed,
+            [[maybe_unused]] const int num_threads, utils::AlignedVector<uint8_t, 64> *centers,
+            std::vector<int> *assignment) {
+  const DescriptorType type = descriptors.type();
+  const int dimension = descriptors.dimension();
+  const size_t stride = descriptors.stride();
+  const int num_members = static_cast<int>(members.size());
+
+  std::vector<uint32_t> shuffled(members);
+  std::mt19937 rng(seed);
+  for (int c = 0; c < k; ++c) {
+    std::swap(shuffled[c], shuffled[c + rng() % (num_members - c)]);
+  }
+  centers->assign(k * stride, 0);
+  for (int c = 0; c < k; ++c) {
+    std::memcpy(centers->data() + c * stride, descriptors.Row<uint8_t>(shuffled[c]), stride);
+  }
+
+  assignment->assign(num_members, -1);
+  const int num_bits = dimension * 8;
+  std::vector<double> sums(static_cast<size_t>(k) * (type == DescriptorType::BINARY ? num_bits
+                                                                                    : dimension));
+  std::vector<int> counts(k);
+  for (int iteration = 0; iteration < max_iterations; ++iteration) {
+    int num_changed = 0;
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp parallel for schedule(static) num_threads(num_threads) reduction(+ : num_changed) \
+    if (num_members > 1024)
+#endif
+    for (int i = 0; i < num_members; ++i) {
+      const uint8_t *row = descriptors.Row<uint8_t>(members[i]);
+      int best = 0;
+      float best_distance = Distance(type, row, centers->data(), dimension, stride);
+      for (int c = 1; c < k; ++c) {
+        const float distance = Distance(type, row, centers->data() + c * stride, dimension, stride);
+        if (distance < best_distance) {
+          best = c;
+          best_distance = distance;
+        }
+      }
+      num_changed += (*assignment)[i] != best ? 1 : 0;
+      (*assignment)[i] = best;
+    }
+    if (num_changed == 0) {
+      break;
+    }
+
+    // 空的类保持原来的中心
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(counts.begin(), counts.end(), 0);
+    if (type == DescriptorType::BINARY) {
+      for (int i = 0; i < num_members; ++i) {
+        const uint8_t *row = descriptors.Row<uint8_t>(members[i]);
+        double *bits = sums.data() + static_cast<size_t>((*assignment)[i]) * num_bits;
+        for (int b = 0; b < num_bits; ++b) {
+          bits[b] += (row[b >> 3] >> (b & 7)) & 1;
+        }
+        ++counts[(*assignment)[i]];
+      }
+      for (int c = 0; c < k; ++c) {
+        if (counts[c] == 0) {
+          continue;
+        }
+        uint8_t *center = centers->data() + c * stride;
+        std::fill(center, center + stride, 0);
+        const double *bits = sums.data() + static_cast<size_t>(c) * num_bits;
+        for (int b = 0; b < num_bits; ++b) {
+          if (2 * bits[b] > counts[c]) {
+            center[b >> 3] |= static_cast<uint8_t>(1 << (b & 7));
+          }
+        }
+      }
+    } else {
+      for (int i = 0; i < num_members; ++i) {
+        const float *row = descriptors.Row<float>(members[i]);
+        double *sum = sums.data() + static_cast<size_t>((*assignment)[i]) * dimension;
+        for (int d = 0; d < dimension; ++d) {
+          sum[d] += row[d];
+        }
+        ++counts[(*assignment)[i]];
+      }
+      for (int c = 0; c < k; ++c) {
+        if (counts[c] == 0) {
+          continue;
+        }
+        float *center = reinterpret_cast<float *>(centers->data() + c * stride);
+        const double *sum = sums.data() + static_cast<size_t>(c) * dimension;
+        for (int d = 0; d < dimension; ++d) {
+          center[d] = static_cast<float>(sum[d] / counts[c]);
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+VocabularyTree VocabularyTree::Train(const FeatureDescriptors &descriptors,
+                                     const VocabularyTreeOptions &options) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("retrieval/train_vocabulary");
+  if (!options.Check()) {
+    throw std::invalid_argument("Invalid vocabulary tree options");
+  }
+  if (descriptors.empty()) {
+    throw std::invalid_argument("Cannot train a vocabulary without descriptors");
+  }
+  const size_t stride = descriptors.stride();
+  const int num_threads = utils::GetEffectiveNumThreads(options.num_threads);
+
+  // 按层次顺序训练, 使同一节点的子节点连续
+  struct Pending {
+    uint32_t node;
+    int level;
+    std::vector<uint32_t> members;
+  };
+  std::vector<Node> nodes(1);
+  utils::AlignedVector<uint8_t, 64> centers(stride, 0);
+  uint32_t num_words = 0;
+  std::queue<Pending> pending;
+  pending.push({0, 0, std::vector<uint32_t>(descriptors.size())});
+  std::iota(pending.front().members.begin(), pending.front().members.end(), 0u);
+
+  utils::AlignedVector<uint8_t, 64> cluster_centers;
+  std::vector<int> assignment;
+  while (!pending.empty()) {
+    Pending item = std::move(pending.front());
+    pending.pop();
+    if (item.level == options.depth || item.members.size() <= size_t(options.branching)) {
+      nodes[item.node] = {num_words++, 0};
+      continue;
+    }
+    KMeans(descriptors, item.members, options.branching, options.max_iterations, item.node,
+           num_threads, &cluster_centers, &assignment);
+    std::vector<std::vector<uint32_t>> clusters(options.branching);
+    for (size_t i = 0; i < item.members.size(); ++i) {
+      clusters[assignment[i]].push_back(item.members[i]);
+    }
+    const uint32_t first_child = static_cast<uint32_t>(nodes.size());
+    for (int c = 0; c < options.branching; ++c) {
+      if (clusters[c].empty()) {
+        continue;
+      }
+      const uint32_t child = static_cast<uint32_t>(nodes.size());
+      nodes.push_back({0, 0});
+      centers.insert(centers.end(), cluster_centers.begin() + c * stride,
+                     cluster_centers.begin() + (c + 1) * stride);
+      pending.push({child, item.level + 1, std::move(clusters[c])});
+    }
+    nodes[item.node] = {first_child, static_cast<uint32_t>(nodes.size()) - first_child};
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.type = static_cast<uint32_t>(descriptors.type());
+  header.dimension = static_cast<uint32_t>(descriptors.dimension());
+  header.stride = static_cast<uint32_t>(stride);
+  header.num_nodes = static_cast<uint32_t>(nodes.size());
+  header.num_words = num_words;
+  header.nodes_offset = AlignUp(sizeof(Header));
+  header.centers_offset = AlignUp(header.nodes_offset + nodes.size() * sizeof(Node));
+  header.size = header.centers_offset + centers.size();
+
+  VocabularyTree tree;
+  tree.buffer_.assign(header.size, 0);
+  std::memcpy(tree.buffer_.data(), &header, sizeof(Header));
+  std::memcpy(tree.buffer_.data() + header.nodes_offset, nodes.data(),
+              nodes.size() * sizeof(Node));
+  std::memcpy(tree.buffer_.data() + header.centers_offset, centers.data(), centers.size());
+  tree.Attach(tree.buffer_.data(), tree.buffer_.size());
+  return tree;
+}
+
+void VocabularyTree::Write(const std::string &path) const {
+  if (empty()) {
+    throw std::runtime_error("Cannot write an empty vocabulary tree");
+  }
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char *>(header_), header_->size);
+  if (!file) {
+    throw std::runtime_error("Failed to write vocabulary tree to " + path);
+  }
+}
+
+VocabularyTree VocabularyTree::Read(const std::string &path) {
+  VocabularyTree tree;
+  tree.mapped_ = std::make_unique<utils::MappedFile>(path);
+  tree.Attach(tree.mapped_->data(), tree.mapped_->size());
+  return tree;
+}
+
+void VocabularyTree::Attach(const uint8_t *data, const size_t size) {
+  const Header *header = reinterpret_cast<const Header *>(data);
+  if (size < sizeof(Header) || std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion || header->size != size || header->num_nodes == 0 ||
+      header->nodes_offset + header->num_nodes * sizeof(Node) > header->centers_offset ||
+      header->centers_offset + size_t(header->num_nodes) * header->stride != size ||
+      header->nodes_offset % kAlignment != 0 || header->centers_offset % kAlignment != 0 ||
+      header->type > static_cast<uint32_t>(DescriptorType::FLOAT32) || header->dimension == 0 ||
+      header->stride !=
+          RowStride(static_cast<DescriptorType>(header->type), header->dimension)) {
+    throw std::runtime_error("Invalid vocabulary tree data");
+  }
+  const Node *nodes = reinterpret_cast<const Node *>(data + header->nodes_offset);
+  for (uint32_t i = 0; i < header->num_nodes; ++i) {
+    const bool valid = nodes[i].num_children == 0
+                           ? nodes[i].first_child < header->num_words
+                           : nodes[i].first_child > i && nodes[i].first_child < header->num_nodes &&
+                                 nodes[i].num_children <= header->num_nodes - nodes[i].first_child;
+    if (!valid) {
+      throw std::runtime_error("Invalid vocabulary tree data");
+    }
+  }
+  header_ = header;
+  nodes_ = nodes;
+  centers_ = data + header->centers_offset;
+}
+
+word_t VocabularyTree::Quantize(const uint8_t *descriptor) const {
+  const DescriptorType type = Type();
+  const int dimension = header_->dimension;
+  const size_t stride = header_->stride;
+  uint32_t node = 0;
+  while (nodes_[node].num_children > 0) {
+    const uint32_t first = nodes_[node].first_child;
+    uint32_t best = first;
+    float best_distance = Distance(type, descriptor, centers_ + first * stride, dimension, stride);
+    for (uint32_t child = first + 1; child < first + nodes_[node].num_children; ++child) {
+      const float distance =
+          Distance(type, descriptor, centers_ + child * stride, dimension, stride);
+      if (distance < best_distance) {
+        best = child;
+        best_distance = distance;
+      }
+    }
+    node = best;
+  }
+  return nodes_[node].first_child;
+}
+
+std::vector<word_t> VocabularyTree::Quantize(const FeatureDescriptors &descriptors) const {
+  if (empty()) {
+    throw std::runtime_error("Vocabulary tree is empty");
+  }
+  if (descriptors.type() != Type() || descriptors.dimension() != Dimension()) {
+    throw std::invalid_argument("Descriptors do not match the vocabulary");
+  }
+  std::vector<word_t> words(descriptors.size());
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    words[i] = Quantize(descriptors.Row<uint8_t>(i));
+  }
+  return words;
+}
+
+size_t VocabularyTree::NumWords() const { return empty() ? 0 : header_->num_words; }
+
+size_t VocabularyTree::NumNodes() const { return empty() ? 0 : header_->num_nodes; }
+
+DescriptorType VocabularyTree::Type() const {
+  return empty() ? DescriptorType::BINARY : static_cast<DescriptorType>(header_->type);
+}
+
+int VocabularyTree::Dimension() const { return empty() ? 0 : static_cast<int>(header_->dimension); }
+
+} // namespace retrieval
+} // namespace photogrammetry
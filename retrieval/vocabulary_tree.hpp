@@ -0,0 +1,93 @@
+#ifndef PHOTOGRAMMETRY_RETRIEVAL_VOCABULARY_TREE_HPP
+#define PHOTOGRAMMETRY_RETRIEVAL_VOCABULARY_TREE_HPP
+
+#include "feature/types.hpp"
+#include "utils/aligned_allocator.hpp"
+#include "utils/mapped_file.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace photogrammetry {
+namespace retrieval {
+
+// 视觉单词编号
+typedef uint32_t word_t;
+
+struct VocabularyTreeOptions {
+  // 每个节点的子节点数与树的层数, 单词数最多为 branching^depth
+  int branching = 10;
+  int depth = 5;
+  // 每个节点 k-means 的迭代次数
+  int max_iterations = 10;
+  // 训练时计算聚类分配的线程数, -1 表示使用全部硬件线程
+  int num_threads = -1;
+
+  bool Check() const {
+    return branching >= 2 && depth >= 1 && max_iterations >= 1 && branching <= 256;
+  }
+};
+
+/*
+ * @brief 视觉词汇树
+ * 由层次 k-means 训练: 每个节点把分到它的描述子聚成 branching 类, 递归 depth 层, 叶子为单词。
+ * 二值描述子的聚类中心为各位的多数(k-majority), 用 Hamming 距离; 浮点描述子用均值与欧氏距离。
+ * 一个节点的子节点连续存放, 它们的中心也连续存放, 量化一个描述子只需从根向下 depth 次比较
+ * branching 个相邻的中心。
+ * 树以一块连续内存保存, 文件内容与内存布局相同, Read 通过内存映射打开文件, 不需要解析或复制。
+ */
+class VocabularyTree {
+public:
+  VocabularyTree() = default;
+
+  VocabularyTree(VocabularyTree &&) = default;
+  VocabularyTree &operator=(VocabularyTree &&) = default;
+  VocabularyTree(const VocabularyTree &) = delete;
+  VocabularyTree &operator=(const VocabularyTree &) = delete;
+
+  /*
+   * @brief 训练词汇树
+   * @param descriptors 训练用的描述子, 通常从各影像中抽样
+   * @throw std::invalid_argument 参数无效或没有描述子
+   */
+  static VocabularyTree Train(const feature::FeatureDescriptors &descriptors,
+                              const VocabularyTreeOptions &options = VocabularyTreeOptions());
+
+  // 写入文件, 失败时抛出 std::runtime_error
+  void Write(const std::string &path) const;
+
+  // 以内存映射方式打开 Write 写入的文件, 格式不符时抛出 std::runtime_error
+  static VocabularyTree Read(const std::string &path);
+
+  // 量化一个描述子, 行的格式与训练用的描述子相同
+  word_t Quantize(const uint8_t *descriptor) const;
+
+  // 量化一组描述子
+  std::vector<word_t> Quantize(const feature::FeatureDescriptors &descriptors) const;
+
+  bool empty() const { return nodes_ == nullptr; }
+  size_t NumWords() const;
+  size_t NumNodes() const;
+  feature::DescriptorType Type() const;
+  int Dimension() const;
+
+private:
+  struct Header;
+  struct Node;
+
+  // 检查 data 中的头部并设置各数组的指针
+  void Attach(const uint8_t *data, size_t size);
+
+  // 训练得到的树保存在 buffer_ 中, 读取的树保存在 mapped_ 中
+  utils::AlignedVector<uint8_t, 64> buffer_;
+  std::unique_ptr<utils::MappedFile> mapped_;
+  const Header *header_ = nullptr;
+  const Node *nodes_ = nullptr;
+  const uint8_t *centers_ = nullptr;
+};
+
+} // namespace retrieval
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_RETRIEVAL_VOCABULARY_TREE_HPP
@@ -0,0 +1,142 @@
+#include "retrieval/vocabulary_tree.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+
+using namespace photogrammetry;
+using namespace photogrammetry::feature;
+using namespace photogrammetry::retrieval;
+
+namespace {
+
+// 围绕 num_clusters 个随机中心的描述子, 二值描述子翻转少量位, 浮点描述子加少量噪声
+FeatureDescriptors ClusteredDescriptors(const DescriptorType type, const int num_clusters,
+                                        const int per_cluster, std::mt19937 *rng) {
+  const int dimension = type == DescriptorType::BINARY ? 32 : 64;
+  FeatureDescriptors centers(type, dimension, num_clusters);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  for (int c = 0; c < num_clusters; ++c) {
+    for (int j = 0; j < dimension; ++j) {
+      if (type == DescriptorType::BINARY) {
+        centers.Row<uint8_t>(c)[j] = static_cast<uint8_t>((*rng)());
+      } else {
+        centers.Row<float>(c)[j] = uniform(*rng);
+      }
+    }
+  }
+  FeatureDescriptors descriptors(type, dimension, num_clusters * per_cluster);
+  for (size_t i = 0; i < descriptors.size(); ++i) {
+    const int c = static_cast<int>(i) % num_clusters;
+    std::copy(centers.Row<uint8_t>(c), centers.Row<uint8_t>(c) + centers.stride(),
+              descriptors.Row<uint8_t>(i));
+    for (int k = 0; k < 4; ++k) {
+      if (type == DescriptorType::BINARY) {
+        const int bit = (*rng)() % 256;
+        descriptors.Row<uint8_t>(i)[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+      } else {
+        descriptors.Row<float>(i)[(*rng)() % dimension] += noise(*rng);
+      }
+    }
+  }
+  return descriptors;
+}
+
+} // namespace
+
+TEST(VocabularyTreeTest, SeparatesClusters) {
+  std::mt19937 rng(1);
+  VocabularyTreeOptions options;
+  options.branching = 4;
+  options.depth = 4;
+  for (const DescriptorType type : {DescriptorType::BINARY, DescriptorType::FLOAT32}) {
+    const FeatureDescriptors descriptors = ClusteredDescriptors(type, 16, 50, &rng);
+    const VocabularyTree tree = VocabularyTree::Train(descriptors, options);
+    EXPECT_EQ(tree.Type(), type);
+    EXPECT_GE(tree.NumWords(), 16u);
+    EXPECT_LE(tree.NumWords(), 256u);
+
+    // 不同类的描述子不落在同一个单词
+    const std::vector<word_t> words = tree.Quantize(descriptors);
+    std::vector<std::set<word_t>> cluster_words(16);
+    for (size_t i = 0; i < words.size(); ++i) {
+      EXPECT_LT(words[i], tree.NumWords());
+      cluster_words[i % 16].insert(words[i]);
+    }
+    std::set<word_t> all_words;
+    size_t num_cluster_words = 0;
+    for (const std::set<word_t> &set : cluster_words) {
+      all_words.insert(set.begin(), set.end());
+      num_cluster_words += set.size();
+    }
+    EXPECT_EQ(all_words.size(), num_cluster_words);
+  }
+}
+
+TEST(VocabularyTreeTest, WriteAndMemoryMappedRead) {
+  std::mt19937 rng(2);
+  const FeatureDescriptors descriptors =
+      ClusteredDescriptors(DescriptorType::BINARY, 100, 20, &rng);
+  const VocabularyTree tree = VocabularyTree::Train(descriptors);
+  const std::string path = ::testing::TempDir() + "vocabulary_tree_test.bin";
+  tree.Write(path);
+
+  const VocabularyTree read = VocabularyTree::Read(path);
+  EXPECT_EQ(read.NumWords(), tree.NumWords());
+  EXPECT_EQ(read.NumNodes(), tree.NumNodes());
+  EXPECT_EQ(read.Dimension(), 32);
+  EXPECT_EQ(read.Quantize(descriptors), tree.Quantize(descriptors));
+
+  // 截断的文件被拒绝
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "PGVOCAB";
+  EXPECT_THROW(VocabularyTree::Read(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+TEST(VocabularyTreeTest, RejectsCorruptRowStride) {
+  std::mt19937 rng(4);
+  const VocabularyTree tree =
+      VocabularyTree::Train(ClusteredDescriptors(DescriptorType::BINARY, 4, 4, &rng));
+  const std::string path = ::testing::TempDir() + "vocabulary_tree_stride_test.bin";
+  tree.Write(path);
+  std::ifstream in(path, std::ios::binary);
+  const std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+  in.close();
+
+  // 文件头中 dimension 位于偏移 16, stride 位于偏移 20, 中心数组起点位于偏移 40, 总大小位于偏移 48
+  const auto write_patched = [&](const uint32_t dimension, const uint32_t stride) {
+    std::vector<char> patched = bytes;
+    uint64_t centers_offset;
+    std::memcpy(&centers_offset, patched.data() + 40, sizeof(centers_offset));
+    const uint64_t size = centers_offset + uint64_t(tree.NumNodes()) * stride;
+    patched.resize(size);
+    std::memcpy(patched.data() + 16, &dimension, sizeof(dimension));
+    std::memcpy(patched.data() + 20, &stride, sizeof(stride));
+    std::memcpy(patched.data() + 48, &size, sizeof(size));
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(patched.data(), patched.size());
+  };
+  // 文件大小与 stride 自洽, 但 stride 小于一行描述子, 或不是 32 字节的整数倍
+  write_patched(33, 32);
+  EXPECT_THROW(VocabularyTree::Read(path), std::runtime_error);
+  write_patched(16, 16);
+  EXPECT_THROW(VocabularyTree::Read(path), std::runtime_error);
+  write_patched(32, 64);
+  EXPECT_THROW(VocabularyTree::Read(path), std::runtime_error);
+  write_patched(32, 32);
+  EXPECT_EQ(VocabularyTree::Read(path).NumWords(), tree.NumWords());
+  std::remove(path.c_str());
+}
+
+TEST(VocabularyTreeTest, RejectsInvalidInput) {
+  EXPECT_THROW(VocabularyTree::Train(FeatureDescriptors(DescriptorType::BINARY, 32)),
+               std::invalid_argument);
+  std::mt19937 rng(3);
+  const VocabularyTree tree =
+      VocabularyTree::Train(ClusteredDescriptors(DescriptorType::BINARY, 4, 4, &rng));
+  EXPECT_THROW(tree.Quantize(FeatureDescriptors(DescriptorType::FLOAT32, 32, 1)),
+               std::invalid_argument);
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Compare two sets of Google Benchmark JSON results and flag regressions.
+
+Each side is either one JSON file written with --benchmark_out_format=json or a
+directory of such files, e.g. the output of the run_benchmarks build target:
+
+    cmake --build build --target run_benchmarks
+    cp -r build/benchmark_results baseline
+    # ... change the code, rebuild ...
+    cmake --build build --target run_benchmarks
+    scripts/compare_benchmarks.py baseline build/benchmark_results --threshold 0.05
+
+When a benchmark was run with repetitions, its median aggregate is compared.
+The exit status is 1 if any benchmark slowed down by more than the threshold,
+or if a baseline benchmark is missing and --fail-on-missing is given.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import sys
+
+
+def load_results(path):
+    """Map benchmark name to its run entry for a JSON file or a directory of them."""
+    if os.path.isdir(path):
+        files = sorted(
+            os.path.join(path, name) for name in os.listdir(path) if name.endswith(".json")
+        )
+    else:
+        files = [path]
+    results = {}
+    for file_name in files:
+        with open(file_name) as file:
+            data = json.load(file)
+        medians = {}
+        for entry in data.get("benchmarks", []):
+            if entry.get("error_occurred"):
+                continue
+            if entry.get("run_type") == "aggregate":
+                if entry.get("aggregate_name") == "median":
+                    medians[entry["run_name"]] = entry
+                continue
+            name = entry.get("run_name", entry["name"])
+            # Without aggregates keep the first repetition
+            results.setdefault(name, entry)
+        results.update(medians)
+    return results
+
+
+def time_in_ns(entry, metric):
+    scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[entry.get("time_unit", "ns")]
+    return entry[metric] * scale
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.3f %s" % (ns / scale, unit)
+    return "%.1f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="JSON file or directory with the reference results")
+    parser.add_argument("contender", help="JSON file or directory with the new results")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.05,
+        help="relative slowdown reported as a regression (default: 0.05)",
+    )
+    parser.add_argument(
+        "--metric",
+        choices=("cpu_time", "real_time"),
+        default="cpu_time",
+        help="time to compare (default: cpu_time)",
+    )
+    parser.add_argument("--filter", default="", help="only compare names matching this regex")
+    parser.add_argument(
+        "--fail-on-missing",
+        action="store_true",
+        help="also fail when a baseline benchmark has no new result",
+    )
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    contender = load_results(args.contender)
+    name_filter = re.compile(args.filter)
+    names = sorted(name for name in baseline if name_filter.search(name))
+
+    regressions = []
+    missing = []
+    ratios = []
+    width = max([len(name) for name in names] + [len("Benchmark")])
+    print("%-*s %14s %14s %9s" % (width, "Benchmark", "Baseline", "Contender", "Change"))
+    for name in names:
+        if name not in contender:
+            missing.append(name)
+            continue
+        old = time_in_ns(baseline[name], args.metric)
+        new = time_in_ns(contender[name], args.metric)
+        if old <= 0.0:
+            continue
+        change = new / old - 1.0
+        ratios.append(new / old)
+        marker = ""
+        if change > args.threshold:
+            regressions.append(name)
+            marker = "  REGRESSION"
+        elif change < -args.threshold:
+            marker = "  improved"
+        print(
+            "%-*s %14s %14s %+8.1f%%%s"
+            % (width, name, format_time(old), format_time(new), 100.0 * change, marker)
+        )
+
+    if ratios:
+        geomean = math.exp(sum(math.log(ratio) for ratio in ratios) / len(ratios))
+        print("\nGeometric mean change over %d benchmarks: %+.1f%%"
+              % (len(ratios), 100.0 * (geomean - 1.0)))
+    added = sorted(name for name in contender if name not in baseline and name_filter.search(name))
+    if added:
+        print("New benchmarks without baseline: %s" % ", ".join(added))
+    if missing:
+        print("Baseline benchmarks without new result: %s" % ", ".join(missing))
+    if regressions:
+        print("%d regression(s) above %.1f%%: %s"
+              % (len(regressions), 100.0 * args.threshold, ", ".join(regressions)))
+
+    failed = bool(regressions) or (args.fail_on_missing and bool(missing))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,95 @@
+#include "sfm/correspondence_graph.hpp"
+#include "utils/profiler.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace photogrammetry {
+namespace sfm {
+
+void CorrespondenceGraph::AddImage(const image_t image_id, const point2D_t num_points2D) {
+  if (finalized_) {
+    throw std::logic_error("Correspondence graph is already finalized");
+  }
+  if (!images_.try_emplace(image_id, ImageEntry{num_points2D, num_points2D_}).second) {
+    throw std::invalid_argument("Image " + std::to_string(image_id) + " is already added");
+  }
+  num_points2D_ += num_points2D;
+}
+
+void CorrespondenceGraph::AddCorrespondences(const image_t image_id1, const image_t image_id2,
+                                             const matching::FeatureMatches &matches) {
+  if (finalized_) {
+    throw std::logic_error("Correspondence graph is already finalized");
+  }
+  if (image_id1 == image_id2) {
+    throw std::invalid_argument("Correspondences must connect two different images");
+  }
+  const ImageEntry &image1 = Image(image_id1);
+  const ImageEntry &image2 = Image(image_id2);
+  for (const matching::FeatureMatch &match : matches) {
+    if (match.point2D_idx1 >= image1.num_points2D || match.point2D_idx2 >= image2.num_points2D) {
+      throw std::invalid_argument("Correspondence references a point that does not exist");
+    }
+  }
+  edges_.reserve(edges_.size() + 2 * matches.size());
+  for (const matching::FeatureMatch &match : matches) {
+    edges_.push_back({{image_id1, match.point2D_idx1}, {image_id2, match.point2D_idx2}});
+    edges_.push_back({{image_id2, match.point2D_idx2}, {image_id1, match.point2D_idx1}});
+  }
+  pair_num_correspondences_[ImagePairToPairId(image_id1, image_id2)] += matches.size();
+}
+
+void CorrespondenceGraph::Finalize() {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/correspondence_graph/finalize");
+  // 两遍计数排序, 与 TrackStore::Build 相同
+  point_offsets_.assign(num_points2D_ + 1, 0);
+  for (const Edge &edge : edges_) {
+    ++point_offsets_[Image(edge.from.image_id).first_point + edge.from.point2D_idx + 1];
+  }
+  for (size_t i = 0; i < num_points2D_; ++i) {
+    point_offsets_[i + 1] += point_offsets_[i];
+  }
+  correspondences_.resize(edges_.size());
+  std::vector<size_t> next(point_offsets_.begin(), point_offsets_.end() - 1);
+  for (const Edge &edge : edges_) {
+    correspondences_[next[Image(edge.from.image_id).first_point + edge.from.point2D_idx]++] =
+        edge.to;
+  }
+  edges_ = std::vector<Edge>();
+  finalized_ = true;
+}
+
+point2D_t CorrespondenceGraph::NumPoints2D(const image_t image_id) const {
+  return Image(image_id).num_points2D;
+}
+
+size_t CorrespondenceGraph::NumCorrespondencesBetween(const image_t image_id1,
+                                                      const image_t image_id2) const {
+  const auto it = pair_num_correspondences_.find(ImagePairToPairId(image_id1, image_id2));
+  return it == pair_num_correspondences_.end() ? 0 : it->second;
+}
+
+Span<TrackElement> CorrespondenceGraph::Correspondences(const image_t image_id,
+                                                        const point2D_t point2D_idx) const {
+  if (!finalized_) {
+    throw std::logic_error("Correspondence graph must be finalized before queries");
+  }
+  const ImageEntry &image = Image(image_id);
+  if (point2D_idx >= image.num_points2D) {
+    throw std::out_of_range("Point " + std::to_string(point2D_idx) + " does not exist");
+  }
+  const size_t point = image.first_point + point2D_idx;
+  return Span<TrackElement>(correspondences_.data() + point_offsets_[point],
+                            point_offsets_[point + 1] - point_offsets_[point]);
+}
+
+const CorrespondenceGraph::ImageEntry &CorrespondenceGraph::Image(const image_t image_id) const {
+  const auto it = images_.find(image_id);
+  if (it == images_.end()) {
+    throw std::invalid_argument("Image " + std::to_string(image_id) + " does not exist");
+  }
+  return it->second;
+}
+
+} // namespace sfm
+} // namespace photogrammetry
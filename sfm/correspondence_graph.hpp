@@ -0,0 +1,66 @@
+#ifndef PHOTOGRAMMETRY_SFM_CORRESPONDENCE_GRAPH_HPP
+#define PHOTOGRAMMETRY_SFM_CORRESPONDENCE_GRAPH_HPP
+
+#include "camera/std_types.hpp"
+#include "matching/matcher.hpp"
+#include "sfm/track_store.hpp"
+#include <vector>
+
+namespace photogrammetry {
+namespace sfm {
+
+/*
+ * @brief 特征点之间的对应关系图
+ * 由几何校验后的内点匹配构建, 每个特征点的对应(其他影像中的特征点, 以 TrackElement 表示)
+ * 按影像和特征点序号连续存放(CSR)。用法: AddImage 加入全部影像, AddCorrespondences 加入影像对
+ * 的匹配, Finalize 建立索引后查询; Finalize 之后不能再修改。
+ */
+class CorrespondenceGraph {
+public:
+  // 加入影像及其特征点数, 重复加入抛出 std::invalid_argument
+  void AddImage(image_t image_id, point2D_t num_points2D);
+
+  // 加入两张影像间的对应, 影像须已加入且特征点序号有效, 否则抛出 std::invalid_argument
+  void AddCorrespondences(image_t image_id1, image_t image_id2,
+                          const matching::FeatureMatches &matches);
+
+  void Finalize();
+
+  bool HasImage(const image_t image_id) const { return images_.contains(image_id); }
+  size_t NumImages() const { return images_.size(); }
+  point2D_t NumPoints2D(image_t image_id) const;
+  // 影像对的对应数, 不区分两张影像的顺序
+  size_t NumCorrespondencesBetween(image_t image_id1, image_t image_id2) const;
+  size_t NumCorrespondences() const { return correspondences_.size(); }
+
+  // 特征点在其他影像中的全部对应, 在图被修改前有效
+  Span<TrackElement> Correspondences(image_t image_id, point2D_t point2D_idx) const;
+
+private:
+  struct ImageEntry {
+    point2D_t num_points2D;
+    // 该影像第一个特征点在 point_offsets_ 中的下标
+    size_t first_point;
+  };
+  struct Edge {
+    TrackElement from;
+    TrackElement to;
+  };
+
+  const ImageEntry &Image(image_t image_id) const;
+
+  Flat_Hash_Map<image_t, ImageEntry> images_;
+  size_t num_points2D_ = 0;
+  Flat_Hash_Map<image_pair_t, size_t> pair_num_correspondences_;
+  // Finalize 之前暂存的有向边, 每个对应两条
+  std::vector<Edge> edges_;
+  bool finalized_ = false;
+
+  std::vector<size_t> point_offsets_;
+  std::vector<TrackElement> correspondences_;
+};
+
+} // namespace sfm
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_SFM_CORRESPONDENCE_GRAPH_HPP
@@ -0,0 +1,24 @@
+#include "sfm/incremental_mapper.hpp"
+
+namespace photogrammetry {
+namespace sfm {
+
+IncrementalMapperOptions::IncrementalMapperOptions() {
+  init_ransac.max_error = 0.004;
+  abs_pose_ransac.max_error = 0.004;
+  // 局部平差只调整位姿与点, 迭代次数较少; 内参在全局平差中优化
+  local_ba.refine_intrinsics = camera::IntrinsicParameterType::NONE;
+  local_ba.solver_options.max_num_iterations = 25;
+  global_ba.solver_options.max_num_iterations = 50;
+}
+
+bool IncrementalMapperOptions::Check() const {
+  return init_ransac.Check() && init_min_num_points >= 5 && init_max_num_pairs > 0 &&
+         abs_pose_ransac.Check() && abs_pose_min_num_inliers >= 3 &&
+         max_num_registration_trials > 0 && triangulation.Check() && local_ba_num_images >= 0 &&
+         local_ba.Check() && global_ba.Check() && global_ba_images_ratio > 1.0 &&
+         global_ba_points_ratio > 1.0;
+}
+
+} // namespace sfm
+} // namespace photogrammetry
@@ -0,0 +1,738 @@
+#ifndef PHOTOGRAMMETRY_SFM_INCREMENTAL_MAPPER_HPP
+#define PHOTOGRAMMETRY_SFM_INCREMENTAL_MAPPER_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "camera/std_types.hpp"
+#include "core/eigen_types.hpp"
+#include "estimators/absolute_pose.hpp"
+#include "estimators/essential_matrix.hpp"
+#include "estimators/ransac.hpp"
+#include "estimators/two_view_geometry.hpp"
+#include "optim/bundle_adjustment.hpp"
+#include "sfm/correspondence_graph.hpp"
+#include "sfm/track_store.hpp"
+#include "sfm/triangulation.hpp"
+#include "utils/flat_hash_map.hpp"
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace photogrammetry {
+namespace sfm {
+
+struct IncrementalMapperOptions {
+  // 初始影像对: 在去畸变的方位向量上重新估计本质矩阵, max_error 为角度误差(弧度)
+  estimators::RansacOptions init_ransac;
+  // 初始影像对至少三角化的点数
+  int init_min_num_points = 100;
+  // 最多尝试的初始影像对数, 按内点匹配数从多到少
+  int init_max_num_pairs = 20;
+
+  // 注册影像: P3P RANSAC, max_error 为角度误差的正弦
+  estimators::RansacOptions abs_pose_ransac;
+  int abs_pose_min_num_inliers = 30;
+  // 每张影像最多尝试注册的次数, 失败的影像在重建增长后再次尝试
+  int max_num_registration_trials = 3;
+
+  // 新三维点的三角化与所有点的过滤阈值
+  TriangulationOptions triangulation;
+
+  // 局部平差中新注册影像之外的相邻影像数, 按共视点数选取
+  int local_ba_num_images = 6;
+  optim::BundleAdjustmentOptions local_ba;
+  optim::BundleAdjustmentOptions global_ba;
+  // 注册影像数或三维点数增长到上一次全局平差时的该倍数时进行全局平差
+  double global_ba_images_ratio = 1.1;
+  double global_ba_points_ratio = 1.1;
+
+  IncrementalMapperOptions();
+
+  bool Check() const;
+};
+
+struct IncrementalMapperSummary {
+  image_t init_image_id1 = UINvaliedImageId;
+  image_t init_image_id2 = UINvaliedImageId;
+  size_t num_registered_images = 0;
+  size_t num_points3D = 0;
+  size_t num_local_bundle_adjustments = 0;
+  size_t num_global_bundle_adjustments = 0;
+};
+
+/*
+ * @brief 增量式 SfM
+ * 从内点匹配最多的已标定影像对开始: 重新估计本质矩阵并恢复相对位姿, 三角化后做一次全局平差。
+ * 之后每次选择可见三维点最多的未注册影像, 用 P3P RANSAC 注册, 延续已有轨迹并三角化新点, 再只对
+ * 新影像及其共视最多的相邻影像做局部平差, 邻域外观测到这些点的影像保持固定。注册影像数或三维点数
+ * 相对上一次全局平差增长到给定倍数时才做全局平差, 全局平差的总代价为等比级数, 与最终规模同阶。
+ * 每次平差后剔除重投影误差过大的观测和三角化角过小的点。
+ * 第一张初始影像的位姿与第二张的光心固定, 消除坐标系与尺度的自由度。
+ * @tparam CameraType 相机模型
+ */
+template <typename CameraType>
+class IncrementalMapper {
+public:
+  typedef optim::BundleAdjustmentScene<CameraType> Scene;
+
+  explicit IncrementalMapper(Hash_Map<camera_t, CameraType> cameras,
+                             const IncrementalMapperOptions &options = IncrementalMapperOptions());
+
+  /*
+   * @brief 加入影像
+   * @param points2D 特征点的像素坐标, 以 point2D_t 为列下标
+   * @throw std::invalid_argument 相机不存在或影像重复
+   */
+  void AddImage(image_t image_id, camera_t camera_id, const Mat2X &points2D);
+
+  /*
+   * @brief 加入 TwoViewGeometryVerifier 的结果, 影像须已加入
+   * 内点匹配构成对应关系图, DEGENERATE 的影像对被忽略, CALIBRATED 的影像对作为初始影像对的候选
+   */
+  void AddTwoViewGeometries(
+      const Flat_Hash_Map<image_pair_t, estimators::TwoViewGeometry> &geometries);
+
+  /*
+   * @brief 增量重建, 只能调用一次
+   * @return 找不到可用的初始影像对时返回 false
+   */
+  bool Reconstruct();
+
+  // 重建结果: 相机、已注册影像的位姿与三维点; observations 为空, 轨迹见 Tracks
+  const Scene &Reconstruction() const { return scene_; }
+  const TrackStore &Tracks() const { return tracks_; }
+  const IncrementalMapperSummary &Summary() const { return summary_; }
+
+  bool IsRegistered(const image_t image_id) const { return scene_.images.count(image_id) > 0; }
+  // 特征点对应的三维点, 没有时为 UINvaliedPoint3DId
+  point3D_t Point3DId(const image_t image_id, const point2D_t point2D_idx) const {
+    return images_.at(image_id).point3D_ids.at(point2D_idx);
+  }
+
+private:
+  struct ImageData {
+    camera_t camera_id = UINvaliedCameraId;
+    Mat2X points2D;
+    // 去畸变后的单位方位向量
+    Mat3X bearings;
+    std::vector<point3D_t> point3D_ids;
+    // 每个特征点的对应中已有三维点的个数
+    std::vector<uint32_t> num_triangulated_correspondences;
+    // num_triangulated_correspondences 非零的特征点数, 用于选择下一张影像
+    size_t num_visible_points3D = 0;
+    int num_registration_trials = 0;
+  };
+
+  struct InitialPair {
+    image_t image_id1;
+    image_t image_id2;
+    matching::FeatureMatches matches;
+  };
+
+  bool Initialize();
+  std::vector<image_t> NextImages() const;
+  bool RegisterImage(image_t image_id);
+  // 延续相邻影像中已有的轨迹, 并三角化其余有对应的特征点
+  void TriangulateImage(image_t image_id);
+  /*
+   * @brief 三角化候选轨迹, 只保留尚未属于任何三维点的内点观测, 同一影像只取一个
+   * @param offsets 候选轨迹 t 为 elements[offsets[t], offsets[t + 1])
+   */
+  void TriangulateTracks(const std::vector<size_t> &offsets,
+                         const std::vector<TrackElement> &elements);
+  void LocalBundleAdjustment(image_t image_id);
+  void GlobalBundleAdjustment();
+  bool NeedsGlobalBundleAdjustment() const;
+  void SetGaugeConstraints(const Scene &problem, optim::BundleAdjustmentConfig *config) const;
+  // 剔除重投影误差过大的观测, 观测少于 2 个或三角化角过小的点被删除
+  void FilterPoints(const std::vector<point3D_t> &point3D_ids);
+
+  point3D_t AddPoint(const Vec3 &xyz);
+  void AddObservation(point3D_t point3D_id, image_t image_id, point2D_t point2D_idx);
+  void DeleteObservation(point3D_t point3D_id, image_t image_id, point2D_t point2D_idx);
+  void DeletePoint(point3D_t point3D_id);
+  bool TrackHasImage(point3D_t point3D_id, image_t image_id) const;
+  double SquaredReprojectionError(image_t image_id, point2D_t point2D_idx,
+                                  const Vec3 &xyz) const;
+
+  IncrementalMapperOptions options_;
+  Scene scene_;
+  TrackStore tracks_;
+  CorrespondenceGraph graph_;
+  Flat_Hash_Map<image_t, ImageData> images_;
+  // 按内点匹配数从多到少排列, 至多 init_max_num_pairs 个
+  std::vector<InitialPair> initial_pairs_;
+  IncrementalMapperSummary summary_;
+  point3D_t next_point3D_id_ = 0;
+  size_t last_global_ba_num_images_ = 0;
+  size_t last_global_ba_num_points_ = 0;
+  bool reconstructed_ = false;
+};
+
+template <typename CameraType>
+IncrementalMapper<CameraType>::IncrementalMapper(Hash_Map<camera_t, CameraType> cameras,
+                                                 const IncrementalMapperOptions &options)
+    : options_(options) {
+  if (!options_.Check()) {
+    throw std::invalid_argument("Invalid incremental mapper options");
+  }
+  scene_.cameras = std::move(cameras);
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::AddImage(const image_t image_id, const camera_t camera_id,
+                                             const Mat2X &points2D) {
+  const auto camera_it = scene_.cameras.find(camera_id);
+  if (camera_it == scene_.cameras.end()) {
+    throw std::invalid_argument("Camera " + std::to_string(camera_id) + " does not exist");
+  }
+  graph_.AddImage(image_id, static_cast<point2D_t>(points2D.cols()));
+  const CameraType &camera = camera_it->second;
+  ImageData image;
+  image.camera_id = camera_id;
+  image.points2D = points2D;
+  image.bearings.resize(3, points2D.cols());
+  for (Eigen::Index i = 0; i < points2D.cols(); ++i) {
+    image.bearings.col(i) =
+        camera.undistort(camera.ima2cam(points2D.col(i))).homogeneous().normalized();
+  }
+  image.point3D_ids.assign(points2D.cols(), UINvaliedPoint3DId);
+  image.num_triangulated_correspondences.assign(points2D.cols(), 0);
+  images_.emplace(image_id, std::move(image));
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::AddTwoViewGeometries(
+    const Flat_Hash_Map<image_pair_t, estimators::TwoViewGeometry> &geometries) {
+  const size_t max_num_pairs = static_cast<size_t>(options_.init_max_num_pairs);
+  // 内点匹配多的优先, 相同时影像对 id 小的优先
+  const auto before = [](const size_t num_matches1, const image_pair_t pair_id1,
+                         const InitialPair &pair2) {
+    const size_t num_matches2 = pair2.matches.size();
+    return num_matches1 > num_matches2 ||
+           (num_matches1 == num_matches2 &&
+            pair_id1 < ImagePairToPairId(pair2.image_id1, pair2.image_id2));
+  };
+  for (const auto &item : geometries) {
+    const estimators::TwoViewGeometry &geometry = item.second;
+    if (geometry.config == estimators::TwoViewConfiguration::DEGENERATE) {
+      continue;
+    }
+    const Pair pair = PairIdToImagePair(item.first);
+    graph_.AddCorrespondences(pair.first, pair.second, geometry.inlier_matches);
+    const size_t num_matches = geometry.inlier_matches.size();
+    if (geometry.config != estimators::TwoViewConfiguration::CALIBRATED ||
+        (initial_pairs_.size() == max_num_pairs &&
+         !before(num_matches, item.first, initial_pairs_.back()))) {
+      continue;
+    }
+    const auto position = std::find_if(
+        initial_pairs_.begin(), initial_pairs_.end(),
+        [&](const InitialPair &other) { return before(num_matches, item.first, other); });
+    initial_pairs_.insert(position, {pair.first, pair.second, geometry.inlier_matches});
+    if (initial_pairs_.size() > max_num_pairs) {
+      initial_pairs_.pop_back();
+    }
+  }
+}
+
+template <typename CameraType>
+bool IncrementalMapper<CameraType>::Reconstruct() {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper");
+  if (reconstructed_) {
+    throw std::logic_error("Reconstruct can only be called once");
+  }
+  reconstructed_ = true;
+  graph_.Finalize();
+  if (!Initialize()) {
+    return false;
+  }
+
+  for (;;) {
+    bool registered = false;
+    for (const image_t image_id : NextImages()) {
+      if (!RegisterImage(image_id)) {
+        continue;
+      }
+      TriangulateImage(image_id);
+      LocalBundleAdjustment(image_id);
+      if (NeedsGlobalBundleAdjustment()) {
+        GlobalBundleAdjustment();
+      }
+      registered = true;
+      // 重建增长后重新排序候选影像
+      break;
+    }
+    if (!registered) {
+      break;
+    }
+  }
+  if (scene_.images.size() != last_global_ba_num_images_ ||
+      scene_.points3D.size() != last_global_ba_num_points_) {
+    GlobalBundleAdjustment();
+  }
+  summary_.num_registered_images = scene_.images.size();
+  summary_.num_points3D = scene_.points3D.size();
+  return true;
+}
+
+template <typename CameraType>
+bool IncrementalMapper<CameraType>::Initialize() {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper/initialize");
+  const estimators::Ransac<estimators::EssentialMatrixFivePointEstimator> ransac(
+      options_.init_ransac);
+  for (const InitialPair &pair : initial_pairs_) {
+    const ImageData &image1 = images_.at(pair.image_id1);
+    const ImageData &image2 = images_.at(pair.image_id2);
+    const Eigen::Index num_matches = static_cast<Eigen::Index>(pair.matches.size());
+    if (num_matches < options_.init_min_num_points) {
+      continue;
+    }
+    Mat3X x1(3, num_matches), x2(3, num_matches);
+    for (Eigen::Index i = 0; i < num_matches; ++i) {
+      x1.col(i) = image1.bearings.col(pair.matches[i].point2D_idx1);
+      x2.col(i) = image2.bearings.col(pair.matches[i].point2D_idx2);
+    }
+    // 没有得到任何模型时 success 为 false, 此时 model 与 inlier_mask 都不可用
+    const auto report = ransac.Estimate(x1, x2);
+    if (!report.success || report.num_inliers < size_t(options_.init_min_num_points) ||
+        !report.model.allFinite()) {
+      continue;
+    }
+    Mat3X inliers1(3, report.num_inliers), inliers2(3, report.num_inliers);
+    std::vector<size_t> offsets = {0};
+    std::vector<TrackElement> elements;
+    for (Eigen::Index i = 0, j = 0; i < num_matches; ++i) {
+      if (report.inlier_mask[i]) {
+        inliers1.col(j) = x1.col(i);
+        inliers2.col(j++) = x2.col(i);
+        elements.push_back({pair.image_id1, pair.matches[i].point2D_idx1});
+        elements.push_back({pair.image_id2, pair.matches[i].point2D_idx2});
+        offsets.push_back(elements.size());
+      }
+    }
+    camera::CameraExtrinsicParams pose2;
+    if (estimators::RelativePoseFromEssentialMatrix(report.model, inliers1, inliers2, &pose2) <
+        size_t(options_.init_min_num_points)) {
+      continue;
+    }
+
+    scene_.images[pair.image_id1] = {image1.camera_id, camera::CameraExtrinsicParams()};
+    scene_.images[pair.image_id2] = {image2.camera_id, pose2};
+    TriangulateTracks(offsets, elements);
+    if (scene_.points3D.size() < size_t(options_.init_min_num_points)) {
+      const std::vector<point3D_t> point3D_ids = tracks_.PointIds();
+      for (const point3D_t point3D_id : point3D_ids) {
+        DeletePoint(point3D_id);
+      }
+      scene_.images.clear();
+      continue;
+    }
+    summary_.init_image_id1 = pair.image_id1;
+    summary_.init_image_id2 = pair.image_id2;
+    GlobalBundleAdjustment();
+    initial_pairs_ = std::vector<InitialPair>();
+    return true;
+  }
+  return false;
+}
+
+template <typename CameraType>
+std::vector<image_t> IncrementalMapper<CameraType>::NextImages() const {
+  std::vector<std::pair<size_t, image_t>> candidates;
+  for (const auto &item : images_) {
+    const ImageData &image = item.second;
+    if (!IsRegistered(item.first) &&
+        image.num_registration_trials < options_.max_num_registration_trials &&
+        image.num_visible_points3D >= size_t(options_.abs_pose_min_num_inliers)) {
+      candidates.emplace_back(image.num_visible_points3D, item.first);
+    }
+  }
+  // 可见三维点多的优先, 相同时 id 小的优先
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<size_t, image_t> &a, const std::pair<size_t, image_t> &b) {
+              return a.first > b.first || (a.first == b.first && a.second < b.second);
+            });
+  std::vector<image_t> image_ids(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    image_ids[i] = candidates[i].second;
+  }
+  return image_ids;
+}
+
+template <typename CameraType>
+bool IncrementalMapper<CameraType>::RegisterImage(const image_t image_id) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper/register_image");
+  ImageData &image = images_.at(image_id);
+  ++image.num_registration_trials;
+
+  // 2D-3D 对应: 每个特征点取第一个已三角化的对应特征点的三维点
+  std::vector<point2D_t> point2D_idxs;
+  std::vector<point3D_t> point3D_ids;
+  for (point2D_t point2D_idx = 0; point2D_idx < image.point3D_ids.size(); ++point2D_idx) {
+    for (const TrackElement &corr : graph_.Correspondences(image_id, point2D_idx)) {
+      const point3D_t point3D_id = images_.at(corr.image_id).point3D_ids[corr.point2D_idx];
+      if (point3D_id != UINvaliedPoint3DId && IsRegistered(corr.image_id)) {
+        point2D_idxs.push_back(point2D_idx);
+        point3D_ids.push_back(point3D_id);
+        break;
+      }
+    }
+  }
+  const size_t min_num_inliers = static_cast<size_t>(options_.abs_pose_min_num_inliers);
+  if (point2D_idxs.size() < min_num_inliers) {
+    return false;
+  }
+
+  const Eigen::Index num_correspondences = static_cast<Eigen::Index>(point2D_idxs.size());
+  Mat3X bearings(3, num_correspondences), points3D(3, num_correspondences);
+  for (Eigen::Index i = 0; i < num_correspondences; ++i) {
+    bearings.col(i) = image.bearings.col(point2D_idxs[i]);
+    points3D.col(i) = scene_.points3D.at(point3D_ids[i]);
+  }
+  estimators::RansacOptions ransac_options = options_.abs_pose_ransac;
+  ransac_options.random_seed = utils::MixHash(ransac_options.random_seed ^ image_id);
+  const auto report =
+      estimators::Ransac<estimators::P3PEstimator>(ransac_options).Estimate(bearings, points3D);
+  if (!report.success || report.num_inliers < min_num_inliers ||
+      !report.model.Rotation().allFinite() || !report.model.Center().allFinite()) {
+    return false;
+  }
+
+  scene_.images[image_id] = {image.camera_id, report.model};
+  for (Eigen::Index i = 0; i < num_correspondences; ++i) {
+    // 多个特征点可能对应同一个三维点, 每张影像只保留一个观测
+    if (report.inlier_mask[i] && !TrackHasImage(point3D_ids[i], image_id)) {
+      AddObservation(point3D_ids[i], image_id, point2D_idxs[i]);
+    }
+  }
+  return true;
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::TriangulateImage(const image_t image_id) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper/triangulate_image");
+  const ImageData &image = images_.at(image_id);
+  const double max_squared_error =
+      options_.triangulation.max_reprojection_error * options_.triangulation.max_reprojection_error;
+  std::vector<size_t> offsets = {0};
+  std::vector<TrackElement> elements;
+  for (point2D_t point2D_idx = 0; point2D_idx < image.point3D_ids.size(); ++point2D_idx) {
+    if (image.point3D_ids[point2D_idx] != UINvaliedPoint3DId) {
+      continue;
+    }
+    const size_t begin = elements.size();
+    elements.push_back({image_id, point2D_idx});
+    bool continued = false;
+    for (const TrackElement &corr : graph_.Correspondences(image_id, point2D_idx)) {
+      if (!IsRegistered(corr.image_id)) {
+        continue;
+      }
+      const point3D_t point3D_id = images_.at(corr.image_id).point3D_ids[corr.point2D_idx];
+      if (point3D_id == UINvaliedPoint3DId) {
+        elements.push_back(corr);
+      } else if (!continued && !TrackHasImage(point3D_id, image_id) &&
+                 SquaredReprojectionError(image_id, point2D_idx,
+                                          scene_.points3D.at(point3D_id)) <= max_squared_error) {
+        // 注册时未被选中的 2D-3D 对应, 重投影误差足够小时延续该轨迹
+        AddObservation(point3D_id, image_id, point2D_idx);
+        continued = true;
+      }
+    }
+    if (continued || elements.size() - begin < 2) {
+      elements.resize(begin);
+    } else {
+      offsets.push_back(elements.size());
+    }
+  }
+  TriangulateTracks(offsets, elements);
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::TriangulateTracks(const std::vector<size_t> &offsets,
+                                                      const std::vector<TrackElement> &elements) {
+  if (offsets.size() < 2) {
+    return;
+  }
+  // 只为出现在候选轨迹中的影像建立视图
+  Flat_Hash_Map<image_t, uint32_t> view_indices;
+  std::vector<TriangulationView<CameraType>> views;
+  std::vector<TrackObservation> observations(elements.size());
+  for (size_t i = 0; i < elements.size(); ++i) {
+    const TrackElement &element = elements[i];
+    const auto result = view_indices.try_emplace(element.image_id, uint32_t(views.size()));
+    if (result.second) {
+      const optim::BundleAdjustmentImage &image = scene_.images.at(element.image_id);
+      views.push_back({&scene_.cameras.at(image.camera_id), image.pose});
+    }
+    observations[i] = {result.first->second,
+                       images_.at(element.image_id).points2D.col(element.point2D_idx)};
+  }
+  const Triangulator<CameraType> triangulator(std::move(views), options_.triangulation);
+  std::vector<char> inlier_mask;
+  const std::vector<TriangulatedPoint> points =
+      triangulator.Triangulate(offsets, observations, &inlier_mask);
+
+  std::vector<TrackElement> track;
+  for (size_t t = 0; t + 1 < offsets.size(); ++t) {
+    if (!points[t].success) {
+      continue;
+    }
+    track.clear();
+    for (size_t i = offsets[t]; i < offsets[t + 1]; ++i) {
+      const TrackElement &element = elements[i];
+      if (inlier_mask[i] &&
+          images_.at(element.image_id).point3D_ids[element.point2D_idx] == UINvaliedPoint3DId &&
+          std::none_of(track.begin(), track.end(), [&](const TrackElement &other) {
+            return other.image_id == element.image_id;
+          })) {
+        track.push_back(element);
+      }
+    }
+    if (track.size() < 2) {
+      continue;
+    }
+    const point3D_t point3D_id = AddPoint(points[t].xyz);
+    for (const TrackElement &element : track) {
+      AddObservation(point3D_id, element.image_id, element.point2D_idx);
+    }
+  }
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::LocalBundleAdjustment(const image_t image_id) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper/local_bundle_adjustment");
+  // 按共视点数选取相邻影像
+  Flat_Hash_Map<image_t, size_t> num_shared_points;
+  for (const ImageObservation &observation : tracks_.ImagePoints(image_id)) {
+    for (const TrackElement &element : tracks_.Track(observation.point3D_id)) {
+      if (element.image_id != image_id) {
+        ++num_shared_points[element.image_id];
+      }
+    }
+  }
+  std::vector<std::pair<size_t, image_t>> neighbors;
+  neighbors.reserve(num_shared_points.size());
+  for (const auto &item : num_shared_points) {
+    neighbors.emplace_back(item.second, item.first);
+  }
+  const size_t num_neighbors =
+      std::min(neighbors.size(), static_cast<size_t>(options_.local_ba_num_images));
+  std::partial_sort(neighbors.begin(), neighbors.begin() + num_neighbors, neighbors.end(),
+                    [](const std::pair<size_t, image_t> &a, const std::pair<size_t, image_t> &b) {
+                      return a.first > b.first || (a.first == b.first && a.second < b.second);
+                    });
+  std::vector<image_t> local_images = {image_id};
+  for (size_t i = 0; i < num_neighbors; ++i) {
+    local_images.push_back(neighbors[i].second);
+  }
+
+  // 邻域影像观测到的全部点参与优化, 其他观测到这些点的影像固定
+  Scene problem;
+  problem.cameras = scene_.cameras;
+  std::vector<point3D_t> point3D_ids;
+  for (const image_t local_image_id : local_images) {
+    problem.images.emplace(local_image_id, scene_.images.at(local_image_id));
+    for (const ImageObservation &observation : tracks_.ImagePoints(local_image_id)) {
+      if (problem.points3D.emplace(observation.point3D_id,
+                                   scene_.points3D.at(observation.point3D_id))
+              .second) {
+        point3D_ids.push_back(observation.point3D_id);
+      }
+    }
+  }
+  optim::BundleAdjustmentConfig config;
+  for (const point3D_t point3D_id : point3D_ids) {
+    for (const TrackElement &element : tracks_.Track(point3D_id)) {
+      if (problem.images.emplace(element.image_id, scene_.images.at(element.image_id)).second) {
+        config.SetConstantPose(element.image_id);
+      }
+      problem.observations.push_back(
+          {element.image_id, point3D_id,
+           images_.at(element.image_id).points2D.col(element.point2D_idx)});
+    }
+  }
+  SetGaugeConstraints(problem, &config);
+
+  optim::BundleAdjuster<CameraType> adjuster(options_.local_ba, config);
+  if (adjuster.Solve(&problem)) {
+    for (const image_t local_image_id : local_images) {
+      scene_.images.at(local_image_id).pose = problem.images.at(local_image_id).pose;
+    }
+    for (const point3D_t point3D_id : point3D_ids) {
+      scene_.points3D.at(point3D_id) = problem.points3D.at(point3D_id);
+    }
+    scene_.cameras = std::move(problem.cameras);
+  }
+  ++summary_.num_local_bundle_adjustments;
+  FilterPoints(point3D_ids);
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::GlobalBundleAdjustment() {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper/global_bundle_adjustment");
+  // 平差直接作用于重建本身, 不复制场景
+  scene_.observations.clear();
+  scene_.observations.reserve(tracks_.NumObservations());
+  for (const point3D_t point3D_id : tracks_.PointIds()) {
+    for (const TrackElement &element : tracks_.Track(point3D_id)) {
+      scene_.observations.push_back(
+          {element.image_id, point3D_id,
+           images_.at(element.image_id).points2D.col(element.point2D_idx)});
+    }
+  }
+  optim::BundleAdjustmentConfig config;
+  SetGaugeConstraints(scene_, &config);
+  optim::BundleAdjuster<CameraType> adjuster(options_.global_ba, config);
+  adjuster.Solve(&scene_);
+  scene_.observations = std::vector<optim::BundleAdjustmentObservation>();
+  ++summary_.num_global_bundle_adjustments;
+
+  FilterPoints(tracks_.PointIds());
+  last_global_ba_num_images_ = scene_.images.size();
+  last_global_ba_num_points_ = scene_.points3D.size();
+}
+
+template <typename CameraType>
+bool IncrementalMapper<CameraType>::NeedsGlobalBundleAdjustment() const {
+  return scene_.images.size() >= options_.global_ba_images_ratio * last_global_ba_num_images_ ||
+         scene_.points3D.size() >= options_.global_ba_points_ratio * last_global_ba_num_points_;
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::SetGaugeConstraints(
+    const Scene &problem, optim::BundleAdjustmentConfig *config) const {
+  if (problem.images.count(summary_.init_image_id1) > 0) {
+    config->SetConstantPose(summary_.init_image_id1);
+  }
+  if (problem.images.count(summary_.init_image_id2) > 0 &&
+      !config->HasConstantPose(summary_.init_image_id2)) {
+    config->SetConstantCenter(summary_.init_image_id2);
+  }
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::FilterPoints(const std::vector<point3D_t> &point3D_ids) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/incremental_mapper/filter_points");
+  const double max_squared_error =
+      options_.triangulation.max_reprojection_error * options_.triangulation.max_reprojection_error;
+  const double max_cos = std::cos(options_.triangulation.min_triangulation_angle * internal::kPi /
+                                  180.0);
+  // 删除会修改 point3D_ids 可能引用的 TrackStore::PointIds, 先复制
+  const std::vector<point3D_t> candidates = point3D_ids;
+  std::vector<TrackElement> track;
+  for (const point3D_t point3D_id : candidates) {
+    if (!tracks_.HasPoint(point3D_id)) {
+      continue;
+    }
+    const Vec3 xyz = scene_.points3D.at(point3D_id);
+    const Span<TrackElement> span = tracks_.Track(point3D_id);
+    track.assign(span.begin(), span.end());
+    for (const TrackElement &element : track) {
+      if (SquaredReprojectionError(element.image_id, element.point2D_idx, xyz) >
+          max_squared_error) {
+        DeleteObservation(point3D_id, element.image_id, element.point2D_idx);
+      }
+    }
+    if (!tracks_.HasPoint(point3D_id)) {
+      continue;
+    }
+    if (tracks_.TrackLength(point3D_id) < 2) {
+      DeletePoint(point3D_id);
+      continue;
+    }
+    // 任意两条视线的夹角达到最小三角化角即可保留
+    const Span<TrackElement> remaining = tracks_.Track(point3D_id);
+    bool sufficient_angle = false;
+    for (size_t i = 0; i < remaining.size() && !sufficient_angle; ++i) {
+      const Vec3 ray1 = (xyz - scene_.images.at(remaining[i].image_id).pose.Center()).normalized();
+      for (size_t j = i + 1; j < remaining.size() && !sufficient_angle; ++j) {
+        const Vec3 ray2 =
+            (xyz - scene_.images.at(remaining[j].image_id).pose.Center()).normalized();
+        sufficient_angle = ray1.dot(ray2) <= max_cos;
+      }
+    }
+    if (!sufficient_angle) {
+      DeletePoint(point3D_id);
+    }
+  }
+}
+
+template <typename CameraType>
+point3D_t IncrementalMapper<CameraType>::AddPoint(const Vec3 &xyz) {
+  const point3D_t point3D_id = next_point3D_id_++;
+  scene_.points3D.emplace(point3D_id, xyz);
+  return point3D_id;
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::AddObservation(const point3D_t point3D_id,
+                                                   const image_t image_id,
+                                                   const point2D_t point2D_idx) {
+  tracks_.AddObservation(point3D_id, image_id, point2D_idx);
+  images_.at(image_id).point3D_ids[point2D_idx] = point3D_id;
+  for (const TrackElement &corr : graph_.Correspondences(image_id, point2D_idx)) {
+    ImageData &other = images_.at(corr.image_id);
+    if (other.num_triangulated_correspondences[corr.point2D_idx]++ == 0) {
+      ++other.num_visible_points3D;
+    }
+  }
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::DeleteObservation(const point3D_t point3D_id,
+                                                      const image_t image_id,
+                                                      const point2D_t point2D_idx) {
+  if (!tracks_.DeleteObservation(point3D_id, image_id, point2D_idx)) {
+    return;
+  }
+  images_.at(image_id).point3D_ids[point2D_idx] = UINvaliedPoint3DId;
+  for (const TrackElement &corr : graph_.Correspondences(image_id, point2D_idx)) {
+    ImageData &other = images_.at(corr.image_id);
+    if (--other.num_triangulated_correspondences[corr.point2D_idx] == 0) {
+      --other.num_visible_points3D;
+    }
+  }
+  // TrackStore 在轨迹为空时删除该点
+  if (!tracks_.HasPoint(point3D_id)) {
+    scene_.points3D.erase(point3D_id);
+  }
+}
+
+template <typename CameraType>
+void IncrementalMapper<CameraType>::DeletePoint(const point3D_t point3D_id) {
+  const Span<TrackElement> span = tracks_.Track(point3D_id);
+  const std::vector<TrackElement> track(span.begin(), span.end());
+  for (const TrackElement &element : track) {
+    DeleteObservation(point3D_id, element.image_id, element.point2D_idx);
+  }
+  scene_.points3D.erase(point3D_id);
+}
+
+template <typename CameraType>
+bool IncrementalMapper<CameraType>::TrackHasImage(const point3D_t point3D_id,
+                                                  const image_t image_id) const {
+  for (const TrackElement &element : tracks_.Track(point3D_id)) {
+    if (element.image_id == image_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename CameraType>
+double IncrementalMapper<CameraType>::SquaredReprojectionError(const image_t image_id,
+                                                               const point2D_t point2D_idx,
+                                                               const Vec3 &xyz) const {
+  const optim::BundleAdjustmentImage &image = scene_.images.at(image_id);
+  return sfm::SquaredReprojectionError(scene_.cameras.at(image.camera_id), image.pose, xyz,
+                                       images_.at(image_id).points2D.col(point2D_idx));
+}
+
+} // namespace sfm
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_SFM_INCREMENTAL_MAPPER_HPP
@@ -0,0 +1,241 @@
+#include "sfm/incremental_mapper.hpp"
+#include "camera/pinhole_model.hpp"
+#include <Eigen/Geometry>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::camera;
+using namespace photogrammetry::sfm;
+
+class IncrementalMapperTest : public ::testing::Test {
+protected:
+  static constexpr int kNumImages = 12;
+  static constexpr int kNumPoints = 600;
+
+  void SetUp() override {
+    auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+    params->fx = 1000.0;
+    params->fy = 1010.0;
+    params->cx = 640.0;
+    params->cy = 480.0;
+    params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+    cameras_.emplace(0, PinholeCameraBrown(0, 1280, 960, params));
+    const PinholeCameraBrown &camera = cameras_.at(0);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> uniform(-1.5, 1.5);
+    points3D_.resize(3, kNumPoints);
+    for (int i = 0; i < kNumPoints; ++i) {
+      points3D_.col(i) = Vec3(uniform(rng), uniform(rng), uniform(rng));
+    }
+
+    // 影像位于半径为 6 的圆弧上, 朝向原点
+    for (int i = 0; i < kNumImages; ++i) {
+      const double angle = 0.8 * (i / double(kNumImages - 1) - 0.5);
+      const Vec3 center(6.0 * std::sin(angle), 0.3 * std::cos(3.0 * angle),
+                        -6.0 * std::cos(angle));
+      const Vec3 z = -center.normalized();
+      const Vec3 x = Vec3::UnitY().cross(z).normalized();
+      Mat33 R;
+      R << x.transpose(), z.cross(x).transpose(), z.transpose();
+      poses_.emplace_back(R, center);
+
+      // 特征点顺序打乱, 并加入没有匹配的特征点
+      std::vector<int> order(kNumPoints + 50);
+      std::iota(order.begin(), order.end(), 0);
+      std::shuffle(order.begin(), order.end(), rng);
+      Mat2X points2D(2, order.size());
+      std::vector<point2D_t> point2D_of(kNumPoints);
+      for (size_t k = 0; k < order.size(); ++k) {
+        if (order[k] < kNumPoints) {
+          points2D.col(k) = camera.project(poses_.back()(points3D_.col(order[k])));
+          point2D_of[order[k]] = static_cast<point2D_t>(k);
+        } else {
+          points2D.col(k) = Vec2(640.0 + 200.0 * uniform(rng), 480.0 + 200.0 * uniform(rng));
+        }
+      }
+      points2D_.push_back(points2D);
+      point2D_of_.push_back(point2D_of);
+    }
+
+    // 相隔不超过 3 张的影像对之间有匹配
+    for (image_t i = 0; i < kNumImages; ++i) {
+      for (image_t j = i + 1; j < kNumImages && j <= i + 3; ++j) {
+        estimators::TwoViewGeometry geometry;
+        geometry.config = estimators::TwoViewConfiguration::CALIBRATED;
+        for (int p = 0; p < kNumPoints; ++p) {
+          geometry.inlier_matches.push_back({point2D_of_[i][p], point2D_of_[j][p]});
+        }
+        geometries_.emplace(ImagePairToPairId(i, j), geometry);
+      }
+    }
+  }
+
+  void AddImages(IncrementalMapper<PinholeCameraBrown> *mapper) const {
+    for (image_t i = 0; i < kNumImages; ++i) {
+      mapper->AddImage(i, 0, points2D_[i]);
+    }
+  }
+
+  Hash_Map<camera_t, PinholeCameraBrown> cameras_;
+  Mat3X points3D_;
+  std::vector<CameraExtrinsicParams> poses_;
+  std::vector<Mat2X> points2D_;
+  std::vector<std::vector<point2D_t>> point2D_of_;
+  Flat_Hash_Map<image_pair_t, estimators::TwoViewGeometry> geometries_;
+};
+
+TEST_F(IncrementalMapperTest, ReconstructsAllImages) {
+  IncrementalMapperOptions options;
+  options.global_ba_images_ratio = 1.4;
+  options.global_ba_points_ratio = 1.4;
+  IncrementalMapper<PinholeCameraBrown> mapper(cameras_, options);
+  AddImages(&mapper);
+  mapper.AddTwoViewGeometries(geometries_);
+  ASSERT_TRUE(mapper.Reconstruct());
+
+  const IncrementalMapperSummary &summary = mapper.Summary();
+  EXPECT_EQ(summary.num_registered_images, size_t(kNumImages));
+  EXPECT_GE(summary.num_points3D, size_t(0.98 * kNumPoints));
+  EXPECT_EQ(summary.num_local_bundle_adjustments, size_t(kNumImages - 2));
+  // 初始化与结束时各一次, 其间在注册影像数达到 3, 5, 7, 10 时
+  EXPECT_EQ(summary.num_global_bundle_adjustments, 6u);
+
+  // 以光心估计相似变换, 与真值比较
+  const auto &reconstruction = mapper.Reconstruction();
+  Mat3X estimated_centers(3, kNumImages), true_centers(3, kNumImages);
+  for (image_t i = 0; i < kNumImages; ++i) {
+    ASSERT_TRUE(mapper.IsRegistered(i));
+    estimated_centers.col(i) = reconstruction.images.at(i).pose.Center();
+    true_centers.col(i) = poses_[i].Center();
+  }
+  const Mat44 transform = Eigen::umeyama(estimated_centers, true_centers, true);
+  for (image_t i = 0; i < kNumImages; ++i) {
+    const Vec3 center = (transform * estimated_centers.col(i).homogeneous()).hnormalized();
+    EXPECT_LT((center - true_centers.col(i)).norm(), 1e-6) << i;
+  }
+
+  // 轨迹与特征点的三维点一一对应, 三维点与真值一致
+  const TrackStore &tracks = mapper.Tracks();
+  for (image_t i = 0; i < kNumImages; ++i) {
+    for (int p = 0; p < kNumPoints; ++p) {
+      const point3D_t point3D_id = mapper.Point3DId(i, point2D_of_[i][p]);
+      if (point3D_id == UINvaliedPoint3DId) {
+        continue;
+      }
+      const Vec3 X =
+          (transform * reconstruction.points3D.at(point3D_id).homogeneous()).hnormalized();
+      EXPECT_LT((X - points3D_.col(p)).norm(), 1e-5);
+      const Span<TrackElement> track = tracks.Track(point3D_id);
+      EXPECT_TRUE(std::any_of(track.begin(), track.end(), [&](const TrackElement &element) {
+        return element.image_id == i && element.point2D_idx == point2D_of_[i][p];
+      }));
+    }
+  }
+  EXPECT_EQ(tracks.NumPoints(), reconstruction.points3D.size());
+}
+
+TEST_F(IncrementalMapperTest, FailsWithoutCalibratedPair) {
+  for (auto &item : geometries_) {
+    item.second.config = estimators::TwoViewConfiguration::UNCALIBRATED;
+  }
+  IncrementalMapper<PinholeCameraBrown> mapper(cameras_);
+  AddImages(&mapper);
+  mapper.AddTwoViewGeometries(geometries_);
+  EXPECT_FALSE(mapper.Reconstruct());
+  EXPECT_EQ(mapper.Reconstruction().images.size(), 0u);
+  EXPECT_THROW(mapper.Reconstruct(), std::logic_error);
+}
+
+TEST_F(IncrementalMapperTest, FailsWithTooFewCorrespondences) {
+  // 每个影像对只有 init_min_num_points - 1 个匹配, 也无法注册其他影像
+  IncrementalMapperOptions options;
+  for (auto &item : geometries_) {
+    item.second.inlier_matches.resize(options.init_min_num_points - 1);
+  }
+  IncrementalMapper<PinholeCameraBrown> mapper(cameras_, options);
+  AddImages(&mapper);
+  mapper.AddTwoViewGeometries(geometries_);
+  EXPECT_FALSE(mapper.Reconstruct());
+  EXPECT_EQ(mapper.Reconstruction().images.size(), 0u);
+  EXPECT_EQ(mapper.Reconstruction().points3D.size(), 0u);
+  EXPECT_EQ(mapper.Summary().init_image_id1, UINvaliedImageId);
+}
+
+TEST_F(IncrementalMapperTest, FailsOnPureRotation) {
+  // 两张影像光心相同, 只有旋转: 本质矩阵的平移任意, 三角化角为零
+  const PinholeCameraBrown &camera = cameras_.at(0);
+  const Vec3 center(0.0, 0.0, -6.0);
+  const CameraExtrinsicParams poses[2] = {
+      CameraExtrinsicParams(Mat33::Identity(), center),
+      CameraExtrinsicParams(
+          Eigen::AngleAxisd(0.1, Vec3(0.2, 1.0, 0.1).normalized()).toRotationMatrix(), center)};
+  IncrementalMapper<PinholeCameraBrown> mapper(cameras_);
+  estimators::TwoViewGeometry geometry;
+  geometry.config = estimators::TwoViewConfiguration::CALIBRATED;
+  for (image_t i = 0; i < 2; ++i) {
+    Mat2X points2D(2, kNumPoints);
+    for (int p = 0; p < kNumPoints; ++p) {
+      points2D.col(p) = camera.project(poses[i](points3D_.col(p)));
+    }
+    mapper.AddImage(i, 0, points2D);
+  }
+  for (int p = 0; p < kNumPoints; ++p) {
+    geometry.inlier_matches.push_back({point2D_t(p), point2D_t(p)});
+  }
+  Flat_Hash_Map<image_pair_t, estimators::TwoViewGeometry> geometries;
+  geometries.emplace(ImagePairToPairId(0, 1), geometry);
+  mapper.AddTwoViewGeometries(geometries);
+
+  EXPECT_FALSE(mapper.Reconstruct());
+  EXPECT_FALSE(mapper.IsRegistered(0));
+  EXPECT_FALSE(mapper.IsRegistered(1));
+  EXPECT_EQ(mapper.Reconstruction().points3D.size(), 0u);
+  EXPECT_EQ(mapper.Tracks().NumPoints(), 0u);
+  EXPECT_EQ(mapper.Point3DId(0, 0), UINvaliedPoint3DId);
+  EXPECT_EQ(mapper.Summary().num_global_bundle_adjustments, 0u);
+}
+
+TEST_F(IncrementalMapperTest, InvalidInput) {
+  IncrementalMapperOptions options;
+  options.global_ba_images_ratio = 1.0;
+  EXPECT_THROW(IncrementalMapper<PinholeCameraBrown>(cameras_, options), std::invalid_argument);
+
+  IncrementalMapper<PinholeCameraBrown> mapper(cameras_);
+  EXPECT_THROW(mapper.AddImage(0, 1, points2D_[0]), std::invalid_argument);
+  mapper.AddImage(0, 0, points2D_[0]);
+  EXPECT_THROW(mapper.AddImage(0, 0, points2D_[0]), std::invalid_argument);
+  // 影像 1 尚未加入
+  EXPECT_THROW(mapper.AddTwoViewGeometries(geometries_), std::invalid_argument);
+}
+
+TEST(CorrespondenceGraphTest, Correspondences) {
+  CorrespondenceGraph graph;
+  graph.AddImage(3, 4);
+  graph.AddImage(7, 2);
+  graph.AddImage(9, 3);
+  graph.AddCorrespondences(3, 7, {{0, 1}, {2, 0}});
+  graph.AddCorrespondences(9, 3, {{1, 0}});
+  EXPECT_THROW(graph.AddCorrespondences(3, 9, {{4, 0}}), std::invalid_argument);
+  EXPECT_THROW(graph.AddCorrespondences(3, 5, {{0, 0}}), std::invalid_argument);
+  graph.Finalize();
+
+  EXPECT_EQ(graph.NumCorrespondences(), 6u);
+  EXPECT_EQ(graph.NumCorrespondencesBetween(7, 3), 2u);
+  EXPECT_EQ(graph.NumCorrespondencesBetween(3, 9), 1u);
+  EXPECT_EQ(graph.NumCorrespondencesBetween(7, 9), 0u);
+
+  const Span<TrackElement> corrs = graph.Correspondences(3, 0);
+  ASSERT_EQ(corrs.size(), 2u);
+  EXPECT_EQ(corrs[0].image_id, 7u);
+  EXPECT_EQ(corrs[0].point2D_idx, 1u);
+  EXPECT_EQ(corrs[1].image_id, 9u);
+  EXPECT_EQ(corrs[1].point2D_idx, 1u);
+  EXPECT_TRUE(graph.Correspondences(3, 1).empty());
+  EXPECT_EQ(graph.Correspondences(7, 0).size(), 1u);
+  EXPECT_THROW(graph.Correspondences(7, 2), std::out_of_range);
+  EXPECT_THROW(graph.AddImage(11, 1), std::logic_error);
+}
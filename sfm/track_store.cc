@@ -0,0 +1,125 @@
+#include "sfm/track_store.hpp"
+#include "utils/profiler.hpp"
+
+namespace photogrammetry {
+namespace sfm {
+
+namespace {
+// 按键计数, 键的顺序为首次出现的顺序
+template <typename Key>
+void CountRows(const std::vector<Key> &row_keys, std::vector<Key> *keys,
+               std::vector<uint32_t> *sizes, std::vector<uint32_t> *rows) {
+  Flat_Hash_Map<Key, uint32_t> row_of;
+  row_of.reserve(row_keys.size() / 4);
+  rows->resize(row_keys.size());
+  for (size_t i = 0; i < row_keys.size(); ++i) {
+    const auto result = row_of.emplace(row_keys[i], static_cast<uint32_t>(keys->size()));
+    if (result.second) {
+      keys->push_back(row_keys[i]);
+      sizes->push_back(0);
+    }
+    (*rows)[i] = result.first->second;
+    ++(*sizes)[result.first->second];
+  }
+}
+} // namespace
+
+void TrackStore::Build(const std::vector<Observation> &observations) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/track_store/build");
+  const size_t num_observations = observations.size();
+  std::vector<point3D_t> point_keys(num_observations);
+  std::vector<image_t> image_keys(num_observations);
+  for (size_t i = 0; i < num_observations; ++i) {
+    point_keys[i] = observations[i].point3D_id;
+    image_keys[i] = observations[i].image_id;
+  }
+
+  // 两遍计数排序: 先统计每行长度, 再按行填充
+  std::vector<point3D_t> point_ids;
+  std::vector<image_t> image_ids;
+  std::vector<uint32_t> track_sizes, image_sizes, point_rows, image_rows;
+  CountRows(point_keys, &point_ids, &track_sizes, &point_rows);
+  CountRows(image_keys, &image_ids, &image_sizes, &image_rows);
+  point_keys = std::vector<point3D_t>();
+  image_keys = std::vector<image_t>();
+
+  std::vector<TrackElement *> track_cursors = tracks_.Allocate(point_ids, track_sizes);
+  std::vector<ImageObservation *> image_cursors = images_.Allocate(image_ids, image_sizes);
+  for (size_t i = 0; i < num_observations; ++i) {
+    const Observation &observation = observations[i];
+    *track_cursors[point_rows[i]]++ = TrackElement{observation.image_id, observation.point2D_idx};
+    *image_cursors[image_rows[i]]++ =
+        ImageObservation{observation.point3D_id, observation.point2D_idx};
+  }
+}
+
+void TrackStore::AddObservation(const point3D_t point3D_id, const image_t image_id,
+                                const point2D_t point2D_idx) {
+  tracks_.Append(point3D_id, TrackElement{image_id, point2D_idx});
+  images_.Append(image_id, ImageObservation{point3D_id, point2D_idx});
+  MaybeCompact();
+}
+
+bool TrackStore::DeleteObservation(const point3D_t point3D_id, const image_t image_id,
+                                   const point2D_t point2D_idx) {
+  const bool erased = tracks_.EraseIf(point3D_id, [&](const TrackElement &element) {
+    return element.image_id == image_id && element.point2D_idx == point2D_idx;
+  });
+  if (!erased) {
+    return false;
+  }
+  images_.EraseIf(image_id, [&](const ImageObservation &observation) {
+    return observation.point3D_id == point3D_id && observation.point2D_idx == point2D_idx;
+  });
+  MaybeCompact();
+  return true;
+}
+
+void TrackStore::DeletePoint(const point3D_t point3D_id) {
+  const Span<TrackElement> track = Track(point3D_id);
+  for (const TrackElement &element : track) {
+    images_.EraseIf(element.image_id, [&](const ImageObservation &observation) {
+      return observation.point3D_id == point3D_id &&
+             observation.point2D_idx == element.point2D_idx;
+    });
+  }
+  tracks_.EraseRow(point3D_id);
+  MaybeCompact();
+}
+
+void TrackStore::MergePoints(const point3D_t point3D_id, const point3D_t other_id) {
+  if (point3D_id == other_id || !HasPoint(other_id)) {
+    return;
+  }
+  // 先复制, 追加可能使 other 的区间失效
+  const Span<TrackElement> other = Track(other_id);
+  const std::vector<TrackElement> elements(other.begin(), other.end());
+  DeletePoint(other_id);
+  for (const TrackElement &element : elements) {
+    tracks_.Append(point3D_id, element);
+    images_.Append(element.image_id, ImageObservation{point3D_id, element.point2D_idx});
+  }
+  MaybeCompact();
+}
+
+void TrackStore::Compact(const bool shrink_to_fit) {
+  PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/track_store/compact");
+  tracks_.Compact(shrink_to_fit);
+  images_.Compact(shrink_to_fit);
+}
+
+void TrackStore::Clear() {
+  tracks_.Clear();
+  images_.Clear();
+}
+
+void TrackStore::MaybeCompact() {
+  // 每条观测在两个索引中各占一个位置
+  if (max_wasted_ratio > 0.0 && NumWastedElements() > 4096 &&
+      static_cast<double>(NumWastedElements()) > max_wasted_ratio * 2.0 * NumObservations()) {
+    Compact(false);
+  }
+}
+
+} // namespace sfm
+} // namespace photogrammetry
@@ -0,0 +1,302 @@
+#ifndef PHOTOGRAMMETRY_SFM_TRACK_STORE_HPP
+#define PHOTOGRAMMETRY_SFM_TRACK_STORE_HPP
+
+#include "camera/std_types.hpp"
+#include "utils/arena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace photogrammetry {
+namespace sfm {
+
+// 轨迹中的一个元素: 三维点在某张影像中的某个二维点
+struct TrackElement {
+  image_t image_id;
+  point2D_t point2D_idx;
+};
+
+// 影像中观测到的一个三维点
+struct ImageObservation {
+  point3D_t point3D_id;
+  point2D_t point2D_idx;
+};
+
+// 批量构建的输入
+struct Observation {
+  point3D_t point3D_id;
+  image_t image_id;
+  point2D_t point2D_idx;
+};
+
+// 只读的连续区间, 在存储被修改之前有效
+template <typename T>
+class Span {
+public:
+  Span() = default;
+  Span(const T *data, const size_t size) : data_(data), size_(size) {}
+
+  const T *begin() const { return data_; }
+  const T *end() const { return data_ + size_; }
+  const T *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T &operator[](const size_t i) const { return data_[i]; }
+
+private:
+  const T *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+namespace detail {
+/*
+ * @brief 按键分行的压缩稀疏行 (CSR) 存储
+ * 每一行是 arena 中的一段连续内存, 行表只记录指针、长度和容量。批量构建时各行紧密排列;
+ * 追加时若行已满, 则以两倍容量在 arena 末尾重新分配该行, 旧的区间成为空洞, 由 Compact 回收;
+ * 容量倍增保证两次压缩之间的追加次数与存储规模同阶, 压缩的代价按追加摊销为常数。
+ * 删除行时与最后一行交换, 行表始终保持稠密。
+ */
+template <typename Key, typename Element>
+class CsrRows {
+public:
+  size_t NumRows() const { return rows_.size(); }
+  size_t NumElements() const { return num_elements_; }
+  const std::vector<Key> &Keys() const { return keys_; }
+
+  bool Contains(const Key key) const { return row_of_.contains(key); }
+
+  Span<Element> Row(const Key key) const {
+    const auto it = row_of_.find(key);
+    if (it == row_of_.end()) {
+      return Span<Element>();
+    }
+    const Extent &row = rows_[it->second];
+    return Span<Element>(row.data, row.size);
+  }
+
+  /*
+   * @brief 按行长度一次性分配所有行, 之前的内容被清空
+   * @param keys 各行的键, 不能重复
+   * @param sizes 各行的长度
+   * @return 各行的起始地址, 由调用者填充
+   */
+  std::vector<Element *> Allocate(const std::vector<Key> &keys,
+                                  const std::vector<uint32_t> &sizes) {
+    Clear();
+    size_t total = 0;
+    for (const uint32_t size : sizes) {
+      total += size;
+    }
+    Element *data = arena_.template Allocate<Element>(total);
+    std::vector<Element *> starts(keys.size());
+    rows_.resize(keys.size());
+    keys_ = keys;
+    row_of_.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      rows_[i] = Extent{data, sizes[i], sizes[i]};
+      starts[i] = data;
+      data += sizes[i];
+      row_of_.emplace(keys[i], static_cast<uint32_t>(i));
+    }
+    num_elements_ = total;
+    return starts;
+  }
+
+  void Append(const Key key, const Element &element) {
+    auto it = row_of_.find(key);
+    if (it == row_of_.end()) {
+      it = row_of_.emplace(key, static_cast<uint32_t>(rows_.size())).first;
+      rows_.push_back(Extent{nullptr, 0, 0});
+      keys_.push_back(key);
+    }
+    Extent &row = rows_[it->second];
+    if (row.size == row.capacity) {
+      const uint32_t capacity = row.capacity < 2 ? 2 : 2 * row.capacity;
+      Element *data = arena_.template Allocate<Element>(capacity);
+      if (row.size > 0) {
+        std::memcpy(data, row.data, row.size * sizeof(Element));
+      }
+      num_wasted_ += row.capacity;
+      row.data = data;
+      row.capacity = capacity;
+    }
+    row.data[row.size++] = element;
+    ++num_elements_;
+  }
+
+  // 删除行中第一个满足 pred 的元素, 行内顺序不保持, 空出的位置留给之后的追加
+  template <typename Pred>
+  bool EraseIf(const Key key, Pred &&pred) {
+    const auto it = row_of_.find(key);
+    if (it == row_of_.end()) {
+      return false;
+    }
+    Extent &row = rows_[it->second];
+    for (uint32_t i = 0; i < row.size; ++i) {
+      if (pred(row.data[i])) {
+        row.data[i] = row.data[--row.size];
+        --num_elements_;
+        if (row.size == 0) {
+          EraseRow(key);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void EraseRow(const Key key) {
+    const auto it = row_of_.find(key);
+    if (it == row_of_.end()) {
+      return;
+    }
+    const uint32_t index = it->second;
+    num_elements_ -= rows_[index].size;
+    num_wasted_ += rows_[index].capacity;
+    row_of_.erase(it);
+    const uint32_t last = static_cast<uint32_t>(rows_.size() - 1);
+    if (index != last) {
+      rows_[index] = rows_[last];
+      keys_[index] = keys_[last];
+      row_of_[keys_[index]] = index;
+    }
+    rows_.pop_back();
+    keys_.pop_back();
+  }
+
+  // arena 中不再属于任何行的位置数: 搬迁后作废的旧区间与被删除的行, 不含行尾的剩余容量
+  size_t NumWastedElements() const { return num_wasted_; }
+
+  /*
+   * @brief 将所有行连续复制到新的 arena 中, 释放空洞
+   * @param shrink_to_fit 为 true 时丢弃行尾的剩余容量; 为 false 时保留, 之后的追加不会立即搬迁
+   */
+  void Compact(const bool shrink_to_fit) {
+    size_t total = 0;
+    for (Extent &row : rows_) {
+      row.capacity = shrink_to_fit ? row.size : row.capacity;
+      total += row.capacity;
+    }
+    utils::Arena arena;
+    Element *data = arena.template Allocate<Element>(total);
+    for (Extent &row : rows_) {
+      if (row.size > 0) {
+        std::memcpy(data, row.data, row.size * sizeof(Element));
+      }
+      row.data = data;
+      data += row.capacity;
+    }
+    arena_ = std::move(arena);
+    num_wasted_ = 0;
+  }
+
+  void Clear() {
+    rows_.clear();
+    keys_.clear();
+    row_of_.clear();
+    arena_.Clear();
+    num_elements_ = 0;
+    num_wasted_ = 0;
+  }
+
+  size_t MemoryUsage() const {
+    return arena_.BytesReserved() + rows_.capacity() * sizeof(Extent) +
+           keys_.capacity() * sizeof(Key) +
+           row_of_.capacity() * (sizeof(std::pair<const Key, uint32_t>) + 1);
+  }
+
+private:
+  // 行在 arena 中的区间
+  struct Extent {
+    Element *data;
+    uint32_t size;
+    uint32_t capacity;
+  };
+
+  std::vector<Extent> rows_;
+  // 每行的键, 与 rows_ 一一对应
+  std::vector<Key> keys_;
+  Flat_Hash_Map<Key, uint32_t> row_of_;
+  utils::Arena arena_;
+  size_t num_elements_ = 0;
+  size_t num_wasted_ = 0;
+};
+} // namespace detail
+
+/*
+ * @brief 三维点轨迹与影像观测的双向索引
+ * 同一组观测保存两份: 按三维点分行的轨迹 (TrackElement) 与按影像分行的观测 (ImageObservation),
+ * 均为 arena 上的 CSR 行, 没有每个点或每张影像的单独堆分配。批量构建一次完成排布;
+ * 增量添加只在行尾追加, 行满时整行搬到 arena 末尾; 删除在行内交换删除。搬迁和删除留下的空间
+ * 由 Compact 回收, 超过 max_wasted_ratio 时自动压缩。
+ * 返回的 Span 在下一次修改存储前有效。不是线程安全的, 但没有写入时可以并发读取。
+ */
+class TrackStore {
+public:
+  // 作废的位置超过有效位置的该比例时, 修改操作后自动压缩, 小于等于 0 时不自动压缩
+  double max_wasted_ratio = 1.0;
+
+  /*
+   * @brief 由观测列表批量构建, 之前的内容被清空
+   * 同一轨迹内按输入顺序排列; 重复的观测会被保留, 调用者负责去重
+   */
+  void Build(const std::vector<Observation> &observations);
+
+  // 追加一条观测, 点或影像不存在时新建
+  void AddObservation(const point3D_t point3D_id, const image_t image_id,
+                      const point2D_t point2D_idx);
+
+  // 删除一条观测, 轨迹为空时删除该点; 不存在时返回 false
+  bool DeleteObservation(const point3D_t point3D_id, const image_t image_id,
+                         const point2D_t point2D_idx);
+
+  // 删除三维点及其全部观测
+  void DeletePoint(const point3D_t point3D_id);
+
+  // 将轨迹 other_id 并入 point3D_id, 并删除 other_id
+  void MergePoints(const point3D_t point3D_id, const point3D_t other_id);
+
+  Span<TrackElement> Track(const point3D_t point3D_id) const {
+    return tracks_.Row(point3D_id);
+  }
+  Span<ImageObservation> ImagePoints(const image_t image_id) const {
+    return images_.Row(image_id);
+  }
+
+  bool HasPoint(const point3D_t point3D_id) const { return tracks_.Contains(point3D_id); }
+  bool HasImage(const image_t image_id) const { return images_.Contains(image_id); }
+  size_t TrackLength(const point3D_t point3D_id) const { return Track(point3D_id).size(); }
+
+  // 所有三维点 / 影像的 id, 顺序在修改后可能变化
+  const std::vector<point3D_t> &PointIds() const { return tracks_.Keys(); }
+  const std::vector<image_t> &ImageIds() const { return images_.Keys(); }
+
+  size_t NumPoints() const { return tracks_.NumRows(); }
+  size_t NumImages() const { return images_.NumRows(); }
+  size_t NumObservations() const { return tracks_.NumElements(); }
+
+  // 重新紧密排布两个索引, 释放全部空闲位置
+  void Compact() { Compact(true); }
+  size_t NumWastedElements() const {
+    return tracks_.NumWastedElements() + images_.NumWastedElements();
+  }
+
+  // 占用的字节数(arena、行表与键映射)
+  size_t MemoryUsage() const { return tracks_.MemoryUsage() + images_.MemoryUsage(); }
+
+  void Clear();
+
+private:
+  void Compact(const bool shrink_to_fit);
+  // 自动压缩保留行尾容量, 否则正在增长的行在压缩后会立即再次搬迁
+  void MaybeCompact();
+
+  detail::CsrRows<point3D_t, TrackElement> tracks_;
+  detail::CsrRows<image_t, ImageObservation> images_;
+};
+
+} // namespace sfm
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_SFM_TRACK_STORE_HPP
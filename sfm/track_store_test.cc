@@ -0,0 +1,142 @@
+#include "sfm/track_store.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+
+using namespace photogrammetry;
+using namespace photogrammetry::sfm;
+
+namespace {
+typedef std::set<std::tuple<point3D_t, image_t, point2D_t>> ObservationSet;
+
+// 分别从两个索引读出全部观测, 两者必须一致
+void ExpectStoreEquals(const TrackStore &store, const ObservationSet &expected) {
+  ObservationSet from_tracks, from_images;
+  for (const point3D_t point3D_id : store.PointIds()) {
+    EXPECT_FALSE(store.Track(point3D_id).empty());
+    for (const TrackElement &element : store.Track(point3D_id)) {
+      from_tracks.emplace(point3D_id, element.image_id, element.point2D_idx);
+    }
+  }
+  for (const image_t image_id : store.ImageIds()) {
+    for (const ImageObservation &observation : store.ImagePoints(image_id)) {
+      from_images.emplace(observation.point3D_id, image_id, observation.point2D_idx);
+    }
+  }
+  EXPECT_EQ(from_tracks, expected);
+  EXPECT_EQ(from_images, expected);
+  EXPECT_EQ(store.NumObservations(), expected.size());
+}
+} // namespace
+
+TEST(TrackStoreTest, BuildsBothIndices) {
+  const std::vector<Observation> observations = {
+      {10, 1, 0}, {10, 2, 5}, {11, 1, 1}, {12, 3, 7}, {11, 3, 2}, {10, 3, 9}};
+  TrackStore store;
+  store.Build(observations);
+  EXPECT_EQ(store.NumPoints(), 3u);
+  EXPECT_EQ(store.NumImages(), 3u);
+  EXPECT_EQ(store.NumObservations(), 6u);
+  EXPECT_EQ(store.NumWastedElements(), 0u);
+
+  // 轨迹内保持输入顺序
+  const Span<TrackElement> track = store.Track(10);
+  ASSERT_EQ(track.size(), 3u);
+  EXPECT_EQ(track[0].image_id, 1u);
+  EXPECT_EQ(track[1].image_id, 2u);
+  EXPECT_EQ(track[2].image_id, 3u);
+  EXPECT_EQ(track[2].point2D_idx, 9u);
+
+  const Span<ImageObservation> points = store.ImagePoints(3);
+  ASSERT_EQ(points.size(), 3u);
+  EXPECT_EQ(points[0].point3D_id, 12u);
+  EXPECT_EQ(points[1].point3D_id, 11u);
+  EXPECT_EQ(points[2].point3D_id, 10u);
+
+  EXPECT_TRUE(store.Track(99).empty());
+  EXPECT_FALSE(store.HasImage(4));
+}
+
+TEST(TrackStoreTest, AppendAndDelete) {
+  TrackStore store;
+  store.Build({{0, 0, 0}, {0, 1, 0}, {1, 0, 1}});
+  store.AddObservation(0, 2, 4);
+  store.AddObservation(2, 2, 5);
+  EXPECT_EQ(store.TrackLength(0), 3u);
+  EXPECT_EQ(store.NumPoints(), 3u);
+  EXPECT_GT(store.NumWastedElements(), 0u);
+
+  EXPECT_TRUE(store.DeleteObservation(0, 1, 0));
+  EXPECT_FALSE(store.DeleteObservation(0, 1, 0));
+  store.DeletePoint(1);
+  EXPECT_FALSE(store.HasPoint(1));
+  ExpectStoreEquals(store, {{0, 0, 0}, {0, 2, 4}, {2, 2, 5}});
+
+  // 删除最后一条观测时点与影像一并删除
+  EXPECT_TRUE(store.DeleteObservation(2, 2, 5));
+  EXPECT_FALSE(store.HasPoint(2));
+  store.DeletePoint(0);
+  EXPECT_EQ(store.NumPoints(), 0u);
+  EXPECT_EQ(store.NumImages(), 0u);
+}
+
+TEST(TrackStoreTest, MergePoints) {
+  TrackStore store;
+  store.Build({{0, 0, 0}, {0, 1, 0}, {1, 2, 3}, {1, 3, 3}});
+  store.MergePoints(0, 1);
+  EXPECT_FALSE(store.HasPoint(1));
+  ExpectStoreEquals(store, {{0, 0, 0}, {0, 1, 0}, {0, 2, 3}, {0, 3, 3}});
+}
+
+TEST(TrackStoreTest, RandomEditsMatchReference) {
+  std::mt19937 rng(3);
+  std::vector<Observation> observations;
+  ObservationSet expected;
+  for (point3D_t point3D_id = 0; point3D_id < 2000; ++point3D_id) {
+    for (image_t image_id = 0; image_id < 50; image_id += 1 + rng() % 20) {
+      observations.push_back({point3D_id, image_id, static_cast<point2D_t>(rng() % 1000)});
+      expected.emplace(point3D_id, image_id, observations.back().point2D_idx);
+    }
+  }
+  TrackStore store;
+  store.Build(observations);
+  ExpectStoreEquals(store, expected);
+
+  for (int i = 0; i < 20000; ++i) {
+    const point3D_t point3D_id = rng() % 2500;
+    const image_t image_id = rng() % 60;
+    const point2D_t point2D_idx = rng() % 1000;
+    if (rng() % 4 != 0) {
+      if (expected.emplace(point3D_id, image_id, point2D_idx).second) {
+        store.AddObservation(point3D_id, image_id, point2D_idx);
+      }
+    } else if (store.HasPoint(point3D_id)) {
+      const TrackElement element = store.Track(point3D_id)[0];
+      EXPECT_TRUE(store.DeleteObservation(point3D_id, element.image_id, element.point2D_idx));
+      expected.erase(std::make_tuple(point3D_id, element.image_id, element.point2D_idx));
+    }
+  }
+  ExpectStoreEquals(store, expected);
+
+  store.Compact();
+  EXPECT_EQ(store.NumWastedElements(), 0u);
+  ExpectStoreEquals(store, expected);
+}
+
+TEST(TrackStoreTest, AutomaticCompaction) {
+  TrackStore store;
+  store.max_wasted_ratio = 0.5;
+  for (point3D_t point3D_id = 0; point3D_id < 10000; ++point3D_id) {
+    for (image_t image_id = 0; image_id < 5; ++image_id) {
+      store.AddObservation(point3D_id, image_id, static_cast<point2D_t>(point3D_id));
+    }
+  }
+  // 每次搬迁都会留下旧区间, 自动压缩使作废的位置保持在上限以内
+  EXPECT_LE(store.NumWastedElements(), store.NumObservations());
+  EXPECT_EQ(store.NumObservations(), 50000u);
+  EXPECT_EQ(store.TrackLength(1234), 5u);
+  EXPECT_EQ(store.ImagePoints(4).size(), 10000u);
+}
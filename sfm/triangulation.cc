@@ -0,0 +1,111 @@
+#include "sfm/triangulation.hpp"
+#include <Eigen/Eigenvalues>
+#include <limits>
+
+namespace photogrammetry {
+namespace sfm {
+namespace internal {
+
+bool TriangulateMultiViewDLT(const Mat34 *projections, const TrackObservation *observations,
+                             const Vec2 *points2D, const char *inlier_mask,
+                             const size_t num_observations, Vec3 *xyz) {
+  // 每次观测贡献两行 x * P3 - P1 与 y * P3 - P2, 归一化后各视图的权重相同
+  Mat44 AtA = Mat44::Zero();
+  for (size_t i = 0; i < num_observations; ++i) {
+    if (!inlier_mask[i]) {
+      continue;
+    }
+    const Mat34 &P = projections[observations[i].view_idx];
+    const Vec4 row1 = (points2D[i].x() * P.row(2) - P.row(0)).transpose();
+    const Vec4 row2 = (points2D[i].y() * P.row(2) - P.row(1)).transpose();
+    AtA.noalias() += row1 * row1.transpose() / row1.squaredNorm();
+    AtA.noalias() += row2 * row2.transpose() / row2.squaredNorm();
+  }
+  const Eigen::SelfAdjointEigenSolver<Mat44> solver(AtA);
+  if (solver.info() != Eigen::Success) {
+    return false;
+  }
+  const Vec4 X = solver.eigenvectors().col(0);
+  if (std::abs(X(3)) <= std::numeric_limits<double>::epsilon() * X.head<3>().norm()) {
+    return false;
+  }
+  *xyz = X.hnormalized();
+  return xyz->allFinite();
+}
+
+void RefineTriangulation(const Mat34 *projections, const TrackObservation *observations,
+                         const Vec2 *points2D, const char *inlier_mask,
+                         const size_t num_observations, const int num_iterations, Vec3 *xyz) {
+  double last_cost = std::numeric_limits<double>::max();
+  Vec3 last_xyz = *xyz;
+  for (int iteration = 0; iteration <= num_iterations; ++iteration) {
+    // 在当前点处同时求代价与法方程
+    Mat33 H = Mat33::Zero();
+    Vec3 g = Vec3::Zero();
+    double cost = 0.0;
+    for (size_t i = 0; i < num_observations; ++i) {
+      if (!inlier_mask[i]) {
+        continue;
+      }
+      const Mat34 &P = projections[observations[i].view_idx];
+      const Vec3 p = P.leftCols<3>() * *xyz + P.col(3);
+      if (p.z() <= 0.0) {
+        continue;
+      }
+      const double inv_z = 1.0 / p.z();
+      const Vec2 projected(p.x() * inv_z, p.y() * inv_z);
+      const Vec2 r = projected - points2D[i];
+      Eigen::Matrix<double, 2, 3> J;
+      J.row(0) = inv_z * (P.block<1, 3>(0, 0) - projected.x() * P.block<1, 3>(2, 0));
+      J.row(1) = inv_z * (P.block<1, 3>(1, 0) - projected.y() * P.block<1, 3>(2, 0));
+      H.noalias() += J.transpose() * J;
+      g.noalias() += J.transpose() * r;
+      cost += r.squaredNorm();
+    }
+    if (cost > last_cost) {
+      *xyz = last_xyz;
+      return;
+    }
+    if (iteration == num_iterations) {
+      return;
+    }
+    const Eigen::LDLT<Mat33> ldlt(H);
+    if (ldlt.info() != Eigen::Success) {
+      return;
+    }
+    const Vec3 delta = ldlt.solve(-g);
+    if (!delta.allFinite()) {
+      return;
+    }
+    last_cost = cost;
+    last_xyz = *xyz;
+    *xyz += delta;
+    if (delta.squaredNorm() <= 1e-20 * (1.0 + xyz->squaredNorm())) {
+      return;
+    }
+  }
+}
+
+double MaxTriangulationAngle(const Vec3 *centers, const TrackObservation *observations,
+                             const char *inlier_mask, const size_t num_observations,
+                             const Vec3 &xyz) {
+  // 夹角最大即方向余弦最小
+  double min_cos = 1.0;
+  for (size_t i = 0; i < num_observations; ++i) {
+    if (!inlier_mask[i]) {
+      continue;
+    }
+    const Vec3 ray1 = (xyz - centers[observations[i].view_idx]).normalized();
+    for (size_t j = i + 1; j < num_observations; ++j) {
+      if (inlier_mask[j]) {
+        const Vec3 ray2 = (xyz - centers[observations[j].view_idx]).normalized();
+        min_cos = std::min(min_cos, ray1.dot(ray2));
+      }
+    }
+  }
+  return std::acos(std::max(-1.0, min_cos));
+}
+
+} // namespace internal
+} // namespace sfm
+} // namespace photogrammetry
@@ -0,0 +1,272 @@
+#ifndef PHOTOGRAMMETRY_SFM_TRIANGULATION_HPP
+#define PHOTOGRAMMETRY_SFM_TRIANGULATION_HPP
+
+#include "camera/camera_parametres.hpp"
+#include "core/eigen_types.hpp"
+#include "utils/profiler.hpp"
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace photogrammetry {
+namespace sfm {
+
+struct TriangulationOptions {
+  // 内点观测的最大重投影误差(像素)
+  double max_reprojection_error = 4.0;
+  // 最小三角化角(度): 内点观测的视线两两之间的最大夹角须不小于该值
+  double min_triangulation_angle = 1.5;
+  // DLT 之后最小化重投影误差的 Gauss-Newton 迭代次数, 0 表示只做 DLT
+  int num_refinement_iterations = 5;
+  // 剔除外点后重新三角化的最大次数, 即每条轨迹在估计中最多剔除的观测数
+  int max_num_reestimations = 2;
+  // -1 表示使用全部硬件线程
+  int num_threads = -1;
+
+  bool Check() const {
+    return max_reprojection_error > 0.0 && min_triangulation_angle >= 0.0 &&
+           min_triangulation_angle < 180.0 && num_refinement_iterations >= 0 &&
+           max_num_reestimations >= 0;
+  }
+};
+
+// 轨迹中的一次观测: 影像在 Triangulator 视图表中的下标与(带畸变的)像素坐标
+struct TrackObservation {
+  uint32_t view_idx;
+  Vec2 point2D;
+};
+
+struct TriangulatedPoint {
+  Vec3 xyz = Vec3::Zero();
+  bool success = false;
+  uint32_t num_inliers = 0;
+  // 内点观测的视线之间的最大夹角(弧度)
+  double triangulation_angle = 0.0;
+  // 内点的平均重投影误差(像素)
+  double mean_reprojection_error = 0.0;
+};
+
+template <typename CameraType>
+struct TriangulationView {
+  const CameraType *camera = nullptr;
+  camera::CameraExtrinsicParams pose;
+};
+
+// 相机模型(含畸变)下的重投影误差平方, 点在相机后方时为无穷大
+template <typename CameraType>
+double SquaredReprojectionError(const CameraType &camera, const camera::CameraExtrinsicParams &pose,
+                                const Vec3 &xyz, const Vec2 &point2D) {
+  const Vec3 X_cam = pose.Rotation() * (xyz - pose.Center());
+  if (X_cam.z() <= 0.0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return camera.residual(X_cam, point2D).squaredNorm();
+}
+
+namespace internal {
+constexpr double kPi = 3.14159265358979323846;
+
+/*
+ * 以下函数只使用 inlier_mask 非零的观测; projections 以 TrackObservation::view_idx 为下标,
+ * points2D 为去畸变后的像素坐标。全部使用固定尺寸的矩阵, 不分配内存。
+ */
+
+// 多视图 DLT: 累加逐行归一化的 4x4 法方程并取最小特征向量, 点在无穷远处时返回 false
+bool TriangulateMultiViewDLT(const Mat34 *projections, const TrackObservation *observations,
+                             const Vec2 *points2D, const char *inlier_mask, size_t num_observations,
+                             Vec3 *xyz);
+
+// Gauss-Newton 最小化针孔投影下的重投影误差, 代价上升时保留上一次的结果并停止
+void RefineTriangulation(const Mat34 *projections, const TrackObservation *observations,
+                         const Vec2 *points2D, const char *inlier_mask, size_t num_observations,
+                         int num_iterations, Vec3 *xyz);
+
+// 视线 xyz - C 两两之间的最大夹角(弧度), centers 以 view_idx 为下标
+double MaxTriangulationAngle(const Vec3 *centers, const TrackObservation *observations,
+                             const char *inlier_mask, size_t num_observations, const Vec3 &xyz);
+} // namespace internal
+
+/*
+ * @brief 批量多视图三角化
+ * 每条轨迹先用去畸变的观测做 DLT, 再以 Gauss-Newton 细化; 若有观测在相机模型下的重投影误差
+ * 超过阈值或深度非正, 剔除误差最大的一个后重新三角化。最后以全部观测的检验结果作为内点,
+ * 内点少于 2 个或三角化角过小的点视为失败。
+ * 各视图的投影矩阵 ProjectionMatrix(pose) 与光心在构造时预先计算。
+ * 轨迹按 CSR 形式给出, 在 OpenMP 线程间动态分配; 每条轨迹只使用固定尺寸的线性代数与整批预先
+ * 分配的缓冲区, 不分配堆内存。
+ */
+template <typename CameraType>
+class Triangulator {
+public:
+  typedef TriangulationView<CameraType> View;
+
+  /*
+   * @param views 参与三角化的影像, 相机须在三角化期间有效
+   */
+  explicit Triangulator(std::vector<View> views,
+                        const TriangulationOptions &options = TriangulationOptions())
+      : options_(options), views_(std::move(views)) {
+    if (!options_.Check()) {
+      throw std::invalid_argument("Invalid triangulation options");
+    }
+    projections_.reserve(views_.size());
+    centers_.reserve(views_.size());
+    for (const View &view : views_) {
+      if (view.camera == nullptr) {
+        throw std::invalid_argument("Triangulation view without camera");
+      }
+      projections_.push_back(view.camera->ProjectionMatrix(view.pose));
+      centers_.push_back(view.pose.Center());
+    }
+  }
+
+  const TriangulationOptions &Options() const { return options_; }
+  size_t NumViews() const { return views_.size(); }
+
+  /*
+   * @brief 三角化一条轨迹, 可以被多个线程同时调用
+   * @param points2D 长度为 num_observations 的临时缓冲区, 写入去畸变后的像素坐标
+   * @param inlier_mask 长度为 num_observations, 输出各观测是否为内点
+   */
+  TriangulatedPoint TriangulateTrack(const TrackObservation *observations,
+                                     const size_t num_observations, Vec2 *points2D,
+                                     char *inlier_mask) const {
+    TriangulatedPoint point;
+    for (size_t i = 0; i < num_observations; ++i) {
+      const CameraType &camera = *views_[observations[i].view_idx].camera;
+      points2D[i] = camera.cam2ima(camera.undistort(camera.ima2cam(observations[i].point2D)));
+      inlier_mask[i] = 1;
+    }
+
+    const double max_squared_error =
+        options_.max_reprojection_error * options_.max_reprojection_error;
+    size_t num_used = num_observations;
+    for (int round = 0;; ++round) {
+      if (num_used < 2 ||
+          !internal::TriangulateMultiViewDLT(projections_.data(), observations, points2D,
+                                             inlier_mask, num_observations, &point.xyz)) {
+        std::fill(inlier_mask, inlier_mask + num_observations, 0);
+        return point;
+      }
+      internal::RefineTriangulation(projections_.data(), observations, points2D, inlier_mask,
+                                    num_observations, options_.num_refinement_iterations,
+                                    &point.xyz);
+      if (round == options_.max_num_reestimations) {
+        break;
+      }
+      // 剔除参与估计的观测中误差最大的外点后重新三角化
+      size_t worst = num_observations;
+      double worst_error = max_squared_error;
+      for (size_t i = 0; i < num_observations; ++i) {
+        if (inlier_mask[i]) {
+          const double squared_error = SquaredReprojectionError(observations[i], point.xyz);
+          if (squared_error > worst_error) {
+            worst = i;
+            worst_error = squared_error;
+          }
+        }
+      }
+      if (worst == num_observations) {
+        break;
+      }
+      inlier_mask[worst] = 0;
+      --num_used;
+    }
+
+    // 在相机模型(含畸变)下检验全部观测, 被剔除的观测也可以重新成为内点
+    double sum_error = 0.0;
+    for (size_t i = 0; i < num_observations; ++i) {
+      const double squared_error = SquaredReprojectionError(observations[i], point.xyz);
+      inlier_mask[i] = squared_error <= max_squared_error;
+      if (inlier_mask[i]) {
+        ++point.num_inliers;
+        sum_error += std::sqrt(squared_error);
+      }
+    }
+    point.mean_reprojection_error = point.num_inliers > 0 ? sum_error / point.num_inliers : 0.0;
+
+    if (point.num_inliers < 2) {
+      return point;
+    }
+    point.triangulation_angle = internal::MaxTriangulationAngle(
+        centers_.data(), observations, inlier_mask, num_observations, point.xyz);
+    point.success =
+        point.triangulation_angle >= options_.min_triangulation_angle * internal::kPi / 180.0;
+    return point;
+  }
+
+  /*
+   * @brief 并行三角化一批轨迹
+   * @param track_offsets 轨迹 t 的观测为 observations[track_offsets[t], track_offsets[t + 1])
+   * @param inlier_mask 可选, 输出与 observations 一一对应的内点标记
+   * @return 每条轨迹的结果
+   */
+  std::vector<TriangulatedPoint> Triangulate(const std::vector<size_t> &track_offsets,
+                                             const std::vector<TrackObservation> &observations,
+                                             std::vector<char> *inlier_mask = nullptr) const {
+    PHOTOGRAMMETRY_PROFILE_SCOPE("sfm/triangulate");
+    if (track_offsets.empty() || track_offsets.front() != 0 ||
+        track_offsets.back() != observations.size()) {
+      throw std::invalid_argument("Track offsets do not cover the observations");
+    }
+    for (size_t t = 1; t < track_offsets.size(); ++t) {
+      if (track_offsets[t] < track_offsets[t - 1]) {
+        throw std::invalid_argument("Track offsets must be non-decreasing");
+      }
+    }
+    for (const TrackObservation &observation : observations) {
+      if (observation.view_idx >= views_.size()) {
+        throw std::out_of_range("Observation references unknown view " +
+                                std::to_string(observation.view_idx));
+      }
+    }
+
+    const int64_t num_tracks = static_cast<int64_t>(track_offsets.size()) - 1;
+    std::vector<TriangulatedPoint> points(num_tracks);
+    std::vector<Vec2> points2D(observations.size());
+    std::vector<char> local_mask;
+    if (inlier_mask == nullptr) {
+      inlier_mask = &local_mask;
+    }
+    inlier_mask->resize(observations.size());
+
+    [[maybe_unused]] const int num_threads = utils::GetEffectiveNumThreads(options_.num_threads);
+    size_t num_success = 0;
+    // 轨迹长度不一, 动态分配以平衡负载
+#ifdef PHOTOGRAMMETRY_OPENMP_ENABLED
+#pragma omp parallel for schedule(dynamic, 256) num_threads(num_threads) \
+    reduction(+ : num_success)
+#endif
+    for (int64_t t = 0; t < num_tracks; ++t) {
+      const size_t begin = track_offsets[t];
+      const size_t size = track_offsets[t + 1] - begin;
+      points[t] = TriangulateTrack(observations.data() + begin, size, points2D.data() + begin,
+                                   inlier_mask->data() + begin);
+      num_success += points[t].success;
+    }
+    PHOTOGRAMMETRY_PROFILE_COUNT("sfm/triangulated_points", num_success);
+    return points;
+  }
+
+private:
+  double SquaredReprojectionError(const TrackObservation &observation, const Vec3 &xyz) const {
+    const View &view = views_[observation.view_idx];
+    return sfm::SquaredReprojectionError(*view.camera, view.pose, xyz, observation.point2D);
+  }
+
+  TriangulationOptions options_;
+  std::vector<View> views_;
+  std::vector<Mat34> projections_;
+  std::vector<Vec3> centers_;
+};
+
+} // namespace sfm
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_SFM_TRIANGULATION_HPP
@@ -0,0 +1,62 @@
+#include "sfm/triangulation.hpp"
+#include "camera/pinhole_model.hpp"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace photogrammetry;
+using namespace photogrammetry::camera;
+using namespace photogrammetry::sfm;
+
+// state.range(0) 条轨迹, 每条在 2 到 8 个视图中观测, 带 0.5 像素噪声与 5% 的外点观测
+static void BM_Triangulate(benchmark::State &state) {
+  auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+  params->fx = 1000.0;
+  params->fy = 1000.0;
+  params->cx = 640.0;
+  params->cy = 480.0;
+  params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+  const auto camera = std::make_unique<PinholeCameraBrown>(0, 1280, 960, params);
+
+  constexpr int kNumViews = 16;
+  std::vector<Triangulator<PinholeCameraBrown>::View> views;
+  for (int i = 0; i < kNumViews; ++i) {
+    const double t = i / double(kNumViews - 1);
+    views.push_back({camera.get(), CameraExtrinsicParams(Eigen::AngleAxisd(0.2 * (t - 0.5),
+                                                                           Vec3::UnitY())
+                                                             .toRotationMatrix(),
+                                                         Vec3(6.0 * t - 3.0, 0.0, -6.0))});
+  }
+  const Triangulator<PinholeCameraBrown> triangulator(views);
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::uniform_int_distribution<int> length(2, 8);
+  std::uniform_int_distribution<int> first_view(0, kNumViews - 8);
+  std::normal_distribution<double> noise(0.0, 0.5);
+  std::vector<size_t> offsets = {0};
+  std::vector<TrackObservation> observations;
+  for (int64_t t = 0; t < state.range(0); ++t) {
+    const Vec3 X(uniform(rng), uniform(rng), uniform(rng));
+    const int begin = first_view(rng);
+    const int num_views = length(rng);
+    for (int v = begin; v < begin + num_views; ++v) {
+      const Vec3 X_cam = views[v].pose.Rotation() * (X - views[v].pose.Center());
+      Vec2 x = camera->project(X_cam) + Vec2(noise(rng), noise(rng));
+      if (uniform(rng) > 0.9) {
+        x += Vec2(50.0, 50.0);
+      }
+      observations.push_back({static_cast<uint32_t>(v), x});
+    }
+    offsets.push_back(observations.size());
+  }
+
+  std::vector<char> inlier_mask;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(triangulator.Triangulate(offsets, observations, &inlier_mask));
+  }
+  state.counters["tracks/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * state.range(0), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Triangulate)->Arg(100000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,170 @@
+#include "sfm/triangulation.hpp"
+#include "camera/pinhole_model.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+
+using namespace photogrammetry;
+using namespace photogrammetry::camera;
+using namespace photogrammetry::sfm;
+
+class TriangulationTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    auto *params = new PinholeCameraInitParams(CameraModelType::PINHOLE_CAMERA_BROWN);
+    params->fx = 1000.0;
+    params->fy = 1010.0;
+    params->cx = 640.0;
+    params->cy = 480.0;
+    params->distortion = {-0.12, 0.03, -0.002, 0.0005, -0.0003};
+    camera_ = std::make_unique<PinholeCameraBrown>(0, 1280, 960, params);
+
+    // 影像位于 z = -6 平面上, 朝向 +z 方向
+    for (int i = 0; i < 6; ++i) {
+      const double t = i / 5.0;
+      views_.push_back(
+          {camera_.get(), CameraExtrinsicParams(Eigen::AngleAxisd(0.1 * (t - 0.5),
+                                                             Vec3(0.3, 1.0, 0.1).normalized())
+                                               .toRotationMatrix(),
+                                           Vec3(4.0 * t - 2.0, 0.5 * t, -6.0))});
+    }
+  }
+
+  TrackObservation Observe(const uint32_t view_idx, const Vec3 &X) const {
+    const CameraExtrinsicParams &pose = views_[view_idx].pose;
+    return {view_idx, camera_->project(pose.Rotation() * (X - pose.Center()))};
+  }
+
+  std::unique_ptr<PinholeCameraBrown> camera_;
+  std::vector<Triangulator<PinholeCameraBrown>::View> views_;
+};
+
+TEST_F(TriangulationTest, ExactObservations) {
+  const Triangulator<PinholeCameraBrown> triangulator(views_);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::uniform_int_distribution<int> length(2, 6);
+
+  std::vector<Vec3> points;
+  std::vector<size_t> offsets = {0};
+  std::vector<TrackObservation> observations;
+  for (int t = 0; t < 500; ++t) {
+    points.emplace_back(uniform(rng), uniform(rng), uniform(rng));
+    // 取连续的 length 个视图, 两端的视图间距保证足够的三角化角
+    const int num_views = length(rng);
+    observations.push_back(Observe(0, points.back()));
+    for (int v = 6 - num_views + 1; v < 6; ++v) {
+      observations.push_back(Observe(v, points.back()));
+    }
+    offsets.push_back(observations.size());
+  }
+
+  std::vector<char> inlier_mask;
+  const std::vector<TriangulatedPoint> result =
+      triangulator.Triangulate(offsets, observations, &inlier_mask);
+  ASSERT_EQ(result.size(), points.size());
+  for (size_t t = 0; t < points.size(); ++t) {
+    ASSERT_TRUE(result[t].success) << t;
+    EXPECT_LT((result[t].xyz - points[t]).norm(), 1e-6);
+    EXPECT_EQ(result[t].num_inliers, offsets[t + 1] - offsets[t]);
+    EXPECT_LT(result[t].mean_reprojection_error, 1e-6);
+    EXPECT_GT(result[t].triangulation_angle, 0.4);
+  }
+  for (const char inlier : inlier_mask) {
+    EXPECT_TRUE(inlier);
+  }
+}
+
+TEST_F(TriangulationTest, NoisyObservationsAreRefined) {
+  TriangulationOptions options;
+  options.num_refinement_iterations = 0;
+  const Triangulator<PinholeCameraBrown> dlt(views_, options);
+  options.num_refinement_iterations = 10;
+  const Triangulator<PinholeCameraBrown> refined(views_, options);
+
+  std::mt19937 rng(5);
+  std::normal_distribution<double> noise(0.0, 1.0);
+  std::vector<TrackObservation> observations;
+  const Vec3 X(0.3, -0.2, 0.5);
+  for (uint32_t v = 0; v < 6; ++v) {
+    observations.push_back(Observe(v, X));
+    observations.back().point2D += Vec2(noise(rng), noise(rng));
+  }
+  std::vector<Vec2> points2D(observations.size());
+  std::vector<char> inlier_mask(observations.size());
+  const TriangulatedPoint dlt_point = dlt.TriangulateTrack(
+      observations.data(), observations.size(), points2D.data(), inlier_mask.data());
+  const TriangulatedPoint refined_point = refined.TriangulateTrack(
+      observations.data(), observations.size(), points2D.data(), inlier_mask.data());
+  ASSERT_TRUE(dlt_point.success);
+  ASSERT_TRUE(refined_point.success);
+  // 细化最小化的是重投影误差, 结果不会比代数误差的解差
+  EXPECT_LE(refined_point.mean_reprojection_error, dlt_point.mean_reprojection_error + 1e-9);
+  EXPECT_LT((refined_point.xyz - X).norm(), 0.05);
+}
+
+TEST_F(TriangulationTest, OutlierObservationIsRejected) {
+  const Triangulator<PinholeCameraBrown> triangulator(views_);
+  const Vec3 X(-0.4, 0.6, 0.2);
+  std::vector<TrackObservation> observations;
+  for (uint32_t v = 0; v < 6; ++v) {
+    observations.push_back(Observe(v, X));
+  }
+  observations[2].point2D += Vec2(60.0, -45.0);
+  std::vector<Vec2> points2D(observations.size());
+  std::vector<char> inlier_mask(observations.size());
+  const TriangulatedPoint point = triangulator.TriangulateTrack(
+      observations.data(), observations.size(), points2D.data(), inlier_mask.data());
+  ASSERT_TRUE(point.success);
+  EXPECT_EQ(point.num_inliers, 5u);
+  EXPECT_FALSE(inlier_mask[2]);
+  EXPECT_LT((point.xyz - X).norm(), 1e-6);
+}
+
+TEST_F(TriangulationTest, SmallTriangulationAngleIsRejected) {
+  // 两个光心相距 1 mm 的视图
+  std::vector<Triangulator<PinholeCameraBrown>::View> views = {views_[0], views_[0]};
+  views[1].pose.Center() += Vec3(1e-3, 0.0, 0.0);
+  const Triangulator<PinholeCameraBrown> triangulator(views);
+  const Vec3 X(0.1, 0.2, 0.3);
+  std::vector<TrackObservation> observations = {{0, Vec2::Zero()}, {1, Vec2::Zero()}};
+  for (TrackObservation &observation : observations) {
+    const CameraExtrinsicParams &pose = views[observation.view_idx].pose;
+    observation.point2D = camera_->project(pose.Rotation() * (X - pose.Center()));
+  }
+  std::vector<Vec2> points2D(2);
+  std::vector<char> inlier_mask(2);
+  const TriangulatedPoint point =
+      triangulator.TriangulateTrack(observations.data(), 2, points2D.data(), inlier_mask.data());
+  EXPECT_FALSE(point.success);
+  EXPECT_EQ(point.num_inliers, 2u);
+  EXPECT_LT(point.triangulation_angle, 1.5 * sfm::internal::kPi / 180.0);
+}
+
+TEST_F(TriangulationTest, DegenerateTracksFail) {
+  const Triangulator<PinholeCameraBrown> triangulator(views_);
+  const Vec3 X(0.0, 0.0, 1.0);
+  // 空轨迹, 单个观测, 以及同一视图的重复观测
+  const std::vector<size_t> offsets = {0, 0, 1, 3};
+  const std::vector<TrackObservation> observations = {Observe(0, X), Observe(1, X),
+                                                      Observe(1, X)};
+  const std::vector<TriangulatedPoint> result = triangulator.Triangulate(offsets, observations);
+  ASSERT_EQ(result.size(), 3u);
+  for (const TriangulatedPoint &point : result) {
+    EXPECT_FALSE(point.success);
+  }
+}
+
+TEST_F(TriangulationTest, InvalidInput) {
+  TriangulationOptions options;
+  options.max_reprojection_error = 0.0;
+  EXPECT_THROW(Triangulator<PinholeCameraBrown>(views_, options), std::invalid_argument);
+  std::vector<Triangulator<PinholeCameraBrown>::View> views = views_;
+  views[3].camera = nullptr;
+  EXPECT_THROW(Triangulator<PinholeCameraBrown>{views}, std::invalid_argument);
+
+  const Triangulator<PinholeCameraBrown> triangulator(views_);
+  const std::vector<TrackObservation> observations = {{0, Vec2(1.0, 2.0)}, {6, Vec2(3.0, 4.0)}};
+  EXPECT_THROW(triangulator.Triangulate({0, 1}, observations), std::invalid_argument);
+  EXPECT_THROW(triangulator.Triangulate({0, 2}, observations), std::out_of_range);
+}
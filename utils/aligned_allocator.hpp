@@ -0,0 +1,49 @@
+#ifndef PHOTOGRAMMETRY_UTILS_ALIGNED_ALLOCATOR_HPP
+#define PHOTOGRAMMETRY_UTILS_ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace photogrammetry {
+namespace utils {
+
+/**
+ * @brief Standard allocator returning Alignment aligned memory, e.g. for SIMD loads of rows
+ */
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+  static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of two and at least alignof(T)");
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind {
+    typedef AlignedAllocator<U, Alignment> other;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+  T *allocate(const size_t n) {
+    return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+  void deallocate(T *p, const size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Alignment> &) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U, Alignment> &) const {
+    return false;
+  }
+};
+
+template <typename T, size_t Alignment = 64>
+using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
+} // namespace utils
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_UTILS_ALIGNED_ALLOCATOR_HPP
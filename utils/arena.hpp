@@ -0,0 +1,127 @@
+#ifndef PHOTOGRAMMETRY_UTILS_ARENA_HPP
+#define PHOTOGRAMMETRY_UTILS_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace photogrammetry {
+namespace utils {
+
+/**
+ * @brief Bump allocator for arrays of trivially copyable elements
+ *
+ * Memory is taken from large cache line aligned blocks and is only returned all at once by
+ * Clear or the destructor. Requests larger than the block size get a dedicated block, so big
+ * arrays never waste the rest of the current block. Allocated memory never moves.
+ *
+ * Not thread safe.
+ */
+class Arena {
+public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kDefaultBlockSize = size_t(4) << 20;
+
+  explicit Arena(const size_t block_size = kDefaultBlockSize) : block_size_(block_size) {}
+  ~Arena() { Clear(); }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  Arena(Arena &&other) noexcept { swap(other); }
+  Arena &operator=(Arena &&other) noexcept {
+    if (this != &other) {
+      Clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  void swap(Arena &other) noexcept {
+    using std::swap;
+    swap(block_size_, other.block_size_);
+    swap(blocks_, other.blocks_);
+    swap(cursor_, other.cursor_);
+    swap(remaining_, other.remaining_);
+    swap(bytes_reserved_, other.bytes_reserved_);
+    swap(bytes_used_, other.bytes_used_);
+  }
+
+  /**
+   * @brief Uninitialized storage for count elements of T
+   * @return nullptr if count is 0
+   */
+  template <typename T>
+  T *Allocate(const size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                  "Arena only holds trivially copyable elements");
+    static_assert(alignof(T) <= kAlignment, "Element alignment exceeds the arena alignment");
+    return static_cast<T *>(AllocateBytes(count * sizeof(T), alignof(T)));
+  }
+
+  void *AllocateBytes(const size_t num_bytes, const size_t alignment) {
+    if (num_bytes == 0) {
+      return nullptr;
+    }
+    const size_t misalignment = reinterpret_cast<uintptr_t>(cursor_) % alignment;
+    const size_t padding = misalignment == 0 ? 0 : alignment - misalignment;
+    if (cursor_ != nullptr && padding + num_bytes <= remaining_) {
+      void *result = cursor_ + padding;
+      cursor_ += padding + num_bytes;
+      remaining_ -= padding + num_bytes;
+      bytes_used_ += num_bytes;
+      return result;
+    }
+    if (num_bytes > block_size_ / 4) {
+      // Dedicated block, the current block keeps serving small requests
+      bytes_used_ += num_bytes;
+      return NewBlock(num_bytes);
+    }
+    cursor_ = static_cast<uint8_t *>(NewBlock(block_size_));
+    remaining_ = block_size_ - num_bytes;
+    void *result = cursor_;
+    cursor_ += num_bytes;
+    bytes_used_ += num_bytes;
+    return result;
+  }
+
+  // Release all blocks, every pointer handed out becomes invalid
+  void Clear() {
+    for (void *block : blocks_) {
+      ::operator delete(block, std::align_val_t(kAlignment));
+    }
+    blocks_.clear();
+    cursor_ = nullptr;
+    remaining_ = 0;
+    bytes_reserved_ = 0;
+    bytes_used_ = 0;
+  }
+
+  // Bytes of all blocks
+  size_t BytesReserved() const { return bytes_reserved_; }
+  // Bytes handed out by Allocate
+  size_t BytesUsed() const { return bytes_used_; }
+
+private:
+  void *NewBlock(const size_t num_bytes) {
+    void *data = ::operator new(num_bytes, std::align_val_t(kAlignment));
+    blocks_.push_back(data);
+    bytes_reserved_ += num_bytes;
+    return data;
+  }
+
+  size_t block_size_ = kDefaultBlockSize;
+  std::vector<void *> blocks_;
+  uint8_t *cursor_ = nullptr;
+  size_t remaining_ = 0;
+  size_t bytes_reserved_ = 0;
+  size_t bytes_used_ = 0;
+};
+} // namespace utils
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_UTILS_ARENA_HPP
@@ -0,0 +1,566 @@
+#ifndef PHOTOGRAMMETRY_UTILS_FLAT_HASH_MAP_HPP
+#define PHOTOGRAMMETRY_UTILS_FLAT_HASH_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHOTOGRAMMETRY_FLAT_HASH_MAP_SSE2
+#endif
+
+namespace photogrammetry {
+namespace utils {
+
+/**
+ * @brief Finalizer of splitmix64, every input bit affects every output bit
+ *
+ * Used to spread identity hashes of integer ids (std::hash<uint64_t> on libstdc++) and to combine
+ * the members of composite keys.
+ */
+constexpr uint64_t MixHash(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+namespace detail {
+
+// Control byte of a slot: kEmpty and kDeleted have the sign bit set, a full slot stores the low
+// 7 bits of the hash of its key
+typedef int8_t ctrl_t;
+constexpr ctrl_t kCtrlEmpty = -128;
+constexpr ctrl_t kCtrlDeleted = -2;
+
+// Slots are probed in groups of 16 control bytes, one SSE2 compare per group
+constexpr size_t kGroupWidth = 16;
+
+// Bit i is set for every byte i of a group that satisfies the query
+class GroupMask {
+public:
+  explicit GroupMask(const uint32_t mask) : mask_(mask) {}
+  explicit operator bool() const { return mask_ != 0; }
+  int LowestBit() const {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask_);
+#else
+    int bit = 0;
+    while (((mask_ >> bit) & 1u) == 0) {
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+  void ClearLowestBit() { mask_ &= mask_ - 1; }
+
+private:
+  uint32_t mask_;
+};
+
+class Group {
+public:
+  explicit Group(const ctrl_t *ctrl) {
+#ifdef PHOTOGRAMMETRY_FLAT_HASH_MAP_SSE2
+    ctrl_ = _mm_load_si128(reinterpret_cast<const __m128i *>(ctrl));
+#else
+    std::memcpy(ctrl_, ctrl, kGroupWidth);
+#endif
+  }
+
+  GroupMask Match(const ctrl_t h2) const {
+#ifdef PHOTOGRAMMETRY_FLAT_HASH_MAP_SSE2
+    return GroupMask(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(static_cast<char>(h2))))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+    }
+    return GroupMask(mask);
+#endif
+  }
+
+  GroupMask MatchEmpty() const { return Match(kCtrlEmpty); }
+
+  // Empty or deleted slots, i.e. all bytes with the sign bit set
+  GroupMask MatchFree() const {
+#ifdef PHOTOGRAMMETRY_FLAT_HASH_MAP_SSE2
+    return GroupMask(static_cast<uint32_t>(_mm_movemask_epi8(ctrl_)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+    }
+    return GroupMask(mask);
+#endif
+  }
+
+private:
+#ifdef PHOTOGRAMMETRY_FLAT_HASH_MAP_SSE2
+  __m128i ctrl_;
+#else
+  ctrl_t ctrl_[kGroupWidth];
+#endif
+};
+} // namespace detail
+
+/**
+ * @brief Open addressing hash map with entries stored inline in one flat array
+ *
+ * The layout follows Swiss tables: every slot has one control byte holding 7 bits of the hash of
+ * its key, and lookups compare a whole group of 16 control bytes against those bits with one SIMD
+ * instruction (SSE2, with a scalar fallback). Keys are only compared for slots whose bits match,
+ * so a lookup usually touches one control group and one slot. Groups are probed quadratically.
+ *
+ * The hash of the key is passed through MixHash, std::hash of integer ids is therefore fine.
+ * The map grows by doubling at a load factor of 7/8.
+ *
+ * Unlike std::unordered_map, inserting may move all entries: references, pointers and iterators
+ * are invalidated by every insertion that grows the map and by rehash / reserve. Erasing only
+ * invalidates the erased entry.
+ *
+ * @tparam Key type of the keys
+ * @tparam Value type of the values
+ * @tparam Hash hash functor of the keys
+ * @tparam KeyEqual equality of the keys
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef std::pair<const Key, Value> value_type;
+  typedef size_t size_type;
+  typedef Hash hasher;
+  typedef KeyEqual key_equal;
+
+  template <bool IsConst>
+  class Iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename FlatHashMap::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::conditional_t<IsConst, const value_type, value_type> *pointer;
+    typedef std::conditional_t<IsConst, const value_type, value_type> &reference;
+
+    Iterator() = default;
+    // iterator converts to const_iterator
+    template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+    Iterator(const Iterator<OtherConst> &other) : ctrl_(other.ctrl_), slot_(other.slot_) {}
+
+    reference operator*() const { return *slot_; }
+    pointer operator->() const { return slot_; }
+
+    Iterator &operator++() {
+      ++ctrl_;
+      ++slot_;
+      SkipFree();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    bool operator==(const Iterator &other) const { return ctrl_ == other.ctrl_; }
+    bool operator!=(const Iterator &other) const { return ctrl_ != other.ctrl_; }
+
+  private:
+    friend class FlatHashMap;
+    template <bool>
+    friend class Iterator;
+
+    Iterator(const detail::ctrl_t *ctrl, pointer slot) : ctrl_(ctrl), slot_(slot) {}
+
+    // The control array ends with a full sentinel byte, so the scan stops at end()
+    void SkipFree() {
+      while (*ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    const detail::ctrl_t *ctrl_ = nullptr;
+    pointer slot_ = nullptr;
+  };
+
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+  FlatHashMap() = default;
+
+  explicit FlatHashMap(const size_t bucket_count, const Hash &hash = Hash(),
+                       const KeyEqual &equal = KeyEqual())
+      : hash_(hash), equal_(equal) {
+    reserve(bucket_count);
+  }
+
+  FlatHashMap(std::initializer_list<value_type> values) {
+    reserve(values.size());
+    insert(values.begin(), values.end());
+  }
+
+  FlatHashMap(const FlatHashMap &other) : hash_(other.hash_), equal_(other.equal_) {
+    reserve(other.size());
+    for (const value_type &value : other) {
+      InsertUnique(value.first, value);
+    }
+  }
+
+  FlatHashMap(FlatHashMap &&other) noexcept
+      : ctrl_(std::exchange(other.ctrl_, EmptyGroup())),
+        slots_(std::exchange(other.slots_, nullptr)), capacity_(std::exchange(other.capacity_, 0)), size_(std::exchange(other.size_, 0)),
+        growth_left_(std::exchange(other.growth_left_, 0)), hash_(std::move(other.hash_)),
+        equal_(std::move(other.equal_)) {}
+
+  FlatHashMap &operator=(const FlatHashMap &other) {
+    if (this != &other) {
+      FlatHashMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  FlatHashMap &operator=(FlatHashMap &&other) noexcept {
+    if (this != &other) {
+      Destroy();
+      ctrl_ = std::exchange(other.ctrl_, EmptyGroup());
+      slots_ = std::exchange(other.slots_, nullptr);
+      capacity_ = std::exchange(other.capacity_, 0);
+      size_ = std::exchange(other.size_, 0);
+      growth_left_ = std::exchange(other.growth_left_, 0);
+      hash_ = std::move(other.hash_);
+      equal_ = std::move(other.equal_);
+    }
+    return *this;
+  }
+
+  ~FlatHashMap() { Destroy(); }
+
+  void swap(FlatHashMap &other) noexcept {
+    using std::swap;
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+    swap(hash_, other.hash_);
+    swap(equal_, other.equal_);
+  }
+
+  iterator begin() {
+    if (empty()) {
+      return end();
+    }
+    iterator it(ctrl_, slots_);
+    it.SkipFree();
+    return it;
+  }
+  const_iterator begin() const { return const_cast<FlatHashMap *>(this)->begin(); }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+  const_iterator end() const { return const_cast<FlatHashMap *>(this)->end(); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  // Number of slots, a power of two and a multiple of the group width (or 0)
+  size_t capacity() const { return capacity_; }
+  float load_factor() const {
+    return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / capacity_;
+  }
+
+  // Destroy all entries, the slots are kept
+  void clear() {
+    if (capacity_ == 0) {
+      return;
+    }
+    DestroySlots();
+    std::memset(ctrl_, detail::kCtrlEmpty, capacity_);
+    size_ = 0;
+    growth_left_ = MaxLoad(capacity_);
+  }
+
+  // Make room for count entries without growing
+  void reserve(const size_t count) {
+    if (count > size_ + growth_left_) {
+      Resize(CapacityFor(count));
+    }
+  }
+
+  void rehash(const size_t count) { Resize(CapacityFor(std::max(count, size_))); }
+
+  iterator find(const Key &key) {
+    const size_t index = FindIndex(key);
+    return index == kNotFound ? end() : IteratorAt(index);
+  }
+  const_iterator find(const Key &key) const { return const_cast<FlatHashMap *>(this)->find(key); }
+
+  bool contains(const Key &key) const { return FindIndex(key) != kNotFound; }
+  size_t count(const Key &key) const { return contains(key) ? 1 : 0; }
+
+  Value &at(const Key &key) {
+    const size_t index = FindIndex(key);
+    if (index == kNotFound) {
+      throw std::out_of_range("FlatHashMap::at: key not found");
+    }
+    return slots_[index].second;
+  }
+  const Value &at(const Key &key) const { return const_cast<FlatHashMap *>(this)->at(key); }
+
+  Value &operator[](const Key &key) { return try_emplace(key).first->second; }
+  Value &operator[](Key &&key) { return try_emplace(std::move(key)).first->second; }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K &&key, Args &&...args) {
+    return InsertUnique(key, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <typename K, typename V>
+  std::pair<iterator, bool> emplace(K &&key, V &&value) {
+    return InsertUnique(key, std::forward<K>(key), std::forward<V>(value));
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return InsertUnique(value.first, value);
+  }
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return InsertUnique(value.first, std::move(value));
+  }
+  template <typename InputIt>
+  void insert(InputIt first, const InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  template <typename V>
+  std::pair<iterator, bool> insert_or_assign(const Key &key, V &&value) {
+    auto result = try_emplace(key, std::forward<V>(value));
+    if (!result.second) {
+      result.first->second = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  size_t erase(const Key &key) {
+    const size_t index = FindIndex(key);
+    if (index == kNotFound) {
+      return 0;
+    }
+    EraseAt(index);
+    return 1;
+  }
+
+  // Returns the iterator following the erased entry
+  iterator erase(const_iterator pos) {
+    const size_t index = static_cast<size_t>(pos.ctrl_ - ctrl_);
+    EraseAt(index);
+    iterator it(ctrl_ + index, slots_ + index);
+    it.SkipFree();
+    return it;
+  }
+
+private:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  // Control bytes of a map without slots, a lookup stops at the first group without any capacity
+  // check. Never written to.
+  static detail::ctrl_t *EmptyGroup() {
+    alignas(detail::kGroupWidth) static detail::ctrl_t empty_group[detail::kGroupWidth] = {
+        detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty,
+        detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty,
+        detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty,
+        detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty, detail::kCtrlEmpty};
+    return empty_group;
+  }
+
+  static size_t MaxLoad(const size_t capacity) { return capacity - capacity / 8; }
+
+  static size_t CapacityFor(const size_t count) {
+    if (count == 0) {
+      return 0;
+    }
+    size_t capacity = detail::kGroupWidth;
+    while (MaxLoad(capacity) < count) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  size_t HashOf(const Key &key) const {
+    return static_cast<size_t>(MixHash(static_cast<uint64_t>(hash_(key))));
+  }
+  static size_t H1(const size_t hash) { return hash >> 7; }
+  static detail::ctrl_t H2(const size_t hash) { return static_cast<detail::ctrl_t>(hash & 0x7f); }
+
+  iterator IteratorAt(const size_t index) { return iterator(ctrl_ + index, slots_ + index); }
+
+  // Triangular probing over the groups, visits every group once when the number of groups is a
+  // power of two
+  template <typename F>
+  size_t Probe(const size_t hash, F &&visit_group) const {
+    const size_t group_mask = capacity_ == 0 ? 0 : capacity_ / detail::kGroupWidth - 1;
+    size_t group = H1(hash) & group_mask;
+    for (size_t step = 1;; ++step) {
+      const size_t offset = group * detail::kGroupWidth;
+      const size_t index = visit_group(offset, detail::Group(ctrl_ + offset));
+      if (index != kNotFound || step > group_mask) {
+        return index;
+      }
+      group = (group + step) & group_mask;
+    }
+  }
+
+  size_t FindIndex(const Key &key) const {
+    const size_t hash = HashOf(key);
+    const detail::ctrl_t h2 = H2(hash);
+    size_t found = kNotFound;
+    Probe(hash, [&](const size_t offset, const detail::Group &group) {
+      for (detail::GroupMask match = group.Match(h2); match; match.ClearLowestBit()) {
+        const size_t index = offset + match.LowestBit();
+        if (equal_(slots_[index].first, key)) {
+          found = index;
+          return index;
+        }
+      }
+      // An empty slot ends the probe sequence, a deleted one does not
+      return group.MatchEmpty() ? offset : kNotFound;
+    });
+    return found;
+  }
+
+  // First empty or deleted slot on the probe sequence of hash
+  size_t FindFreeIndex(const size_t hash) const {
+    return Probe(hash, [](const size_t offset, const detail::Group &group) {
+      const detail::GroupMask free = group.MatchFree();
+      return free ? offset + free.LowestBit() : kNotFound;
+    });
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> InsertUnique(const Key &key, Args &&...args) {
+    const size_t found = FindIndex(key);
+    if (found != kNotFound) {
+      return {IteratorAt(found), false};
+    }
+    const size_t hash = HashOf(key);
+    size_t index = FindFreeIndex(hash);
+    // Reusing a deleted slot does not consume growth
+    if (capacity_ == 0 || (growth_left_ == 0 && ctrl_[index] == detail::kCtrlEmpty)) {
+      // Rehash in place when at least half of the non-empty slots are tombstones
+      Resize(size_ + 1 <= MaxLoad(capacity_) / 2 ? capacity_ : CapacityFor(size_ + 1));
+      index = FindFreeIndex(hash);
+    }
+    new (slots_ + index) value_type(std::forward<Args>(args)...);
+    growth_left_ -= ctrl_[index] == detail::kCtrlEmpty ? 1 : 0;
+    ctrl_[index] = H2(hash);
+    ++size_;
+    return {IteratorAt(index), true};
+  }
+
+  void EraseAt(const size_t index) {
+    slots_[index].~value_type();
+    // A slot can become empty again when its group still has an empty slot: no probe sequence
+    // continued past this group
+    const size_t offset = index & ~(detail::kGroupWidth - 1);
+    if (detail::Group(ctrl_ + offset).MatchEmpty()) {
+      ctrl_[index] = detail::kCtrlEmpty;
+      ++growth_left_;
+    } else {
+      ctrl_[index] = detail::kCtrlDeleted;
+    }
+    --size_;
+  }
+
+  void Resize(const size_t new_capacity) {
+    detail::ctrl_t *old_ctrl = ctrl_;
+    value_type *old_slots = slots_;
+    const size_t old_capacity = capacity_;
+
+    if (new_capacity == 0) {
+      ctrl_ = EmptyGroup();
+      slots_ = nullptr;
+    } else {
+      // new_capacity control bytes, padded by one full sentinel group that stops iteration
+      ctrl_ = static_cast<detail::ctrl_t *>(::operator new(
+          new_capacity + detail::kGroupWidth, std::align_val_t(detail::kGroupWidth)));
+      std::memset(ctrl_, detail::kCtrlEmpty, new_capacity);
+      std::memset(ctrl_ + new_capacity, 0, detail::kGroupWidth);
+      slots_ = static_cast<value_type *>(
+          ::operator new(new_capacity * sizeof(value_type), std::align_val_t(alignof(value_type))));
+    }
+    capacity_ = new_capacity;
+    growth_left_ = MaxLoad(new_capacity) - size_;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] >= 0) {
+        const size_t hash = HashOf(old_slots[i].first);
+        const size_t index = FindFreeIndex(hash);
+        ctrl_[index] = H2(hash);
+        new (slots_ + index) value_type(std::move_if_noexcept(old_slots[i]));
+        old_slots[i].~value_type();
+      }
+    }
+    if (old_capacity != 0) {
+      Deallocate(old_ctrl, old_slots);
+    }
+  }
+
+  void DestroySlots() {
+    if constexpr (!std::is_trivially_destructible<value_type>::value) {
+      for (size_t i = 0; i < capacity_; ++i) {
+        if (ctrl_[i] >= 0) {
+          slots_[i].~value_type();
+        }
+      }
+    }
+  }
+
+  static void Deallocate(detail::ctrl_t *ctrl, value_type *slots) {
+    ::operator delete(ctrl, std::align_val_t(detail::kGroupWidth));
+    ::operator delete(slots, std::align_val_t(alignof(value_type)));
+  }
+
+  void Destroy() {
+    if (capacity_ != 0) {
+      DestroySlots();
+      Deallocate(ctrl_, slots_);
+      ctrl_ = EmptyGroup();
+      slots_ = nullptr;
+      capacity_ = 0;
+      size_ = 0;
+      growth_left_ = 0;
+    }
+  }
+
+  detail::ctrl_t *ctrl_ = EmptyGroup();
+  value_type *slots_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  // Number of empty slots that can still be filled before the map grows
+  size_t growth_left_ = 0;
+  Hash hash_;
+  KeyEqual equal_;
+};
+} // namespace utils
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_UTILS_FLAT_HASH_MAP_HPP
@@ -0,0 +1,130 @@
+#include "utils/flat_hash_map.hpp"
+#include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace photogrammetry::utils;
+
+namespace {
+// Every key hashes to the same value, all entries share one probe sequence
+struct ConstantHash {
+  size_t operator()(int) const { return 7; }
+};
+} // namespace
+
+TEST(FlatHashMapTest, InsertFindErase) {
+  FlatHashMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.find(3), map.end());
+  EXPECT_TRUE(map.emplace(3, "three").second);
+  EXPECT_FALSE(map.emplace(3, "drei").second);
+  map[5] = "five";
+  EXPECT_EQ(map.size(), 2u);
+  EXPECT_EQ(map.at(3), "three");
+  EXPECT_EQ(map.find(5)->second, "five");
+  EXPECT_TRUE(map.contains(5));
+  EXPECT_THROW(map.at(4), std::out_of_range);
+  EXPECT_EQ(map.erase(3), 1u);
+  EXPECT_EQ(map.erase(3), 0u);
+  EXPECT_FALSE(map.contains(3));
+  EXPECT_EQ(map.size(), 1u);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(FlatHashMapTest, MatchesStdMap) {
+  FlatHashMap<uint64_t, int> map;
+  std::map<uint64_t, int> reference;
+  std::mt19937_64 rng(42);
+  for (int i = 0; i < 200000; ++i) {
+    // Small key range, so inserts, updates and erases of present keys are all frequent
+    const uint64_t key = rng() % 5000;
+    switch (rng() % 3) {
+    case 0:
+      map[key] = i;
+      reference[key] = i;
+      break;
+    case 1:
+      EXPECT_EQ(map.erase(key), reference.erase(key));
+      break;
+    default:
+      EXPECT_EQ(map.contains(key), reference.count(key) == 1);
+    }
+  }
+  ASSERT_EQ(map.size(), reference.size());
+  size_t num_visited = 0;
+  for (const auto &item : map) {
+    EXPECT_EQ(reference.at(item.first), item.second);
+    ++num_visited;
+  }
+  EXPECT_EQ(num_visited, reference.size());
+}
+
+TEST(FlatHashMapTest, CollidingHashes) {
+  FlatHashMap<int, int, ConstantHash> map;
+  for (int i = 0; i < 100; ++i) {
+    map.emplace(i, 2 * i);
+  }
+  for (int i = 0; i < 100; i += 2) {
+    map.erase(i);
+  }
+  // Lookups must probe past erased entries of the shared sequence
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(map.contains(i), i % 2 == 1);
+  }
+  EXPECT_EQ(map.at(99), 198);
+}
+
+TEST(FlatHashMapTest, EraseWhileIterating) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 1000; ++i) {
+    map.emplace(i, i);
+  }
+  for (auto it = map.begin(); it != map.end();) {
+    it = it->first % 3 == 0 ? map.erase(it) : std::next(it);
+  }
+  EXPECT_EQ(map.size(), 666u);
+  for (const auto &item : map) {
+    EXPECT_NE(item.first % 3, 0);
+  }
+}
+
+TEST(FlatHashMapTest, ReserveKeepsCapacity) {
+  FlatHashMap<int, int> map;
+  map.reserve(1000);
+  const size_t capacity = map.capacity();
+  EXPECT_GE(capacity, 1000u);
+  for (int i = 0; i < 1000; ++i) {
+    map.emplace(i, i);
+  }
+  EXPECT_EQ(map.capacity(), capacity);
+  // Repeated insert / erase reuses tombstones or rehashes in place instead of growing
+  for (int i = 1000; i < 100000; ++i) {
+    map.emplace(i, i);
+    map.erase(i - 1000);
+  }
+  EXPECT_EQ(map.capacity(), capacity);
+  EXPECT_EQ(map.size(), 1000u);
+}
+
+TEST(FlatHashMapTest, CopyAndMove) {
+  FlatHashMap<int, std::unique_ptr<int>> map;
+  for (int i = 0; i < 100; ++i) {
+    map.emplace(i, std::make_unique<int>(i));
+  }
+  FlatHashMap<int, std::unique_ptr<int>> moved(std::move(map));
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(*moved.at(42), 42);
+
+  FlatHashMap<int, std::string> a{{1, "one"}, {2, "two"}};
+  FlatHashMap<int, std::string> b = a;
+  b[3] = "three";
+  EXPECT_EQ(a.size(), 2u);
+  EXPECT_EQ(b.size(), 3u);
+  EXPECT_EQ(b.at(2), "two");
+  a = std::move(b);
+  EXPECT_EQ(a.at(3), "three");
+}
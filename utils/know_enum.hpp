@@ -1,14 +1,18 @@
 #ifndef PHOTOGRAMMETRY_KNOW_ENUM_HPP
 #define PHOTOGRAMMETRY_KNOW_ENUM_HPP
 
-#include <sstream>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace photogrammetry {
 // magic_enum_max_value is the maximum value of the enum type.It symbolizes the maximum number of
 // camera mpdels
-// It is used to limit the number of enum values that can be passed to the get_enum_name function.
-// If the enum value is greater than magic_enum_max_value, the function will throw an exception.
+// Only the enum values in [0, magic_enum_max_value) have names, get_enum_name throws for any other
+// value.
 constexpr int magic_enum_max_value = 10;
 } // namespace photogrammetry
 
@@ -16,127 +20,178 @@ namespace photogrammetry {
 namespace utils {
 
 namespace detail {
-// get_enum_name_static is a helper function that returns
-// the name of the enum value in a static compile time.
+// get_enum_name_static returns the name of the enum value N, parsed at compile time from the
+// signature of the function. Values without an enumerator give an empty name.
 template <typename T, T N>
-const char *get_enum_name_static() {
-#ifdef __clang__
-  return __PRETTY_FUNCTION__;
-#elif defined(__GNUC__)
-  return __PRETTY_FUNCTION__;
+constexpr std::string_view get_enum_name_static() {
+#if defined(__clang__) || defined(__GNUC__)
+  // GCC "[with T = ns::Color; T N = ns::Color::Red; ...]"
+  // clang "[T = ns::Color, N = ns::Color::Red]"
+  constexpr std::string_view signature = __PRETTY_FUNCTION__;
+  constexpr size_t begin = signature.find(" N = ") + 5;
+  constexpr size_t end = signature.find_first_of(";]", begin);
 #elif defined(_MSC_VER)
-  return __FUNCSIG__;
+  // "... get_enum_name_static<enum ns::Color,ns::Color::Red>(void)"
+  constexpr std::string_view signature = __FUNCSIG__;
+  constexpr size_t begin = signature.rfind(",", signature.rfind(">")) + 1;
+  constexpr size_t end = signature.rfind(">");
 #endif
+  constexpr std::string_view value = signature.substr(begin, end - begin);
+  // Values without an enumerator are printed as a cast "(ns::Color)7" or as a number
+  if constexpr (value.empty() || value[0] == '(' || value[0] == '-' ||
+                (value[0] >= '0' && value[0] <= '9')) {
+    return std::string_view();
+  } else {
+    // remove namespace name and enum name prefix
+    constexpr size_t last_colon = value.rfind("::");
+    return last_colon == std::string_view::npos ? value : value.substr(last_colon + 2);
+  }
 }
 
-template <bool Cond>
-struct enable_if__ {};
-
-template <>
-struct enable_if__<true> {
-  using type = void;
-};
+template <typename T, int... I>
+constexpr std::array<std::string_view, sizeof...(I)>
+make_enum_names(std::integer_sequence<int, I...>) {
+  return {{get_enum_name_static<T, static_cast<T>(I)>()...}};
+}
 
-// static_for is a helper function that calls a function
-// for each value in a range in static compile time.
-template <int Begin, int End, typename F>
-typename photogrammetry::utils::detail::enable_if__<Begin == End>::type static_for(F &&func) {}
+// FNV-1a, seeded so that a collision free seed can be searched for each enum
+constexpr uint32_t enum_name_hash(const std::string_view name, const uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (const char c : name) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
 
-template <int Begin, int End, typename F>
-typename photogrammetry::utils::detail::enable_if__<Begin != End>::type static_for(F &&func) {
-  func.template call<Begin>();
-  static_for<Begin + 1, End>(func);
+// Number of hash slots for the names: a power of two, at least twice the number of names
+template <size_t N>
+constexpr size_t enum_num_slots(const std::array<std::string_view, N> &names) {
+  size_t num_names = 0;
+  for (const std::string_view name : names) {
+    num_names += name.empty() ? 0 : 1;
+  }
+  size_t num_slots = 1;
+  while (num_slots < 2 * num_names) {
+    num_slots *= 2;
+  }
+  return num_slots;
 }
 
-template <typename T>
-struct get_enum_name_functor {
-  int n_;
-  std::string &s_;
-  get_enum_name_functor(int n, std::string &s) : n_(n), s_(s) {}
-
-  template <int N>
-  void call() const {
-    if (n_ == N) {
-      s_ = photogrammetry::utils::detail::get_enum_name_static<T, (T)N>();
+// Store the index of every name in its hash slot, false on a collision
+template <size_t N, size_t S>
+constexpr bool fill_enum_slots(const std::array<std::string_view, N> &names, const uint32_t seed,
+                               std::array<int8_t, S> &slots) {
+  for (int8_t &slot : slots) {
+    slot = -1;
+  }
+  for (size_t i = 0; i < N; ++i) {
+    if (names[i].empty()) {
+      continue;
     }
+    int8_t &slot = slots[enum_name_hash(names[i], seed) & (S - 1)];
+    if (slot >= 0) {
+      return false;
+    }
+    slot = static_cast<int8_t>(i);
   }
-};
+  return true;
+}
 
-template <typename T, T Begin, T End>
-std::string get_enum_name(T n) {
-  std::string s;
-  photogrammetry::utils::detail::static_for<(int)Begin, (int)End>(
-      photogrammetry::utils::detail::get_enum_name_functor<T>((int)n, s));
-  // if the enum name is not found, return an empty string
-  if (s.empty()) {
-    return "";
+// First seed for which the names hash without collisions
+template <size_t S, size_t N>
+constexpr uint32_t find_enum_seed(const std::array<std::string_view, N> &names) {
+  std::array<int8_t, S> slots{};
+  uint32_t seed = 0;
+  while (!fill_enum_slots(names, seed, slots)) {
+    ++seed;
   }
-#if defined(__clang__) || defined(__GNUC__)
-  size_t pos = s.find("N = ");
-  pos += 4;
-  size_t end = s.find_first_of(";]", pos);
-#elif defined(_MSC_VER)
-  size_t pos = s.find(",");
-  pos += 1;
-  size_t end = s.find(">", pos);
-#endif
-  s = s.substr(pos, end - pos);
-  // remove namespace name and enum name prefix
-  size_t last_colon = s.rfind("::");
-  s = s.substr(last_colon + 2);
-  return s;
+  return seed;
+}
+
+template <size_t S, size_t N>
+constexpr std::array<int8_t, S> make_enum_slots(const std::array<std::string_view, N> &names,
+                                                const uint32_t seed) {
+  std::array<int8_t, S> slots{};
+  fill_enum_slots(names, seed, slots);
+  return slots;
 }
 
+/**
+ * @brief Compile time name tables of an enum
+ *
+ * names[i] is the name of the value i. Name lookup uses a perfect hash: there are at least twice
+ * as many slots as names and the seed is chosen at compile time so that every name lands in its
+ * own slot, a lookup is one hash and one string comparison.
+ */
+template <typename T>
+struct enum_table {
+  static constexpr int kNumValues = photogrammetry::magic_enum_max_value;
+  static constexpr std::array<std::string_view, kNumValues> names =
+      make_enum_names<T>(std::make_integer_sequence<int, kNumValues>{});
+  static constexpr size_t kNumSlots = enum_num_slots(names);
+  static constexpr uint32_t seed = find_enum_seed<kNumSlots>(names);
+  // Value index stored in each slot, -1 for empty slots
+  static constexpr std::array<int8_t, kNumSlots> slots = make_enum_slots<kNumSlots>(names, seed);
+
+  static constexpr std::string_view name(const int value) {
+    return value >= 0 && value < kNumValues ? names[value] : std::string_view();
+  }
+
+  // Index of the value with this name, -1 if there is none
+  static constexpr int find(const std::string_view name) {
+    const int index = slots[enum_name_hash(name, seed) & (kNumSlots - 1)];
+    return index >= 0 && names[index] == name ? index : -1;
+  }
+};
 } // namespace detail
 
 /**
  * @brief Get the enum name object
  *
+ * The name refers to a compile time table, the call neither parses nor allocates.
+ *
  * @tparam T enum type
  * @param n enum value
- * @return std::string enum name
+ * @return std::string_view enum name
  */
 template <typename T>
-std::string get_enum_name(T n) {
-  std::string s =
-      photogrammetry::utils::detail::get_enum_name<T, (T)0,
-                                                   (T)photogrammetry::magic_enum_max_value>(n);
-  if (s.empty()) {
-    std::stringstream ss;
-    ss << "Invalid enum value: " << (int)n;
-    throw std::invalid_argument(ss.str());
+constexpr std::string_view get_enum_name(T n) {
+  const std::string_view name = detail::enum_table<T>::name(static_cast<int>(n));
+  if (name.empty()) {
+    throw std::invalid_argument("Invalid enum value: " + std::to_string(static_cast<int>(n)));
   }
-  return s;
+  return name;
 }
 
 /**
  * @brief determine whether the input enum is valid
  *
  * @tparam T enum type
- * @param name enum name
+ * @param n enum value
  * @return true or false
  */
 template <typename T>
-bool enum_contains(T n) {
-  std::string s =
-      photogrammetry::utils::detail::get_enum_name<T, (T)0,
-                                                   (T)photogrammetry::magic_enum_max_value>(n);
-  return !s.empty();
+constexpr bool enum_contains(T n) {
+  return !detail::enum_table<T>::name(static_cast<int>(n)).empty();
 }
 
-namespace detail {
-template <typename T, T Begin, T End>
-T enum_from_name(const std::string &name) {
-  for (int i = (int)Begin; i <= (int)End; ++i) {
-    if (photogrammetry::utils::get_enum_name((T)i) == name) {
-      return (T)i;
-    }
+/**
+ * @brief Get the enum value from name without throwing
+ *
+ * @tparam T enum type
+ * @param name enum name
+ * @param value set to the enum value if the name is valid
+ * @return true if the name is valid
+ */
+template <typename T>
+constexpr bool try_enum_from_name(const std::string_view name, T *value) {
+  const int index = detail::enum_table<T>::find(name);
+  if (index < 0) {
+    return false;
   }
-  std::stringstream ss;
-  ss << "Invalid enum name: " << name;
-  throw std::invalid_argument(ss.str());
+  *value = static_cast<T>(index);
+  return true;
 }
-} // namespace detail
 
 /**
  * @brief Get the enum value from name object
@@ -146,15 +201,12 @@ T enum_from_name(const std::string &name) {
  * @return T enum value
  */
 template <typename T>
-T enum_from_name(const std::string &name) {
-  if (name.empty()) {
-    std::stringstream ss;
-    ss << "Invalid enum name: " << name;
-    throw std::invalid_argument(ss.str());
+constexpr T enum_from_name(const std::string_view name) {
+  T value{};
+  if (!try_enum_from_name(name, &value)) {
+    throw std::invalid_argument("Invalid enum name: " + std::string(name));
   }
-  return photogrammetry::utils::detail::enum_from_name<T, (T)0,
-                                                       (T)photogrammetry::magic_enum_max_value>(
-      name);
+  return value;
 }
 } // namespace utils
 } // namespace photogrammetry
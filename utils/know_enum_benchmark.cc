@@ -0,0 +1,50 @@
+#include "utils/know_enum.hpp"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <string_view>
+
+namespace {
+enum class BenchmarkEnum {
+  PINHOLE_CAMERA,
+  PINHOLE_CAMERA_BROWN,
+  FISHEYE_CAMERA,
+  SPHERICAL_CAMERA,
+};
+
+const char *const kBenchmarkEnumNames[] = {"PINHOLE_CAMERA", "PINHOLE_CAMERA_BROWN",
+                                           "FISHEYE_CAMERA", "SPHERICAL_CAMERA"};
+} // namespace
+
+static void BM_GetEnumName(benchmark::State &state) {
+  int value = 0;
+  for (auto _ : state) {
+    std::string_view name =
+        photogrammetry::utils::get_enum_name(static_cast<BenchmarkEnum>(value));
+    benchmark::DoNotOptimize(name.data());
+    value = (value + 1) % 4;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_EnumContains(benchmark::State &state) {
+  int value = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        photogrammetry::utils::enum_contains(static_cast<BenchmarkEnum>(value)));
+    value = (value + 1) % 4;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Name to value lookup, the argument is the position of the name in the enum
+static void BM_EnumFromName(benchmark::State &state) {
+  const std::string name = kBenchmarkEnumNames[state.range(0)];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(photogrammetry::utils::enum_from_name<BenchmarkEnum>(name));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GetEnumName);
+BENCHMARK(BM_EnumContains);
+BENCHMARK(BM_EnumFromName)->Arg(0)->Arg(3);
@@ -34,3 +34,32 @@ TEST_F(KnowEnumTest, EnumFromName) {
   EXPECT_EQ(photogrammetry::utils::enum_from_name<TestEnum>("Kiwi"), TestEnum::Kiwi);
 }
 
+TEST_F(KnowEnumTest, ConstexprTables) {
+  static_assert(photogrammetry::utils::get_enum_name(TestEnum::Mango) == "Mango");
+  static_assert(photogrammetry::utils::enum_from_name<TestEnum>("Pear") == TestEnum::Pear);
+  static_assert(photogrammetry::utils::enum_contains(TestEnum::Kiwi));
+  static_assert(!photogrammetry::utils::enum_contains(static_cast<TestEnum>(7)));
+  EXPECT_FALSE(photogrammetry::utils::enum_contains(static_cast<TestEnum>(invalid_enum_value)));
+}
+
+TEST_F(KnowEnumTest, InvalidNames) {
+  TestEnum value = TestEnum::Apple;
+  EXPECT_FALSE(photogrammetry::utils::try_enum_from_name("Appl", &value));
+  EXPECT_FALSE(photogrammetry::utils::try_enum_from_name("", &value));
+  EXPECT_FALSE(photogrammetry::utils::try_enum_from_name("KiwiKiwi", &value));
+  EXPECT_EQ(value, TestEnum::Apple);
+  EXPECT_TRUE(photogrammetry::utils::try_enum_from_name("Orange", &value));
+  EXPECT_EQ(value, TestEnum::Orange);
+  EXPECT_THROW(photogrammetry::utils::enum_from_name<TestEnum>("Grape"), std::invalid_argument);
+  EXPECT_THROW(photogrammetry::utils::get_enum_name(static_cast<TestEnum>(-1)),
+               std::invalid_argument);
+}
+
+TEST_F(KnowEnumTest, RoundTripsAllValues) {
+  for (int i = 0; i <= static_cast<int>(TestEnum::Kiwi); ++i) {
+    const TestEnum value = static_cast<TestEnum>(i);
+    EXPECT_EQ(photogrammetry::utils::enum_from_name<TestEnum>(
+                  photogrammetry::utils::get_enum_name(value)),
+              value);
+  }
+}
@@ -0,0 +1,367 @@
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace photogrammetry {
+namespace utils {
+
+namespace {
+
+using internal::LogRecord;
+
+/**
+ * @brief Single-producer single-consumer ring buffer owned by one logging thread
+ *
+ * The producer writes the slot at tail_ in place and publishes it by advancing tail_ with release
+ * semantics, the writer thread reads up to tail_ and frees slots by advancing head_.
+ */
+class ThreadLogBuffer {
+public:
+  static constexpr size_t kCapacity = 1024;
+
+  explicit ThreadLogBuffer(const uint32_t index)
+      : index_(index), records_(new LogRecord[kCapacity]) {}
+
+  uint32_t Index() const { return index_; }
+
+  LogRecord *TryBeginPush() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+      return nullptr;
+    }
+    return &records_[tail & (kCapacity - 1)];
+  }
+
+  void EndPush() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Number of published records not yet consumed
+  size_t Available() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+  }
+
+  // The i-th unconsumed record, i < Available()
+  const LogRecord &Peek(const size_t i) const {
+    return records_[(head_.load(std::memory_order_relaxed) + i) & (kCapacity - 1)];
+  }
+
+  // Free the oldest num_records slots
+  void Pop(const size_t num_records) {
+    head_.store(head_.load(std::memory_order_relaxed) + num_records, std::memory_order_release);
+  }
+
+  std::atomic<uint64_t> num_dropped{0};
+  // Set when the owning thread exits, the writer releases the buffer once it is drained
+  std::atomic<bool> retired{false};
+
+private:
+  const uint32_t index_;
+  std::unique_ptr<LogRecord[]> records_;
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+char LevelChar(const LogLevel level) {
+  switch (level) {
+  case LogLevel::VERBOSE:
+    return 'V';
+  case LogLevel::INFO:
+    return 'I';
+  case LogLevel::WARNING:
+    return 'W';
+  case LogLevel::ERROR:
+  default:
+    return 'E';
+  }
+}
+
+int64_t NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// "I20260101 12:34:56.789012 3 file.cc:42] message"
+std::string FormatLine(const LogRecord &record, std::ostringstream *stream) {
+  stream->str(std::string());
+  const std::time_t seconds = static_cast<std::time_t>(record.timestamp_ns / 1000000000);
+  std::tm time;
+  localtime_r(&seconds, &time);
+  char prefix[64];
+  std::snprintf(prefix, sizeof(prefix), "%c%04d%02d%02d %02d:%02d:%02d.%06d ",
+                LevelChar(record.level), time.tm_year + 1900, time.tm_mon + 1, time.tm_mday,
+                time.tm_hour, time.tm_min, time.tm_sec,
+                static_cast<int>(record.timestamp_ns % 1000000000 / 1000));
+  const char *file = std::strrchr(record.file, '/');
+  *stream << prefix << record.thread_index << ' ' << (file ? file + 1 : record.file) << ':'
+          << record.line << "] ";
+  record.formatter(record, stream);
+  return stream->str();
+}
+
+void WriteToStderr(LogLevel, const std::string &line) {
+  std::fwrite(line.data(), 1, line.size(), stderr);
+  std::fputc('\n', stderr);
+}
+
+class LoggerState {
+public:
+  static LoggerState &Instance() {
+    // Never destroyed, the writer is stopped from an atexit handler instead so that threads
+    // logging during static destruction still find a valid logger
+    static LoggerState *state = new LoggerState();
+    return *state;
+  }
+
+  LogRecord *Begin(const LogLevel level) {
+    LogRecord *record = nullptr;
+    if (stopped_.load(std::memory_order_acquire)) {
+      record = &SynchronousRecord();
+    } else {
+      ThreadLogBuffer &buffer = CurrentBuffer();
+      record = buffer.TryBeginPush();
+      while (record == nullptr && block_when_full_.load(std::memory_order_relaxed) &&
+             !stopped_.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+        record = buffer.TryBeginPush();
+      }
+      if (record == nullptr) {
+        buffer.num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      record->thread_index = buffer.Index();
+    }
+    record->level = level;
+    record->timestamp_ns = NowNanoseconds();
+    return record;
+  }
+
+  void Commit(LogRecord *record) {
+    if (record == &SynchronousRecord()) {
+      std::ostringstream stream;
+      const std::string line = FormatLine(*record, &stream);
+      std::lock_guard<std::mutex> lock(sink_mutex_);
+      sink_(record->level, line);
+      return;
+    }
+    CurrentBuffer().EndPush();
+  }
+
+  void SetSink(Logger::Sink sink) {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    sink_ = sink ? std::move(sink) : Logger::Sink(WriteToStderr);
+  }
+
+  void SetBlockWhenFull(const bool block) { block_when_full_.store(block); }
+
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopped_.load()) {
+      return;
+    }
+    const uint64_t request = ++flush_requested_;
+    condition_.notify_all();
+    flushed_condition_.wait(lock, [&]() { return flushed_ >= request || stopped_.load(); });
+  }
+
+  void Shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_requested_) {
+        return;
+      }
+      stop_requested_ = true;
+    }
+    condition_.notify_all();
+    writer_.join();
+  }
+
+  uint64_t NumDropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t num_dropped = num_dropped_retired_;
+    for (const std::shared_ptr<ThreadLogBuffer> &buffer : buffers_) {
+      num_dropped += buffer->num_dropped.load(std::memory_order_relaxed);
+    }
+    return num_dropped;
+  }
+
+private:
+  LoggerState() : sink_(WriteToStderr) {
+    writer_ = std::thread(&LoggerState::WriterFunc, this);
+    std::atexit([]() { LoggerState::Instance().Shutdown(); });
+  }
+
+  // Registers the ring buffer of the calling thread on first use
+  ThreadLogBuffer &CurrentBuffer() {
+    struct Holder {
+      ~Holder() {
+        if (buffer) {
+          buffer->retired.store(true, std::memory_order_release);
+        }
+      }
+      std::shared_ptr<ThreadLogBuffer> buffer;
+    };
+    thread_local Holder holder;
+    if (!holder.buffer) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      holder.buffer = std::make_shared<ThreadLogBuffer>(next_buffer_index_++);
+      buffers_.push_back(holder.buffer);
+    }
+    return *holder.buffer;
+  }
+
+  // Used once the writer has stopped, the record is formatted by the producer itself
+  static LogRecord &SynchronousRecord() {
+    thread_local LogRecord record;
+    return record;
+  }
+
+  void WriterFunc() {
+    std::vector<std::shared_ptr<ThreadLogBuffer>> buffers;
+    std::vector<size_t> num_available;
+    std::vector<const LogRecord *> batch;
+    std::ostringstream stream;
+    while (true) {
+      uint64_t flush_request;
+      bool stop;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait_for(lock, kFlushInterval,
+                            [&]() { return stop_requested_ || flush_requested_ > flushed_; });
+        flush_request = flush_requested_;
+        stop = stop_requested_;
+        buffers = buffers_;
+      }
+
+      // Collect everything published so far and write it in timestamp order
+      batch.clear();
+      num_available.resize(buffers.size());
+      for (size_t i = 0; i < buffers.size(); ++i) {
+        num_available[i] = buffers[i]->Available();
+        for (size_t j = 0; j < num_available[i]; ++j) {
+          batch.push_back(&buffers[i]->Peek(j));
+        }
+      }
+      std::stable_sort(batch.begin(), batch.end(), [](const LogRecord *a, const LogRecord *b) {
+        return a->timestamp_ns < b->timestamp_ns;
+      });
+      {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        for (const LogRecord *record : batch) {
+          sink_(record->level, FormatLine(*record, &stream));
+        }
+        ReportDropped(buffers);
+        std::fflush(stderr);
+      }
+      // Records are formatted in place, their slots are freed only afterwards
+      for (size_t i = 0; i < buffers.size(); ++i) {
+        buffers[i]->Pop(num_available[i]);
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Release buffers of exited threads once they are drained
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                      [&](const std::shared_ptr<ThreadLogBuffer> &buffer) {
+                                        if (!buffer->retired.load(std::memory_order_acquire) ||
+                                            buffer->Available() != 0) {
+                                          return false;
+                                        }
+                                        num_dropped_retired_ += buffer->num_dropped.load();
+                                        return true;
+                                      }),
+                       buffers_.end());
+        flushed_ = std::max(flushed_, flush_request);
+        if (stop && batch.empty()) {
+          stopped_.store(true, std::memory_order_release);
+        }
+      }
+      flushed_condition_.notify_all();
+      if (stopped_.load()) {
+        return;
+      }
+    }
+  }
+
+  // Called with sink_mutex_ held
+  void ReportDropped(const std::vector<std::shared_ptr<ThreadLogBuffer>> &buffers) {
+    uint64_t num_dropped = 0;
+    for (const std::shared_ptr<ThreadLogBuffer> &buffer : buffers) {
+      num_dropped += buffer->num_dropped.load(std::memory_order_relaxed);
+    }
+    if (num_dropped > num_dropped_reported_) {
+      sink_(LogLevel::WARNING, "Logger dropped " +
+                                   std::to_string(num_dropped - num_dropped_reported_) +
+                                   " records, ring buffers were full");
+      num_dropped_reported_ = num_dropped;
+    }
+  }
+
+  static constexpr std::chrono::milliseconds kFlushInterval{10};
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable flushed_condition_;
+  std::vector<std::shared_ptr<ThreadLogBuffer>> buffers_;
+  uint32_t next_buffer_index_ = 0;
+  uint64_t flush_requested_ = 0;
+  uint64_t flushed_ = 0;
+  uint64_t num_dropped_retired_ = 0;
+  bool stop_requested_ = false;
+  std::atomic<bool> stopped_{false};
+  std::atomic<bool> block_when_full_{false};
+
+  std::mutex sink_mutex_;
+  Logger::Sink sink_;
+  uint64_t num_dropped_reported_ = 0;
+
+  std::thread writer_;
+};
+
+} // namespace
+
+namespace internal {
+
+LogRecord *BeginLogRecord(const LogLevel level) { return LoggerState::Instance().Begin(level); }
+
+void CommitLogRecord(LogRecord *record) { LoggerState::Instance().Commit(record); }
+
+} // namespace internal
+
+Logger::Logger() = default;
+
+Logger &Logger::Instance() {
+  static Logger logger;
+  return logger;
+}
+
+void Logger::SetLevel(const LogLevel level) {
+  internal::g_log_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::Level() const {
+  return static_cast<LogLevel>(internal::g_log_level.load(std::memory_order_relaxed));
+}
+
+void Logger::SetSink(Sink sink) { LoggerState::Instance().SetSink(std::move(sink)); }
+
+void Logger::SetBlockWhenFull(const bool block) { LoggerState::Instance().SetBlockWhenFull(block); }
+
+void Logger::Flush() { LoggerState::Instance().Flush(); }
+
+void Logger::Shutdown() { LoggerState::Instance().Shutdown(); }
+
+uint64_t Logger::NumDropped() const { return LoggerState::Instance().NumDropped(); }
+
+} // namespace utils
+} // namespace photogrammetry
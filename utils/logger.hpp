@@ -1,7 +1,273 @@
 #ifndef PHOTOGRAMMETRY_UTILS_LOGGER_HPP
 #define PHOTOGRAMMETRY_UTILS_LOGGER_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
+/**
+ * Minimum level that is compiled in: 0 VERBOSE, 1 INFO, 2 WARNING, 3 ERROR, 4 disables logging.
+ * Statements below this level are type checked but never evaluated.
+ */
+#ifndef PHOTOGRAMMETRY_LOG_MIN_LEVEL
+#define PHOTOGRAMMETRY_LOG_MIN_LEVEL 1
+#endif
 
+namespace photogrammetry {
+namespace utils {
 
-#endif  // PHOTOGRAMMETRY_UTILS_LOGGER_HPP
+enum class LogLevel : uint8_t { VERBOSE = 0, INFO = 1, WARNING = 2, ERROR = 3 };
+
+namespace internal {
+
+// Bytes available for the encoded arguments of one record
+constexpr size_t kLogPayloadSize = 192;
+
+/**
+ * @brief One log statement as pushed by the producer
+ *
+ * The format string and file name must be string literals, only the arguments are copied into
+ * the payload. Formatting is deferred to the writer thread through the type-erased formatter.
+ */
+struct LogRecord {
+  int64_t timestamp_ns;
+  const char *file;
+  const char *format;
+  void (*formatter)(const LogRecord &, std::ostream *);
+  uint32_t line;
+  uint32_t thread_index;
+  LogLevel level;
+  alignas(8) char payload[kLogPayloadSize];
+};
+
+/**
+ * @brief Payload encoding of a trivially copyable argument
+ */
+template <typename T, typename Enable = void>
+struct LogArgCodec {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Log arguments must be trivially copyable or strings");
+  typedef T Decoded;
+  static constexpr size_t kFixedSize = sizeof(T);
+
+  static void Encode(const T &value, char **cursor, size_t *) {
+    std::memcpy(*cursor, &value, sizeof(T));
+    *cursor += sizeof(T);
+  }
+  static T Decode(const char **cursor) {
+    T value;
+    std::memcpy(&value, *cursor, sizeof(T));
+    *cursor += sizeof(T);
+    return value;
+  }
+};
+
+/**
+ * @brief Payload encoding of strings: a 16 bit length followed by the characters
+ *
+ * Strings share the payload space left over by the fixed size arguments and are truncated when
+ * they do not fit.
+ */
+template <typename T>
+struct LogArgCodec<T, std::enable_if_t<std::is_same<T, const char *>::value ||
+                                       std::is_same<T, char *>::value ||
+                                       std::is_same<T, std::string>::value ||
+                                       std::is_same<T, std::string_view>::value>> {
+  typedef std::string_view Decoded;
+  static constexpr size_t kFixedSize = sizeof(uint16_t);
+
+  static void Encode(const std::string_view value, char **cursor, size_t *string_budget) {
+    const uint16_t size = static_cast<uint16_t>(std::min(value.size(), *string_budget));
+    *string_budget -= size;
+    std::memcpy(*cursor, &size, sizeof(size));
+    std::memcpy(*cursor + sizeof(size), value.data(), size);
+    *cursor += sizeof(size) + size;
+  }
+  static std::string_view Decode(const char **cursor) {
+    uint16_t size;
+    std::memcpy(&size, *cursor, sizeof(size));
+    const std::string_view value(*cursor + sizeof(size), size);
+    *cursor += sizeof(size) + size;
+    return value;
+  }
+};
+
+// Write the format string up to the end, no placeholders left to fill
+inline void FormatLogMessage(std::ostream *os, const char *format) { *os << format; }
+
+/**
+ * @brief Replace each "{}" in the format string with the next argument
+ *
+ * Surplus arguments are ignored, surplus placeholders are written verbatim.
+ */
+template <typename T, typename... Rest>
+void FormatLogMessage(std::ostream *os, const char *format, const T &value,
+                      const Rest &...rest) {
+  const char *placeholder = std::strstr(format, "{}");
+  if (placeholder == nullptr) {
+    *os << format;
+    return;
+  }
+  os->write(format, placeholder - format);
+  if constexpr (std::is_same<T, int8_t>::value || std::is_same<T, uint8_t>::value) {
+    *os << static_cast<int>(value);
+  } else if constexpr (std::is_enum<T>::value) {
+    *os << static_cast<typename std::underlying_type<T>::type>(value);
+  } else {
+    *os << value;
+  }
+  FormatLogMessage(os, placeholder + 2, rest...);
+}
+
+template <typename... Args>
+void FormatLogRecord(const LogRecord &record, std::ostream *os) {
+  const char *cursor = record.payload;
+  // Braced initialization decodes the arguments from left to right
+  const std::tuple<typename LogArgCodec<Args>::Decoded...> args{
+      LogArgCodec<Args>::Decode(&cursor)...};
+  std::apply([&](const auto &...values) { FormatLogMessage(os, record.format, values...); },
+             args);
+  (void)cursor;
+}
+
+/**
+ * @brief Reserve a record in the ring buffer of the calling thread
+ * @return nullptr if the buffer is full and the record is dropped
+ */
+LogRecord *BeginLogRecord(const LogLevel level);
+
+// Publish a record obtained from BeginLogRecord to the writer thread
+void CommitLogRecord(LogRecord *record);
+
+// Minimum level enabled at runtime
+inline std::atomic<int> g_log_level{PHOTOGRAMMETRY_LOG_MIN_LEVEL};
+
+/**
+ * @brief Push one record, the hot path only copies the arguments
+ * @param format string literal with "{}" placeholders
+ */
+template <typename... Args>
+void Log(const LogLevel level, const char *file, const int line, const char *format,
+         const Args &...args) {
+  constexpr size_t kFixedSize = (size_t(0) + ... + LogArgCodec<std::decay_t<Args>>::kFixedSize);
+  static_assert(kFixedSize <= kLogPayloadSize, "Too many log arguments");
+  LogRecord *record = BeginLogRecord(level);
+  if (record == nullptr) {
+    return;
+  }
+  record->file = file;
+  record->line = static_cast<uint32_t>(line);
+  record->format = format;
+  record->formatter = &FormatLogRecord<std::decay_t<Args>...>;
+  char *cursor = record->payload;
+  size_t string_budget = kLogPayloadSize - kFixedSize;
+  (LogArgCodec<std::decay_t<Args>>::Encode(args, &cursor, &string_budget), ...);
+  (void)cursor;
+  (void)string_budget;
+  CommitLogRecord(record);
+}
+
+} // namespace internal
+
+/**
+ * @brief Asynchronous logger
+ *
+ * Every logging thread owns a lock-free single-producer ring buffer. Pushing a record copies the
+ * arguments into the buffer and never takes a lock or touches a stream. A background writer
+ * thread drains all buffers, formats the records in timestamp order and hands the lines to the
+ * sink (stderr by default). When a buffer is full the record is dropped and counted, unless
+ * SetBlockWhenFull(true) makes the producer wait. The writer is stopped at exit after draining,
+ * later records are written synchronously.
+ */
+class Logger {
+public:
+  typedef std::function<void(LogLevel, const std::string &)> Sink;
+
+  static Logger &Instance();
+
+  static bool IsEnabled(const LogLevel level) {
+    return static_cast<int>(level) >= internal::g_log_level.load(std::memory_order_relaxed);
+  }
+
+  // Minimum level at runtime, levels removed at compile time cannot be enabled
+  void SetLevel(const LogLevel level);
+  LogLevel Level() const;
+
+  /**
+   * @brief Replace the output of the writer thread
+   * @param sink receives every formatted line without trailing newline, nullptr restores stderr
+   */
+  void SetSink(Sink sink);
+
+  // Whether producers wait for space instead of dropping records when their buffer is full
+  void SetBlockWhenFull(const bool block);
+
+  // Block until every record committed before the call has been written
+  void Flush();
+
+  // Stop the writer thread after draining all buffers
+  void Shutdown();
+
+  // Number of records dropped because a ring buffer was full
+  uint64_t NumDropped() const;
+
+private:
+  Logger();
+  ~Logger() = default;
+};
+
+} // namespace utils
+} // namespace photogrammetry
+
+#define PHOTOGRAMMETRY_LOG_IMPL(level, ...)                                                      \
+  do {                                                                                           \
+    if (::photogrammetry::utils::Logger::IsEnabled(::photogrammetry::utils::LogLevel::level)) {  \
+      ::photogrammetry::utils::internal::Log(::photogrammetry::utils::LogLevel::level, __FILE__, \
+                                             __LINE__, __VA_ARGS__);                             \
+    }                                                                                            \
+  } while (0)
+
+// Compiled-out statements keep their arguments type checked but never evaluate them
+#define PHOTOGRAMMETRY_LOG_DISCARD(level, ...)                                                   \
+  do {                                                                                           \
+    if (false) {                                                                                 \
+      ::photogrammetry::utils::internal::Log(::photogrammetry::utils::LogLevel::level, __FILE__, \
+                                             __LINE__, __VA_ARGS__);                             \
+    }                                                                                            \
+  } while (0)
+
+#if PHOTOGRAMMETRY_LOG_MIN_LEVEL <= 0
+#define PHOTOGRAMMETRY_LOG_VERBOSE(...) PHOTOGRAMMETRY_LOG_IMPL(VERBOSE, __VA_ARGS__)
+#else
+#define PHOTOGRAMMETRY_LOG_VERBOSE(...) PHOTOGRAMMETRY_LOG_DISCARD(VERBOSE, __VA_ARGS__)
+#endif
+#if PHOTOGRAMMETRY_LOG_MIN_LEVEL <= 1
+#define PHOTOGRAMMETRY_LOG_INFO(...) PHOTOGRAMMETRY_LOG_IMPL(INFO, __VA_ARGS__)
+#else
+#define PHOTOGRAMMETRY_LOG_INFO(...) PHOTOGRAMMETRY_LOG_DISCARD(INFO, __VA_ARGS__)
+#endif
+#if PHOTOGRAMMETRY_LOG_MIN_LEVEL <= 2
+#define PHOTOGRAMMETRY_LOG_WARNING(...) PHOTOGRAMMETRY_LOG_IMPL(WARNING, __VA_ARGS__)
+#else
+#define PHOTOGRAMMETRY_LOG_WARNING(...) PHOTOGRAMMETRY_LOG_DISCARD(WARNING, __VA_ARGS__)
+#endif
+#if PHOTOGRAMMETRY_LOG_MIN_LEVEL <= 3
+#define PHOTOGRAMMETRY_LOG_ERROR(...) PHOTOGRAMMETRY_LOG_IMPL(ERROR, __VA_ARGS__)
+#else
+#define PHOTOGRAMMETRY_LOG_ERROR(...) PHOTOGRAMMETRY_LOG_DISCARD(ERROR, __VA_ARGS__)
+#endif
+
+/**
+ * @brief Log a message, e.g. PHOTOGRAMMETRY_LOG(WARNING, "{} of {} points failed", n, total)
+ * @param level VERBOSE, INFO, WARNING or ERROR
+ */
+#define PHOTOGRAMMETRY_LOG(level, ...) PHOTOGRAMMETRY_LOG_##level(__VA_ARGS__)
+
+#endif // PHOTOGRAMMETRY_UTILS_LOGGER_HPP
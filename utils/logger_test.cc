@@ -0,0 +1,128 @@
+#include "utils/logger.hpp"
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace photogrammetry::utils;
+
+class LoggerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    Logger::Instance().SetLevel(LogLevel::INFO);
+    Logger::Instance().SetBlockWhenFull(false);
+    Logger::Instance().SetSink([this](LogLevel level, const std::string &line) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      levels_.push_back(level);
+      lines_.push_back(line);
+    });
+  }
+
+  void TearDown() override {
+    Logger::Instance().Flush();
+    Logger::Instance().SetSink(nullptr);
+  }
+
+  std::vector<std::string> Lines() {
+    Logger::Instance().Flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lines_;
+  }
+
+  // Message part of a line, after the "file:line] " prefix
+  static std::string Message(const std::string &line) { return line.substr(line.find("] ") + 2); }
+
+  std::mutex mutex_;
+  std::vector<LogLevel> levels_;
+  std::vector<std::string> lines_;
+};
+
+TEST_F(LoggerTest, FormatsArguments) {
+  std::string name = "camera";
+  PHOTOGRAMMETRY_LOG(WARNING, "{} {} has {} of {} points, ratio {}", name, 7u, int8_t(-3),
+                     uint64_t(1) << 40, 0.25);
+  // Arguments are copied when the record is pushed
+  name = "changed";
+  PHOTOGRAMMETRY_LOG(INFO, "missing {} {}", "one");
+  PHOTOGRAMMETRY_LOG(ERROR, "plain message");
+  const std::vector<std::string> lines = Lines();
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_EQ(lines[0][0], 'W');
+  EXPECT_NE(lines[0].find("logger_test.cc:"), std::string::npos);
+  EXPECT_EQ(Message(lines[0]), "camera 7 has -3 of 1099511627776 points, ratio 0.25");
+  EXPECT_EQ(Message(lines[1]), "missing one {}");
+  EXPECT_EQ(Message(lines[2]), "plain message");
+  EXPECT_EQ(levels_[2], LogLevel::ERROR);
+}
+
+TEST_F(LoggerTest, TruncatesLongStrings) {
+  const std::string long_string(1000, 'x');
+  PHOTOGRAMMETRY_LOG(INFO, "{}|{}", long_string, 42);
+  const std::vector<std::string> lines = Lines();
+  ASSERT_EQ(lines.size(), 1u);
+  const std::string message = Message(lines[0]);
+  EXPECT_LT(message.size(), long_string.size());
+  EXPECT_EQ(message.substr(message.size() - 3), "|42");
+}
+
+TEST_F(LoggerTest, FiltersLevels) {
+  int evaluations = 0;
+  const auto count = [&evaluations]() { return ++evaluations; };
+  // VERBOSE is below the default compile-time level, its arguments are never evaluated
+  PHOTOGRAMMETRY_LOG(VERBOSE, "{}", count());
+  Logger::Instance().SetLevel(LogLevel::WARNING);
+  PHOTOGRAMMETRY_LOG(INFO, "{}", count());
+  PHOTOGRAMMETRY_LOG(WARNING, "{}", count());
+  EXPECT_EQ(evaluations, 1);
+  const std::vector<std::string> lines = Lines();
+  ASSERT_EQ(lines.size(), 1u);
+  EXPECT_EQ(Message(lines[0]), "1");
+}
+
+TEST_F(LoggerTest, KeepsPerThreadOrder) {
+  const int kNumThreads = 4;
+  const int kNumRecords = 200;
+  Logger::Instance().SetBlockWhenFull(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([t]() {
+      for (int i = 0; i < kNumRecords; ++i) {
+        PHOTOGRAMMETRY_LOG(INFO, "{} {}", t, i);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  const std::vector<std::string> lines = Lines();
+  ASSERT_EQ(lines.size(), size_t(kNumThreads * kNumRecords));
+  std::vector<int> next(kNumThreads, 0);
+  for (const std::string &line : lines) {
+    const std::string message = Message(line);
+    const int t = std::stoi(message.substr(0, message.find(' ')));
+    const int i = std::stoi(message.substr(message.find(' ') + 1));
+    EXPECT_EQ(i, next[t]++);
+  }
+}
+
+TEST_F(LoggerTest, DropsRecordsWhenFull) {
+  // Stall the writer inside the sink so that the ring buffer of this thread fills up
+  std::mutex stall;
+  std::unique_lock<std::mutex> stalled(stall);
+  size_t num_written = 0;
+  Logger::Instance().SetSink([&](LogLevel, const std::string &) {
+    std::lock_guard<std::mutex> lock(stall);
+    ++num_written;
+  });
+  const uint64_t num_dropped = Logger::Instance().NumDropped();
+  const int kNumRecords = 3000;
+  for (int i = 0; i < kNumRecords; ++i) {
+    PHOTOGRAMMETRY_LOG(INFO, "{}", i);
+  }
+  EXPECT_GT(Logger::Instance().NumDropped(), num_dropped);
+  stalled.unlock();
+  Logger::Instance().Flush();
+  // Every record is either written or counted as dropped, plus the drop report
+  EXPECT_EQ(num_written - 1 + Logger::Instance().NumDropped() - num_dropped, size_t(kNumRecords));
+}
@@ -0,0 +1,41 @@
+#ifndef PHOTOGRAMMETRY_UTILS_MAPPED_FILE_HPP
+#define PHOTOGRAMMETRY_UTILS_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace photogrammetry {
+namespace utils {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Pages are loaded on first access and shared between processes mapping the same file, so large
+ * read-only data such as a vocabulary can be opened without parsing or copying. The mapping is
+ * page aligned. Throws std::runtime_error if the file cannot be opened or mapped.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  void Unmap();
+
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+} // namespace utils
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_UTILS_MAPPED_FILE_HPP
@@ -0,0 +1,27 @@
+#include "utils/mapped_file.hpp"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+using namespace photogrammetry::utils;
+
+TEST(MappedFileTest, MapsFileContents) {
+  const std::string path = ::testing::TempDir() + "mapped_file_test.bin";
+  const std::string contents = "photogrammetry mapped file";
+  std::ofstream(path, std::ios::binary) << contents;
+
+  MappedFile file(path);
+  ASSERT_EQ(file.size(), contents.size());
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(file.data()), file.size()), contents);
+
+  MappedFile moved(std::move(file));
+  EXPECT_EQ(file.data(), nullptr);
+  EXPECT_EQ(moved.size(), contents.size());
+  std::remove(path.c_str());
+}
+
+TEST(MappedFileTest, ThrowsForMissingFile) {
+  EXPECT_THROW(MappedFile("/nonexistent/mapped_file_test.bin"), std::runtime_error);
+}
@@ -0,0 +1,448 @@
+#include "utils/profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace photogrammetry {
+namespace utils {
+
+namespace {
+
+constexpr int64_t kInitialMin = std::numeric_limits<int64_t>::max();
+constexpr int64_t kInitialMax = std::numeric_limits<int64_t>::min();
+constexpr size_t kNumBucketSlots =
+    size_t(Profiler::kMaxNumHistograms) * Profiler::kNumHistogramBuckets;
+
+// Only the owning thread writes, a relaxed load and store is enough and avoids a locked add
+template <typename T>
+void RelaxedAdd(std::atomic<T> *value, const T delta) {
+  value->store(value->load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+int HistogramBucket(const int64_t value) {
+  if (value <= 0) {
+    return 0;
+  }
+  return 64 - __builtin_clzll(static_cast<uint64_t>(value));
+}
+
+struct MetricSlot {
+  std::atomic<uint64_t> count{0};
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> min{kInitialMin};
+  std::atomic<int64_t> max{kInitialMax};
+
+  void Record(const int64_t value) {
+    RelaxedAdd(&count, uint64_t(1));
+    RelaxedAdd(&sum, value);
+    if (value < min.load(std::memory_order_relaxed)) {
+      min.store(value, std::memory_order_relaxed);
+    }
+    if (value > max.load(std::memory_order_relaxed)) {
+      max.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  void Clear() {
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    min.store(kInitialMin, std::memory_order_relaxed);
+    max.store(kInitialMax, std::memory_order_relaxed);
+  }
+};
+
+// Samples of one thread, written only by that thread
+struct ThreadProfile {
+  explicit ThreadProfile(const uint32_t thread_index) : index(thread_index) {
+    for (std::atomic<uint64_t> &bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  const uint32_t index;
+  std::array<MetricSlot, Profiler::kMaxNumMetrics> slots;
+  std::array<std::atomic<uint64_t>, kNumBucketSlots> buckets;
+
+  // Tracing is rare and opt-in, the lock is only contended while a report is taken
+  std::mutex trace_mutex;
+  std::vector<TraceEvent> events;
+  uint64_t num_dropped_events = 0;
+};
+
+// Plain accumulator for merging thread profiles
+struct Totals {
+  Totals() : slots(Profiler::kMaxNumMetrics), buckets(kNumBucketSlots, 0) {}
+
+  struct Slot {
+    uint64_t count = 0;
+    int64_t sum = 0;
+    int64_t min = kInitialMin;
+    int64_t max = kInitialMax;
+  };
+
+  void Merge(const ThreadProfile &profile, const uint32_t num_metrics) {
+    for (uint32_t id = 0; id < num_metrics; ++id) {
+      const MetricSlot &src = profile.slots[id];
+      Slot &dst = slots[id];
+      dst.count += src.count.load(std::memory_order_relaxed);
+      dst.sum += src.sum.load(std::memory_order_relaxed);
+      dst.min = std::min(dst.min, src.min.load(std::memory_order_relaxed));
+      dst.max = std::max(dst.max, src.max.load(std::memory_order_relaxed));
+    }
+    for (size_t i = 0; i < kNumBucketSlots; ++i) {
+      buckets[i] += profile.buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  std::vector<Slot> slots;
+  std::vector<uint64_t> buckets;
+};
+
+class ProfilerState {
+public:
+  static ProfilerState &Instance() {
+    // Never destroyed, threads exiting during static destruction still retire their profiles
+    static ProfilerState *state = new ProfilerState();
+    return *state;
+  }
+
+  uint32_t Register(const std::string &name, const MetricType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = ids_.find(name);
+    if (it != ids_.end()) {
+      if (types_[it->second] != type) {
+        throw std::invalid_argument("Metric " + name + " is registered with another type");
+      }
+      return it->second;
+    }
+    if (names_.size() == Profiler::kMaxNumMetrics) {
+      throw std::length_error("Too many profiler metrics");
+    }
+    const uint32_t id = static_cast<uint32_t>(names_.size());
+    if (type == MetricType::HISTOGRAM) {
+      if (num_histograms_ == Profiler::kMaxNumHistograms) {
+        throw std::length_error("Too many profiler histograms");
+      }
+      histogram_offsets_[id] = num_histograms_++ * Profiler::kNumHistogramBuckets;
+    }
+    names_.push_back(name);
+    types_.push_back(type);
+    ids_.emplace(name, id);
+    return id;
+  }
+
+  void RecordTime(const uint32_t id, const int64_t start_ns, const int64_t duration_ns) {
+    ThreadProfile &profile = CurrentProfile();
+    profile.slots[id].Record(duration_ns);
+    if (trace_enabled_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(profile.trace_mutex);
+      if (profile.events.size() < Profiler::kMaxNumTraceEventsPerThread) {
+        profile.events.push_back({id, profile.index, start_ns, duration_ns});
+      } else {
+        ++profile.num_dropped_events;
+      }
+    }
+  }
+
+  void AddCount(const uint32_t id, const int64_t value) {
+    MetricSlot &slot = CurrentProfile().slots[id];
+    RelaxedAdd(&slot.count, uint64_t(1));
+    RelaxedAdd(&slot.sum, value);
+  }
+
+  void RecordValue(const uint32_t id, int64_t value) {
+    value = std::max(value, int64_t(0));
+    ThreadProfile &profile = CurrentProfile();
+    profile.slots[id].Record(value);
+    RelaxedAdd(&profile.buckets[histogram_offsets_[id] + HistogramBucket(value)], uint64_t(1));
+  }
+
+  void SetTraceEnabled(const bool enabled) { trace_enabled_.store(enabled); }
+  bool TraceEnabled() const { return trace_enabled_.load(); }
+
+  ProfileReport Report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t num_metrics = static_cast<uint32_t>(names_.size());
+    Totals totals = retired_;
+    ProfileReport report;
+    report.events = retired_events_;
+    report.num_dropped_events = retired_num_dropped_events_;
+    for (const std::shared_ptr<ThreadProfile> &profile : profiles_) {
+      totals.Merge(*profile, num_metrics);
+      std::lock_guard<std::mutex> trace_lock(profile->trace_mutex);
+      report.events.insert(report.events.end(), profile->events.begin(), profile->events.end());
+      report.num_dropped_events += profile->num_dropped_events;
+    }
+
+    report.metrics.resize(num_metrics);
+    for (uint32_t id = 0; id < num_metrics; ++id) {
+      const Totals::Slot &slot = totals.slots[id];
+      MetricStats &stats = report.metrics[id];
+      stats.name = names_[id];
+      stats.type = types_[id];
+      stats.count = slot.count;
+      stats.sum = slot.sum;
+      if (stats.type != MetricType::COUNTER && slot.count > 0) {
+        stats.min = slot.min;
+        stats.max = slot.max;
+      }
+      if (stats.type == MetricType::HISTOGRAM) {
+        const auto begin = totals.buckets.begin() + histogram_offsets_[id];
+        stats.buckets.assign(begin, begin + Profiler::kNumHistogramBuckets);
+      }
+    }
+    for (TraceEvent &event : report.events) {
+      event.start_ns -= epoch_ns_;
+    }
+    std::sort(report.events.begin(), report.events.end(),
+              [](const TraceEvent &a, const TraceEvent &b) { return a.start_ns < b.start_ns; });
+    return report;
+  }
+
+  void Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_ = Totals();
+    retired_events_.clear();
+    retired_num_dropped_events_ = 0;
+    for (const std::shared_ptr<ThreadProfile> &profile : profiles_) {
+      for (MetricSlot &slot : profile->slots) {
+        slot.Clear();
+      }
+      for (std::atomic<uint64_t> &bucket : profile->buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+      std::lock_guard<std::mutex> trace_lock(profile->trace_mutex);
+      profile->events.clear();
+      profile->num_dropped_events = 0;
+    }
+  }
+
+private:
+  ProfilerState() : epoch_ns_(Profiler::NowNanoseconds()) { histogram_offsets_.fill(0); }
+
+  // Registers the profile of the calling thread on first use
+  ThreadProfile &CurrentProfile() {
+    struct Holder {
+      ~Holder() {
+        if (profile) {
+          ProfilerState::Instance().Retire(profile);
+        }
+      }
+      std::shared_ptr<ThreadProfile> profile;
+    };
+    thread_local Holder holder;
+    if (!holder.profile) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      holder.profile = std::make_shared<ThreadProfile>(next_thread_index_++);
+      profiles_.push_back(holder.profile);
+    }
+    return *holder.profile;
+  }
+
+  // Fold the samples of an exiting thread into the retired totals
+  void Retire(const std::shared_ptr<ThreadProfile> &profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_.Merge(*profile, static_cast<uint32_t>(names_.size()));
+    retired_events_.insert(retired_events_.end(), profile->events.begin(),
+                           profile->events.end());
+    retired_num_dropped_events_ += profile->num_dropped_events;
+    profiles_.erase(std::find(profiles_.begin(), profiles_.end(), profile));
+  }
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<std::string> names_;
+  std::vector<MetricType> types_;
+  uint32_t num_histograms_ = 0;
+  // Written before the id is handed out, read without locking when recording
+  std::array<uint32_t, Profiler::kMaxNumMetrics> histogram_offsets_;
+
+  std::vector<std::shared_ptr<ThreadProfile>> profiles_;
+  uint32_t next_thread_index_ = 0;
+  Totals retired_;
+  std::vector<TraceEvent> retired_events_;
+  uint64_t retired_num_dropped_events_ = 0;
+
+  std::atomic<bool> trace_enabled_{false};
+  const int64_t epoch_ns_;
+};
+
+const char *MetricTypeName(const MetricType type) {
+  switch (type) {
+  case MetricType::TIMER:
+    return "timer";
+  case MetricType::COUNTER:
+    return "counter";
+  case MetricType::HISTOGRAM:
+  default:
+    return "histogram";
+  }
+}
+
+void WriteJsonString(const std::string &value, std::ostream *os) {
+  *os << '"';
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      *os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      *os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec
+          << std::setfill(' ');
+    } else {
+      *os << c;
+    }
+  }
+  *os << '"';
+}
+
+bool WriteTextFile(const std::string &path, const std::string &text) {
+  std::ofstream file(path, std::ios::binary);
+  file << text;
+  return file.good();
+}
+
+} // namespace
+
+int64_t MetricStats::Quantile(const double q) const {
+  if (count == 0 || buckets.empty()) {
+    return 0;
+  }
+  const uint64_t rank =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::min(1.0, q) * count)));
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    cumulative += buckets[i];
+    if (cumulative >= rank) {
+      const int64_t upper = i == 0 ? 0 : static_cast<int64_t>((uint64_t(1) << i) - 1);
+      return std::min(std::max(upper, min), max);
+    }
+  }
+  return max;
+}
+
+const MetricStats *ProfileReport::Find(const std::string &name) const {
+  for (const MetricStats &stats : metrics) {
+    if (stats.name == name) {
+      return &stats;
+    }
+  }
+  return nullptr;
+}
+
+std::string ProfileReport::ToJson() const {
+  std::ostringstream os;
+  os << "{\"metrics\": [";
+  bool first = true;
+  for (const MetricStats &stats : metrics) {
+    if (stats.count == 0) {
+      continue;
+    }
+    os << (first ? "\n  " : ",\n  ") << "{\"name\": ";
+    first = false;
+    WriteJsonString(stats.name, &os);
+    os << ", \"type\": \"" << MetricTypeName(stats.type) << "\", \"count\": " << stats.count;
+    switch (stats.type) {
+    case MetricType::TIMER:
+      os << ", \"total_ns\": " << stats.sum << ", \"mean_ns\": " << stats.Mean()
+         << ", \"min_ns\": " << stats.min << ", \"max_ns\": " << stats.max;
+      break;
+    case MetricType::COUNTER:
+      os << ", \"value\": " << stats.sum;
+      break;
+    case MetricType::HISTOGRAM: {
+      os << ", \"sum\": " << stats.sum << ", \"mean\": " << stats.Mean() << ", \"min\": "
+         << stats.min << ", \"max\": " << stats.max << ", \"p50\": " << stats.Quantile(0.5)
+         << ", \"p90\": " << stats.Quantile(0.9) << ", \"p99\": " << stats.Quantile(0.99)
+         << ", \"buckets\": [";
+      // Trailing empty buckets are omitted
+      size_t num_buckets = stats.buckets.size();
+      while (num_buckets > 0 && stats.buckets[num_buckets - 1] == 0) {
+        --num_buckets;
+      }
+      for (size_t i = 0; i < num_buckets; ++i) {
+        os << (i == 0 ? "" : ", ") << stats.buckets[i];
+      }
+      os << "]";
+      break;
+    }
+    }
+    os << "}";
+  }
+  os << (first ? "]" : "\n]") << ", \"num_dropped_events\": " << num_dropped_events << "}\n";
+  return os.str();
+}
+
+std::string ProfileReport::ToChromeTrace() const {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for (size_t i = 0; i < events.size(); ++i) {
+    const TraceEvent &event = events[i];
+    os << (i == 0 ? "\n  " : ",\n  ") << "{\"name\": ";
+    WriteJsonString(metrics[event.metric].name, &os);
+    os << ", \"cat\": \"photogrammetry\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+       << event.thread_index << ", \"ts\": " << event.start_ns * 1e-3
+       << ", \"dur\": " << event.duration_ns * 1e-3 << "}";
+  }
+  os << (events.empty() ? "]}\n" : "\n]}\n");
+  return os.str();
+}
+
+bool ProfileReport::WriteJson(const std::string &path) const {
+  return WriteTextFile(path, ToJson());
+}
+
+bool ProfileReport::WriteChromeTrace(const std::string &path) const {
+  return WriteTextFile(path, ToChromeTrace());
+}
+
+Profiler::Profiler() = default;
+
+Profiler &Profiler::Instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+uint32_t Profiler::Register(const std::string &name, const MetricType type) {
+  return ProfilerState::Instance().Register(name, type);
+}
+
+void Profiler::RecordTime(const uint32_t id, const int64_t start_ns, const int64_t duration_ns) {
+  ProfilerState::Instance().RecordTime(id, start_ns, duration_ns);
+}
+
+void Profiler::AddCount(const uint32_t id, const int64_t value) {
+  ProfilerState::Instance().AddCount(id, value);
+}
+
+void Profiler::RecordValue(const uint32_t id, const int64_t value) {
+  ProfilerState::Instance().RecordValue(id, value);
+}
+
+void Profiler::SetTraceEnabled(const bool enabled) {
+  ProfilerState::Instance().SetTraceEnabled(enabled);
+}
+
+bool Profiler::TraceEnabled() const { return ProfilerState::Instance().TraceEnabled(); }
+
+ProfileReport Profiler::Report() const { return ProfilerState::Instance().Report(); }
+
+void Profiler::Reset() { ProfilerState::Instance().Reset(); }
+
+int64_t Profiler::NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace utils
+} // namespace photogrammetry
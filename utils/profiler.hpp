@@ -0,0 +1,191 @@
+#ifndef PHOTOGRAMMETRY_UTILS_PROFILER_HPP
+#define PHOTOGRAMMETRY_UTILS_PROFILER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace photogrammetry {
+namespace utils {
+
+enum class MetricType : uint8_t { TIMER, COUNTER, HISTOGRAM };
+
+/**
+ * @brief Statistics of one metric merged over all threads
+ *
+ * Timers record durations in nanoseconds: count calls, sum total time. Counters only use sum.
+ * Histograms record non-negative integer samples into power-of-two buckets, buckets[0] holds
+ * zeros and buckets[i] the samples in [2^(i-1), 2^i).
+ */
+struct MetricStats {
+  std::string name;
+  MetricType type = MetricType::COUNTER;
+  uint64_t count = 0;
+  int64_t sum = 0;
+  int64_t min = 0;
+  int64_t max = 0;
+  std::vector<uint64_t> buckets;
+
+  double Mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+
+  /**
+   * @brief Approximate quantile of a histogram
+   * @param q quantile in [0, 1]
+   * @return upper bound of the bucket holding the quantile, clamped to [min, max]
+   */
+  int64_t Quantile(const double q) const;
+};
+
+// One completed timer scope, recorded while tracing is enabled
+struct TraceEvent {
+  uint32_t metric;
+  uint32_t thread_index;
+  int64_t start_ns;
+  int64_t duration_ns;
+};
+
+/**
+ * @brief Snapshot of all metrics, produced by Profiler::Report
+ */
+struct ProfileReport {
+  // Indexed by metric id, in registration order
+  std::vector<MetricStats> metrics;
+  // Sorted by start time, start_ns is relative to the creation of the profiler
+  std::vector<TraceEvent> events;
+  // Trace events discarded because a thread reached its event limit
+  uint64_t num_dropped_events = 0;
+
+  // nullptr if no metric with this name was registered
+  const MetricStats *Find(const std::string &name) const;
+
+  // {"metrics": [...]} with one object per metric that has samples
+  std::string ToJson() const;
+
+  // Chrome trace event format, loadable in chrome://tracing and Perfetto
+  std::string ToChromeTrace() const;
+
+  bool WriteJson(const std::string &path) const;
+  bool WriteChromeTrace(const std::string &path) const;
+};
+
+/**
+ * @brief Process wide registry of timers, counters and histograms
+ *
+ * Metrics are registered once by name and then addressed by id. Every thread records into its
+ * own slots with relaxed atomic stores, so recording never locks or shares cache lines with other
+ * threads. Report() merges the slots of all live threads with the totals of exited ones.
+ *
+ * Normally used through the PHOTOGRAMMETRY_PROFILE_* macros, which compile to nothing unless
+ * PHOTOGRAMMETRY_PROFILING_ENABLED is defined.
+ */
+class Profiler {
+public:
+  static constexpr uint32_t kMaxNumMetrics = 512;
+  static constexpr uint32_t kMaxNumHistograms = 32;
+  static constexpr int kNumHistogramBuckets = 64;
+  static constexpr size_t kMaxNumTraceEventsPerThread = size_t(1) << 20;
+
+  static Profiler &Instance();
+
+  /**
+   * @brief Id of the metric with this name, registering it on first use
+   * @throw std::invalid_argument if the name is registered with another type
+   * @throw std::length_error if the metric or histogram capacity is exhausted
+   */
+  uint32_t Register(const std::string &name, const MetricType type);
+
+  void RecordTime(const uint32_t id, const int64_t start_ns, const int64_t duration_ns);
+  void AddCount(const uint32_t id, const int64_t value);
+  // Negative samples are counted as zero
+  void RecordValue(const uint32_t id, const int64_t value);
+
+  // Whether timer scopes are also recorded as individual trace events
+  void SetTraceEnabled(const bool enabled);
+  bool TraceEnabled() const;
+
+  ProfileReport Report() const;
+
+  // Clear all samples and trace events, registered metrics are kept. Samples recorded by other
+  // threads during the call may be lost.
+  void Reset();
+
+  // Monotonic clock used for all timings
+  static int64_t NowNanoseconds();
+
+private:
+  Profiler();
+  ~Profiler() = default;
+};
+
+/**
+ * @brief Record the lifetime of the object as one sample of a timer
+ */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(const uint32_t id) : id_(id), start_ns_(Profiler::NowNanoseconds()) {}
+  ~ScopedTimer() {
+    Profiler::Instance().RecordTime(id_, start_ns_, Profiler::NowNanoseconds() - start_ns_);
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  const uint32_t id_;
+  const int64_t start_ns_;
+};
+
+} // namespace utils
+} // namespace photogrammetry
+
+#define PHOTOGRAMMETRY_PROFILE_CONCAT_IMPL(a, b) a##b
+#define PHOTOGRAMMETRY_PROFILE_CONCAT(a, b) PHOTOGRAMMETRY_PROFILE_CONCAT_IMPL(a, b)
+#define PHOTOGRAMMETRY_PROFILE_ID(type, name)                                                    \
+  static const uint32_t PHOTOGRAMMETRY_PROFILE_CONCAT(photogrammetry_profile_id_, __LINE__) =    \
+      ::photogrammetry::utils::Profiler::Instance().Register(                                    \
+          name, ::photogrammetry::utils::MetricType::type)
+
+#ifdef PHOTOGRAMMETRY_PROFILING_ENABLED
+
+/**
+ * @brief Time the rest of the enclosing scope, e.g. PHOTOGRAMMETRY_PROFILE_SCOPE("image/load")
+ * @param name string literal
+ */
+#define PHOTOGRAMMETRY_PROFILE_SCOPE(name)                                                       \
+  PHOTOGRAMMETRY_PROFILE_ID(TIMER, name);                                                        \
+  const ::photogrammetry::utils::ScopedTimer PHOTOGRAMMETRY_PROFILE_CONCAT(                      \
+      photogrammetry_profile_timer_, __LINE__)(                                                  \
+      PHOTOGRAMMETRY_PROFILE_CONCAT(photogrammetry_profile_id_, __LINE__))
+
+// Add value to a monotonic counter
+#define PHOTOGRAMMETRY_PROFILE_COUNT(name, value)                                                \
+  do {                                                                                           \
+    PHOTOGRAMMETRY_PROFILE_ID(COUNTER, name);                                                    \
+    ::photogrammetry::utils::Profiler::Instance().AddCount(                                      \
+        PHOTOGRAMMETRY_PROFILE_CONCAT(photogrammetry_profile_id_, __LINE__),                     \
+        static_cast<int64_t>(value));                                                            \
+  } while (0)
+
+// Record one sample of a histogram
+#define PHOTOGRAMMETRY_PROFILE_HISTOGRAM(name, value)                                            \
+  do {                                                                                           \
+    PHOTOGRAMMETRY_PROFILE_ID(HISTOGRAM, name);                                                  \
+    ::photogrammetry::utils::Profiler::Instance().RecordValue(                                   \
+        PHOTOGRAMMETRY_PROFILE_CONCAT(photogrammetry_profile_id_, __LINE__),                     \
+        static_cast<int64_t>(value));                                                            \
+  } while (0)
+
+#else
+
+// Disabled instrumentation generates no code and does not evaluate its arguments
+#define PHOTOGRAMMETRY_PROFILE_SCOPE(name) static_assert(true, "")
+#define PHOTOGRAMMETRY_PROFILE_COUNT(name, value)                                                \
+  do {                                                                                           \
+  } while (0)
+#define PHOTOGRAMMETRY_PROFILE_HISTOGRAM(name, value)                                            \
+  do {                                                                                           \
+  } while (0)
+
+#endif
+
+#endif // PHOTOGRAMMETRY_UTILS_PROFILER_HPP
@@ -0,0 +1,146 @@
+#include "utils/profiler.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace photogrammetry::utils;
+
+TEST(ProfilerTest, RegistersMetricsOnce) {
+  Profiler &profiler = Profiler::Instance();
+  const uint32_t id = profiler.Register("test/register", MetricType::COUNTER);
+  EXPECT_EQ(profiler.Register("test/register", MetricType::COUNTER), id);
+  EXPECT_NE(profiler.Register("test/register_other", MetricType::COUNTER), id);
+  EXPECT_THROW(profiler.Register("test/register", MetricType::TIMER), std::invalid_argument);
+}
+
+TEST(ProfilerTest, MergesThreads) {
+  Profiler &profiler = Profiler::Instance();
+  const uint32_t timer = profiler.Register("test/merge_timer", MetricType::TIMER);
+  const uint32_t counter = profiler.Register("test/merge_counter", MetricType::COUNTER);
+  const int kNumThreads = 4;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 100; ++i) {
+        profiler.RecordTime(timer, 0, 10 * (t + 1));
+        profiler.AddCount(counter, 2);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  // The threads have exited, their samples are kept in the retired totals
+  profiler.AddCount(counter, 1);
+  const ProfileReport report = profiler.Report();
+  const MetricStats *timer_stats = report.Find("test/merge_timer");
+  ASSERT_NE(timer_stats, nullptr);
+  EXPECT_EQ(timer_stats->type, MetricType::TIMER);
+  EXPECT_EQ(timer_stats->count, 400u);
+  EXPECT_EQ(timer_stats->sum, 100 * (10 + 20 + 30 + 40));
+  EXPECT_EQ(timer_stats->min, 10);
+  EXPECT_EQ(timer_stats->max, 40);
+  EXPECT_DOUBLE_EQ(timer_stats->Mean(), 25.0);
+  const MetricStats *counter_stats = report.Find("test/merge_counter");
+  ASSERT_NE(counter_stats, nullptr);
+  EXPECT_EQ(counter_stats->sum, 801);
+  EXPECT_EQ(report.Find("test/missing"), nullptr);
+}
+
+TEST(ProfilerTest, RecordsHistograms) {
+  Profiler &profiler = Profiler::Instance();
+  const uint32_t id = profiler.Register("test/histogram", MetricType::HISTOGRAM);
+  for (int64_t value = 0; value < 100; ++value) {
+    profiler.RecordValue(id, value);
+  }
+  profiler.RecordValue(id, -5);
+  const ProfileReport report = profiler.Report();
+  const MetricStats *stats = report.Find("test/histogram");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->count, 101u);
+  EXPECT_EQ(stats->min, 0);
+  EXPECT_EQ(stats->max, 99);
+  ASSERT_EQ(stats->buckets.size(), size_t(Profiler::kNumHistogramBuckets));
+  EXPECT_EQ(stats->buckets[0], 2u);
+  EXPECT_EQ(stats->buckets[1], 1u);
+  EXPECT_EQ(stats->buckets[2], 2u);
+  EXPECT_EQ(stats->buckets[7], 36u);
+  // The median 49 falls into [32, 64)
+  EXPECT_EQ(stats->Quantile(0.5), 63);
+  EXPECT_EQ(stats->Quantile(1.0), 99);
+  EXPECT_EQ(stats->Quantile(0.0), 0);
+}
+
+TEST(ProfilerTest, ExportsJsonAndChromeTrace) {
+  Profiler &profiler = Profiler::Instance();
+  const uint32_t id = profiler.Register("test/\"export\"", MetricType::TIMER);
+  profiler.SetTraceEnabled(true);
+  {
+    const ScopedTimer timer(id);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  profiler.SetTraceEnabled(false);
+  {
+    const ScopedTimer timer(id);
+  }
+  const ProfileReport report = profiler.Report();
+  const MetricStats *stats = report.Find("test/\"export\"");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->count, 2u);
+  EXPECT_GE(stats->max, 1000000);
+
+  const std::string json = report.ToJson();
+  EXPECT_NE(json.find("{\"name\": \"test/\\\"export\\\"\", \"type\": \"timer\", \"count\": 2"),
+            std::string::npos);
+  const std::string trace = report.ToChromeTrace();
+  EXPECT_EQ(trace.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["), 0u);
+  size_t num_events = 0;
+  for (const TraceEvent &event : report.events) {
+    if (event.metric == id) {
+      EXPECT_GE(event.duration_ns, 1000000);
+      EXPECT_GE(event.start_ns, 0);
+      ++num_events;
+    }
+  }
+  EXPECT_EQ(num_events, 1u);
+  EXPECT_NE(trace.find("\"ph\": \"X\""), std::string::npos);
+}
+
+TEST(ProfilerTest, ResetsSamples) {
+  Profiler &profiler = Profiler::Instance();
+  const uint32_t id = profiler.Register("test/reset", MetricType::COUNTER);
+  profiler.AddCount(id, 5);
+  profiler.Reset();
+  profiler.AddCount(id, 3);
+  const ProfileReport report = profiler.Report();
+  ASSERT_NE(report.Find("test/reset"), nullptr);
+  EXPECT_EQ(report.Find("test/reset")->sum, 3);
+  EXPECT_EQ(report.Find("test/reset")->count, 1u);
+}
+
+TEST(ProfilerTest, MacrosFollowBuildFlag) {
+  int evaluations = 0;
+  for (int i = 0; i < 3; ++i) {
+    PHOTOGRAMMETRY_PROFILE_SCOPE("test/macro_scope");
+    PHOTOGRAMMETRY_PROFILE_COUNT("test/macro_count", ++evaluations);
+    PHOTOGRAMMETRY_PROFILE_HISTOGRAM("test/macro_histogram", 4);
+  }
+  const ProfileReport report = Profiler::Instance().Report();
+#ifdef PHOTOGRAMMETRY_PROFILING_ENABLED
+  EXPECT_EQ(evaluations, 3);
+  ASSERT_NE(report.Find("test/macro_scope"), nullptr);
+  EXPECT_EQ(report.Find("test/macro_scope")->count, 3u);
+  ASSERT_NE(report.Find("test/macro_count"), nullptr);
+  EXPECT_EQ(report.Find("test/macro_count")->sum, 1 + 2 + 3);
+  ASSERT_NE(report.Find("test/macro_histogram"), nullptr);
+  EXPECT_EQ(report.Find("test/macro_histogram")->buckets[3], 3u);
+#else
+  // Compiled out: nothing is registered and the arguments are not evaluated
+  EXPECT_EQ(evaluations, 0);
+  EXPECT_EQ(report.Find("test/macro_scope"), nullptr);
+  EXPECT_EQ(report.Find("test/macro_count"), nullptr);
+#endif
+}
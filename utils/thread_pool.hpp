@@ -0,0 +1,137 @@
+#ifndef PHOTOGRAMMETRY_THREAD_POOL_HPP
+#define PHOTOGRAMMETRY_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace photogrammetry {
+namespace utils {
+
+/**
+ * @brief Number of worker threads to use for a requested thread count
+ * @param num_threads requested count, values <= 0 mean all hardware threads
+ * @return effective thread count, at least 1
+ */
+inline int GetEffectiveNumThreads(const int num_threads) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * @brief Fixed size thread pool with a FIFO task queue
+ *
+ * Tasks are started in submission order. AddTask returns a std::future for the task result,
+ * exceptions thrown by a task are rethrown from future::get(). The destructor finishes all queued
+ * tasks before joining the workers.
+ */
+class ThreadPool {
+public:
+  static const int kMaxNumThreads = -1;
+
+  explicit ThreadPool(const int num_threads = kMaxNumThreads) {
+    const int num_workers = GetEffectiveNumThreads(num_threads);
+    workers_.reserve(num_workers);
+    for (int i = 0; i < num_workers; ++i) {
+      workers_.emplace_back(&ThreadPool::WorkerFunc, this);
+    }
+  }
+
+  ~ThreadPool() { Stop(); }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int NumThreads() const { return static_cast<int>(workers_.size()); }
+
+  /**
+   * @brief Queue a task for execution
+   * @param func callable
+   * @param args arguments bound to the callable
+   * @return future holding the result of the task
+   */
+  template <typename Func, typename... Args>
+  auto AddTask(Func &&func, Args &&...args)
+      -> std::future<typename std::invoke_result<Func, Args...>::type> {
+    typedef typename std::invoke_result<Func, Args...>::type Result;
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+    std::future<Result> result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) {
+        throw std::runtime_error("Cannot add task to a stopped thread pool");
+      }
+      tasks_.emplace([task]() { (*task)(); });
+    }
+    task_condition_.notify_one();
+    return result;
+  }
+
+  // Block until all queued and running tasks have finished
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_condition_.wait(lock, [this]() { return tasks_.empty() && num_active_ == 0; });
+  }
+
+  // Finish the queued tasks and join all workers, no tasks can be added afterwards
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) {
+        return;
+      }
+      stopped_ = true;
+    }
+    task_condition_.notify_all();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+  }
+
+private:
+  void WorkerFunc() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        task_condition_.wait(lock, [this]() { return stopped_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+        ++num_active_;
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --num_active_;
+      }
+      finished_condition_.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable task_condition_;
+  std::condition_variable finished_condition_;
+  int num_active_ = 0;
+  bool stopped_ = false;
+};
+
+} // namespace utils
+} // namespace photogrammetry
+
+#endif // PHOTOGRAMMETRY_THREAD_POOL_HPP